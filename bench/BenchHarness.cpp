@@ -0,0 +1,612 @@
+#include "BenchHarness.h"
+#include "ObseGPCompat.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <system_error>
+#include <thread>
+
+#ifndef OBSE64GP_BENCH_BUILD_TYPE
+#define OBSE64GP_BENCH_BUILD_TYPE "unknown"
+#endif
+
+namespace ObseGPCompat
+{
+
+    namespace Bench
+    {
+
+        namespace
+        {
+            std::string EscapeJson(std::string_view text)
+            {
+                std::string escaped;
+                escaped.reserve(text.size());
+                for (char c : text)
+                {
+                    switch (c)
+                    {
+                    case '"':
+                        escaped += "\\\"";
+                        break;
+                    case '\\':
+                        escaped += "\\\\";
+                        break;
+                    case '\n':
+                        escaped += "\\n";
+                        break;
+                    case '\t':
+                        escaped += "\\t";
+                        break;
+                    default:
+                        if (static_cast<unsigned char>(c) < 0x20)
+                        {
+                            char code[8];
+                            snprintf(code, sizeof(code), "\\u%04x", c);
+                            escaped += code;
+                        }
+                        else
+                        {
+                            escaped += c;
+                        }
+                    }
+                }
+                return escaped;
+            }
+
+            // Finite numbers only; JSON has no NaN or infinity
+            std::string FormatNumber(double value)
+            {
+                if (!std::isfinite(value))
+                {
+                    return "null";
+                }
+                char text[32];
+                snprintf(text, sizeof(text), "%.6g", value);
+                return text;
+            }
+
+            std::string GetCompilerName()
+            {
+#if defined(__clang__)
+                return std::string("Clang ") + __clang_version__;
+#elif defined(__GNUC__)
+                return std::string("GCC ") + __VERSION__;
+#elif defined(_MSC_VER)
+                return "MSVC " + std::to_string(_MSC_VER);
+#else
+                return "unknown";
+#endif
+            }
+
+            const char *GetPlatformName()
+            {
+#if defined(_WIN32)
+                return "windows";
+#elif defined(__linux__)
+                return "linux";
+#elif defined(__APPLE__)
+                return "macos";
+#else
+                return "posix";
+#endif
+            }
+
+            std::string GetTimestamp()
+            {
+                std::time_t now = std::time(nullptr);
+                std::tm utc = {};
+#ifdef _WIN32
+                gmtime_s(&utc, &now);
+#else
+                gmtime_r(&now, &utc);
+#endif
+                char text[32];
+                std::strftime(text, sizeof(text), "%Y-%m-%dT%H:%M:%SZ", &utc);
+                return text;
+            }
+
+            // Just enough JSON to read back what WriteResults writes
+            struct JsonValue
+            {
+                enum class Type
+                {
+                    Null,
+                    Bool,
+                    Number,
+                    String,
+                    Array,
+                    Object
+                };
+
+                Type type = Type::Null;
+                double number = 0.0;
+                std::string string;
+                std::vector<JsonValue> elements;
+                std::vector<std::pair<std::string, JsonValue>> members;
+
+                const JsonValue *Find(std::string_view key) const
+                {
+                    for (const auto &member : members)
+                    {
+                        if (member.first == key)
+                        {
+                            return &member.second;
+                        }
+                    }
+                    return nullptr;
+                }
+            };
+
+            class JsonParser
+            {
+            public:
+                explicit JsonParser(std::string_view text) : m_Text(text), m_Position(0) {}
+
+                bool Parse(JsonValue &value)
+                {
+                    return ParseValue(value, 0) && (SkipWhitespace(), m_Position == m_Text.size());
+                }
+
+            private:
+                static constexpr int MaxDepth = 32;
+
+                void SkipWhitespace()
+                {
+                    while (m_Position < m_Text.size() && std::isspace(static_cast<unsigned char>(m_Text[m_Position])))
+                    {
+                        ++m_Position;
+                    }
+                }
+
+                bool Consume(char c)
+                {
+                    SkipWhitespace();
+                    if (m_Position < m_Text.size() && m_Text[m_Position] == c)
+                    {
+                        ++m_Position;
+                        return true;
+                    }
+                    return false;
+                }
+
+                bool ConsumeWord(std::string_view word)
+                {
+                    if (m_Text.substr(m_Position, word.size()) != word)
+                    {
+                        return false;
+                    }
+                    m_Position += word.size();
+                    return true;
+                }
+
+                bool ParseString(std::string &out)
+                {
+                    if (!Consume('"'))
+                    {
+                        return false;
+                    }
+                    while (m_Position < m_Text.size())
+                    {
+                        char c = m_Text[m_Position++];
+                        if (c == '"')
+                        {
+                            return true;
+                        }
+                        if (c != '\\')
+                        {
+                            out += c;
+                            continue;
+                        }
+                        if (m_Position >= m_Text.size())
+                        {
+                            return false;
+                        }
+                        char escape = m_Text[m_Position++];
+                        switch (escape)
+                        {
+                        case 'n':
+                            out += '\n';
+                            break;
+                        case 't':
+                            out += '\t';
+                            break;
+                        case 'u':
+                            // Only control characters are written escaped, so one byte is enough
+                            if (m_Position + 4 > m_Text.size())
+                            {
+                                return false;
+                            }
+                            out += static_cast<char>(std::strtol(std::string(m_Text.substr(m_Position, 4)).c_str(), nullptr, 16));
+                            m_Position += 4;
+                            break;
+                        default:
+                            out += escape;
+                        }
+                    }
+                    return false;
+                }
+
+                bool ParseValue(JsonValue &value, int depth)
+                {
+                    SkipWhitespace();
+                    if (m_Position >= m_Text.size() || depth > MaxDepth)
+                    {
+                        return false;
+                    }
+
+                    char c = m_Text[m_Position];
+                    if (c == '{')
+                    {
+                        ++m_Position;
+                        value.type = JsonValue::Type::Object;
+                        if (Consume('}'))
+                        {
+                            return true;
+                        }
+                        do
+                        {
+                            std::pair<std::string, JsonValue> member;
+                            if (!ParseString(member.first) || !Consume(':') || !ParseValue(member.second, depth + 1))
+                            {
+                                return false;
+                            }
+                            value.members.push_back(std::move(member));
+                        } while (Consume(','));
+                        return Consume('}');
+                    }
+                    if (c == '[')
+                    {
+                        ++m_Position;
+                        value.type = JsonValue::Type::Array;
+                        if (Consume(']'))
+                        {
+                            return true;
+                        }
+                        do
+                        {
+                            value.elements.emplace_back();
+                            if (!ParseValue(value.elements.back(), depth + 1))
+                            {
+                                return false;
+                            }
+                        } while (Consume(','));
+                        return Consume(']');
+                    }
+                    if (c == '"')
+                    {
+                        value.type = JsonValue::Type::String;
+                        return ParseString(value.string);
+                    }
+                    if (ConsumeWord("true") || ConsumeWord("false"))
+                    {
+                        value.type = JsonValue::Type::Bool;
+                        return true;
+                    }
+                    if (ConsumeWord("null"))
+                    {
+                        return true;
+                    }
+
+                    // strtod stops at the end of the number
+                    std::string rest(m_Text.substr(m_Position, 64));
+                    char *end = nullptr;
+                    value.number = std::strtod(rest.c_str(), &end);
+                    if (end == rest.c_str())
+                    {
+                        return false;
+                    }
+                    value.type = JsonValue::Type::Number;
+                    m_Position += end - rest.c_str();
+                    return true;
+                }
+
+                std::string_view m_Text;
+                size_t m_Position;
+            };
+
+            std::string GetLabelOf(const JsonValue &result)
+            {
+                const JsonValue *name = result.Find("name");
+                if (!name || name->type != JsonValue::Type::String)
+                {
+                    return std::string();
+                }
+
+                BenchParams params;
+                if (const JsonValue *values = result.Find("params"))
+                {
+                    for (const auto &member : values->members)
+                    {
+                        params.emplace_back(member.first, static_cast<int64_t>(member.second.number));
+                    }
+                }
+                return GetCaseLabel(name->string, params);
+            }
+        }
+
+        double BenchResult::Median() const
+        {
+            if (samples.empty())
+            {
+                return 0.0;
+            }
+            std::vector<double> sorted = samples;
+            std::sort(sorted.begin(), sorted.end());
+            size_t middle = sorted.size() / 2;
+            return sorted.size() % 2 ? sorted[middle] : (sorted[middle - 1] + sorted[middle]) / 2.0;
+        }
+
+        double BenchResult::Min() const
+        {
+            return samples.empty() ? 0.0 : *std::min_element(samples.begin(), samples.end());
+        }
+
+        double BenchResult::Max() const
+        {
+            return samples.empty() ? 0.0 : *std::max_element(samples.begin(), samples.end());
+        }
+
+        BenchState::BenchState(const BenchOptions &options, BenchResult &result, std::filesystem::path workDirectory)
+            : m_Options(options),
+              m_Result(result),
+              m_WorkDirectory(std::move(workDirectory)),
+              m_Repetitions(options.repetitions > 0 ? options.repetitions : 1)
+        {
+        }
+
+        int64_t BenchState::Param(std::string_view name) const
+        {
+            for (const auto &param : m_Result.params)
+            {
+                if (param.first == name)
+                {
+                    return param.second;
+                }
+            }
+            return 0;
+        }
+
+        void BenchState::SetCounter(const std::string &name, double value)
+        {
+            for (auto &counter : m_Result.counters)
+            {
+                if (counter.first == name)
+                {
+                    counter.second = value;
+                    return;
+                }
+            }
+            m_Result.counters.emplace_back(name, value);
+        }
+
+        void BenchState::AddSample(uint64_t operations, Clock::duration elapsed)
+        {
+            double nanoseconds = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+            m_Result.operations += operations;
+            m_Result.samples.push_back(operations ? nanoseconds / static_cast<double>(operations) : 0.0);
+        }
+
+        void BenchRegistry::Add(const std::string &name, BenchParams params, BenchFunction function, bool large)
+        {
+            m_Cases.push_back({name, std::move(params), std::move(function), large});
+        }
+
+        void BenchRegistry::AddGrid(const std::string &name, const std::vector<BenchAxis> &axes, const BenchFunction &function)
+        {
+            if (axes.empty())
+            {
+                Add(name, {}, function);
+                return;
+            }
+
+            // Odometer over the axes, the last one changing fastest
+            std::vector<size_t> positions(axes.size(), 0);
+            for (;;)
+            {
+                BenchParams params;
+                for (size_t i = 0; i < axes.size(); ++i)
+                {
+                    params.emplace_back(axes[i].first, axes[i].second[positions[i]]);
+                }
+                Add(name, std::move(params), function);
+
+                size_t axis = axes.size();
+                while (axis > 0 && ++positions[axis - 1] == axes[axis - 1].second.size())
+                {
+                    positions[axis - 1] = 0;
+                    --axis;
+                }
+                if (axis == 0)
+                {
+                    return;
+                }
+            }
+        }
+
+        std::string GetCaseLabel(const std::string &name, const BenchParams &params)
+        {
+            std::string label = name;
+            for (const auto &param : params)
+            {
+                label += '/' + param.first + ':' + std::to_string(param.second);
+            }
+            return label;
+        }
+
+        BenchResult RunCase(const BenchCase &benchCase, const BenchOptions &options)
+        {
+            BenchResult result;
+            result.name = benchCase.name;
+            result.params = benchCase.params;
+
+            // A fresh directory per case, so leftovers of one never skew the next
+            std::error_code ec;
+            std::filesystem::path workDirectory = options.workDirectory / "case";
+            std::filesystem::remove_all(workDirectory, ec);
+            std::filesystem::create_directories(workDirectory, ec);
+            if (ec)
+            {
+                result.skipped = "cannot create the work directory: " + ec.message();
+                return result;
+            }
+
+            {
+                BenchState state(options, result, workDirectory);
+                try
+                {
+                    benchCase.function(state);
+                }
+                catch (const std::exception &e)
+                {
+                    state.Skip(std::string("failed: ") + e.what());
+                }
+                if (!state.IsSkipped() && result.samples.empty())
+                {
+                    state.Skip("nothing was measured");
+                }
+            }
+
+            std::filesystem::remove_all(workDirectory, ec);
+            return result;
+        }
+
+        bool WriteResults(const std::filesystem::path &path, const BenchOptions &options, const std::vector<BenchResult> &results)
+        {
+            std::ofstream file(path, std::ios::binary | std::ios::trunc);
+            if (!file.is_open())
+            {
+                return false;
+            }
+
+            file << "{\n";
+            file << "  \"version\": \"" << EscapeJson(VERSION) << "\",\n";
+            file << "  \"timestamp\": \"" << GetTimestamp() << "\",\n";
+            file << "  \"platform\": \"" << GetPlatformName() << "\",\n";
+            file << "  \"compiler\": \"" << EscapeJson(GetCompilerName()) << "\",\n";
+            file << "  \"build_type\": \"" << EscapeJson(OBSE64GP_BENCH_BUILD_TYPE) << "\",\n";
+            file << "  \"hardware_threads\": " << std::thread::hardware_concurrency() << ",\n";
+            file << "  \"min_time_ms\": " << options.minTime.count() << ",\n";
+            file << "  \"repetitions\": " << options.repetitions << ",\n";
+            file << "  \"results\": [";
+
+            for (size_t i = 0; i < results.size(); ++i)
+            {
+                const BenchResult &result = results[i];
+                file << (i ? ",\n" : "\n") << "    {\"name\": \"" << EscapeJson(result.name) << "\", \"params\": {";
+                for (size_t j = 0; j < result.params.size(); ++j)
+                {
+                    file << (j ? ", " : "") << '"' << EscapeJson(result.params[j].first) << "\": " << result.params[j].second;
+                }
+                file << '}';
+
+                if (!result.skipped.empty())
+                {
+                    file << ", \"skipped\": \"" << EscapeJson(result.skipped) << "\"}";
+                    continue;
+                }
+
+                double median = result.Median();
+                double perSecond = median > 0.0 ? 1e9 / median : 0.0;
+                file << ", \"operations\": " << result.operations;
+                file << ", \"ns_per_op\": " << FormatNumber(median);
+                file << ", \"ns_per_op_min\": " << FormatNumber(result.Min());
+                file << ", \"ns_per_op_max\": " << FormatNumber(result.Max());
+                file << ", \"ops_per_second\": " << FormatNumber(perSecond);
+                if (result.itemsPerOperation > 0.0)
+                {
+                    file << ", \"items_per_second\": " << FormatNumber(perSecond * result.itemsPerOperation);
+                }
+                if (result.bytesPerOperation > 0.0)
+                {
+                    file << ", \"bytes_per_second\": " << FormatNumber(perSecond * result.bytesPerOperation);
+                }
+                if (!result.counters.empty())
+                {
+                    file << ", \"counters\": {";
+                    for (size_t j = 0; j < result.counters.size(); ++j)
+                    {
+                        file << (j ? ", " : "") << '"' << EscapeJson(result.counters[j].first) << "\": "
+                             << FormatNumber(result.counters[j].second);
+                    }
+                    file << '}';
+                }
+                file << '}';
+            }
+
+            file << "\n  ]\n}\n";
+            return file.good();
+        }
+
+        bool CompareResults(const std::filesystem::path &baselinePath, const std::vector<BenchResult> &results)
+        {
+            std::ifstream file(baselinePath, std::ios::binary);
+            if (!file.is_open())
+            {
+                fprintf(stderr, "Cannot open baseline %s\n", baselinePath.string().c_str());
+                return false;
+            }
+            std::stringstream text;
+            text << file.rdbuf();
+
+            JsonValue baseline;
+            std::string contents = text.str();
+            const JsonValue *entries = nullptr;
+            if (!JsonParser(contents).Parse(baseline) || !(entries = baseline.Find("results")) ||
+                entries->type != JsonValue::Type::Array)
+            {
+                fprintf(stderr, "Baseline %s is not a results file\n", baselinePath.string().c_str());
+                return false;
+            }
+
+            std::map<std::string, double> previous;
+            for (const JsonValue &entry : entries->elements)
+            {
+                const JsonValue *median = entry.Find("ns_per_op");
+                if (median && median->type == JsonValue::Type::Number)
+                {
+                    previous[GetLabelOf(entry)] = median->number;
+                }
+            }
+
+            fprintf(stderr, "\n%-64s %14s %14s %9s\n", "Compared with baseline", "baseline ns", "current ns", "change");
+            for (const BenchResult &result : results)
+            {
+                std::string label = GetCaseLabel(result.name, result.params);
+                auto it = previous.find(label);
+                if (!result.skipped.empty())
+                {
+                    if (it != previous.end())
+                    {
+                        previous.erase(it);
+                    }
+                    continue;
+                }
+                if (it == previous.end())
+                {
+                    fprintf(stderr, "%-64s %14s %14.1f %9s\n", label.c_str(), "-", result.Median(), "new");
+                    continue;
+                }
+
+                // Negative is faster
+                double change = it->second > 0.0 ? (result.Median() - it->second) / it->second * 100.0 : 0.0;
+                fprintf(stderr, "%-64s %14.1f %14.1f %+8.1f%%\n", label.c_str(), it->second, result.Median(), change);
+                previous.erase(it);
+            }
+            for (const auto &missing : previous)
+            {
+                fprintf(stderr, "%-64s %14.1f %14s %9s\n", missing.first.c_str(), missing.second, "-", "gone");
+            }
+            return true;
+        }
+    }
+
+} // namespace ObseGPCompat
@@ -0,0 +1,202 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace ObseGPCompat
+{
+
+    namespace Bench
+    {
+        // Named integer parameters of one case, in declaration order
+        using BenchParams = std::vector<std::pair<std::string, int64_t>>;
+
+        struct BenchOptions
+        {
+            std::chrono::milliseconds minTime{200}; // Per repetition
+            int repetitions = 3;
+            bool large = false;                      // Also run the cases marked large
+            std::filesystem::path workDirectory;     // Scratch space, one subdirectory per case
+        };
+
+        struct BenchResult
+        {
+            std::string name;
+            BenchParams params;
+            std::string skipped;               // Why the case did not run; empty when it did
+            uint64_t operations = 0;           // Timed operations over all repetitions
+            std::vector<double> samples;       // Nanoseconds per operation, one per repetition
+            double itemsPerOperation = 0.0;    // Zero when the case does not count items
+            double bytesPerOperation = 0.0;
+            std::vector<std::pair<std::string, double>> counters;
+
+            double Median() const;
+            double Min() const;
+            double Max() const;
+        };
+
+        // Handed to each case: its parameters, a scratch directory, and the timing loops.
+        // A case prepares its data, then calls Measure or MeasureEach exactly once.
+        class BenchState
+        {
+        public:
+            BenchState(const BenchOptions &options, BenchResult &result, std::filesystem::path workDirectory);
+
+            // Value of a declared parameter; zero when the case has no such parameter
+            int64_t Param(std::string_view name) const;
+
+            // Empty and private to this case; removed once it finishes
+            const std::filesystem::path &WorkDirectory() const { return m_WorkDirectory; }
+
+            // Kept for the whole run, for generated inputs that several cases read but never change
+            std::filesystem::path SharedDirectory() const { return m_Options.workDirectory / "shared"; }
+
+            void SetItemsPerOperation(double items) { m_Result.itemsPerOperation = items; }
+            void SetBytesPerOperation(double bytes) { m_Result.bytesPerOperation = bytes; }
+            void SetCounter(const std::string &name, double value);
+
+            // For cases whose single operation takes seconds
+            void SetRepetitions(int repetitions) { m_Repetitions = repetitions > 0 ? repetitions : 1; }
+
+            // Records why the case cannot run here; Measure is then not called
+            void Skip(const std::string &reason) { m_Result.skipped = reason; }
+            bool IsSkipped() const { return !m_Result.skipped.empty(); }
+
+            // Times body in batches large enough that the clock does not matter, for cheap
+            // operations. Each repetition runs for at least the minimum time.
+            template <typename Body>
+            void Measure(Body &&body);
+
+            // Times each call of body on its own, after an untimed call of prepare, for
+            // operations that need fresh state or take long enough to time individually
+            template <typename Prepare, typename Body>
+            void MeasureEach(Prepare &&prepare, Body &&body);
+
+        private:
+            using Clock = std::chrono::steady_clock;
+
+            void AddSample(uint64_t operations, Clock::duration elapsed);
+
+            const BenchOptions &m_Options;
+            BenchResult &m_Result;
+            std::filesystem::path m_WorkDirectory;
+            int m_Repetitions;
+        };
+
+        using BenchFunction = std::function<void(BenchState &)>;
+
+        // Parameter name and the values it takes; a grid runs every combination
+        using BenchAxis = std::pair<std::string, std::vector<int64_t>>;
+
+        struct BenchCase
+        {
+            std::string name;
+            BenchParams params;
+            BenchFunction function;
+            bool large; // Only run with --large
+        };
+
+        class BenchRegistry
+        {
+        public:
+            void Add(const std::string &name, BenchParams params, BenchFunction function, bool large = false);
+            void AddGrid(const std::string &name, const std::vector<BenchAxis> &axes, const BenchFunction &function);
+
+            const std::vector<BenchCase> &GetCases() const { return m_Cases; }
+
+        private:
+            std::vector<BenchCase> m_Cases;
+        };
+
+        // Keeps the compiler from dropping a computation whose result is otherwise unused
+        template <typename T>
+        inline void KeepResult(const T &value)
+        {
+#if defined(_MSC_VER)
+            static volatile const void *sink;
+            sink = &value;
+#else
+            asm volatile("" : : "r,m"(value) : "memory");
+#endif
+        }
+
+        // "name/param:value/..." as printed and matched by --filter
+        std::string GetCaseLabel(const std::string &name, const BenchParams &params);
+
+        // Runs one case in its own scratch directory
+        BenchResult RunCase(const BenchCase &benchCase, const BenchOptions &options);
+
+        // All results of a run, with enough context to tell runs apart
+        bool WriteResults(const std::filesystem::path &path, const BenchOptions &options, const std::vector<BenchResult> &results);
+
+        // Prints each result's median next to the same case in a results file from an
+        // earlier run. Cases missing from either side are listed as such.
+        bool CompareResults(const std::filesystem::path &baselinePath, const std::vector<BenchResult> &results);
+
+        template <typename Body>
+        void BenchState::Measure(Body &&body)
+        {
+            // Grow the batch until one takes a tenth of the minimum time, so the clock
+            // reads are noise; that also serves as warm-up
+            uint64_t batch = 1;
+            auto target = std::chrono::duration_cast<Clock::duration>(m_Options.minTime) / 10;
+            for (;;)
+            {
+                auto start = Clock::now();
+                for (uint64_t i = 0; i < batch; ++i)
+                {
+                    body();
+                }
+                if (Clock::now() - start >= target || batch >= (uint64_t(1) << 40))
+                {
+                    break;
+                }
+                batch *= 2;
+            }
+
+            for (int repetition = 0; repetition < m_Repetitions; ++repetition)
+            {
+                uint64_t operations = 0;
+                Clock::duration elapsed{};
+                while (elapsed < m_Options.minTime)
+                {
+                    auto start = Clock::now();
+                    for (uint64_t i = 0; i < batch; ++i)
+                    {
+                        body();
+                    }
+                    elapsed += Clock::now() - start;
+                    operations += batch;
+                }
+                AddSample(operations, elapsed);
+            }
+        }
+
+        template <typename Prepare, typename Body>
+        void BenchState::MeasureEach(Prepare &&prepare, Body &&body)
+        {
+            for (int repetition = 0; repetition < m_Repetitions; ++repetition)
+            {
+                uint64_t operations = 0;
+                Clock::duration elapsed{};
+                do
+                {
+                    prepare();
+                    auto start = Clock::now();
+                    body();
+                    elapsed += Clock::now() - start;
+                    ++operations;
+                } while (elapsed < m_Options.minTime);
+                AddSample(operations, elapsed);
+            }
+        }
+    }
+
+} // namespace ObseGPCompat
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "BenchHarness.h"
+
+namespace ObseGPCompat
+{
+
+    namespace Bench
+    {
+        // One per area, each in its own file
+        void RegisterTranslationBenchmarks(BenchRegistry &registry);
+        void RegisterFileSystemBenchmarks(BenchRegistry &registry);
+        void RegisterMountBenchmarks(BenchRegistry &registry);
+        void RegisterStorageBenchmarks(BenchRegistry &registry);
+        void RegisterConfigBenchmarks(BenchRegistry &registry);
+        void RegisterLogBenchmarks(BenchRegistry &registry);
+    }
+
+} // namespace ObseGPCompat
@@ -0,0 +1,163 @@
+#include "Benchmarks.h"
+#include "SyntheticInstall.h"
+#include "ObseGPCompat.h"
+#include "ConfigurationManager.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <system_error>
+
+namespace ObseGPCompat
+{
+
+    namespace Bench
+    {
+
+        namespace
+        {
+            constexpr size_t KeysPerSection = 16;
+            constexpr size_t CorpusSize = 4096;
+            constexpr size_t CorpusMask = CorpusSize - 1;
+
+            // Where Initialize looks; the bench points the known folder into its work directory
+            std::filesystem::path GetConfigPath()
+            {
+                return GetLocalAppDataPath() / "OBSE64GP" / "config.ini";
+            }
+
+            bool WriteConfig(const std::string &text)
+            {
+                std::error_code ec;
+                std::filesystem::create_directories(GetConfigPath().parent_path(), ec);
+                std::ofstream file(GetConfigPath(), std::ios::binary | std::ios::trunc);
+                file << text;
+                return file.good();
+            }
+
+            // Saves on destruction, so the file is removed only once the manager is gone
+            struct ConfigSetup
+            {
+                std::unique_ptr<ConfigurationManager> manager;
+
+                ~ConfigSetup()
+                {
+                    manager.reset();
+                    std::error_code ec;
+                    std::filesystem::remove(GetConfigPath(), ec);
+                }
+            };
+
+            size_t GetSectionCount(const BenchState &state)
+            {
+                return std::max<size_t>(static_cast<size_t>(state.Param("keys")) / KeysPerSection, 1);
+            }
+
+            void Parse(BenchState &state)
+            {
+                std::string text = MakeConfigText(GetSectionCount(state), KeysPerSection, 83);
+                ConfigSetup setup;
+                bool parsed = true;
+                state.MeasureEach([&]
+                                  {
+                                      // Rewritten each time, since the previous manager saved its own version
+                                      setup.manager.reset();
+                                      WriteConfig(text);
+                                      setup.manager = std::make_unique<ConfigurationManager>();
+                                  },
+                                  [&]
+                                  { parsed = setup.manager->Initialize() && parsed; });
+                state.SetItemsPerOperation(static_cast<double>(GetSectionCount(state) * KeysPerSection));
+                state.SetBytesPerOperation(static_cast<double>(text.size()));
+                if (!parsed)
+                {
+                    state.Skip("the configuration did not parse");
+                }
+            }
+
+            void Get(BenchState &state)
+            {
+                size_t sections = GetSectionCount(state);
+                ConfigSetup setup;
+                setup.manager = std::make_unique<ConfigurationManager>();
+                if (!WriteConfig(MakeConfigText(sections, KeysPerSection, 89)) || !setup.manager->Initialize())
+                {
+                    state.Skip("cannot load the configuration");
+                    return;
+                }
+
+                // Misses name keys the file does not have, which then fall back to their defaults
+                Random random(97);
+                bool hit = state.Param("hit") != 0;
+                std::vector<std::pair<std::string, std::string>> corpus;
+                corpus.reserve(CorpusSize);
+                for (size_t i = 0; i < CorpusSize; ++i)
+                {
+                    std::string section = "Section" + std::to_string(random.Below(sections));
+                    std::string key = "Key" + std::to_string(random.Below(KeysPerSection) + (hit ? 0 : KeysPerSection));
+                    corpus.emplace_back(std::move(section), std::move(key));
+                }
+
+                size_t next = 0;
+                state.Measure([&]
+                              {
+                                  const auto &entry = corpus[next++ & CorpusMask];
+                                  KeepResult(setup.manager->GetString(entry.first, entry.second, "").size());
+                              });
+            }
+
+            // The typed reads the components make while they initialize
+            bool LoadDefaults(BenchState &state, ConfigSetup &setup)
+            {
+                setup.manager = std::make_unique<ConfigurationManager>();
+                if (!WriteConfig(MakeConfigText(0, 0, 101)) || !setup.manager->Initialize())
+                {
+                    state.Skip("cannot load the configuration");
+                    return false;
+                }
+                return true;
+            }
+
+            void GetBool(BenchState &state)
+            {
+                ConfigSetup setup;
+                if (!LoadDefaults(state, setup))
+                {
+                    return;
+                }
+
+                const std::string section = "Settings";
+                const std::string keys[] = {"EnableDirectoryIndex", "MountArchives", "ScanPlugins", "CheckLoadOrder",
+                                            "DeployMode", "WatchDirectories", "AutoDetectPaths", "EnableLogging"};
+                size_t next = 0;
+                state.Measure([&]
+                              { KeepResult(setup.manager->GetBool(section, keys[next++ % std::size(keys)], false)); });
+            }
+
+            void GetInt(BenchState &state)
+            {
+                ConfigSetup setup;
+                if (!LoadDefaults(state, setup))
+                {
+                    return;
+                }
+
+                const std::string section = "Settings";
+                const std::string keys[] = {"LogLevel", "MetadataCacheTTLMs", "BatchWorkerThreads"};
+                size_t next = 0;
+                state.Measure([&]
+                              { KeepResult(setup.manager->GetInt(section, keys[next++ % std::size(keys)], 0)); });
+            }
+        }
+
+        void RegisterConfigBenchmarks(BenchRegistry &registry)
+        {
+            registry.AddGrid("config/parse", {{"keys", {16, 1024, 16384}}}, Parse);
+            registry.AddGrid("config/get", {{"keys", {16, 1024}}, {"hit", {0, 1}}}, Get);
+            registry.Add("config/get_bool", {}, GetBool);
+            registry.Add("config/get_int", {}, GetInt);
+        }
+    }
+
+} // namespace ObseGPCompat
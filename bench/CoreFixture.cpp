@@ -0,0 +1,72 @@
+#include "CoreFixture.h"
+#include "ObseGPCompat.h"
+#include "ConfigurationManager.h"
+#include "MappingRegistry.h"
+#include "PathTranslator.h"
+#include "VirtualFileSystem.h"
+
+#include <system_error>
+
+namespace ObseGPCompat
+{
+
+    namespace Bench
+    {
+
+        CoreFixture::~CoreFixture()
+        {
+            // Same order as Shutdown
+            g_VirtualFileSystem.reset();
+            g_PathTranslator.reset();
+            g_MappingRegistry.reset();
+            g_ConfigurationManager.reset();
+
+            g_GamePassInstallPath.clear();
+            g_ObsePath.clear();
+        }
+
+        bool CoreFixture::Start(const SyntheticInstall &install, const CoreOptions &options)
+        {
+            g_GamePassInstallPath = install.GetInstallPath();
+            g_ObsePath = install.GetObsePath();
+
+            // Start from the defaults rather than whatever an earlier case saved
+            std::error_code ec;
+            std::filesystem::remove(GetLocalAppDataPath() / "OBSE64GP" / "config.ini", ec);
+
+            g_ConfigurationManager = std::make_unique<ConfigurationManager>();
+            if (!g_ConfigurationManager->Initialize())
+            {
+                return false;
+            }
+            g_ConfigurationManager->SetBool("Settings", "EnableDirectoryIndex", options.directoryIndex);
+            g_ConfigurationManager->SetBool("Settings", "MountArchives", options.mountArchives);
+            g_ConfigurationManager->SetBool("Settings", "ScanPlugins", options.scanPlugins);
+            g_ConfigurationManager->SetBool("Settings", "CheckLoadOrder", options.checkLoadOrder);
+            g_ConfigurationManager->SetBool("Settings", "WatchDirectories", options.watchDirectories);
+
+            g_MappingRegistry = std::make_unique<MappingRegistry>();
+            if (!g_MappingRegistry->Initialize())
+            {
+                return false;
+            }
+
+            g_PathTranslator = std::make_unique<PathTranslator>();
+            if (!g_PathTranslator->Initialize())
+            {
+                return false;
+            }
+
+            if (options.virtualFileSystem)
+            {
+                g_VirtualFileSystem = std::make_unique<VirtualFileSystem>();
+                if (!g_VirtualFileSystem->Initialize())
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+    }
+
+} // namespace ObseGPCompat
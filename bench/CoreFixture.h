@@ -0,0 +1,36 @@
+#pragma once
+
+#include "SyntheticInstall.h"
+
+namespace ObseGPCompat
+{
+
+    namespace Bench
+    {
+        // Settings the benchmarks change; everything else keeps its default
+        struct CoreOptions
+        {
+            bool virtualFileSystem = true; // Otherwise only configuration, mappings and translator
+            bool directoryIndex = true;
+            bool mountArchives = false;
+            bool scanPlugins = false;
+            bool checkLoadOrder = false;
+            bool watchDirectories = false;
+        };
+
+        // The globals Initialize in main.cpp creates, pointed at a synthetic install instead
+        // of a real one. Only one may exist at a time; the destructor resets the globals.
+        class CoreFixture
+        {
+        public:
+            CoreFixture() = default;
+            ~CoreFixture();
+
+            CoreFixture(const CoreFixture &) = delete;
+            CoreFixture &operator=(const CoreFixture &) = delete;
+
+            bool Start(const SyntheticInstall &install, const CoreOptions &options = CoreOptions());
+        };
+    }
+
+} // namespace ObseGPCompat
@@ -0,0 +1,213 @@
+#include "Benchmarks.h"
+#include "CoreFixture.h"
+#include "ObseGPCompat.h"
+#include "VirtualFileSystem.h"
+
+#include <map>
+#include <set>
+#include <system_error>
+
+namespace ObseGPCompat
+{
+
+    namespace Bench
+    {
+
+        namespace
+        {
+            constexpr size_t CorpusSize = 8192;
+            constexpr size_t CorpusMask = CorpusSize - 1;
+
+            // Read-only cases share one install per size rather than generating it each time
+            const SyntheticInstall *GetSharedInstall(const BenchState &state, size_t files)
+            {
+                static std::map<size_t, SyntheticInstall> installs;
+                auto it = installs.find(files);
+                if (it != installs.end())
+                {
+                    return &it->second;
+                }
+
+                InstallShape shape;
+                shape.dataFiles = files;
+                SyntheticInstall install;
+                if (!install.Create(state.SharedDirectory() / ("install" + std::to_string(files)), shape))
+                {
+                    return nullptr;
+                }
+                return &installs.emplace(files, std::move(install)).first->second;
+            }
+
+            // Virtual paths of the install's files, or of missing files next to them
+            std::vector<std::filesystem::path> MakeVirtualPaths(const SyntheticInstall &install, bool existing, uint64_t seed)
+            {
+                Random random(seed);
+                const auto &files = install.GetDataFiles();
+                std::vector<std::filesystem::path> paths;
+                paths.reserve(CorpusSize);
+                for (size_t i = 0; i < CorpusSize && !files.empty(); ++i)
+                {
+                    std::filesystem::path path = install.GetObsePath() / "Data" / files[random.Below(files.size())];
+                    if (!existing)
+                    {
+                        path.replace_extension(".bak");
+                    }
+                    paths.push_back(std::move(path));
+                }
+                return paths;
+            }
+
+            // A fixture over the shared install; false (and the case skipped) when it cannot be built
+            bool StartShared(BenchState &state, CoreFixture &core, const SyntheticInstall *&install, const CoreOptions &options)
+            {
+                install = GetSharedInstall(state, static_cast<size_t>(state.Param("files")));
+                if (!install || !core.Start(*install, options))
+                {
+                    state.Skip("cannot set up the virtual file system");
+                    return false;
+                }
+                return true;
+            }
+
+            void Exists(BenchState &state)
+            {
+                CoreOptions options;
+                options.directoryIndex = state.Param("index") != 0;
+                CoreFixture core;
+                const SyntheticInstall *install = nullptr;
+                if (!StartShared(state, core, install, options))
+                {
+                    return;
+                }
+
+                std::vector<std::filesystem::path> corpus = MakeVirtualPaths(*install, state.Param("hit") != 0, 41);
+                size_t next = 0;
+                state.Measure([&]
+                              { KeepResult(g_VirtualFileSystem->FileExists(corpus[next++ & CorpusMask])); });
+            }
+
+            void Metadata(BenchState &state)
+            {
+                CoreFixture core;
+                const SyntheticInstall *install = nullptr;
+                if (!StartShared(state, core, install, CoreOptions()))
+                {
+                    return;
+                }
+
+                std::vector<std::filesystem::path> corpus = MakeVirtualPaths(*install, state.Param("hit") != 0, 43);
+                FileMetadata metadata = {};
+                size_t next = 0;
+                state.Measure([&]
+                              { KeepResult(g_VirtualFileSystem->GetFileMetadata(corpus[next++ & CorpusMask], metadata)); });
+            }
+
+            void ListDirectory(BenchState &state)
+            {
+                CoreFixture core;
+                const SyntheticInstall *install = nullptr;
+                if (!StartShared(state, core, install, CoreOptions()))
+                {
+                    return;
+                }
+
+                std::set<std::filesystem::path> folders;
+                for (const auto &file : install->GetDataFiles())
+                {
+                    folders.insert(install->GetObsePath() / "Data" / file.parent_path());
+                }
+                std::vector<std::filesystem::path> corpus(folders.begin(), folders.end());
+
+                size_t next = 0;
+                size_t names = 0;
+                state.Measure([&]
+                              { names += g_VirtualFileSystem->ListDirectory(corpus[next++ % corpus.size()]).size(); });
+                state.SetCounter("names_per_listing", next ? static_cast<double>(names) / static_cast<double>(next) : 0.0);
+            }
+
+            void TranslateToReal(BenchState &state)
+            {
+                CoreFixture core;
+                const SyntheticInstall *install = nullptr;
+                if (!StartShared(state, core, install, CoreOptions()))
+                {
+                    return;
+                }
+
+                std::vector<std::filesystem::path> corpus = MakeVirtualPaths(*install, true, 47);
+                size_t next = 0;
+                state.Measure([&]
+                              { KeepResult(g_VirtualFileSystem->TranslateToReal(corpus[next++ & CorpusMask]).native().size()); });
+            }
+
+            // Staging a profile's worth of small plugin files into Data, one call at a time or as
+            // one batch on the worker pool
+            void Stage(BenchState &state)
+            {
+                size_t files = static_cast<size_t>(state.Param("files"));
+                InstallShape shape;
+                shape.dataFiles = 0;
+                SyntheticInstall install;
+                CoreFixture core;
+                if (!install.Create(state.WorkDirectory(), shape) || !core.Start(install))
+                {
+                    state.Skip("cannot set up the virtual file system");
+                    return;
+                }
+
+                // The sources sit outside every mapping, so they pass through untranslated
+                std::filesystem::path source = state.WorkDirectory() / "Profile";
+                std::error_code ec;
+                std::filesystem::create_directories(source, ec);
+                std::vector<FileOperation> operations;
+                operations.reserve(files);
+                for (size_t i = 0; i < files; ++i)
+                {
+                    std::string name = "plugin" + std::to_string(i) + ".esp";
+                    if (!WriteFile(source / name, 2048, i + 1))
+                    {
+                        state.Skip("cannot write the source files");
+                        return;
+                    }
+                    operations.push_back({FileOperationType::Copy, source / name, install.GetObsePath() / "Data" / "Staged" / name, true});
+                }
+                g_VirtualFileSystem->CreateDirectory(install.GetObsePath() / "Data" / "Staged");
+
+                bool batched = state.Param("batched") != 0;
+                size_t failed = 0;
+                state.SetRepetitions(1);
+                state.MeasureEach([] {},
+                                  [&]
+                                  {
+                                      if (batched)
+                                      {
+                                          for (const FileOperationResult &result : g_VirtualFileSystem->SubmitBatch(operations).get())
+                                          {
+                                              failed += result.success ? 0 : 1;
+                                          }
+                                          return;
+                                      }
+                                      for (const FileOperation &operation : operations)
+                                      {
+                                          failed += g_VirtualFileSystem->CopyFile(operation.path, operation.destination, true) ? 0 : 1;
+                                      }
+                                  });
+                state.SetItemsPerOperation(static_cast<double>(files));
+                if (failed)
+                {
+                    state.Skip(std::to_string(failed) + " copies failed");
+                }
+            }
+        }
+
+        void RegisterFileSystemBenchmarks(BenchRegistry &registry)
+        {
+            registry.AddGrid("vfs/exists", {{"files", {1000, 20000}}, {"index", {0, 1}}, {"hit", {0, 1}}}, Exists);
+            registry.AddGrid("vfs/metadata", {{"files", {20000}}, {"hit", {0, 1}}}, Metadata);
+            registry.AddGrid("vfs/list", {{"files", {20000}}}, ListDirectory);
+            registry.AddGrid("vfs/translate", {{"files", {20000}}}, TranslateToReal);
+            registry.AddGrid("vfs/stage", {{"files", {1000, 10000}}, {"batched", {0, 1}}}, Stage);
+        }
+    }
+
+} // namespace ObseGPCompat
@@ -0,0 +1,129 @@
+#include "Benchmarks.h"
+#include "SyntheticInstall.h"
+#include "ObseGPCompat.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace ObseGPCompat
+{
+
+    namespace Bench
+    {
+
+        namespace
+        {
+            // Keeps the log file open for one case; without it Log only reaches stdout
+            struct LogFileSetup
+            {
+                bool open = false;
+
+                bool Start(BenchState &state)
+                {
+                    if (state.Param("file") == 0)
+                    {
+                        return true;
+                    }
+                    open = OpenLogFile(state.WorkDirectory() / "compat_layer.log");
+                    if (!open)
+                    {
+                        state.Skip("cannot open the log file");
+                    }
+                    return open;
+                }
+
+                ~LogFileSetup()
+                {
+                    if (open)
+                    {
+                        CloseLogFile();
+                    }
+                }
+            };
+
+            // Other threads logging the same message flat out while this one is timed
+            class BackgroundLoggers
+            {
+            public:
+                BackgroundLoggers(size_t count, const std::string &message) : m_Stop(false)
+                {
+                    for (size_t i = 0; i < count; ++i)
+                    {
+                        m_Threads.emplace_back([this, &message]
+                                               {
+                                                   while (!m_Stop.load(std::memory_order_relaxed))
+                                                   {
+                                                       Log(LogLevel::Info, "%s", message.c_str());
+                                                   }
+                                               });
+                    }
+                }
+
+                ~BackgroundLoggers()
+                {
+                    m_Stop = true;
+                    for (std::thread &thread : m_Threads)
+                    {
+                        thread.join();
+                    }
+                }
+
+            private:
+                std::atomic<bool> m_Stop;
+                std::vector<std::thread> m_Threads;
+            };
+
+            // The line the translation hooks write for every hit
+            void LogTranslation(BenchState &state)
+            {
+                LogFileSetup file;
+                if (!file.Start(state))
+                {
+                    return;
+                }
+
+                Random random(103);
+                std::string from = "C:\\Games\\Oblivion Remastered\\OblivionRemastered\\Binaries\\Win64\\Data\\meshes\\" +
+                                   random.Word() + "\\" + random.Word() + ".nif";
+                std::string to = "C:\\XboxGames\\The Elder Scrolls IV- Oblivion Remastered\\Content\\OblivionRemastered\\Content\\Dev\\ObvData\\data\\meshes\\" +
+                                 random.Word() + "\\" + random.Word() + ".nif";
+                std::string background = "Translated OBSE path '" + from + "' to Game Pass path '" + to + "'";
+
+                BackgroundLoggers others(static_cast<size_t>(state.Param("threads")) - 1, background);
+                state.Measure([&]
+                              { Log(LogLevel::Debug, "Translated OBSE path '%s' to Game Pass path '%s'", from.c_str(), to.c_str()); });
+            }
+
+            // Longer messages, up to the 4 KB Log formats into
+            void LogSize(BenchState &state)
+            {
+                LogFileSetup file;
+                if (!file.Start(state))
+                {
+                    return;
+                }
+
+                size_t bytes = static_cast<size_t>(state.Param("message_bytes"));
+                Random random(107);
+                std::string message;
+                while (message.size() < bytes)
+                {
+                    message += random.Word() + ' ';
+                }
+                message.resize(bytes);
+
+                state.Measure([&]
+                              { Log(LogLevel::Info, "%s", message.c_str()); });
+                state.SetBytesPerOperation(static_cast<double>(bytes));
+            }
+        }
+
+        void RegisterLogBenchmarks(BenchRegistry &registry)
+        {
+            registry.AddGrid("log/translation", {{"threads", {1, 4}}, {"file", {0, 1}}}, LogTranslation);
+            registry.AddGrid("log/size", {{"message_bytes", {64, 1024, 4000}}, {"file", {1}}}, LogSize);
+        }
+    }
+
+} // namespace ObseGPCompat
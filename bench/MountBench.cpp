@@ -0,0 +1,173 @@
+#include "Benchmarks.h"
+#include "CoreFixture.h"
+#include "ObseGPCompat.h"
+#include "BsaArchive.h"
+#include "MappingRegistry.h"
+#include "PathTranslator.h"
+
+#include <cctype>
+#include <map>
+
+namespace ObseGPCompat
+{
+
+    namespace Bench
+    {
+
+        namespace
+        {
+            constexpr size_t CorpusSize = 8192;
+            constexpr size_t CorpusMask = CorpusSize - 1;
+
+            // Archives keep about as many files per folder as the game's own
+            constexpr size_t ArchiveFilesPerFolder = 100;
+
+            void OpenArchive(BenchState &state)
+            {
+                size_t entries = static_cast<size_t>(state.Param("entries"));
+                std::filesystem::path path = state.WorkDirectory() / "Synthetic.bsa";
+                if (!WriteArchive(path, entries, ArchiveFilesPerFolder, 53))
+                {
+                    state.Skip("cannot write the archive");
+                    return;
+                }
+
+                BsaArchive archive;
+                state.MeasureEach([] {},
+                                  [&]
+                                  { KeepResult(archive.Open(path)); });
+                state.SetItemsPerOperation(static_cast<double>(entries));
+                state.SetCounter("files", static_cast<double>(archive.FileCount()));
+            }
+
+            void FindInArchive(BenchState &state)
+            {
+                size_t entries = static_cast<size_t>(state.Param("entries"));
+                std::filesystem::path path = state.WorkDirectory() / "Synthetic.bsa";
+                std::vector<std::string> names;
+                BsaArchive archive;
+                if (!WriteArchive(path, entries, ArchiveFilesPerFolder, 59, &names) || !archive.Open(path))
+                {
+                    state.Skip("cannot write the archive");
+                    return;
+                }
+
+                // Lookups come with either separator and any case; misses are loose-file spellings
+                Random random(61);
+                bool hit = state.Param("hit") != 0;
+                std::vector<std::string> corpus;
+                corpus.reserve(CorpusSize);
+                for (size_t i = 0; i < CorpusSize; ++i)
+                {
+                    std::string name = names[random.Below(names.size())];
+                    for (char &c : name)
+                    {
+                        c = c == '\\' ? '/' : (random.Below(4) == 0 ? static_cast<char>(std::toupper(static_cast<unsigned char>(c))) : c);
+                    }
+                    corpus.push_back(hit ? name : name + ".bak");
+                }
+
+                size_t next = 0;
+                state.Measure([&]
+                              { KeepResult(archive.FindFile(corpus[next++ & CorpusMask])); });
+            }
+
+            // Mod-manager style layers over Data, with part of each layer's files also in others
+            struct OverlaySetup
+            {
+                SyntheticInstall install;
+                CoreFixture core;
+                std::vector<OverlayLayer> layers;
+                std::vector<std::string> names;
+
+                bool Start(BenchState &state)
+                {
+                    size_t layerCount = static_cast<size_t>(state.Param("layers"));
+                    size_t files = static_cast<size_t>(state.Param("files"));
+                    InstallShape shape;
+                    shape.dataFiles = 0;
+                    CoreOptions options;
+                    options.virtualFileSystem = false;
+                    if (!install.Create(state.WorkDirectory(), shape) || !core.Start(install, options))
+                    {
+                        state.Skip("cannot set up the mappings");
+                        return false;
+                    }
+
+                    // The layers are only read, so cases with the same shape share them
+                    static std::map<std::pair<size_t, size_t>, std::pair<std::vector<OverlayLayer>, std::vector<std::string>>> shared;
+                    auto key = std::make_pair(layerCount, files);
+                    auto it = shared.find(key);
+                    if (it == shared.end())
+                    {
+                        std::filesystem::path root = state.SharedDirectory() / ("overlay" + std::to_string(layerCount) + "x" + std::to_string(files));
+                        std::vector<std::string> created;
+                        auto createdLayers = CreateOverlayLayers(root, layerCount, files / layerCount, 20, 67, &created);
+                        it = shared.emplace(key, std::make_pair(std::move(createdLayers), std::move(created))).first;
+                    }
+                    layers = it->second.first;
+                    names = it->second.second;
+                    if (names.empty())
+                    {
+                        state.Skip("cannot create the layers");
+                        return false;
+                    }
+                    return true;
+                }
+            };
+
+            void MountOverlay(BenchState &state)
+            {
+                OverlaySetup setup;
+                if (!setup.Start(state))
+                {
+                    return;
+                }
+
+                // Mounting again at the same point replaces the previous overlay
+                std::filesystem::path mountPoint = setup.install.GetObsePath() / "Data";
+                state.MeasureEach([] {},
+                                  [&]
+                                  { g_MappingRegistry->MountOverlay(mountPoint, setup.layers); });
+                state.SetItemsPerOperation(static_cast<double>(state.Param("files")));
+            }
+
+            void TranslateOverlay(BenchState &state)
+            {
+                OverlaySetup setup;
+                if (!setup.Start(state))
+                {
+                    return;
+                }
+
+                std::filesystem::path mountPoint = setup.install.GetObsePath() / "Data";
+                g_MappingRegistry->MountOverlay(mountPoint, setup.layers);
+
+                Random random(71);
+                std::vector<std::string> corpus;
+                corpus.reserve(CorpusSize);
+                for (size_t i = 0; i < CorpusSize; ++i)
+                {
+                    corpus.push_back((mountPoint / setup.names[random.Below(setup.names.size())]).string());
+                }
+
+                std::vector<char> buffer(PathTranslator::MaxPathLength);
+                size_t next = 0;
+                state.Measure([&]
+                              {
+                                  const std::string &path = corpus[next++ & CorpusMask];
+                                  KeepResult(g_PathTranslator->TryTranslate(std::string_view(path), buffer.data(), buffer.size()));
+                              });
+            }
+        }
+
+        void RegisterMountBenchmarks(BenchRegistry &registry)
+        {
+            registry.AddGrid("bsa/open", {{"entries", {1000, 100000}}}, OpenArchive);
+            registry.AddGrid("bsa/find", {{"entries", {1000, 100000}}, {"hit", {0, 1}}}, FindInArchive);
+            registry.AddGrid("overlay/mount", {{"layers", {20, 200}}, {"files", {50000}}}, MountOverlay);
+            registry.AddGrid("overlay/translate", {{"layers", {20, 200}}, {"files", {50000}}}, TranslateOverlay);
+        }
+    }
+
+} // namespace ObseGPCompat
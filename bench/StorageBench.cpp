@@ -0,0 +1,222 @@
+#include "Benchmarks.h"
+#include "CoreFixture.h"
+#include "ObseGPCompat.h"
+#include "ContentStore.h"
+#include "CopyEngine.h"
+#include "LinkDeployer.h"
+#include "MappingRegistry.h"
+
+#include <memory>
+#include <string>
+#include <system_error>
+
+namespace ObseGPCompat
+{
+
+    namespace Bench
+    {
+
+        namespace
+        {
+            void CopySingleFile(BenchState &state)
+            {
+                uint64_t bytes = static_cast<uint64_t>(state.Param("size_kb")) * 1024;
+                std::filesystem::path source = state.WorkDirectory() / "source.bin";
+                std::filesystem::path destination = state.WorkDirectory() / "destination.bin";
+                if (!WriteFile(source, static_cast<size_t>(bytes), 73))
+                {
+                    state.Skip("cannot write the source file");
+                    return;
+                }
+
+                CopyEngine engine;
+                CopyResult result = {};
+                size_t failed = 0;
+                state.MeasureEach([] {},
+                                  [&]
+                                  {
+                                      result = engine.Copy(source, destination, true);
+                                      failed += result.success ? 0 : 1;
+                                  });
+                state.SetBytesPerOperation(static_cast<double>(bytes));
+                state.SetCounter("block_clone", result.method == CopyMethod::BlockClone ? 1.0 : 0.0);
+                if (failed)
+                {
+                    // A failed copy returns early, so its time says nothing about copying
+                    state.Skip(std::to_string(failed) + " copies failed");
+                }
+            }
+
+            // Importing a profile into a fresh store, where some files are copies of others
+            void ImportFiles(BenchState &state)
+            {
+                size_t files = static_cast<size_t>(state.Param("files"));
+                size_t duplicatePercent = static_cast<size_t>(state.Param("duplicate_percent"));
+                std::filesystem::path source = state.WorkDirectory() / "Profile";
+                std::error_code ec;
+                std::filesystem::create_directories(source, ec);
+
+                // Duplicates reuse the content seed of one of a few originals
+                Random random(79);
+                std::vector<std::filesystem::path> paths;
+                for (size_t i = 0; i < files; ++i)
+                {
+                    uint64_t seed = random.Below(100) < duplicatePercent ? 1 + random.Below(16) : 1000 + i;
+                    std::filesystem::path path = source / ("asset" + std::to_string(i) + ".dds");
+                    if (!WriteFile(path, 64 * 1024, seed))
+                    {
+                        state.Skip("cannot write the source files");
+                        return;
+                    }
+                    paths.push_back(std::move(path));
+                }
+
+                std::filesystem::path root = state.WorkDirectory() / "Store";
+                std::unique_ptr<ContentStore> store;
+                size_t failed = 0;
+                state.MeasureEach([&]
+                                  {
+                                      store.reset();
+                                      std::filesystem::remove_all(root, ec);
+                                      store = std::make_unique<ContentStore>();
+                                      store->Initialize(root);
+                                  },
+                                  [&]
+                                  {
+                                      ContentId id = {};
+                                      for (const auto &path : paths)
+                                      {
+                                          failed += store->Add(path, id) ? 0 : 1;
+                                      }
+                                  });
+
+                ContentStoreStats stats = store->GetStats();
+                state.SetItemsPerOperation(static_cast<double>(files));
+                state.SetBytesPerOperation(static_cast<double>(files) * 64 * 1024);
+                state.SetCounter("stored", static_cast<double>(stats.stored));
+                state.SetCounter("deduplicated", static_cast<double>(stats.deduplicated));
+                if (failed)
+                {
+                    state.Skip(std::to_string(failed) + " files were not stored");
+                }
+            }
+
+            struct DeploySetup
+            {
+                SyntheticInstall install;
+                CoreFixture core;
+
+                bool Start(BenchState &state)
+                {
+                    InstallShape shape;
+                    shape.dataFiles = static_cast<size_t>(state.Param("files"));
+                    CoreOptions options;
+                    options.virtualFileSystem = false;
+                    if (!install.Create(state.WorkDirectory(), shape) || !core.Start(install, options))
+                    {
+                        state.Skip("cannot set up the install");
+                        return false;
+                    }
+                    return true;
+                }
+
+                // What DeployLinks does before each launch
+                DeployStats Deploy(LinkDeployer &deployer)
+                {
+                    MappingRegistry::Reader mappings(*g_MappingRegistry);
+                    return deployer.Apply(deployer.Plan(*mappings));
+                }
+            };
+
+            // Counters of the last deploy; failed counts every timed one, since a link that
+            // could not be made costs far less than one that was
+            void SetDeployCounters(BenchState &state, const DeployStats &stats, size_t failed)
+            {
+                state.SetCounter("added", static_cast<double>(stats.added));
+                state.SetCounter("updated", static_cast<double>(stats.updated));
+                state.SetCounter("unchanged", static_cast<double>(stats.unchanged));
+                if (failed)
+                {
+                    state.Skip(std::to_string(failed) + " links failed");
+                }
+            }
+
+            // Every link created from nothing
+            void DeployCold(BenchState &state)
+            {
+                DeploySetup setup;
+                if (!setup.Start(state))
+                {
+                    return;
+                }
+
+                std::unique_ptr<LinkDeployer> deployer;
+                DeployStats stats = {};
+                size_t failed = 0;
+                std::error_code ec;
+                state.MeasureEach([&]
+                                  {
+                                      std::filesystem::remove_all(setup.install.GetObsePath(), ec);
+                                      deployer = std::make_unique<LinkDeployer>();
+                                  },
+                                  [&]
+                                  {
+                                      stats = setup.Deploy(*deployer);
+                                      failed += stats.failed;
+                                  });
+                state.SetItemsPerOperation(static_cast<double>(state.Param("files")));
+                SetDeployCounters(state, stats, failed);
+            }
+
+            // The next launch, after a few files changed
+            void DeployIncremental(BenchState &state)
+            {
+                DeploySetup setup;
+                if (!setup.Start(state))
+                {
+                    return;
+                }
+
+                LinkDeployer deployer;
+                size_t failed = setup.Deploy(deployer).failed;
+
+                const auto &files = setup.install.GetDataFiles();
+                size_t changed = files.size() * static_cast<size_t>(state.Param("changed_percent")) / 100;
+                uint64_t generation = 0;
+                DeployStats stats = {};
+                std::error_code ec;
+                state.MeasureEach([&]
+                                  {
+                                      // Replaced the way mod managers install files: written beside, renamed over
+                                      ++generation;
+                                      for (size_t i = 0; i < changed; ++i)
+                                      {
+                                          std::filesystem::path path = setup.install.GetDataPath() / files[i];
+                                          std::filesystem::path temporary = path;
+                                          temporary += ".new";
+                                          WriteFile(temporary, static_cast<size_t>(generation % 2 + 1), generation);
+                                          std::filesystem::rename(temporary, path, ec);
+                                      }
+                                  },
+                                  [&]
+                                  {
+                                      stats = setup.Deploy(deployer);
+                                      failed += stats.failed;
+                                  });
+                state.SetItemsPerOperation(static_cast<double>(files.size()));
+                SetDeployCounters(state, stats, failed);
+            }
+        }
+
+        void RegisterStorageBenchmarks(BenchRegistry &registry)
+        {
+            registry.AddGrid("copy/file", {{"size_kb", {4, 1024, 65536}}}, CopySingleFile);
+            registry.Add("copy/file", {{"size_kb", 1024 * 1024}}, CopySingleFile, true);
+            registry.Add("copy/file", {{"size_kb", 4 * 1024 * 1024}}, CopySingleFile, true);
+            registry.AddGrid("dedup/import", {{"files", {2000}}, {"duplicate_percent", {0, 50, 90}}}, ImportFiles);
+            registry.AddGrid("deploy/cold", {{"files", {5000, 50000}}}, DeployCold);
+            registry.AddGrid("deploy/incremental", {{"files", {5000, 50000}}, {"changed_percent", {0, 1}}}, DeployIncremental);
+        }
+    }
+
+} // namespace ObseGPCompat
@@ -0,0 +1,406 @@
+#include "SyntheticInstall.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <system_error>
+#include <unordered_set>
+
+namespace ObseGPCompat
+{
+
+    namespace Bench
+    {
+
+        namespace
+        {
+            const char *const Syllables[] = {
+                "ar", "bel", "cor", "dra", "el", "fen", "gor", "hal", "is", "jor", "kel", "lor", "mar",
+                "nor", "or", "pel", "quin", "ros", "sil", "tor", "ul", "vel", "wen", "yr", "zan"};
+
+            // The folders the game's own data uses; generated files are spread over them
+            const char *const DataFolders[] = {
+                "meshes", "textures", "sound", "music", "menus", "shaders", "trees", "distantlod"};
+
+            const char *const DataExtensions[] = {".nif", ".dds", ".wav", ".mp3", ".xml", ".kf", ".spt", ".lod"};
+
+            // Directories outside any mapping that games and their libraries probe all the time
+            const char *const UnrelatedRoots[] = {
+                "Windows/System32",
+                "Windows/WinSxS/amd64_microsoft.windows.common-controls",
+                "Program Files/Common Files/microsoft shared",
+                "Users/Player/AppData/Local/Temp",
+                "Users/Player/Documents/My Games/Oblivion Remastered",
+                "ProgramData/Microsoft/Windows/Caches"};
+
+            // Game Pass layout below the install root, as MappingRegistry maps it
+            std::filesystem::path GetContentPath(const std::filesystem::path &installPath)
+            {
+                return installPath / "Content" / "OblivionRemastered";
+            }
+
+            std::filesystem::path MakeFolders(Random &random, size_t depth)
+            {
+                std::filesystem::path folders;
+                for (size_t i = 0; i < depth; ++i)
+                {
+                    folders /= random.Word();
+                }
+                return folders;
+            }
+
+            std::string MakeFileName(Random &random)
+            {
+                return random.Word() + "_" + random.Word() + std::to_string(random.Below(100)) +
+                       DataExtensions[random.Below(std::size(DataExtensions))];
+            }
+
+            template <typename T>
+            void Append(std::string &out, const T &value)
+            {
+                out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+            }
+        }
+
+        uint64_t Random::Next()
+        {
+            uint64_t z = (m_State += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        }
+
+        std::string Random::Word()
+        {
+            std::string word;
+            size_t syllables = 2 + Below(3);
+            for (size_t i = 0; i < syllables; ++i)
+            {
+                word += Syllables[Below(std::size(Syllables))];
+            }
+            return word;
+        }
+
+        bool WriteFile(const std::filesystem::path &path, size_t size, uint64_t seed)
+        {
+            std::ofstream file(path, std::ios::binary | std::ios::trunc);
+            if (!file.is_open())
+            {
+                return false;
+            }
+
+            // One random block repeated; enough that no two seeds produce the same file
+            Random random(seed);
+            std::vector<uint64_t> block(std::min<size_t>(8192, (size + 7) / 8));
+            for (uint64_t &word : block)
+            {
+                word = random.Next();
+            }
+
+            size_t blockBytes = block.size() * sizeof(uint64_t);
+            for (size_t written = 0; written < size; written += blockBytes)
+            {
+                size_t chunk = std::min(blockBytes, size - written);
+                file.write(reinterpret_cast<const char *>(block.data()), static_cast<std::streamsize>(chunk));
+            }
+            return file.good();
+        }
+
+        bool SyntheticInstall::Create(const std::filesystem::path &root, const InstallShape &shape, uint64_t seed)
+        {
+            m_InstallPath = root / "XboxGames" / "The Elder Scrolls IV- Oblivion Remastered";
+            m_ObsePath = root / "Steam" / "steamapps" / "common" / "Oblivion Remastered" / "OblivionRemastered" /
+                         "Binaries" / "Win64";
+            m_DataFiles.clear();
+
+            std::filesystem::path content = GetContentPath(m_InstallPath);
+            std::error_code ec;
+            std::filesystem::create_directories(content / "Binaries" / "WinGDK", ec);
+            std::filesystem::create_directories(GetPluginsPath(), ec);
+            std::filesystem::create_directories(GetDataPath(), ec);
+            if (ec)
+            {
+                return false;
+            }
+
+            Random random(seed);
+            uint64_t fileSeed = seed;
+
+            // Fill folders of filesPerFolder files each, below one of the game's top-level folders
+            size_t perFolder = shape.filesPerFolder ? shape.filesPerFolder : 1;
+            m_DataFiles.reserve(shape.dataFiles);
+            std::unordered_set<std::string> used;
+            while (m_DataFiles.size() < shape.dataFiles)
+            {
+                std::filesystem::path folder = DataFolders[random.Below(std::size(DataFolders))];
+                if (shape.depth > 1)
+                {
+                    folder /= MakeFolders(random, shape.depth - 1);
+                }
+                std::filesystem::create_directories(GetDataPath() / folder, ec);
+                if (ec)
+                {
+                    return false;
+                }
+
+                for (size_t i = 0; i < perFolder && m_DataFiles.size() < shape.dataFiles; ++i)
+                {
+                    std::filesystem::path relative = folder / MakeFileName(random);
+                    if (!used.insert(relative.string()).second)
+                    {
+                        continue;
+                    }
+                    if (!WriteFile(GetDataPath() / relative, shape.fileSize, ++fileSeed))
+                    {
+                        return false;
+                    }
+                    m_DataFiles.push_back(std::move(relative));
+                }
+            }
+
+            for (size_t i = 0; i < shape.plugins; ++i)
+            {
+                std::string name = random.Word() + std::to_string(i) + (i % 8 ? ".esp" : ".esm");
+                if (!WriteFile(GetDataPath() / name, shape.fileSize, ++fileSeed))
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        std::filesystem::path SyntheticInstall::GetDataPath() const
+        {
+            return GetContentPath(m_InstallPath) / "Content" / "Dev" / "ObvData" / "data";
+        }
+
+        std::filesystem::path SyntheticInstall::GetPluginsPath() const
+        {
+            return GetContentPath(m_InstallPath) / "Binaries" / "Win64" / "OBSE" / "Plugins";
+        }
+
+        std::vector<std::pair<std::filesystem::path, std::filesystem::path>> MakeModMappings(
+            const std::filesystem::path &obseData, const std::filesystem::path &gameData, size_t count, uint64_t seed)
+        {
+            Random random(seed);
+            std::vector<std::pair<std::filesystem::path, std::filesystem::path>> mappings;
+            mappings.reserve(count);
+            for (size_t i = 0; i < count; ++i)
+            {
+                // Unique by the index; the word makes prefixes diverge the way mod names do
+                std::string mod = random.Word() + " " + random.Word() + " " + std::to_string(i);
+                mappings.emplace_back(obseData / "Mods" / mod, gameData / "Mods" / mod);
+            }
+            return mappings;
+        }
+
+        std::vector<std::string> MakeHitCorpus(const std::vector<std::filesystem::path> &roots, size_t count, size_t depth, uint64_t seed)
+        {
+            Random random(seed);
+            std::vector<std::string> corpus;
+            corpus.reserve(count);
+            for (size_t i = 0; i < count && !roots.empty(); ++i)
+            {
+                const std::filesystem::path &root = roots[random.Below(roots.size())];
+                corpus.push_back((root / MakeFolders(random, depth) / MakeFileName(random)).string());
+            }
+            return corpus;
+        }
+
+        std::vector<std::string> MakeMissCorpus(const std::vector<std::filesystem::path> &roots, size_t count, size_t depth, uint64_t seed)
+        {
+            Random random(seed);
+            std::vector<std::string> corpus;
+            corpus.reserve(count);
+            for (size_t i = 0; i < count; ++i)
+            {
+                std::filesystem::path base;
+                if (!roots.empty() && random.Below(4) == 0)
+                {
+                    // A sibling that shares all but the last few characters of a root
+                    const std::filesystem::path &root = roots[random.Below(roots.size())];
+                    base = root.parent_path() / (root.filename().string() + ".old");
+                }
+                else
+                {
+                    std::filesystem::path anchor = roots.empty() ? std::filesystem::path("/") : roots.front().root_path();
+                    base = anchor / UnrelatedRoots[random.Below(std::size(UnrelatedRoots))];
+                }
+                corpus.push_back((base / MakeFolders(random, depth) / MakeFileName(random)).string());
+            }
+            return corpus;
+        }
+
+        std::vector<std::string> MakeMixedCorpus(const std::vector<std::filesystem::path> &roots,
+                                                 const std::vector<std::filesystem::path> &missRoots, size_t count, size_t depth,
+                                                 size_t hitPercent, uint64_t seed)
+        {
+            std::vector<std::string> hits = MakeHitCorpus(roots, count, depth, seed);
+            std::vector<std::string> misses = MakeMissCorpus(missRoots, count, depth, seed + 1);
+
+            Random random(seed + 2);
+            std::vector<std::string> corpus;
+            corpus.reserve(count);
+            for (size_t i = 0; i < count; ++i)
+            {
+                corpus.push_back(random.Below(100) < hitPercent && !hits.empty() ? hits[i] : misses[i]);
+            }
+            return corpus;
+        }
+
+        std::string MakeConfigText(size_t sections, size_t keysPerSection, uint64_t seed)
+        {
+            std::string text =
+                "[Paths]\n"
+                "GamePassInstall=C:\\Program Files\\ModifiableWindowsApps\\The Elder Scrolls IV- Oblivion Remastered\n"
+                "SteamInstall=C:\\Path\\To\\Steam\\OBSE64\\Installation\n"
+                "ContentStore=\n"
+                "\n"
+                "[Settings]\n"
+                "AutoDetectPaths=true\n"
+                "EnableLogging=true\n"
+                "LogLevel=1\n"
+                "MetadataCacheTTLMs=0\n"
+                "EnableDirectoryIndex=true\n"
+                "MountArchives=true\n"
+                "ScanPlugins=true\n"
+                "CheckLoadOrder=true\n"
+                "DeployMode=false\n"
+                "WatchDirectories=true\n"
+                "BatchWorkerThreads=0\n";
+
+            // Comments, blank lines and padding, as hand-edited files have them
+            Random random(seed);
+            for (size_t section = 0; section < sections; ++section)
+            {
+                text += "\n; " + random.Word() + " " + random.Word() + "\n";
+                text += "[Section" + std::to_string(section) + "]\n";
+                for (size_t key = 0; key < keysPerSection; ++key)
+                {
+                    text += random.Below(2) ? "Key" : "  Key";
+                    text += std::to_string(key) + (random.Below(2) ? "=" : " = ");
+                    text += random.Below(3) ? random.Word() + "\\" + random.Word() : std::to_string(random.Below(100000));
+                    text += '\n';
+                }
+            }
+            return text;
+        }
+
+        bool WriteArchive(const std::filesystem::path &archivePath, size_t files, size_t filesPerFolder, uint64_t seed,
+                          std::vector<std::string> *names)
+        {
+            struct Folder
+            {
+                std::string name;
+                std::vector<std::string> files;
+            };
+
+            Random random(seed);
+            size_t perFolder = filesPerFolder ? filesPerFolder : 1;
+            std::vector<Folder> folders;
+            size_t totalFolderNameLength = 0;
+            size_t totalFileNameLength = 0;
+            for (size_t created = 0; created < files;)
+            {
+                Folder folder;
+                folder.name = std::string(DataFolders[random.Below(std::size(DataFolders))]) + "\\" + random.Word() + "\\" +
+                              random.Word() + std::to_string(folders.size());
+                std::unordered_set<std::string> used;
+                while (folder.files.size() < perFolder && created < files)
+                {
+                    std::string name = MakeFileName(random);
+                    if (used.insert(name).second)
+                    {
+                        totalFileNameLength += name.size() + 1;
+                        if (names)
+                        {
+                            names->push_back(folder.name + "\\" + name);
+                        }
+                        folder.files.push_back(std::move(name));
+                        ++created;
+                    }
+                }
+                totalFolderNameLength += folder.name.size() + 1;
+                folders.push_back(std::move(folder));
+            }
+
+            // Header, folder records, then each folder's name and file records, then all file
+            // names; hashes are left zero since the layer matches by name
+            std::string bytes;
+            const uint32_t header[] = {
+                0x00415342, 103, 36, 0x3, static_cast<uint32_t>(folders.size()), static_cast<uint32_t>(files),
+                static_cast<uint32_t>(totalFolderNameLength), static_cast<uint32_t>(totalFileNameLength), 0};
+            bytes.append(reinterpret_cast<const char *>(header), sizeof(header));
+
+            for (const Folder &folder : folders)
+            {
+                Append(bytes, uint64_t(0));
+                Append(bytes, static_cast<uint32_t>(folder.files.size()));
+                Append(bytes, uint32_t(0));
+            }
+            for (const Folder &folder : folders)
+            {
+                bytes += static_cast<char>(folder.name.size() + 1);
+                bytes += folder.name;
+                bytes += '\0';
+                for (size_t i = 0; i < folder.files.size(); ++i)
+                {
+                    Append(bytes, uint64_t(0));
+                    Append(bytes, uint32_t(0));
+                    Append(bytes, uint32_t(0));
+                }
+            }
+            for (const Folder &folder : folders)
+            {
+                for (const std::string &name : folder.files)
+                {
+                    bytes += name;
+                    bytes += '\0';
+                }
+            }
+
+            std::ofstream file(archivePath, std::ios::binary | std::ios::trunc);
+            file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+            return file.good();
+        }
+
+        std::vector<OverlayLayer> CreateOverlayLayers(const std::filesystem::path &root, size_t layers, size_t filesPerLayer,
+                                                      size_t sharedPercent, uint64_t seed, std::vector<std::string> *names)
+        {
+            Random random(seed);
+
+            // The pool conflicting files come from, a few folders deep like mod assets
+            std::vector<std::filesystem::path> pool;
+            for (size_t i = 0; i < std::max<size_t>(filesPerLayer, 1); ++i)
+            {
+                pool.push_back(std::filesystem::path(DataFolders[random.Below(std::size(DataFolders))]) / random.Word() /
+                               MakeFileName(random));
+            }
+
+            std::vector<OverlayLayer> result;
+            std::unordered_set<std::string> distinct;
+            std::error_code ec;
+            for (size_t layer = 0; layer < layers; ++layer)
+            {
+                std::filesystem::path layerRoot = root / ("mod" + std::to_string(layer));
+                for (size_t i = 0; i < filesPerLayer; ++i)
+                {
+                    std::filesystem::path relative = random.Below(100) < sharedPercent
+                                                         ? pool[random.Below(pool.size())]
+                                                         : std::filesystem::path(DataFolders[random.Below(std::size(DataFolders))]) /
+                                                               ("mod" + std::to_string(layer)) / MakeFileName(random);
+                    std::filesystem::create_directories((layerRoot / relative).parent_path(), ec);
+                    WriteFile(layerRoot / relative, 0, 0);
+                    if (distinct.insert(relative.string()).second && names)
+                    {
+                        names->push_back(relative.string());
+                    }
+                }
+                result.push_back({layerRoot, static_cast<int>(layer)});
+            }
+            return result;
+        }
+    }
+
+} // namespace ObseGPCompat
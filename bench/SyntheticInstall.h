@@ -0,0 +1,101 @@
+#pragma once
+
+#include "OverlayIndex.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ObseGPCompat
+{
+
+    namespace Bench
+    {
+        // SplitMix64; the same seed always gives the same trees and corpora
+        class Random
+        {
+        public:
+            explicit Random(uint64_t seed) : m_State(seed) {}
+
+            uint64_t Next();
+            size_t Below(size_t bound) { return bound ? static_cast<size_t>(Next() % bound) : 0; }
+
+            // A lowercase word of a few syllables, like the names in the game's data
+            std::string Word();
+
+        private:
+            uint64_t m_State;
+        };
+
+        struct InstallShape
+        {
+            size_t dataFiles = 1000;     // Loose files below Data
+            size_t depth = 3;            // Folders between Data and each file
+            size_t filesPerFolder = 50;
+            size_t plugins = 0;          // .esp files directly in Data
+            size_t fileSize = 0;         // Bytes in each loose file and plugin
+        };
+
+        // A Game Pass install laid out the way MappingRegistry expects it, with generated
+        // loose files and plugins in Data, plus the Steam-style OBSE root that maps onto it
+        class SyntheticInstall
+        {
+        public:
+            bool Create(const std::filesystem::path &root, const InstallShape &shape, uint64_t seed = 1);
+
+            // What g_GamePassInstallPath and g_ObsePath point at; the OBSE root is not created
+            const std::filesystem::path &GetInstallPath() const { return m_InstallPath; }
+            const std::filesystem::path &GetObsePath() const { return m_ObsePath; }
+
+            std::filesystem::path GetDataPath() const;
+            std::filesystem::path GetPluginsPath() const;
+
+            // Relative to Data, in creation order
+            const std::vector<std::filesystem::path> &GetDataFiles() const { return m_DataFiles; }
+
+        private:
+            std::filesystem::path m_InstallPath;
+            std::filesystem::path m_ObsePath;
+            std::vector<std::filesystem::path> m_DataFiles;
+        };
+
+        // Writes a file of size bytes with content derived from seed
+        bool WriteFile(const std::filesystem::path &path, size_t size, uint64_t seed);
+
+        // Extra OBSE -> Game Pass roots below Data, the way mod managers add one per mod
+        std::vector<std::pair<std::filesystem::path, std::filesystem::path>> MakeModMappings(
+            const std::filesystem::path &obseData, const std::filesystem::path &gameData, size_t count, uint64_t seed);
+
+        // Paths below the given roots, each with depth folders before the file name
+        std::vector<std::string> MakeHitCorpus(const std::vector<std::filesystem::path> &roots, size_t count, size_t depth, uint64_t seed);
+
+        // Paths no root covers: system and profile directories, and siblings of the roots
+        // that share most of their prefix
+        std::vector<std::string> MakeMissCorpus(const std::vector<std::filesystem::path> &roots, size_t count, size_t depth, uint64_t seed);
+
+        // Mostly misses with hitPercent hits mixed in, like the stream the hooks see; the
+        // misses are drawn from missRoots, which must not lie under any of the roots
+        std::vector<std::string> MakeMixedCorpus(const std::vector<std::filesystem::path> &roots,
+                                                 const std::vector<std::filesystem::path> &missRoots, size_t count, size_t depth,
+                                                 size_t hitPercent, uint64_t seed);
+
+        // Configuration text with the real sections followed by generated ones; the generated
+        // keys are "Key<n>" in sections "Section<n>"
+        std::string MakeConfigText(size_t sections, size_t keysPerSection, uint64_t seed);
+
+        // An Oblivion (version 103) archive with named folders and files but no file data.
+        // names receives each file's path relative to Data.
+        bool WriteArchive(const std::filesystem::path &archivePath, size_t files, size_t filesPerFolder, uint64_t seed,
+                          std::vector<std::string> *names = nullptr);
+
+        // Mod folders for an overlay mount: each layer holds filesPerLayer files, sharedPercent
+        // of them drawn from a pool every layer picks from, so layers conflict the way mods do.
+        // names receives every distinct relative path.
+        std::vector<OverlayLayer> CreateOverlayLayers(const std::filesystem::path &root, size_t layers, size_t filesPerLayer,
+                                                      size_t sharedPercent, uint64_t seed, std::vector<std::string> *names = nullptr);
+    }
+
+} // namespace ObseGPCompat
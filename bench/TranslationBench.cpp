@@ -0,0 +1,375 @@
+#include "Benchmarks.h"
+#include "CoreFixture.h"
+#include "ObseGPCompat.h"
+#include "MappingRegistry.h"
+#include "PathTranslator.h"
+#include "PathUtils.h"
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace ObseGPCompat
+{
+
+    namespace Bench
+    {
+
+        namespace
+        {
+            // Power of two, and well past what TranslationCache keeps per thread
+            constexpr size_t CorpusSize = 8192;
+            constexpr size_t CorpusMask = CorpusSize - 1;
+
+            // The mappings Initialize creates, topped up with one per mod until there are
+            // the requested number, and the OBSE roots the corpora are drawn from. Everything
+            // under the OBSE path is mapped, so only its own siblings really miss
+            struct TranslationSetup
+            {
+                SyntheticInstall install;
+                CoreFixture core;
+                std::vector<std::pair<std::filesystem::path, std::filesystem::path>> modMappings;
+                std::vector<std::filesystem::path> roots;
+                std::vector<std::filesystem::path> outerRoots;
+
+                bool Start(BenchState &state, size_t mappings)
+                {
+                    InstallShape shape;
+                    shape.dataFiles = 0;
+                    CoreOptions options;
+                    options.virtualFileSystem = false;
+                    if (!install.Create(state.WorkDirectory(), shape) || !core.Start(install, options))
+                    {
+                        state.Skip("cannot set up the mappings");
+                        return false;
+                    }
+
+                    size_t initial = MappingRegistry::Reader(*g_MappingRegistry)->GetMappings().size();
+                    modMappings = MakeModMappings(install.GetObsePath() / "Data", install.GetDataPath(),
+                                                  mappings > initial ? mappings - initial : 0, 7);
+                    g_MappingRegistry->AddMappings(modMappings);
+
+                    const std::filesystem::path &obse = install.GetObsePath();
+                    outerRoots = {obse};
+                    roots = {obse / "Data", obse / "Content", obse / "OBSE" / "Plugins"};
+                    for (const auto &mapping : modMappings)
+                    {
+                        roots.push_back(mapping.first);
+                    }
+                    return true;
+                }
+            };
+
+            // Spellings the hooks see from code that builds paths by concatenation
+            enum class Spelling
+            {
+                Clean,
+                DoubledSeparators,
+                DotSegments
+            };
+
+            std::string Respell(const std::string &path, Spelling spelling)
+            {
+                const char separator = static_cast<char>(std::filesystem::path::preferred_separator);
+                std::string respelled;
+                switch (spelling)
+                {
+                case Spelling::Clean:
+                    return path;
+                case Spelling::DoubledSeparators:
+                    for (char c : path)
+                    {
+                        respelled += c;
+                        if (c == separator)
+                        {
+                            respelled += c;
+                        }
+                    }
+                    return respelled;
+                case Spelling::DotSegments:
+                {
+                    size_t last = path.rfind(separator);
+                    if (last == std::string::npos)
+                    {
+                        return path;
+                    }
+                    respelled = path.substr(0, last);
+                    respelled += separator;
+                    respelled += '.';
+                    respelled += separator;
+                    respelled += "skipped";
+                    respelled += separator;
+                    respelled += "..";
+                    respelled += path.substr(last);
+                    return respelled;
+                }
+                }
+                return path;
+            }
+
+            // TryTranslate into a caller buffer, the way the hooks call it
+            void TranslateCorpus(BenchState &state, const std::vector<std::string> &corpus)
+            {
+                std::vector<char> buffer(PathTranslator::MaxPathLength);
+                size_t next = 0;
+                size_t hits = 0;
+                state.Measure([&]
+                              {
+                                  const std::string &path = corpus[next++ & CorpusMask];
+                                  hits += g_PathTranslator->TryTranslate(std::string_view(path), buffer.data(), buffer.size()) ? 1 : 0;
+                              });
+                state.SetCounter("hit_rate", next ? static_cast<double>(hits) / static_cast<double>(next) : 0.0);
+            }
+
+            void TranslateHit(BenchState &state)
+            {
+                TranslationSetup setup;
+                if (setup.Start(state, static_cast<size_t>(state.Param("mappings"))))
+                {
+                    TranslateCorpus(state, MakeHitCorpus(setup.roots, CorpusSize, static_cast<size_t>(state.Param("depth")), 11));
+                }
+            }
+
+            void TranslateMiss(BenchState &state)
+            {
+                TranslationSetup setup;
+                if (setup.Start(state, static_cast<size_t>(state.Param("mappings"))))
+                {
+                    TranslateCorpus(state, MakeMissCorpus(setup.outerRoots, CorpusSize, static_cast<size_t>(state.Param("depth")), 13));
+                }
+            }
+
+            void TranslateSpelling(BenchState &state)
+            {
+                TranslationSetup setup;
+                if (!setup.Start(state, 100))
+                {
+                    return;
+                }
+
+                std::vector<std::string> corpus = MakeHitCorpus(setup.roots, CorpusSize, 8, 17);
+                for (std::string &path : corpus)
+                {
+                    path = Respell(path, static_cast<Spelling>(state.Param("spelling")));
+                }
+                TranslateCorpus(state, corpus);
+            }
+
+            // Few distinct paths, so nearly every prefix lookup comes from TranslationCache
+            void TranslateRepeated(BenchState &state)
+            {
+                TranslationSetup setup;
+                if (!setup.Start(state, 100))
+                {
+                    return;
+                }
+
+                std::vector<std::string> distinct = MakeHitCorpus(setup.roots, static_cast<size_t>(state.Param("distinct")), 8, 19);
+                std::vector<std::string> corpus;
+                corpus.reserve(CorpusSize);
+                for (size_t i = 0; i < CorpusSize; ++i)
+                {
+                    corpus.push_back(distinct[i % distinct.size()]);
+                }
+                TranslateCorpus(state, corpus);
+            }
+
+            void TranslateWide(BenchState &state)
+            {
+                TranslationSetup setup;
+                if (!setup.Start(state, 100))
+                {
+                    return;
+                }
+
+                std::vector<std::wstring> corpus;
+                for (const std::string &path : MakeHitCorpus(setup.roots, CorpusSize, 8, 23))
+                {
+                    corpus.push_back(std::filesystem::path(path).wstring());
+                }
+
+                std::vector<wchar_t> buffer(PathTranslator::MaxPathLength);
+                size_t next = 0;
+                state.Measure([&]
+                              {
+                                  const std::wstring &path = corpus[next++ & CorpusMask];
+                                  KeepResult(g_PathTranslator->TryTranslate(std::wstring_view(path), buffer.data(), buffer.size()));
+                              });
+            }
+
+            // The allocating wrapper, which also logs every hit
+            void TranslateObsePath(BenchState &state)
+            {
+                TranslationSetup setup;
+                if (!setup.Start(state, 100))
+                {
+                    return;
+                }
+
+                std::vector<std::string> strings = state.Param("hit") ? MakeHitCorpus(setup.roots, CorpusSize, 8, 29)
+                                                                      : MakeMissCorpus(setup.outerRoots, CorpusSize, 8, 29);
+                std::vector<std::filesystem::path> corpus(strings.begin(), strings.end());
+
+                size_t next = 0;
+                state.Measure([&]
+                              {
+                                  std::filesystem::path translated = g_PathTranslator->TranslateObsePath(corpus[next++ & CorpusMask]);
+                                  KeepResult(translated.native().size());
+                              });
+            }
+
+            // The lookup the prefix table replaced: every OBSE root compared in turn, keeping
+            // the longest match. Folding the path once up front already flatters it; the scan
+            // it stands for folded both sides on every comparison.
+            class LinearScan
+            {
+            public:
+                explicit LinearScan(const MappingSnapshot &snapshot)
+                {
+                    const std::vector<PathMapping> &mappings = snapshot.GetMappings();
+                    for (size_t i = 0; i < mappings.size(); ++i)
+                    {
+                        m_Roots.emplace_back(FoldPath(std::string_view(mappings[i].obsePath)), static_cast<uint32_t>(i));
+                    }
+                }
+
+                uint32_t FindLongest(std::string_view path, size_t *matchedLength)
+                {
+                    m_Folded = FoldPath(path);
+                    uint32_t found = MappingSnapshot::NoMapping;
+                    size_t foundLength = 0;
+                    for (const auto &root : m_Roots)
+                    {
+                        const std::string &key = root.first;
+                        if (key.size() >= foundLength && m_Folded.compare(0, key.size(), key) == 0 &&
+                            (m_Folded.size() == key.size() || m_Folded[key.size()] == '\\'))
+                        {
+                            found = root.second;
+                            foundLength = key.size();
+                        }
+                    }
+                    *matchedLength = foundLength;
+                    return found;
+                }
+
+            private:
+                std::vector<std::pair<std::string, uint32_t>> m_Roots; // Folded root, mapping index
+                std::string m_Folded;
+            };
+
+            // The longest-prefix lookup alone, from the table or from the scan it replaced,
+            // on the same paths
+            void Lookup(BenchState &state)
+            {
+                TranslationSetup setup;
+                if (!setup.Start(state, static_cast<size_t>(state.Param("mappings"))))
+                {
+                    return;
+                }
+
+                std::vector<std::string> corpus = MakeHitCorpus(setup.roots, CorpusSize, 8, 41);
+                MappingRegistry::Reader snapshot(*g_MappingRegistry);
+                LinearScan scan(*snapshot);
+                bool linear = state.Param("linear") != 0;
+                size_t next = 0;
+                size_t hits = 0;
+                state.Measure([&]
+                              {
+                                  std::string_view path(corpus[next++ & CorpusMask]);
+                                  size_t matchedLength = 0;
+                                  uint32_t index = linear ? scan.FindLongest(path, &matchedLength)
+                                                          : snapshot->FindLongest(MappingDirection::ObseToGame, path, &matchedLength);
+                                  hits += index != MappingSnapshot::NoMapping ? 1 : 0;
+                              });
+                state.SetCounter("hit_rate", next ? static_cast<double>(hits) / static_cast<double>(next) : 0.0);
+            }
+
+            // TryTranslate into a std::string against what the hooks did before it existed:
+            // IsObsePath, then TranslateObsePath on a hit, each building its own string and
+            // doing its own lookup
+            void TranslateString(BenchState &state)
+            {
+                TranslationSetup setup;
+                if (!setup.Start(state, 100))
+                {
+                    return;
+                }
+
+                std::vector<std::string> corpus = state.Param("hit") ? MakeHitCorpus(setup.roots, CorpusSize, 8, 43)
+                                                                     : MakeMissCorpus(setup.outerRoots, CorpusSize, 8, 43);
+                bool fused = state.Param("fused") != 0;
+                std::string translated;
+                size_t next = 0;
+                state.Measure([&]
+                              {
+                                  const std::string &path = corpus[next++ & CorpusMask];
+                                  if (fused)
+                                  {
+                                      KeepResult(g_PathTranslator->TryTranslate(std::string_view(path), translated));
+                                      return;
+                                  }
+                                  std::filesystem::path filePath(path);
+                                  if (g_PathTranslator->IsObsePath(filePath))
+                                  {
+                                      translated = g_PathTranslator->TranslateObsePath(filePath).string();
+                                  }
+                              });
+                KeepResult(translated.size());
+            }
+
+            // The first-stage check on the stream the hooks see, mostly unrelated paths. Timed
+            // on the snapshot: MayTranslate first resolves paths without a drive letter against
+            // the working directory, which on Linux is all of them
+            void Prefilter(BenchState &state)
+            {
+                TranslationSetup setup;
+                if (!setup.Start(state, 100))
+                {
+                    return;
+                }
+
+                std::vector<std::string> corpus =
+                    MakeMixedCorpus(setup.roots, setup.outerRoots, CorpusSize, 6, static_cast<size_t>(state.Param("hit_percent")), 31);
+
+                MappingRegistry::Reader snapshot(*g_MappingRegistry);
+                size_t next = 0;
+                size_t passed = 0;
+                state.Measure([&]
+                              {
+                                  passed += snapshot->MayMatchObsePath(std::string_view(corpus[next++ & CorpusMask])) ? 1 : 0;
+                              });
+                state.SetCounter("pass_rate", next ? static_cast<double>(passed) / static_cast<double>(next) : 0.0);
+            }
+
+            // Compiling a snapshot with every mapping in one go
+            void Publish(BenchState &state)
+            {
+                size_t count = static_cast<size_t>(state.Param("mappings"));
+                auto mappings = MakeModMappings(state.WorkDirectory() / "Steam" / "Data", state.WorkDirectory() / "XboxGames" / "data",
+                                                count, 37);
+
+                std::unique_ptr<MappingRegistry> registry;
+                state.MeasureEach([&]
+                                  { registry = std::make_unique<MappingRegistry>(); },
+                                  [&]
+                                  { registry->AddMappings(mappings); });
+                state.SetItemsPerOperation(static_cast<double>(count));
+            }
+        }
+
+        void RegisterTranslationBenchmarks(BenchRegistry &registry)
+        {
+            registry.AddGrid("translate/hit", {{"mappings", {10, 100, 10000}}, {"depth", {2, 8, 16}}}, TranslateHit);
+            registry.AddGrid("translate/miss", {{"mappings", {10, 100, 10000}}, {"depth", {2, 8, 16}}}, TranslateMiss);
+            registry.AddGrid("translate/spelling", {{"spelling", {0, 1, 2}}}, TranslateSpelling);
+            registry.AddGrid("translate/repeated", {{"distinct", {16, 4096}}}, TranslateRepeated);
+            registry.Add("translate/wide", {}, TranslateWide);
+            registry.AddGrid("translate/obse_path", {{"hit", {0, 1}}}, TranslateObsePath);
+            registry.AddGrid("translate/string", {{"hit", {0, 1}}, {"fused", {0, 1}}}, TranslateString);
+            registry.AddGrid("translate/lookup", {{"mappings", {10, 100, 10000}}, {"linear", {0, 1}}}, Lookup);
+            registry.AddGrid("translate/prefilter", {{"hit_percent", {1, 10}}}, Prefilter);
+            registry.AddGrid("translate/publish", {{"mappings", {10, 100, 10000}}}, Publish);
+        }
+    }
+
+} // namespace ObseGPCompat
@@ -0,0 +1,194 @@
+#include "Benchmarks.h"
+#include "ObseGPCompat.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <string>
+#include <system_error>
+#include <unistd.h>
+
+namespace
+{
+    void PrintUsage()
+    {
+        fprintf(stderr,
+                "Usage: obse64gp_bench [options]\n"
+                "  --filter <text>      Only run cases whose label contains text\n"
+                "  --list               Print the case labels and exit\n"
+                "  --output <file>      Write the results there (default obse64gp_bench.json)\n"
+                "  --baseline <file>    Compare with the results of an earlier run\n"
+                "  --min-time <ms>      Minimum time per repetition (default 200)\n"
+                "  --repetitions <n>    Repetitions per case (default 3)\n"
+                "  --large              Also run the cases marked large (multi-gigabyte copies)\n"
+                "  --work-dir <dir>     Scratch directory (default: a new one in the temp directory)\n"
+                "  --verbose            Leave the layer's log output on stdout\n");
+    }
+
+    std::string FormatRate(double perSecond, const char *unit)
+    {
+        const char *prefixes[] = {"", "k", "M", "G"};
+        size_t prefix = 0;
+        while (perSecond >= 1000.0 && prefix + 1 < std::size(prefixes))
+        {
+            perSecond /= 1000.0;
+            ++prefix;
+        }
+        char text[32];
+        snprintf(text, sizeof(text), "%.2f %s%s/s", perSecond, prefixes[prefix], unit);
+        return text;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    using namespace ObseGPCompat::Bench;
+
+    BenchOptions options;
+    std::string filter;
+    std::filesystem::path outputPath = "obse64gp_bench.json";
+    std::filesystem::path baselinePath;
+    bool list = false;
+    bool verbose = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (argument == "--filter" && hasValue)
+        {
+            filter = argv[++i];
+        }
+        else if (argument == "--output" && hasValue)
+        {
+            outputPath = argv[++i];
+        }
+        else if (argument == "--baseline" && hasValue)
+        {
+            baselinePath = argv[++i];
+        }
+        else if (argument == "--min-time" && hasValue)
+        {
+            options.minTime = std::chrono::milliseconds(std::max(1, std::atoi(argv[++i])));
+        }
+        else if (argument == "--repetitions" && hasValue)
+        {
+            options.repetitions = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (argument == "--work-dir" && hasValue)
+        {
+            options.workDirectory = argv[++i];
+        }
+        else if (argument == "--large")
+        {
+            options.large = true;
+        }
+        else if (argument == "--list")
+        {
+            list = true;
+        }
+        else if (argument == "--verbose")
+        {
+            verbose = true;
+        }
+        else
+        {
+            PrintUsage();
+            return argument == "--help" ? 0 : 1;
+        }
+    }
+
+    BenchRegistry registry;
+    RegisterTranslationBenchmarks(registry);
+    RegisterFileSystemBenchmarks(registry);
+    RegisterMountBenchmarks(registry);
+    RegisterStorageBenchmarks(registry);
+    RegisterConfigBenchmarks(registry);
+    RegisterLogBenchmarks(registry);
+
+    std::vector<const BenchCase *> selected;
+    for (const BenchCase &benchCase : registry.GetCases())
+    {
+        std::string label = GetCaseLabel(benchCase.name, benchCase.params);
+        if ((benchCase.large && !options.large) || label.find(filter) == std::string::npos)
+        {
+            continue;
+        }
+        if (list)
+        {
+            printf("%s%s\n", label.c_str(), benchCase.large ? " (large)" : "");
+        }
+        selected.push_back(&benchCase);
+    }
+    if (list)
+    {
+        return 0;
+    }
+
+    // Everything the layer writes, configuration and logs included, stays in the work directory
+    bool ownsWorkDirectory = options.workDirectory.empty();
+    if (ownsWorkDirectory)
+    {
+        options.workDirectory = std::filesystem::temp_directory_path() / ("obse64gp_bench_" + std::to_string(getpid()));
+    }
+    std::error_code ec;
+    std::filesystem::create_directories(options.workDirectory / "appdata", ec);
+    if (ec)
+    {
+        fprintf(stderr, "Cannot create %s: %s\n", options.workDirectory.string().c_str(), ec.message().c_str());
+        return 1;
+    }
+    setenv("XDG_DATA_HOME", (options.workDirectory / "appdata").c_str(), 1);
+
+    // Log also prints every line; the results go to stderr and the JSON file
+    if (!verbose && !freopen("/dev/null", "w", stdout))
+    {
+        fprintf(stderr, "Cannot silence stdout; the layer's log output will be mixed in\n");
+    }
+
+    fprintf(stderr, "%-64s %14s %16s %18s\n", "Case", "ns/op", "ops", "throughput");
+    std::vector<BenchResult> results;
+    for (const BenchCase *benchCase : selected)
+    {
+        std::string label = GetCaseLabel(benchCase->name, benchCase->params);
+        results.push_back(RunCase(*benchCase, options));
+        const BenchResult &result = results.back();
+        if (!result.skipped.empty())
+        {
+            fprintf(stderr, "%-64s skipped: %s\n", label.c_str(), result.skipped.c_str());
+            continue;
+        }
+
+        double median = result.Median();
+        double perSecond = median > 0.0 ? 1e9 / median : 0.0;
+        std::string throughput = result.bytesPerOperation > 0.0   ? FormatRate(perSecond * result.bytesPerOperation, "B")
+                                 : result.itemsPerOperation > 0.0 ? FormatRate(perSecond * result.itemsPerOperation, "items")
+                                                                  : FormatRate(perSecond, "ops");
+        fprintf(stderr, "%-64s %14.1f %16llu %18s\n", label.c_str(), median,
+                static_cast<unsigned long long>(result.operations), throughput.c_str());
+    }
+
+    if (ownsWorkDirectory)
+    {
+        std::filesystem::remove_all(options.workDirectory, ec);
+    }
+    else
+    {
+        std::filesystem::remove_all(options.workDirectory / "shared", ec);
+    }
+
+    if (!WriteResults(outputPath, options, results))
+    {
+        fprintf(stderr, "Cannot write %s\n", outputPath.string().c_str());
+        return 1;
+    }
+    fprintf(stderr, "Results written to %s\n", outputPath.string().c_str());
+
+    if (!baselinePath.empty() && !CompareResults(baselinePath, results))
+    {
+        return 1;
+    }
+    return 0;
+}
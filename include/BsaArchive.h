@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace ObseGPCompat
+{
+
+    struct ArchiveFile
+    {
+        uint32_t size;   // Stored size, compressed or not
+        uint32_t offset; // From the start of the archive
+        bool compressed;
+    };
+
+    struct ArchiveFolder
+    {
+        std::vector<std::string> folders; // Immediate subfolder names
+        std::vector<std::string> files;
+    };
+
+    // Name index of an Oblivion .bsa (version 103). The folder and file record tables
+    // are read once from a mapping of the archive; afterwards lookups never touch the
+    // file, which is not kept open. Paths are relative to the directory the archive
+    // belongs to (usually Data), and matched case-insensitively with either separator.
+    class BsaArchive
+    {
+    public:
+        static constexpr uint32_t Version = 103;
+
+        BsaArchive();
+
+        bool Open(const std::filesystem::path &archivePath);
+
+        // Indexes an archive already in memory
+        bool Load(const uint8_t *data, size_t size);
+
+        const std::filesystem::path &GetPath() const { return m_Path; }
+        size_t FileCount() const { return m_Files.size(); }
+        size_t FolderCount() const { return m_Folders.size(); }
+
+        const ArchiveFile *FindFile(std::string_view relativePath) const;
+
+        // The empty path is the archive's root
+        const ArchiveFolder *FindFolder(std::string_view relativePath) const;
+
+    private:
+        static std::string MakeKey(std::string_view relativePath);
+
+        ArchiveFolder &AddFolder(const std::string &key);
+
+        std::filesystem::path m_Path;
+        std::unordered_map<std::string, ArchiveFile> m_Files;
+        std::unordered_map<std::string, ArchiveFolder> m_Folders;
+    };
+
+} // namespace ObseGPCompat
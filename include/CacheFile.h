@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace ObseGPCompat
+{
+
+    // Reads back what CacheWriter wrote, failing instead of reading past the end
+    class CacheReader
+    {
+    public:
+        // Corrupt counts must not turn into huge allocations
+        static constexpr uint32_t MaxCount = 1u << 20;
+
+        bool Open(const std::filesystem::path &path)
+        {
+            std::ifstream in(path, std::ios::binary);
+            if (!in)
+            {
+                return false;
+            }
+            m_Data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+            m_Position = 0;
+            return true;
+        }
+
+        template <typename T>
+        bool Read(T &value)
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "Only plain values are read directly");
+            if (m_Data.size() - m_Position < sizeof(T))
+            {
+                return false;
+            }
+            std::memcpy(&value, m_Data.data() + m_Position, sizeof(T));
+            m_Position += sizeof(T);
+            return true;
+        }
+
+        bool Read(std::string &value)
+        {
+            uint32_t length = 0;
+            if (!Read(length) || m_Data.size() - m_Position < length)
+            {
+                return false;
+            }
+            value.assign(reinterpret_cast<const char *>(m_Data.data() + m_Position), length);
+            m_Position += length;
+            return true;
+        }
+
+        bool Read(std::vector<std::string> &values)
+        {
+            uint32_t count = 0;
+            if (!Read(count) || count > MaxCount)
+            {
+                return false;
+            }
+            values.resize(count);
+            for (std::string &value : values)
+            {
+                if (!Read(value))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+    private:
+        std::vector<uint8_t> m_Data;
+        size_t m_Position = 0;
+    };
+
+    // Writes beside path and renames over it on Commit, so a crash never leaves half a file
+    class CacheWriter
+    {
+    public:
+        explicit CacheWriter(const std::filesystem::path &path)
+            : m_Path(path),
+              m_Temporary(path)
+        {
+            m_Temporary += ".tmp";
+            m_Out.open(m_Temporary, std::ios::binary | std::ios::trunc);
+        }
+
+        template <typename T>
+        void Write(const T &value)
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "Only plain values are written directly");
+            m_Out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+        }
+
+        void Write(const std::string &value)
+        {
+            Write(static_cast<uint32_t>(value.size()));
+            m_Out.write(value.data(), static_cast<std::streamsize>(value.size()));
+        }
+
+        void Write(const std::vector<std::string> &values)
+        {
+            Write(static_cast<uint32_t>(values.size()));
+            for (const std::string &value : values)
+            {
+                Write(value);
+            }
+        }
+
+        bool Commit()
+        {
+            m_Out.close();
+            std::error_code ec;
+            if (!m_Out)
+            {
+                std::filesystem::remove(m_Temporary, ec);
+                return false;
+            }
+            std::filesystem::rename(m_Temporary, m_Path, ec);
+            return !ec;
+        }
+
+    private:
+        std::filesystem::path m_Path;
+        std::filesystem::path m_Temporary;
+        std::ofstream m_Out;
+    };
+
+} // namespace ObseGPCompat
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "CopyEngine.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+namespace ObseGPCompat
+{
+
+    // XXH64 of data. Four independent accumulators keep the pipeline full, which is where
+    // the speed comes from; the result matches the reference implementation.
+    uint64_t HashContent(const void *data, size_t length, uint64_t seed = 0);
+
+    struct ContentId
+    {
+        uint64_t hash;
+        uint64_t size;
+
+        std::wstring ToString() const; // "<16 hex digits>-<size>"
+    };
+
+    struct ContentStoreStats
+    {
+        uint64_t stored;       // Distinct contents written to the store
+        uint64_t deduplicated; // Additions that found their content already stored
+        uint64_t bytesSaved;   // Size of the deduplicated additions
+        uint64_t links;        // Hardlinks created
+    };
+
+    // Stores each distinct file content once, under <root>\<2 hex>\<ContentId>. Identical
+    // plugins and assets shipped by several profiles share one object, and exposing an
+    // object somewhere is a hardlink rather than a copy. Objects are shared by every link
+    // to them, so they are made read-only, and VirtualFileSystem replaces or removes a link
+    // rather than writing through it.
+    class ContentStore
+    {
+    public:
+        ContentStore();
+
+        bool Initialize(const std::filesystem::path &root);
+        bool IsInitialized() const { return !m_Root.empty(); }
+        const std::filesystem::path &GetRoot() const { return m_Root; }
+
+        // Hashes file and stores its content, unless an identical object is already there
+        bool Add(const std::filesystem::path &file, ContentId &id);
+
+        bool Contains(const ContentId &id) const;
+        std::filesystem::path GetObjectPath(const ContentId &id) const;
+
+        // Hardlinks the object at target, replacing any file there. Fails when target is on
+        // another volume than the store.
+        bool Link(const ContentId &id, const std::filesystem::path &target);
+
+        ContentStoreStats GetStats() const;
+
+    private:
+        static bool HashFile(const std::filesystem::path &file, ContentId &id);
+        static bool SameContent(const std::filesystem::path &a, const std::filesystem::path &b);
+
+        std::filesystem::path m_Root;
+        CopyEngine m_CopyEngine;
+
+        std::atomic<uint64_t> m_Stored;
+        std::atomic<uint64_t> m_Deduplicated;
+        std::atomic<uint64_t> m_BytesSaved;
+        std::atomic<uint64_t> m_Links;
+    };
+
+} // namespace ObseGPCompat
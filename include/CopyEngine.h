@@ -0,0 +1,88 @@
+#pragma once
+
+#include "Platform.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+
+namespace ObseGPCompat
+{
+
+    enum class CopyMethod
+    {
+        None,            // Nothing was copied
+        BlockClone,      // Extents shared by the file system (ReFS, Dev Drive); no data moved
+        Chunked,         // Overlapped reads and writes on one thread
+        ParallelChunked  // Chunks spread across worker threads
+    };
+
+    const char *GetCopyMethodName(CopyMethod method);
+
+    struct CopyProgress
+    {
+        uint64_t bytesCopied;
+        uint64_t totalBytes;
+    };
+
+    struct CopyResult
+    {
+        bool success;
+        CopyMethod method;
+        uint64_t bytes;
+        double seconds;
+        Platform::FileError error; // When success is false; AlreadyExists for a refused overwrite
+
+        double BytesPerSecond() const { return seconds > 0.0 ? static_cast<double>(bytes) / seconds : 0.0; }
+    };
+
+    // Called after each chunk, from whichever thread finished it, never concurrently
+    using CopyProgressCallback = std::function<void(const CopyProgress &)>;
+
+    // Copies single files as fast as the volume allows. Block cloning is tried first, so
+    // copies within a ReFS volume (or Btrfs and XFS elsewhere) finish without reading the
+    // data at all. Otherwise the file is preallocated and copied in chunks with overlapped
+    // I/O (positioned reads and writes elsewhere); large files spread their chunks across
+    // worker threads so several requests are in flight at once.
+    // The destination gets the source's last write time and attributes, and a failed
+    // copy never leaves a partial file behind. An overwrite is written beside the
+    // destination and renamed over it once complete, so a failure keeps the old file and
+    // a hardlinked destination is replaced instead of written through. Copying a file
+    // onto itself fails with AlreadyExists.
+    class CopyEngine
+    {
+    public:
+        static constexpr size_t DefaultChunkSize = 4 * 1024 * 1024;
+        static constexpr uint64_t DefaultParallelThreshold = 16 * 1024 * 1024;
+
+        CopyEngine();
+
+        void SetChunkSize(size_t chunkSize) { m_ChunkSize = chunkSize; }
+        void SetParallelThreshold(uint64_t bytes) { m_ParallelThreshold = bytes; }
+        void SetMaxWorkers(unsigned workers) { m_MaxWorkers = workers ? workers : 1; }
+        void SetBlockCloneEnabled(bool enabled) { m_BlockCloneEnabled = enabled; }
+
+        CopyResult Copy(const std::filesystem::path &source, const std::filesystem::path &destination,
+                        bool overwrite, const CopyProgressCallback &progress = nullptr) const;
+
+    private:
+        // A HANDLE on Windows, a file descriptor elsewhere
+#ifdef _WIN32
+        using NativeFile = void *;
+#else
+        using NativeFile = int;
+#endif
+
+        bool TryBlockClone(NativeFile source, NativeFile destination, const std::filesystem::path &destinationPath,
+                           uint64_t size, const CopyProgressCallback &progress) const;
+        bool CopyChunks(NativeFile source, NativeFile destination, uint64_t size, unsigned workers,
+                        const CopyProgressCallback &progress) const;
+
+        size_t m_ChunkSize;
+        uint64_t m_ParallelThreshold;
+        unsigned m_MaxWorkers;
+        bool m_BlockCloneEnabled;
+    };
+
+} // namespace ObseGPCompat
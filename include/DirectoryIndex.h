@@ -0,0 +1,181 @@
+#pragma once
+
+#include "MappedFile.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace ObseGPCompat
+{
+
+    struct DirectoryIndexStats
+    {
+        size_t directories;
+        size_t files;
+        size_t rescannedDirectories; // Listed from disk because they were new or their time changed
+        bool snapshotReused;         // The mapped snapshot was current and is served as is
+    };
+
+    // Names of everything below a set of real roots, so existence checks under them can
+    // be answered without touching the disk. Each directory's children sit next to each
+    // other, sorted by case-folded name, and all names share one string blob.
+    //
+    // The table is persisted as a snapshot file and mapped back in on the next start
+    // without parsing. A directory's time changes whenever an entry is added, removed or
+    // renamed directly inside it, so only directories whose time differs from the
+    // snapshot are listed again; everything else is reused from the mapping.
+    //
+    // While running, directories something changed in are listed again one at a time and
+    // answered from that listing, which overlays the table's own.
+    class DirectoryIndex
+    {
+    public:
+        enum class Presence
+        {
+            NotIndexed, // Outside the roots, or below a directory that may have changed
+            Missing,
+            File,
+            Directory
+        };
+
+        DirectoryIndex();
+
+        // Indexes roots (in parallel, one directory per task), reusing snapshotPath where
+        // it is still current, and rewrites the snapshot when anything changed (an empty
+        // snapshotPath keeps the index in memory only). Not thread-safe; call before the
+        // index is shared.
+        void Build(const std::vector<std::filesystem::path> &roots, const std::filesystem::path &snapshotPath);
+
+        Presence Find(const std::filesystem::path &realPath) const;
+
+        // Stops answering for the directory that holds realPath, after something was created,
+        // deleted or replaced there, until Refresh lists it again. With subtree, Refresh lists
+        // every directory below it as well, for changes nobody reported.
+        void MarkStale(const std::filesystem::path &realPath, bool subtree = false);
+
+        // Lists the directories marked stale again and answers for them from the new
+        // listings, along with any subdirectory whose time moved. Directories created since
+        // Build stay unindexed. Returns how many directories were listed. One thread at a time.
+        size_t Refresh();
+
+        const DirectoryIndexStats &GetStats() const { return m_Stats; }
+
+    private:
+        static constexpr uint32_t NoEntry = UINT32_MAX;
+
+        enum EntryFlags : uint32_t
+        {
+            Directory = 1,
+            Opaque = 2 // Directory whose children are unknown (unreadable, or a link)
+        };
+
+        // Snapshot layout: SnapshotHeader, Entry[entryCount], then the wchar_t name blob.
+        // Entries [0, rootCount) are the roots, named by their full path.
+        struct SnapshotHeader
+        {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t charSize;
+            uint32_t rootCount;
+            uint32_t entryCount;
+            uint32_t nameLength;
+            uint64_t rootsHash;
+        };
+
+        struct Entry
+        {
+            uint32_t nameOffset; // Into the name blob, in characters
+            uint32_t nameLength;
+            uint32_t firstChild;
+            uint32_t childCount;
+            int64_t lastWriteTime; // Directories only
+            uint32_t flags;
+            uint32_t reserved;
+        };
+
+        struct ScanChild
+        {
+            std::wstring name;
+            uint32_t flags;
+            uint32_t node; // Scan node of a directory to descend into, otherwise NoEntry
+        };
+
+        enum class EntryState : uint8_t
+        {
+            Indexed,
+            Stale,   // Changed; lookups below it go to the disk
+            Relisted // Answered from its overlay
+        };
+
+        struct OverlayChild
+        {
+            std::wstring name;
+            uint32_t flags;
+            uint32_t entry; // For a directory the table knows, its entry; otherwise NoEntry
+        };
+
+        // A directory's listing as Refresh found it, replacing the one in the table
+        struct Overlay
+        {
+            int64_t lastWriteTime;
+            bool opaque;
+            std::vector<OverlayChild> children; // Sorted by case-folded name
+        };
+
+        struct StaleDirectory
+        {
+            std::filesystem::path path;
+            bool subtree;
+        };
+
+        struct ScanNode
+        {
+            std::filesystem::path path;
+            uint32_t previous; // Same directory in the mapped snapshot, or NoEntry
+            int64_t lastWriteTime;
+            bool opaque;
+            std::vector<ScanChild> children;
+        };
+
+        bool MapSnapshot(const std::filesystem::path &snapshotPath, uint64_t rootsHash);
+        bool ListChildren(ScanNode &node, std::vector<std::pair<size_t, uint32_t>> &subdirectories) const;
+        void Assemble(const std::deque<ScanNode> &nodes, const std::vector<std::wstring> &rootNames);
+        void WriteSnapshot(const std::filesystem::path &snapshotPath, uint64_t rootsHash) const;
+
+        void Relist(uint32_t entry, const std::filesystem::path &path, bool subtree, std::unordered_set<uint32_t> &listed);
+        std::shared_ptr<const Overlay> GetOverlay(uint32_t entry) const;
+
+        std::wstring_view Name(uint32_t entry) const { return std::wstring_view(m_Names + m_Entries[entry].nameOffset, m_Entries[entry].nameLength); }
+        uint32_t FindChild(uint32_t directory, std::wstring_view name) const;
+        // searched receives the directory whose children were searched last, and
+        // searchedLength the length of the part of path that names it
+        Presence Walk(std::wstring_view path, uint32_t *searched, size_t *searchedLength) const;
+
+        // Live table: points into either m_Snapshot or the owned vectors
+        const Entry *m_Entries;
+        const wchar_t *m_Names;
+        uint32_t m_EntryCount;
+        uint32_t m_RootCount;
+
+        MappedFile m_Snapshot;
+        std::vector<Entry> m_OwnedEntries;
+        std::wstring m_OwnedNames;
+
+        std::unique_ptr<std::atomic<EntryState>[]> m_States; // Per entry
+        mutable std::mutex m_OverlayMutex;                  // Guards the overlays and the stale directories
+        std::unordered_map<uint32_t, std::shared_ptr<const Overlay>> m_Overlays;
+        std::unordered_map<uint32_t, StaleDirectory> m_StaleDirectories; // Waiting for Refresh
+        DirectoryIndexStats m_Stats;
+    };
+
+} // namespace ObseGPCompat
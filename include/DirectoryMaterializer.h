@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string_view>
+
+namespace ObseGPCompat
+{
+
+    // Creates redirected directories on demand instead of up front. Directories known
+    // to exist are remembered process-wide, so each one costs at most one CreateDirectory
+    // call (no separate existence check) and later opens below it cost no syscalls.
+    class DirectoryMaterializer
+    {
+    public:
+        // Makes sure the directory holding filePath exists, creating any missing levels
+        template <typename CharT>
+        static bool EnsureParentDirectory(std::basic_string_view<CharT> filePath);
+
+        // Forgets the directory holding filePath, e.g. after an open found it missing
+        template <typename CharT>
+        static void ForgetParentDirectory(std::basic_string_view<CharT> filePath);
+
+        // Forgets directory, e.g. after the VFS removed it
+        template <typename CharT>
+        static void Forget(std::basic_string_view<CharT> directory);
+
+    private:
+        template <typename CharT>
+        static bool EnsureDirectory(std::basic_string_view<CharT> directory);
+    };
+
+} // namespace ObseGPCompat
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace ObseGPCompat
+{
+
+    enum class FileChangeKind : uint8_t
+    {
+        Added,
+        Removed,
+        Modified // Contents, size or write time, or removed and created again
+    };
+
+    struct FileChange
+    {
+        std::filesystem::path path; // Real path of the file or directory
+        FileChangeKind kind;
+    };
+
+    // What the operating system reports for one watched tree. ReadDirectoryChangesW on
+    // Windows, inotify elsewhere.
+    class ChangeSource
+    {
+    public:
+        virtual ~ChangeSource() = default;
+
+        // Blocks until something below the root changed and appends it to changes. Sets
+        // overflow when the system dropped notifications and the whole tree must be
+        // assumed changed. False once Cancel was called or the tree can no longer be watched.
+        virtual bool Wait(std::vector<FileChange> &changes, bool &overflow) = 0;
+
+        // Makes Wait return false; may be called from any thread
+        virtual void Cancel() = 0;
+
+        // Null if root cannot be watched
+        static std::unique_ptr<ChangeSource> Create(const std::filesystem::path &root);
+    };
+
+    struct DirectoryWatcherStats
+    {
+        uint64_t notifications; // Changes reported by the system
+        uint64_t dispatched;    // Changes left after coalescing, passed to the handler
+        uint64_t batches;
+        uint64_t overflows;
+    };
+
+    // Watches real directory trees while the game runs, so indexes and caches over them
+    // can follow changes made behind the layer's back (a plugin dropped into OBSE\Plugins,
+    // a mod manager rewriting Data). Notifications are collected until the trees have been
+    // quiet for a short while, coalesced to one change per path, and handed to the handler
+    // in one batch on the watcher's own thread.
+    class DirectoryWatcher
+    {
+    public:
+        // overflowedRoots lost notifications; anything below them may have changed
+        using ChangeHandler = std::function<void(const std::vector<FileChange> &changes,
+                                                 const std::vector<std::filesystem::path> &overflowedRoots)>;
+
+        static constexpr std::chrono::milliseconds DefaultSettleTime{200};
+
+        DirectoryWatcher();
+        ~DirectoryWatcher();
+
+        DirectoryWatcher(const DirectoryWatcher &) = delete;
+        DirectoryWatcher &operator=(const DirectoryWatcher &) = delete;
+
+        // Adds a tree to watch; call before Start
+        bool Watch(const std::filesystem::path &root);
+
+        // Starts delivering batches to handler, settleTime after the last notification in each
+        bool Start(ChangeHandler handler, std::chrono::milliseconds settleTime = DefaultSettleTime);
+
+        // Stops watching for good and waits for a batch in progress; the handler is not called again
+        void Stop();
+
+        size_t RootCount() const { return m_Sources.size(); }
+        DirectoryWatcherStats GetStats() const;
+
+    private:
+        struct Source
+        {
+            std::filesystem::path root;
+            std::unique_ptr<ChangeSource> changes;
+            std::thread thread;
+        };
+
+        void Listen(Source &source);
+        void Dispatch();
+
+        std::vector<std::unique_ptr<Source>> m_Sources;
+        ChangeHandler m_Handler;
+        std::chrono::milliseconds m_SettleTime;
+        std::thread m_Dispatcher;
+
+        mutable std::mutex m_Mutex;
+        std::condition_variable m_Changed;
+        bool m_Stopping;
+        std::chrono::steady_clock::time_point m_FirstNotification; // Since the last batch
+        std::chrono::steady_clock::time_point m_LastNotification;
+
+        // Pending changes by folded path, in arrival order
+        std::unordered_map<std::wstring, size_t> m_PendingIndex;
+        std::vector<FileChange> m_Pending;
+        std::vector<std::filesystem::path> m_Overflowed;
+
+        DirectoryWatcherStats m_Stats;
+    };
+
+} // namespace ObseGPCompat
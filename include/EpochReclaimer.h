@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace ObseGPCompat
+{
+
+    // Process-wide epoch-based reclamation for read-mostly data shared with the hooks.
+    // Readers bracket their accesses with a ReadScope, which costs one store on entry
+    // and one on exit and never blocks. Writers unpublish an object and Retire it; it
+    // is destroyed once no reader that might still see it remains.
+    class EpochReclaimer
+    {
+    public:
+        // Threads beyond this many share an overflow counter, which only delays reclamation
+        static constexpr size_t SlotCount = 64;
+
+        class ReadScope
+        {
+        public:
+            ReadScope() { Enter(); }
+            ~ReadScope() { Leave(); }
+
+            ReadScope(const ReadScope &) = delete;
+            ReadScope &operator=(const ReadScope &) = delete;
+        };
+
+        // Nestable on the same thread; only the outermost pair is visible to writers
+        static void Enter();
+        static void Leave();
+
+        // Destroys object later via deleter. Must be called after the object was unpublished.
+        static void Retire(std::function<void()> deleter);
+
+        // Destroys whatever retired objects no reader can reach any more; returns how many remain
+        static size_t Reclaim();
+
+    private:
+        struct alignas(64) Slot
+        {
+            std::atomic<uint64_t> epoch{0}; // Epoch the reader entered at, zero when idle
+            std::atomic<bool> owned{false};
+        };
+
+        struct Retired
+        {
+            uint64_t epoch;
+            std::function<void()> deleter;
+        };
+
+        static size_t ReclaimLocked();
+
+        static Slot s_Slots[SlotCount];
+        static std::atomic<uint64_t> s_Epoch;
+        static std::atomic<uint64_t> s_OverflowReaders;
+
+        static std::mutex s_RetireMutex;
+        static std::vector<Retired> s_Retired;
+    };
+
+} // namespace ObseGPCompat
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "MappedFile.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+
+namespace ObseGPCompat
+{
+
+    // Read-only bytes of a whole file. Copies share one mapping, which stays valid for as
+    // long as any of them is alive, even after the cache has dropped it.
+    class FileView
+    {
+    public:
+        FileView() = default;
+        explicit FileView(std::shared_ptr<const MappedFile> file) : m_File(std::move(file)) {}
+
+        // False when the file could not be opened; an empty file is valid with no data
+        bool IsValid() const { return m_File != nullptr; }
+        explicit operator bool() const { return IsValid(); }
+
+        const uint8_t *Data() const { return m_File ? m_File->Data() : nullptr; }
+        size_t Size() const { return m_File ? m_File->Size() : 0; }
+        bool Empty() const { return Size() == 0; }
+
+        const uint8_t *begin() const { return Data(); }
+        const uint8_t *end() const { return Data() + Size(); }
+
+        std::string_view AsText() const { return std::string_view(reinterpret_cast<const char *>(Data()), Size()); }
+
+    private:
+        std::shared_ptr<const MappedFile> m_File;
+    };
+
+    struct FileViewCacheStats
+    {
+        uint64_t hits;      // Served a mapping another view still holds
+        uint64_t misses;    // Mapped the file
+        uint64_t evictions; // Dropped the least recently used entry to stay within capacity
+    };
+
+    // The mappings of real paths that views currently hold, so readers of a file at the
+    // same time share one. Entries do not keep a mapping open: it closes with its last
+    // view, because an open mapping keeps Windows from truncating or replacing the file.
+    // An entry is reused only while the file keeps the size and write time it was mapped
+    // with; Invalidate covers paths the layer changes without either moving.
+    class FileViewCache
+    {
+    public:
+        static constexpr size_t DefaultCapacity = 32;
+
+        explicit FileViewCache(size_t capacity = DefaultCapacity);
+
+        // View of path, which currently has this size and write time
+        FileView Get(const std::filesystem::path &path, uint64_t size, std::filesystem::file_time_type lastWriteTime);
+
+        void Invalidate(const std::filesystem::path &path);
+        void InvalidateWhere(const std::function<bool(const std::filesystem::path::string_type &)> &predicate);
+        void Clear();
+
+        FileViewCacheStats GetStats() const;
+
+    private:
+        using Key = std::filesystem::path::string_type;
+
+        struct Entry
+        {
+            std::weak_ptr<const MappedFile> file;
+            uint64_t size;
+            std::filesystem::file_time_type lastWriteTime;
+            uint64_t lastUse;
+        };
+
+        void EvictOldest();
+
+        mutable std::mutex m_Mutex;
+        std::unordered_map<Key, Entry> m_Entries;
+        size_t m_Capacity;
+        uint64_t m_Clock;
+        FileViewCacheStats m_Stats;
+    };
+
+} // namespace ObseGPCompat
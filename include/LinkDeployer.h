@@ -0,0 +1,91 @@
+#pragma once
+
+#include "MappingRegistry.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace ObseGPCompat
+{
+
+    enum class LinkKind : uint8_t
+    {
+        HardLink,
+        SymbolicLink // Used across volumes, where hardlinks cannot go
+    };
+
+    // One file the deployment puts at a virtual path
+    struct DeployEntry
+    {
+        std::filesystem::path target; // Where OBSE looks for the file
+        std::filesystem::path source; // The real file it resolves to
+        uint64_t size;
+        int64_t lastWriteTime; // file_time_type ticks of the source
+        LinkKind kind;
+    };
+
+    // A source directory as Plan last listed it. While its write time stays the same,
+    // nothing was added, removed or renamed in it, so the next Plan reuses the listing
+    // instead of reading the directory and querying every file again. Files rewritten in
+    // place keep their links current on their own: a link shares the file's data.
+    struct DeployDirectory
+    {
+        struct File
+        {
+            std::string name; // UTF-8
+            uint64_t size;
+            int64_t lastWriteTime;
+        };
+
+        std::filesystem::path path;
+        int64_t lastWriteTime;
+        std::vector<std::string> subdirectories; // Names, UTF-8
+        std::vector<File> files;
+    };
+
+    struct DeployStats
+    {
+        size_t added;
+        size_t updated;
+        size_t removed;
+        size_t unchanged;
+        size_t conflicts; // Targets already taken by a file the deployment does not own
+        size_t failed;
+    };
+
+    // Materializes the mappings on disk instead of redirecting each open: every real
+    // file is linked at the virtual path it would be translated from, so the game and
+    // OBSE find it there without any hooks. A manifest of what was deployed is kept,
+    // and the next deployment only touches entries that were added, changed or removed.
+    // Files the game creates afterwards stay where it writes them; nothing redirects them.
+    class LinkDeployer
+    {
+    public:
+        LinkDeployer();
+
+        bool LoadManifest(const std::filesystem::path &manifestPath);
+        bool SaveManifest(const std::filesystem::path &manifestPath) const;
+
+        // Every file below the mapped real roots and overlay layers, paired with the
+        // virtual path that translates to it. Directories unchanged since the manifest's
+        // listing of them are not read again; the new listings go into the next manifest.
+        std::vector<DeployEntry> Plan(const MappingSnapshot &mappings);
+
+        // Brings the disk from the loaded manifest to planned, on several threads, and
+        // makes planned (minus conflicts and failures) the new manifest
+        DeployStats Apply(std::vector<DeployEntry> planned);
+
+        const std::vector<DeployEntry> &GetDeployed() const { return m_Deployed; }
+
+    private:
+        static bool CreateLink(const DeployEntry &entry, const std::filesystem::path &linkPath, LinkKind &kind);
+        static bool CreateLinkIn(const DeployEntry &entry, const std::filesystem::path &linkPath, LinkKind &kind);
+
+        std::vector<DeployEntry> m_Deployed;
+        std::vector<DeployDirectory> m_Directories;
+    };
+
+} // namespace ObseGPCompat
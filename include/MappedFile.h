@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+namespace ObseGPCompat
+{
+
+    // Read-only view of a whole file. The file and mapping handles are closed as soon as
+    // the view exists; the view itself keeps the mapping alive until Close.
+    class MappedFile
+    {
+    public:
+        MappedFile();
+        ~MappedFile();
+
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+
+        // Fails for missing or empty files, which cannot be mapped
+        bool Open(const std::filesystem::path &path);
+        void Close();
+
+        // Reads the whole view into memory now, in large requests, instead of one page
+        // fault at a time later; the pages stay cached after the view is closed
+        void Prefetch() const;
+
+        bool IsOpen() const { return m_View != nullptr; }
+        const uint8_t *Data() const { return static_cast<const uint8_t *>(m_View); }
+        size_t Size() const { return m_Size; }
+
+    private:
+        const void *m_View;
+        size_t m_Size;
+    };
+
+} // namespace ObseGPCompat
@@ -0,0 +1,160 @@
+#pragma once
+
+#include "OverlayIndex.h"
+#include "PathPrefilter.h"
+#include "PathPrefixTable.h"
+#include "SnapshotPointer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace ObseGPCompat
+{
+
+    struct PathMapping
+    {
+        std::string obsePath;
+        std::string gamePath;
+        std::wstring obsePathW;
+        std::wstring gamePathW;
+    };
+
+    enum class MappingDirection
+    {
+        ObseToGame,
+        GameToObse
+    };
+
+    // Several real directories merged under one virtual (OBSE-side) path
+    struct OverlayMount
+    {
+        std::string virtualPath;
+        std::wstring virtualPathW;
+        std::shared_ptr<const OverlayIndex> index; // Shared between snapshots, never modified
+    };
+
+    // One immutable set of mappings and overlay mounts with a longest-prefix index per
+    // direction and character type. Never modified once built, so any number of
+    // threads can read it.
+    class MappingSnapshot
+    {
+    public:
+        static constexpr uint32_t NoMapping = UINT32_MAX;
+
+        MappingSnapshot(std::vector<PathMapping> mappings, std::vector<OverlayMount> overlays);
+
+        // Index of the mapping whose source root (in the given direction) is the longest
+        // prefix of path, or NoMapping. matchedLength receives the characters covered.
+        template <typename CharT>
+        uint32_t FindLongest(MappingDirection direction, std::basic_string_view<CharT> path, size_t *matchedLength) const;
+
+        // Root that replaces the matched prefix when translating in the given direction
+        template <typename CharT>
+        const std::basic_string<CharT> &TargetRoot(MappingDirection direction, uint32_t index) const;
+
+        // Root that replaces the first matchedLength characters of path when translating
+        // in the given direction, or nullptr when nothing covers the path. Files an overlay
+        // layer provides resolve to that layer; everything else uses the plain mappings.
+        template <typename CharT>
+        const std::basic_string<CharT> *FindTarget(MappingDirection direction, std::basic_string_view<CharT> path, size_t *matchedLength) const;
+
+        // Cheap check against the OBSE roots; false means no ObseToGame lookup can match
+        template <typename CharT>
+        bool MayMatchObsePath(std::basic_string_view<CharT> path) const;
+
+        const std::vector<PathMapping> &GetMappings() const { return m_Mappings; }
+        const std::vector<OverlayMount> &GetOverlays() const { return m_Overlays; }
+
+        // Unique for the life of the process, unlike the snapshot's address
+        uint64_t GetId() const { return m_Id; }
+
+    private:
+        template <typename CharT>
+        struct Tables
+        {
+            // Longest-prefix lookup in each direction
+            BasicPathPrefixTable<CharT> obseToGame;
+            BasicPathPrefixTable<CharT> gameToObse;
+
+            // Overlay mount points, and every layer root back to its mount point
+            BasicPathPrefixTable<CharT> overlayMounts;
+            BasicPathPrefixTable<CharT> overlayLayers;
+
+            // First-stage rejection for the hooks, derived from the OBSE roots and mount points
+            BasicPathPrefilter<CharT> obsePrefilter;
+        };
+
+        template <typename CharT>
+        const Tables<CharT> &GetTables() const;
+
+        template <typename CharT>
+        void BuildTables(Tables<CharT> &tables);
+
+        uint64_t m_Id;
+
+        // Mapping roots and overlay mounts, indexed by the values stored in the tables
+        std::vector<PathMapping> m_Mappings;
+        std::vector<OverlayMount> m_Overlays;
+        std::vector<uint32_t> m_OverlayLayerMounts; // overlayLayers value -> index into m_Overlays
+
+        Tables<char> m_Narrow;
+        Tables<wchar_t> m_Wide;
+    };
+
+    // The OBSE <-> Game Pass directory mappings, compiled from the configured install
+    // paths and shared by PathTranslator and VirtualFileSystem, so both see the same
+    // roots. Lookups go through a Reader, which pins the current snapshot without
+    // locking; changes build a new snapshot and swap it in, so mappings can be added
+    // while the hooks are live.
+    class MappingRegistry
+    {
+    public:
+        static constexpr uint32_t NoMapping = MappingSnapshot::NoMapping;
+
+        // Keeps one snapshot alive and consistent for the lifetime of the reader
+        class Reader
+        {
+        public:
+            explicit Reader(const MappingRegistry &registry)
+                : m_Snapshot(registry.m_Snapshot.Load())
+            {
+            }
+
+            const MappingSnapshot *operator->() const { return m_Snapshot; }
+            const MappingSnapshot &operator*() const { return *m_Snapshot; }
+
+        private:
+            EpochReclaimer::ReadScope m_Scope; // Entered before the snapshot is loaded
+            const MappingSnapshot *m_Snapshot;
+        };
+
+        MappingRegistry();
+        ~MappingRegistry();
+
+        bool Initialize();
+
+        // Adds a root pair, or retargets an existing OBSE root, and publishes the result
+        void AddMapping(const std::filesystem::path &obsePath, const std::filesystem::path &gamePath);
+
+        // Same for many pairs at once, published as one snapshot
+        void AddMappings(const std::vector<std::pair<std::filesystem::path, std::filesystem::path>> &roots);
+
+        // Merges the layers under virtualPath, replacing any overlay already mounted there.
+        // The layers are scanned here, before the new snapshot is published.
+        bool MountOverlay(const std::filesystem::path &virtualPath, const std::vector<OverlayLayer> &layers);
+
+    private:
+        void Publish(std::vector<PathMapping> mappings, std::vector<OverlayMount> overlays);
+
+        SnapshotPointer<MappingSnapshot> m_Snapshot;
+        std::mutex m_WriteMutex; // Serializes writers; readers never take it
+    };
+
+} // namespace ObseGPCompat
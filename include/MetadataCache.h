@@ -0,0 +1,105 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+
+namespace ObseGPCompat
+{
+
+    struct FileMetadata
+    {
+        bool exists;
+        std::filesystem::file_type type;
+        std::filesystem::perms permissions;
+        uint64_t size;                                // Zero for directories
+        std::filesystem::file_time_type lastWriteTime;
+    };
+
+    struct MetadataCacheStats
+    {
+        uint64_t hits;          // Answered from the cache; each one saved a filesystem query
+        uint64_t negativeHits;  // The subset of hits for paths known not to exist
+        uint64_t misses;        // Went to the filesystem
+        uint64_t expirations;   // Misses caused by an entry outliving the TTL
+        uint64_t invalidations;
+        uint64_t evictions;     // Dropped, oldest first, to stay within capacity
+    };
+
+    // Caches file metadata for real paths, including negative entries for paths that
+    // do not exist, which is what repeated probes for optional files mostly hit.
+    // Split into independently locked shards so concurrent lookups rarely contend.
+    // Entries stay valid until invalidated, or until the optional TTL runs out; keys are
+    // folded, so every spelling of a path shares one entry. A shard that reaches its
+    // share of the capacity drops its expired entries, then its oldest quarter.
+    class MetadataCache
+    {
+    public:
+        static constexpr size_t ShardCount = 16; // Power of two
+        static constexpr size_t DefaultCapacity = 65536;
+
+        explicit MetadataCache(size_t capacity = DefaultCapacity);
+
+        // Zero keeps entries until they are invalidated
+        void SetTimeToLive(std::chrono::milliseconds ttl) { m_TimeToLive = ttl; }
+
+        // Cached metadata for path, querying the filesystem on a miss
+        FileMetadata Get(const std::filesystem::path &path);
+
+        // Forget path, e.g. after creating, deleting or overwriting it
+        void Invalidate(const std::filesystem::path &path);
+
+        // Forget path and each of its ancestors, e.g. after creating directories
+        void InvalidateWithAncestors(const std::filesystem::path &path);
+
+        // Forget every path predicate accepts, e.g. everything below a directory something
+        // outside the layer changed. Visits the whole cache; keys are folded.
+        void InvalidateWhere(const std::function<bool(const std::filesystem::path::string_type &)> &predicate);
+
+        void Clear();
+
+        MetadataCacheStats GetStats() const;
+
+    private:
+        using Key = std::filesystem::path::string_type;
+
+        struct Entry
+        {
+            FileMetadata metadata;
+            std::chrono::steady_clock::time_point cachedAt;
+        };
+
+        struct Shard
+        {
+            std::mutex mutex;
+            std::unordered_map<Key, Entry> entries;
+            uint64_t generation = 0; // Bumped by every invalidation, so racing misses do not store stale results
+        };
+
+        static FileMetadata Query(const std::filesystem::path &path);
+
+        static Key MakeKey(const std::filesystem::path &path);
+
+        Shard &GetShard(const Key &key);
+
+        // Makes room in a full shard; called with its mutex held
+        void Evict(Shard &shard, std::chrono::steady_clock::time_point now);
+
+        std::array<Shard, ShardCount> m_Shards;
+        size_t m_ShardCapacity;
+        std::chrono::milliseconds m_TimeToLive;
+
+        std::atomic<uint64_t> m_Hits;
+        std::atomic<uint64_t> m_NegativeHits;
+        std::atomic<uint64_t> m_Misses;
+        std::atomic<uint64_t> m_Expirations;
+        std::atomic<uint64_t> m_Invalidations;
+        std::atomic<uint64_t> m_Evictions;
+    };
+
+} // namespace ObseGPCompat
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "WorkerPool.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ObseGPCompat
+{
+
+    // Header of an .esp/.esm, from its TES4 record
+    struct ModFileInfo
+    {
+        std::filesystem::path path;
+        uint64_t size;
+        int64_t lastWriteTime; // file_time_type ticks
+
+        bool valid;    // Starts with a readable TES4 record
+        bool isMaster; // Master flag on the TES4 record
+        float version;
+        uint32_t recordCount;
+        std::string author;
+        std::vector<std::string> masters; // File names, in the order the plugin lists them
+    };
+
+    enum class LoadOrderIssue
+    {
+        MissingMaster,   // Not in the data directory at all
+        InactiveMaster,  // Present but not in the load order
+        MasterLoadsLater // Loaded after the plugin that needs it
+    };
+
+    struct LoadOrderProblem
+    {
+        LoadOrderIssue issue;
+        std::string plugin;
+        std::string master;
+    };
+
+    const char *GetLoadOrderIssueName(LoadOrderIssue issue);
+
+    // Reads the TES4 header record of every plugin in the data directory: flags, masters
+    // and record count. Each plugin is mapped and only its first record is touched, on
+    // the worker pool; results are cached by path, size and write time, and persisted
+    // between launches, so only new or changed plugins are read at all.
+    class ModFileScanner
+    {
+    public:
+        ModFileScanner();
+
+        bool LoadCache(const std::filesystem::path &cachePath);
+        bool SaveCache(const std::filesystem::path &cachePath) const;
+
+        // Scans every .esp and .esm in directory, sorted by path. Waits for pool, so it must
+        // not be called from one of the pool's threads.
+        std::vector<ModFileInfo> Scan(const std::filesystem::path &directory, WorkerPool &pool);
+
+        // Parses the TES4 record at the start of a plugin in memory
+        static bool Parse(const uint8_t *data, size_t size, ModFileInfo &info);
+
+        // Masters that would keep the game from loading plugins in loadOrder (file names).
+        // An empty loadOrder means every file, masters first, then by write time.
+        static std::vector<LoadOrderProblem> CheckLoadOrder(const std::vector<ModFileInfo> &files,
+                                                            std::vector<std::string> loadOrder);
+
+        size_t GetParsedCount() const { return m_Parsed; }
+
+    private:
+        ModFileInfo ScanFile(const std::filesystem::path &file, uint64_t size, int64_t lastWriteTime);
+
+        mutable std::mutex m_Mutex;
+        std::unordered_map<std::filesystem::path::string_type, ModFileInfo> m_Cache;
+        bool m_CacheChanged;
+        size_t m_Parsed;
+    };
+
+} // namespace ObseGPCompat
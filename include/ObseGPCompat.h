@@ -1,7 +1,10 @@
 #pragma once
 
-// Include our Windows wrapper first
+// Include our Windows wrapper first, so every translation unit sees the same Win32
+// names (CreateDirectory and friends are macros there)
+#ifdef _WIN32
 #include "WindowsWrapper.h"
+#endif
 
 // Standard includes
 #include <memory>
@@ -24,6 +27,7 @@ namespace ObseGPCompat
     };
 
     // Forward declarations
+    class MappingRegistry;
     class PathTranslator;
     class APIHookManager;
     class VirtualFileSystem;
@@ -35,6 +39,7 @@ namespace ObseGPCompat
     extern std::filesystem::path g_CompatLayerPath;
 
     // Global components
+    extern std::unique_ptr<MappingRegistry> g_MappingRegistry;
     extern std::unique_ptr<PathTranslator> g_PathTranslator;
     extern std::unique_ptr<APIHookManager> g_APIHookManager;
     extern std::unique_ptr<VirtualFileSystem> g_VirtualFileSystem;
@@ -45,6 +50,10 @@ namespace ObseGPCompat
     void Shutdown();
     void Log(LogLevel level, const char *format, ...);
 
+    // Log also writes to path from now on, until CloseLogFile
+    bool OpenLogFile(const std::filesystem::path &path);
+    void CloseLogFile();
+
     // Helper function
     std::filesystem::path GetLocalAppDataPath();
 }
\ No newline at end of file
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "PathUtils.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ObseGPCompat
+{
+
+    struct OverlayLayer
+    {
+        std::filesystem::path root;
+        int priority; // Higher priorities win; equal priorities go to the later layer
+    };
+
+    // Per-file winner index for one overlay mount: several real directories merged
+    // under a single virtual path, the way mod managers stack mod folders. The layers
+    // are scanned once when the mount is built, so resolving a file afterwards is a
+    // single probe into a flat table instead of a filesystem check per layer.
+    class OverlayIndex
+    {
+    public:
+        static constexpr uint32_t NoLayer = UINT32_MAX;
+
+        struct Layer
+        {
+            std::filesystem::path root;
+            int priority;
+            std::string rootString;
+            std::wstring rootStringW;
+        };
+
+        OverlayIndex();
+
+        // Scans every layer and records which one provides each relative file path
+        void Build(const std::vector<OverlayLayer> &layers);
+
+        // Layer providing relativePath (components below the mount point, either
+        // separator, any case), or NoLayer when no layer has that file
+        template <typename CharT>
+        uint32_t FindWinner(std::basic_string_view<CharT> relativePath) const;
+
+        const Layer &GetLayer(uint32_t index) const { return m_Layers[index]; }
+        size_t LayerCount() const { return m_Layers.size(); }
+        size_t FileCount() const { return m_FileCount; }
+        size_t ConflictCount() const { return m_ConflictCount; } // Files provided by more than one layer
+
+    private:
+        struct Slot
+        {
+            uint64_t hash;
+            uint32_t keyOffset; // Into m_Keys; NoLayer when the slot is empty
+            uint32_t keyLength;
+            uint32_t layer;
+        };
+
+        void Insert(std::wstring_view folded, uint32_t layer);
+        void Grow();
+
+        std::vector<Layer> m_Layers; // Ordered by ascending priority
+        std::vector<Slot> m_Slots;   // Power-of-two size, at most half full
+        std::wstring m_Keys;         // Folded relative paths, '\\'-separated, back to back
+        size_t m_FileCount;
+        size_t m_ConflictCount;
+    };
+
+} // namespace ObseGPCompat
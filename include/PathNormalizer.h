@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+namespace ObseGPCompat
+{
+
+    // True when path contains anything the lookups would not see through: doubled
+    // separators, '.' or '..' segments, or a \\.\ or \\?\UNC\ prefix. Either separator
+    // is fine on its own. Scans 16 characters per step with SSE2 where available.
+    template <typename CharT>
+    bool PathNeedsNormalization(std::basic_string_view<CharT> path);
+
+    // Canonicalizes path in one pass into buffer (which may be path itself, but must not
+    // otherwise overlap it):
+    // '\\' separators only, runs collapsed, '.' dropped, '..' resolved without climbing
+    // above the root, trailing separators removed, \\.\ dropped and \\?\UNC\ turned
+    // into \\. A \\?\ prefix is kept. Returns the length written (null-terminated),
+    // or 0 when the result does not fit in capacity.
+    template <typename CharT>
+    size_t NormalizePath(std::basic_string_view<CharT> path, CharT *buffer, size_t capacity);
+
+    // True for paths Windows resolves against the working directory: "foo\bar", "..\x"
+    // and "\foo" (rooted on the current drive). Drive-relative "C:foo" is not covered.
+    template <typename CharT>
+    bool IsRelativePath(std::basic_string_view<CharT> path);
+
+    // Joins a relative path onto the absolute base directory and normalizes the result
+    // into buffer; "\foo" takes only the drive of base (and stays as is if base has none).
+    // Returns the length written, or 0 when the result does not fit.
+    template <typename CharT>
+    size_t ResolveRelativePath(std::basic_string_view<CharT> path, std::basic_string_view<CharT> base,
+                               CharT *buffer, size_t capacity);
+
+} // namespace ObseGPCompat
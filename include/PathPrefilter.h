@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace ObseGPCompat
+{
+
+    // Cheap first-stage rejection for the hooks, built from the actual mapping roots.
+    // Each root contributes an anchor: its first AnchorLength characters, case-folded
+    // and with '/' treated as '\\'. A path can only translate if its folded head agrees
+    // with one of the anchors, which is checked with a single SSE2 compare per anchor.
+    template <typename CharT>
+    class BasicPathPrefilter
+    {
+    public:
+        using StringView = std::basic_string_view<CharT>;
+
+        static constexpr size_t AnchorLength = 16;
+
+        BasicPathPrefilter();
+
+        void Clear();
+        void Build(const std::vector<StringView> &prefixes);
+
+        // False means no mapping can cover this path; true means run the real lookup
+        bool MayMatch(StringView path) const;
+
+        size_t AnchorCount() const { return m_Anchors.size(); }
+
+    private:
+        struct Anchor
+        {
+            alignas(16) CharT chars[AnchorLength];
+            uint32_t mask; // Bit i set when chars[i] takes part in the compare
+            size_t length;
+        };
+
+        uint32_t CompareHead(const CharT *head, const Anchor &anchor) const;
+
+        std::vector<Anchor> m_Anchors;
+        size_t m_MinLength;
+    };
+
+    using PathPrefilter = BasicPathPrefilter<char>;
+    using WidePathPrefilter = BasicPathPrefilter<wchar_t>;
+
+} // namespace ObseGPCompat
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "PathUtils.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ObseGPCompat
+{
+
+    // Flat, case-insensitive map from directory prefixes to values, with
+    // longest-prefix lookup. Keys are stored as folded components joined by '\\'
+    // in an open-addressing table. A lookup hashes every ancestor of the path in one
+    // forward pass (the hash of each prefix is the running hash at its separator),
+    // then probes from the deepest ancestor up, so its cost is O(depth) probes.
+    // Either separator is accepted and runs of separators are treated as one.
+    template <typename CharT>
+    class BasicPathPrefixTable
+    {
+    public:
+        using StringView = std::basic_string_view<CharT>;
+        using String = std::basic_string<CharT>;
+
+        static constexpr uint32_t NoValue = UINT32_MAX;
+
+        // Keys deeper than this many components are rejected by Insert
+        static constexpr size_t MaxDepth = 64;
+
+        BasicPathPrefixTable();
+
+        void Clear();
+
+        // Maps prefix to value, replacing the value of an equal prefix
+        bool Insert(StringView prefix, uint32_t value);
+
+        // Returns the value of the longest mapped prefix of path (NoValue if none).
+        // matchedLength receives the number of characters of path covered by that prefix.
+        uint32_t FindLongest(StringView path, size_t *matchedLength = nullptr) const;
+
+        size_t Size() const { return m_Keys.size(); }
+
+    private:
+        struct Slot
+        {
+            uint64_t hash;
+            uint32_t key; // Index into m_Keys, NoValue when the slot is empty
+            uint32_t value;
+        };
+
+        uint32_t FindSlot(uint64_t hash, StringView path, size_t end) const;
+        void Grow();
+
+        std::vector<Slot> m_Slots; // Power-of-two size, at most half full
+        std::vector<String> m_Keys; // Folded components joined by '\\'
+        size_t m_MaxKeyDepth;
+    };
+
+    using PathPrefixTable = BasicPathPrefixTable<char>;
+    using WidePathPrefixTable = BasicPathPrefixTable<wchar_t>;
+
+} // namespace ObseGPCompat
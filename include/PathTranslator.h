@@ -1,8 +1,10 @@
 #pragma once
 
+#include "MappingRegistry.h"
+
 #include <filesystem>
-#include <map>
 #include <string>
+#include <string_view>
 
 namespace ObseGPCompat
 {
@@ -13,6 +15,9 @@ namespace ObseGPCompat
         PathTranslator();
         ~PathTranslator();
 
+        // Longest path the wide Win32 APIs accept (\\?\ form)
+        static constexpr size_t MaxPathLength = 32768;
+
         bool Initialize();
 
         // Path translation methods (simplified to focus on GamePass directories)
@@ -20,12 +25,28 @@ namespace ObseGPCompat
         bool IsObsePath(const std::filesystem::path &path);
         bool IsGamePath(const std::filesystem::path &path);
 
+        // Single-lookup translation for the hooks. Returns false without allocating
+        // when no mapping covers the path; otherwise fills translatedPath.
+        bool TryTranslate(std::string_view path, std::string &translatedPath) const;
+
+        // Cheap check against the mapping roots; false means TryTranslate cannot succeed
+        bool MayTranslate(std::string_view path) const;
+        bool MayTranslate(std::wstring_view path) const;
+
+        // Buffer-based translation: writes the null-terminated result into buffer without
+        // touching the heap. Returns false when nothing matches or the result does not fit.
+        // Paths with doubled separators, '.'/'..' segments or device prefixes are normalized
+        // into the same buffer first; relative paths are resolved against the working directory.
+        bool TryTranslate(std::string_view path, char *buffer, size_t capacity, size_t *length = nullptr) const;
+        bool TryTranslate(std::wstring_view path, wchar_t *buffer, size_t capacity, size_t *length = nullptr) const;
+
     private:
-        void BuildPathMappings();
+        template <typename CharT>
+        bool TranslateIntoBuffer(MappingDirection direction, std::basic_string_view<CharT> path,
+                                 CharT *buffer, size_t capacity, size_t *length) const;
 
-        // Maps for path translation - using string keys for compatibility
-        std::map<std::string, std::string> m_ObseToGamePaths;
-        std::map<std::string, std::string> m_GameToObsePaths;
+        // Shared with VirtualFileSystem; owned by g_MappingRegistry
+        const MappingRegistry *m_Registry;
     };
 
 } // namespace ObseGPCompat
\ No newline at end of file
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace ObseGPCompat
+{
+
+    // Path helpers shared by the lookup structures
+    template <typename CharT>
+    inline bool IsPathSeparator(CharT c)
+    {
+        return c == CharT('\\') || c == CharT('/');
+    }
+
+    // Matches a leading \\?\ (long path) prefix
+    template <typename CharT>
+    inline bool HasLongPathPrefix(std::basic_string_view<CharT> path)
+    {
+        return path.size() >= 4 && IsPathSeparator(path[0]) && IsPathSeparator(path[1]) &&
+               path[2] == CharT('?') && IsPathSeparator(path[3]);
+    }
+
+    template <typename CharT>
+    inline CharT FoldPathChar(CharT c)
+    {
+        // Windows paths are case-insensitive; ASCII folding covers the mapping roots we build
+        return (c >= CharT('A') && c <= CharT('Z')) ? CharT(c + ('a' - 'A')) : c;
+    }
+
+    // Folded, '\\'-separated, without trailing separators, so spellings of a path compare equal
+    template <typename CharT>
+    inline std::basic_string<CharT> FoldPath(std::basic_string_view<CharT> path)
+    {
+        while (!path.empty() && IsPathSeparator(path.back()))
+        {
+            path.remove_suffix(1);
+        }
+        std::basic_string<CharT> folded(path);
+        for (CharT &c : folded)
+        {
+            c = IsPathSeparator(c) ? CharT('\\') : FoldPathChar(c);
+        }
+        return folded;
+    }
+
+} // namespace ObseGPCompat
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+
+namespace ObseGPCompat
+{
+
+    // The little the core needs from the operating system. PlatformWindows.cpp implements
+    // it with Win32, PlatformPosix.cpp with POSIX; the rest of the core is written against
+    // this and the standard library, so it also builds and runs on Linux.
+    namespace Platform
+    {
+        enum class KnownFolder
+        {
+            LocalAppData // %LOCALAPPDATA%; $XDG_DATA_HOME or ~/.local/share elsewhere
+        };
+
+        // Empty if the folder cannot be determined
+        std::filesystem::path GetKnownFolder(KnownFolder folder);
+
+        struct LocalTime
+        {
+            int hour;
+            int minute;
+            int second;
+            int millisecond;
+        };
+
+        LocalTime GetLocalTime();
+
+        uint32_t GetCurrentThreadId();
+
+        // Why the last file operation below failed, in the cases callers tell apart
+        enum class FileError : uint8_t
+        {
+            None,
+            NotFound,      // The file is missing
+            PathNotFound,  // A directory on the way is missing
+            AlreadyExists,
+            NotSameDevice, // Links and renames cannot cross volumes
+            TooManyLinks,
+            AccessDenied,
+            Other
+        };
+
+        const char *GetFileErrorName(FileError error);
+
+        // For the calling thread, like GetLastError and errno
+        FileError GetLastFileError();
+
+        // Each fails if the target exists, unless it says otherwise. Removing or replacing
+        // a read-only file works on its name alone, so other hardlinks keep the file and its
+        // attributes.
+        bool MakeDirectory(std::basic_string_view<char> path);
+        bool MakeDirectory(std::basic_string_view<wchar_t> path);
+        bool LinkFile(const std::filesystem::path &link, const std::filesystem::path &existing);
+        bool SymlinkFile(const std::filesystem::path &link, const std::filesystem::path &target);
+        bool RenameFile(const std::filesystem::path &from, const std::filesystem::path &to, bool replaceExisting);
+        bool RemoveFile(const std::filesystem::path &path);
+
+        // Clears every write permission; shared by all hardlinks to the file
+        bool SetReadOnly(const std::filesystem::path &path);
+
+        // Maps a whole file read-only; fails for missing or empty files
+        bool MapFile(const std::filesystem::path &path, const void *&view, size_t &size);
+        void UnmapFile(const void *view, size_t size);
+
+        // Starts reading a mapped range into memory ahead of use
+        void PrefetchMemory(const void *address, size_t size);
+    }
+
+} // namespace ObseGPCompat
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "WorkerPool.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace ObseGPCompat
+{
+
+    struct PluginInfo
+    {
+        static constexpr uint16_t MachineAmd64 = 0x8664;
+
+        std::filesystem::path path;
+        uint64_t size;
+        int64_t lastWriteTime; // file_time_type ticks
+
+        bool valid;       // Parsed as a PE image
+        uint16_t machine; // IMAGE_FILE_MACHINE_*
+        bool isDll;
+        std::vector<std::string> exports; // Exported names
+        std::vector<std::string> imports; // Imported module names
+
+        bool HasExport(std::string_view name) const;
+        bool IsObsePlugin() const { return HasExport("OBSEPlugin_Load"); }
+    };
+
+    struct PluginScanStats
+    {
+        size_t plugins;
+        size_t parsed; // Read and parsed; the rest came from the cache
+        size_t cached;
+    };
+
+    // Reads the PE headers of the plugin DLLs in a directory: machine type, exports and
+    // imports, enough to tell up front which plugins OBSE can load. Each DLL is parsed
+    // on the worker pool, results are cached by path, size and write time (and persisted
+    // between launches), and every DLL's pages are read into memory on the way, so the
+    // loader finds them resident instead of faulting them in one by one.
+    class PluginScanner
+    {
+    public:
+        PluginScanner();
+
+        bool LoadCache(const std::filesystem::path &cachePath);
+        bool SaveCache(const std::filesystem::path &cachePath) const;
+
+        // Scans every .dll in directory, sorted by path. Waits for pool, so it must not be
+        // called from one of the pool's threads.
+        std::vector<PluginInfo> Scan(const std::filesystem::path &directory, WorkerPool &pool);
+
+        // Parses the headers of a PE image in memory
+        static bool Parse(const uint8_t *data, size_t size, PluginInfo &info);
+
+        const PluginScanStats &GetStats() const { return m_Stats; }
+
+    private:
+        PluginInfo ScanFile(const std::filesystem::path &file, uint64_t size, int64_t lastWriteTime);
+
+        mutable std::mutex m_Mutex;
+        std::unordered_map<std::filesystem::path::string_type, PluginInfo> m_Cache;
+        bool m_CacheChanged;
+        PluginScanStats m_Stats;
+    };
+
+} // namespace ObseGPCompat
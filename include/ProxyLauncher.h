@@ -28,6 +28,7 @@ namespace ObseGPCompat
         bool LaunchProcessSuspended(const std::filesystem::path &executablePath, const std::string &commandLine);
         bool ResumeProcess();
         bool InjectCompatibilityLayer(HANDLE processHandle);
+        bool DeployLinks(bool deploy);
 
         PROCESS_INFORMATION m_ProcessInfo;
     };
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "EpochReclaimer.h"
+
+#include <atomic>
+#include <memory>
+
+namespace ObseGPCompat
+{
+
+    // Holds the current immutable snapshot of some read-mostly state. Readers Load()
+    // inside an EpochReclaimer::ReadScope and may use the snapshot until the scope
+    // ends; writers build a complete replacement and Publish() it. The previous
+    // snapshot is retired and destroyed once no reader can still hold it.
+    template <typename T>
+    class SnapshotPointer
+    {
+    public:
+        SnapshotPointer()
+            : m_Current(nullptr)
+        {
+        }
+
+        // No readers may be left when the pointer itself goes away
+        ~SnapshotPointer()
+        {
+            delete m_Current.load();
+            EpochReclaimer::Reclaim();
+        }
+
+        SnapshotPointer(const SnapshotPointer &) = delete;
+        SnapshotPointer &operator=(const SnapshotPointer &) = delete;
+
+        const T *Load() const
+        {
+            return m_Current.load();
+        }
+
+        void Publish(std::unique_ptr<T> snapshot)
+        {
+            const T *previous = m_Current.exchange(snapshot.release());
+            if (previous)
+            {
+                EpochReclaimer::Retire([previous]()
+                                       { delete previous; });
+            }
+        }
+
+    private:
+        std::atomic<const T *> m_Current;
+    };
+
+} // namespace ObseGPCompat
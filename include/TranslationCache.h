@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace ObseGPCompat
+{
+
+    struct TranslationCacheStats
+    {
+        uint64_t hits;
+        uint64_t misses;
+    };
+
+    // Small direct-mapped, per-thread cache of prefix lookups, keyed by a hash of the
+    // raw incoming path. Entries are tagged with a global generation; Invalidate()
+    // moves to a new generation so every thread drops its stale entries without locks.
+    class TranslationCache
+    {
+    public:
+        static constexpr size_t EntryCount = 128; // Power of two
+
+        static void Invalidate();
+
+        static TranslationCacheStats GetStats();
+        static void ResetStats();
+
+        // Returns the cached result of find(path, matchedLength) for this owner, running
+        // find and remembering its result on the calling thread when it is not cached.
+        // owner must never be reused for another table, so it cannot be an address.
+        template <typename CharT, typename FindFn>
+        static uint32_t FindLongest(uint64_t owner, std::basic_string_view<CharT> path, size_t *matchedLength, FindFn &&find);
+
+    private:
+        template <typename CharT>
+        struct Entry
+        {
+            uint64_t generation = 0; // Zero never matches a live generation
+            uint64_t hash = 0;
+            uint64_t owner = 0;
+            std::basic_string<CharT> path;
+            uint32_t value = 0;
+            size_t matchedLength = 0;
+        };
+
+        template <typename CharT>
+        static Entry<CharT> *Entries()
+        {
+            static thread_local Entry<CharT> entries[EntryCount];
+            return entries;
+        }
+
+        template <typename CharT>
+        static uint64_t Hash(std::basic_string_view<CharT> path)
+        {
+            // FNV-1a over the raw code units
+            uint64_t hash = 14695981039346656037ull;
+            for (CharT c : path)
+            {
+                hash ^= static_cast<uint64_t>(c);
+                hash *= 1099511628211ull;
+            }
+            return hash;
+        }
+
+        static std::atomic<uint64_t> s_Generation;
+        static std::atomic<uint64_t> s_Hits;
+        static std::atomic<uint64_t> s_Misses;
+    };
+
+    template <typename CharT, typename FindFn>
+    uint32_t TranslationCache::FindLongest(uint64_t owner, std::basic_string_view<CharT> path, size_t *matchedLength, FindFn &&find)
+    {
+        uint64_t hash = Hash(path);
+        uint64_t generation = s_Generation.load(std::memory_order_acquire);
+        Entry<CharT> &entry = Entries<CharT>()[hash & (EntryCount - 1)];
+
+        if (entry.generation == generation && entry.hash == hash && entry.owner == owner &&
+            std::basic_string_view<CharT>(entry.path) == path)
+        {
+            s_Hits.fetch_add(1, std::memory_order_relaxed);
+            *matchedLength = entry.matchedLength;
+            return entry.value;
+        }
+
+        s_Misses.fetch_add(1, std::memory_order_relaxed);
+        uint32_t value = find(path, matchedLength);
+
+        // Reuses the entry's string storage once it has grown to typical path length
+        entry.generation = generation;
+        entry.hash = hash;
+        entry.owner = owner;
+        entry.path.assign(path);
+        entry.value = value;
+        entry.matchedLength = *matchedLength;
+        return value;
+    }
+
+} // namespace ObseGPCompat
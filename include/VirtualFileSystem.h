@@ -1,16 +1,58 @@
 #pragma once
 
-// Include our Windows wrapper first
+// Include our Windows wrapper first; CreateDirectory, DeleteFile and CopyFile below
+// are macros there, so every includer must see them the same way
+#ifdef _WIN32
 #include "WindowsWrapper.h"
+#endif
+#include "BsaArchive.h"
+#include "ContentStore.h"
+#include "CopyEngine.h"
+#include "DirectoryIndex.h"
+#include "DirectoryWatcher.h"
+#include "FileViewCache.h"
+#include "MappingRegistry.h"
+#include "MetadataCache.h"
+#include "ModFileScanner.h"
+#include "PluginScanner.h"
+#include "WorkerPool.h"
 
 // Standard includes
 #include <filesystem>
-#include <map>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
 #include <string>
+#include <vector>
 
 namespace ObseGPCompat
 {
 
+    enum class FileOperationType
+    {
+        Exists,
+        MakeDirectory,
+        Remove,
+        Copy
+    };
+
+    struct FileOperation
+    {
+        FileOperationType type;
+        std::filesystem::path path;        // Virtual path; the source of a copy
+        std::filesystem::path destination; // Copy only
+        bool overwrite;                    // Copy only
+    };
+
+    struct FileOperationResult
+    {
+        bool success; // For Exists, whether the path exists
+    };
+
+    using FileBatchCallback = std::function<void(const std::vector<FileOperationResult> &)>;
+
     class VirtualFileSystem
     {
     public:
@@ -22,6 +64,13 @@ namespace ObseGPCompat
         // Path mapping methods
         bool MapPath(const std::filesystem::path &virtualPath, const std::filesystem::path &realPath);
 
+        // Merges several real directories under one virtual path, by priority
+        bool MountOverlay(const std::filesystem::path &virtualPath, const std::vector<OverlayLayer> &layers);
+
+        // Makes the files inside a .bsa visible below virtualDirectory (usually Data) to
+        // FileExists and ListDirectory, without extracting them; loose files still win
+        bool MountArchive(const std::filesystem::path &virtualDirectory, const std::filesystem::path &archivePath);
+
         // Path translation methods
         std::filesystem::path TranslateToReal(const std::filesystem::path &virtualPath);
         std::filesystem::path TranslateToVirtual(const std::filesystem::path &realPath);
@@ -29,14 +78,109 @@ namespace ObseGPCompat
         // Filesystem operation methods
         bool IsVirtualPath(const std::filesystem::path &path);
         bool FileExists(const std::filesystem::path &virtualPath);
+        bool GetFileMetadata(const std::filesystem::path &virtualPath, FileMetadata &metadata);
+
+        // Names in a directory, from disk and from the archives mounted over it
+        std::vector<std::string> ListDirectory(const std::filesystem::path &virtualPath);
         bool CreateDirectory(const std::filesystem::path &virtualPath);
         bool DeleteFile(const std::filesystem::path &virtualPath);
-        bool CopyFile(const std::filesystem::path &srcVirtualPath, const std::filesystem::path &destVirtualPath, bool overwrite = false);
+        bool CopyFile(const std::filesystem::path &srcVirtualPath, const std::filesystem::path &destVirtualPath, bool overwrite = false,
+                      const CopyProgressCallback &progress = nullptr);
+
+        // Read-only bytes of the file at virtualPath, without copying; invalid if it cannot
+        // be read. Views of a file held at the same time share one mapping, which closes
+        // with the last of them.
+        FileView MapView(const std::filesystem::path &virtualPath);
+
+        // Stores sourcePath's content in the content store and exposes it at virtualPath
+        bool ImportFile(const std::filesystem::path &sourcePath, const std::filesystem::path &virtualPath, ContentId *id = nullptr);
+
+        // Hardlinks a stored object at virtualPath, or copies it there when the store is on
+        // another volume than the path's real location
+        bool ExposeContent(const ContentId &id, const std::filesystem::path &virtualPath);
+
+        // Headers of the OBSE plugin DLLs, as scanned during Initialize and again whenever
+        // the plugins directory changes
+        std::vector<PluginInfo> GetPlugins() const;
+
+        // Headers of the .esp/.esm files in Data, kept current the same way
+        std::vector<ModFileInfo> GetModFiles() const;
+
+        // Batched form of the operations above, run on the worker pool. All paths are
+        // translated against one mapping snapshot. Operations on the same path, or below a
+        // directory the batch creates or removes, run on one worker in submission order;
+        // all others run concurrently, even within one directory. Results come back in
+        // submission order, through onComplete (called on a worker) and then the future.
+        std::future<std::vector<FileOperationResult>> SubmitBatch(std::vector<FileOperation> operations,
+                                                                  FileBatchCallback onComplete = nullptr);
 
     private:
-        // Maps for path translation
-        std::map<std::string, std::string> m_VirtualToRealPaths;
-        std::map<std::string, std::string> m_RealToVirtualPaths;
+        struct ArchiveMount
+        {
+            std::string root; // Real directory, folded and '\\'-separated
+            std::string path; // The archive itself, folded the same way
+            std::shared_ptr<const BsaArchive> archive;
+        };
+
+        std::vector<std::filesystem::path> GetRealRoots() const;
+        void BuildDirectoryIndex();
+        void MountDataArchives();
+        void RemountArchive(const std::filesystem::path &virtualDirectory, const std::filesystem::path &archivePath);
+        void ScanPlugins();
+        void ScanModFiles();
+        void StartWatching();
+        void ApplyChanges(const std::vector<FileChange> &changes, const std::vector<std::filesystem::path> &overflowedRoots);
+        bool IsInArchive(const std::filesystem::path &realPath);
+        std::filesystem::path Translate(MappingDirection direction, const std::filesystem::path &path, const char *description);
+        std::filesystem::path Translate(const MappingSnapshot &mappings, MappingDirection direction,
+                                        const std::filesystem::path &path, const char *description);
+
+        // The operations themselves, on real paths
+        bool FileExistsAt(const std::filesystem::path &realPath);
+        bool CreateDirectoryAt(const std::filesystem::path &realPath);
+        bool DeleteFileAt(const std::filesystem::path &realPath);
+        bool CopyFileAt(const std::filesystem::path &srcRealPath, const std::filesystem::path &destRealPath, bool overwrite,
+                        const CopyProgressCallback &progress);
+        bool RunOperation(const FileOperation &operation);
+
+        // Shared with PathTranslator; owned by g_MappingRegistry
+        MappingRegistry *m_Registry;
+
+        // Existence, size, times and attributes of real paths, including misses
+        MetadataCache m_MetadataCache;
+
+        // Names below the mapped real roots, so most existence checks skip the disk
+        DirectoryIndex m_DirectoryIndex;
+
+        // Read-only archives mounted over real directories
+        std::shared_mutex m_ArchiveMutex;
+        std::vector<ArchiveMount> m_Archives;
+
+        // Mappings behind the views MapView has handed out
+        FileViewCache m_ViewCache;
+
+        // Block clone, or chunked overlapped copies split across threads for large files
+        CopyEngine m_CopyEngine;
+
+        // Deduplicated file contents, exposed by hardlink
+        ContentStore m_ContentStore;
+
+        // OBSE plugin headers, cached between launches
+        PluginScanner m_PluginScanner;
+        std::vector<PluginInfo> m_Plugins;
+
+        // TES4 headers of the game plugins in Data, cached between launches
+        ModFileScanner m_ModFileScanner;
+        std::vector<ModFileInfo> m_ModFiles;
+
+        // Guards the scan results, which the watcher replaces while others read them
+        mutable std::mutex m_ScanMutex;
+
+        // Runs batches; declared after everything its tasks use, so it drains and joins before they go away
+        std::unique_ptr<WorkerPool> m_WorkerPool;
+
+        // Changes made behind the layer's back; its handler uses everything above, so it stops first
+        DirectoryWatcher m_Watcher;
     };
 
 } // namespace ObseGPCompat
\ No newline at end of file
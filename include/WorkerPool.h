@@ -0,0 +1,39 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ObseGPCompat
+{
+
+    // Fixed set of threads draining one task queue. Tasks still queued when the pool is
+    // destroyed are run before the threads are joined, so nothing submitted is lost.
+    class WorkerPool
+    {
+    public:
+        explicit WorkerPool(size_t threadCount);
+        ~WorkerPool();
+
+        WorkerPool(const WorkerPool &) = delete;
+        WorkerPool &operator=(const WorkerPool &) = delete;
+
+        void Submit(std::function<void()> task);
+
+        size_t ThreadCount() const { return m_Threads.size(); }
+
+    private:
+        void Run();
+
+        std::mutex m_Mutex;
+        std::condition_variable m_Wake;
+        std::deque<std::function<void()>> m_Tasks;
+        bool m_Stopping;
+        std::vector<std::thread> m_Threads;
+    };
+
+} // namespace ObseGPCompat
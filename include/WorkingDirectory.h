@@ -0,0 +1,34 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace ObseGPCompat
+{
+
+    // Per-thread snapshot of the process working directory. The hooks on
+    // SetCurrentDirectory bump a global version; a thread only queries the real
+    // working directory again when the version it cached against has moved on.
+    class WorkingDirectory
+    {
+    public:
+        // Call after the working directory has changed
+        static void Invalidate();
+
+        static uint64_t Version() { return s_Version.load(std::memory_order_acquire); }
+
+        // The current working directory as of the latest Invalidate(). The view stays
+        // valid on the calling thread until its next Get() of the same character type.
+        template <typename CharT>
+        static std::basic_string_view<CharT> Get();
+
+    private:
+        template <typename CharT>
+        static std::basic_string<CharT> Query();
+
+        static std::atomic<uint64_t> s_Version;
+    };
+
+} // namespace ObseGPCompat
@@ -1,6 +1,9 @@
 #include "APIHookManager.h"
 #include "ObseGPCompat.h"
+#include "DirectoryMaterializer.h"
 #include "PathTranslator.h"
+#include "Platform.h"
+#include "WorkingDirectory.h"
 #include "DetoursWrapper.h" // Use our detours wrapper
 
 #pragma comment(lib, "detours.lib")
@@ -20,6 +23,135 @@ namespace ObseGPCompat
     static HMODULE(WINAPI *OriginalLoadLibraryW)(LPCWSTR) = LoadLibraryW;
     static HMODULE(WINAPI *OriginalLoadLibraryExA)(LPCSTR, HANDLE, DWORD) = LoadLibraryExA;
     static HMODULE(WINAPI *OriginalLoadLibraryExW)(LPCWSTR, HANDLE, DWORD) = LoadLibraryExW;
+    static BOOL(WINAPI *OriginalSetCurrentDirectoryA)(LPCSTR) = SetCurrentDirectoryA;
+    static BOOL(WINAPI *OriginalSetCurrentDirectoryW)(LPCWSTR) = SetCurrentDirectoryW;
+
+    // Per-thread scratch buffers for translated paths, allocated on first use.
+    // Hooks can nest (a DllMain run by LoadLibraryW may open files), so every
+    // nesting level gets its own buffer.
+    template <typename CharT>
+    class ScopedPathBuffer
+    {
+    public:
+        static constexpr size_t Capacity = PathTranslator::MaxPathLength;
+
+        ScopedPathBuffer()
+        {
+            size_t level = s_Depth++;
+            if (level < MaxDepth)
+            {
+                if (!s_Buffers[level])
+                {
+                    s_Buffers[level] = std::make_unique<CharT[]>(Capacity);
+                }
+                m_Data = s_Buffers[level].get();
+            }
+            else
+            {
+                m_Overflow = std::make_unique<CharT[]>(Capacity);
+                m_Data = m_Overflow.get();
+            }
+        }
+
+        ~ScopedPathBuffer()
+        {
+            --s_Depth;
+        }
+
+        CharT *Data() const { return m_Data; }
+
+    private:
+        static constexpr size_t MaxDepth = 4;
+        static thread_local size_t s_Depth;
+        static thread_local std::unique_ptr<CharT[]> s_Buffers[MaxDepth];
+
+        CharT *m_Data;
+        std::unique_ptr<CharT[]> m_Overflow;
+    };
+
+    template <typename CharT>
+    thread_local size_t ScopedPathBuffer<CharT>::s_Depth = 0;
+
+    template <typename CharT>
+    thread_local std::unique_ptr<CharT[]> ScopedPathBuffer<CharT>::s_Buffers[ScopedPathBuffer<CharT>::MaxDepth];
+
+    // Bare module names go through the DLL search order rather than the working
+    // directory, so only names with a directory part are treated as paths
+    template <typename CharT>
+    static bool IsModulePath(const CharT *name)
+    {
+        for (; *name; ++name)
+        {
+            if (*name == CharT('\\') || *name == CharT('/') || *name == CharT(':'))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // True when CreateFile with this disposition may create the file, so its directory
+    // has to exist. The desired access does not matter: OPEN_ALWAYS creates the file
+    // even for a read-only open, and nothing else creates one.
+    static bool CreatesFile(DWORD creationDisposition)
+    {
+        return creationDisposition == CREATE_NEW || creationDisposition == CREATE_ALWAYS ||
+               creationDisposition == OPEN_ALWAYS;
+    }
+
+    // A read-only file with other links is a content store object exposed at this path
+    static bool IsStoreLink(const std::filesystem::path &path)
+    {
+        DWORD attributes = GetFileAttributesW(path.c_str());
+        if (attributes == INVALID_FILE_ATTRIBUTES || !(attributes & FILE_ATTRIBUTE_READONLY))
+        {
+            return false;
+        }
+
+        HANDLE file = OriginalCreateFileW(path.c_str(), 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                          nullptr, OPEN_EXISTING, 0, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            return false;
+        }
+        BY_HANDLE_FILE_INFORMATION info = {};
+        bool linked = GetFileInformationByHandle(file, &info) && info.nNumberOfLinks > 1;
+        CloseHandle(file);
+        return linked;
+    }
+
+    // Opens a redirected path through open. Only an open that can create the file needs
+    // its directory, and that directory is created on the first such open.
+    template <typename CharT, typename OpenFn>
+    static HANDLE OpenRedirected(const CharT *path, DWORD creationDisposition, OpenFn &&open)
+    {
+        bool createsFile = CreatesFile(creationDisposition);
+        if (createsFile)
+        {
+            DirectoryMaterializer::EnsureParentDirectory(std::basic_string_view<CharT>(path));
+        }
+
+        HANDLE handle = open(path);
+        if (handle == INVALID_HANDLE_VALUE && createsFile && GetLastError() == ERROR_PATH_NOT_FOUND)
+        {
+            // The directory was removed after it was remembered; create it again once
+            DirectoryMaterializer::ForgetParentDirectory(std::basic_string_view<CharT>(path));
+            if (DirectoryMaterializer::EnsureParentDirectory(std::basic_string_view<CharT>(path)))
+            {
+                handle = open(path);
+            }
+        }
+        else if (handle == INVALID_HANDLE_VALUE && creationDisposition == CREATE_ALWAYS &&
+                 GetLastError() == ERROR_ACCESS_DENIED && IsStoreLink(path))
+        {
+            // Writing a new file there replaces the link; the object keeps its content
+            if (Platform::RemoveFile(path))
+            {
+                handle = open(path);
+            }
+        }
+        return handle;
+    }
 
     // API hook implementations
     HANDLE WINAPI HookedCreateFileW(
@@ -31,43 +163,27 @@ namespace ObseGPCompat
         DWORD dwFlagsAndAttributes,
         HANDLE hTemplateFile)
     {
-        // Convert wide string to narrow for logging
-        char narrowPath[MAX_PATH];
-        WideCharToMultiByte(CP_ACP, 0, lpFileName, -1, narrowPath, MAX_PATH, NULL, NULL);
-
-        // Only handle paths related to Oblivion or OBSE
-        if (strstr(narrowPath, "Oblivion") != nullptr || strstr(narrowPath, "OBSE") != nullptr || strstr(narrowPath, "obse") != nullptr)
+        // Only handle paths that can fall under one of the OBSE mapping roots
+        if (lpFileName && g_PathTranslator->MayTranslate(lpFileName))
         {
-            Log(LogLevel::Debug, "CreateFileW called for: %s", narrowPath);
+            Log(LogLevel::Debug, "CreateFileW called for: %ls", lpFileName);
 
-            // Convert path from OBSE to Game Pass if necessary
-            std::filesystem::path filePath(lpFileName);
-            if (g_PathTranslator->IsObsePath(filePath))
+            // Translate the UTF-16 path directly, without round-tripping through ANSI
+            ScopedPathBuffer<wchar_t> gamePassPath;
+            if (g_PathTranslator->TryTranslate(lpFileName, gamePassPath.Data(), gamePassPath.Capacity))
             {
-                std::filesystem::path gamePassPath = g_PathTranslator->TranslateObsePath(filePath);
-
-                // Convert back to wide string
-                wchar_t wideGamePassPath[MAX_PATH];
-                MultiByteToWideChar(CP_ACP, 0, gamePassPath.string().c_str(), -1, wideGamePassPath, MAX_PATH);
-
-                Log(LogLevel::Debug, "Redirecting CreateFileW to: %s", gamePassPath.string().c_str());
-
-                // Create directories if needed
-                std::filesystem::path dirPath = gamePassPath.parent_path();
-                if (!std::filesystem::exists(dirPath))
-                {
-                    std::filesystem::create_directories(dirPath);
-                }
+                Log(LogLevel::Debug, "Redirecting CreateFileW to: %ls", gamePassPath.Data());
 
                 // Call original function with translated path
-                return OriginalCreateFileW(
-                    wideGamePassPath,
-                    dwDesiredAccess,
-                    dwShareMode,
-                    lpSecurityAttributes,
-                    dwCreationDisposition,
-                    dwFlagsAndAttributes,
-                    hTemplateFile);
+                return OpenRedirected(gamePassPath.Data(), dwCreationDisposition, [&](const wchar_t *path)
+                                      { return OriginalCreateFileW(
+                                            path,
+                                            dwDesiredAccess,
+                                            dwShareMode,
+                                            lpSecurityAttributes,
+                                            dwCreationDisposition,
+                                            dwFlagsAndAttributes,
+                                            hTemplateFile); });
             }
         }
 
@@ -91,35 +207,27 @@ namespace ObseGPCompat
         DWORD dwFlagsAndAttributes,
         HANDLE hTemplateFile)
     {
-        // Only handle paths related to Oblivion or OBSE
-        if (strstr(lpFileName, "Oblivion") != nullptr || strstr(lpFileName, "OBSE") != nullptr || strstr(lpFileName, "obse") != nullptr)
+        // Only handle paths that can fall under one of the OBSE mapping roots
+        if (lpFileName && g_PathTranslator->MayTranslate(lpFileName))
         {
             Log(LogLevel::Debug, "CreateFileA called for: %s", lpFileName);
 
             // Convert path from OBSE to Game Pass if necessary
-            std::filesystem::path filePath(lpFileName);
-            if (g_PathTranslator->IsObsePath(filePath))
+            ScopedPathBuffer<char> gamePassPath;
+            if (g_PathTranslator->TryTranslate(lpFileName, gamePassPath.Data(), gamePassPath.Capacity))
             {
-                std::filesystem::path gamePassPath = g_PathTranslator->TranslateObsePath(filePath);
-
-                Log(LogLevel::Debug, "Redirecting CreateFileA to: %s", gamePassPath.string().c_str());
-
-                // Create directories if needed
-                std::filesystem::path dirPath = gamePassPath.parent_path();
-                if (!std::filesystem::exists(dirPath))
-                {
-                    std::filesystem::create_directories(dirPath);
-                }
+                Log(LogLevel::Debug, "Redirecting CreateFileA to: %s", gamePassPath.Data());
 
                 // Call original function with translated path
-                return OriginalCreateFileA(
-                    gamePassPath.string().c_str(),
-                    dwDesiredAccess,
-                    dwShareMode,
-                    lpSecurityAttributes,
-                    dwCreationDisposition,
-                    dwFlagsAndAttributes,
-                    hTemplateFile);
+                return OpenRedirected(gamePassPath.Data(), dwCreationDisposition, [&](const char *path)
+                                      { return OriginalCreateFileA(
+                                            path,
+                                            dwDesiredAccess,
+                                            dwShareMode,
+                                            lpSecurityAttributes,
+                                            dwCreationDisposition,
+                                            dwFlagsAndAttributes,
+                                            hTemplateFile); });
             }
         }
 
@@ -136,28 +244,19 @@ namespace ObseGPCompat
 
     HMODULE WINAPI HookedLoadLibraryA(LPCSTR lpLibFileName)
     {
-        // Only handle paths related to OBSE
-        if (strstr(lpLibFileName, "obse") != nullptr || strstr(lpLibFileName, "OBSE") != nullptr)
+        // Only handle paths that can fall under one of the OBSE mapping roots
+        if (lpLibFileName && IsModulePath(lpLibFileName) && g_PathTranslator->MayTranslate(lpLibFileName))
         {
             Log(LogLevel::Debug, "LoadLibraryA called for: %s", lpLibFileName);
 
             // Convert path from OBSE to Game Pass if necessary
-            std::filesystem::path libPath(lpLibFileName);
-            if (g_PathTranslator->IsObsePath(libPath))
+            ScopedPathBuffer<char> gamePassPath;
+            if (g_PathTranslator->TryTranslate(lpLibFileName, gamePassPath.Data(), gamePassPath.Capacity))
             {
-                std::filesystem::path gamePassPath = g_PathTranslator->TranslateObsePath(libPath);
-
-                Log(LogLevel::Debug, "Redirecting LoadLibraryA to: %s", gamePassPath.string().c_str());
-
-                // Create directories if needed
-                std::filesystem::path dirPath = gamePassPath.parent_path();
-                if (!std::filesystem::exists(dirPath))
-                {
-                    std::filesystem::create_directories(dirPath);
-                }
+                Log(LogLevel::Debug, "Redirecting LoadLibraryA to: %s", gamePassPath.Data());
 
                 // Call original function with translated path
-                return OriginalLoadLibraryA(gamePassPath.string().c_str());
+                return OriginalLoadLibraryA(gamePassPath.Data());
             }
         }
 
@@ -167,37 +266,19 @@ namespace ObseGPCompat
 
     HMODULE WINAPI HookedLoadLibraryW(LPCWSTR lpLibFileName)
     {
-        // Convert wide string to narrow for logging and checking
-        char narrowPath[MAX_PATH];
-        WideCharToMultiByte(CP_ACP, 0, lpLibFileName, -1, narrowPath, MAX_PATH, NULL, NULL);
-
-        // Only handle paths related to OBSE
-        if (strstr(narrowPath, "obse") != nullptr || strstr(narrowPath, "OBSE") != nullptr)
+        // Only handle paths that can fall under one of the OBSE mapping roots
+        if (lpLibFileName && IsModulePath(lpLibFileName) && g_PathTranslator->MayTranslate(lpLibFileName))
         {
-            Log(LogLevel::Debug, "LoadLibraryW called for: %s", narrowPath);
+            Log(LogLevel::Debug, "LoadLibraryW called for: %ls", lpLibFileName);
 
-            // Convert path from OBSE to Game Pass if necessary
-            std::filesystem::path libPath(lpLibFileName);
-            if (g_PathTranslator->IsObsePath(libPath))
+            // Translate the UTF-16 path directly, without round-tripping through ANSI
+            ScopedPathBuffer<wchar_t> gamePassPath;
+            if (g_PathTranslator->TryTranslate(lpLibFileName, gamePassPath.Data(), gamePassPath.Capacity))
             {
-                std::filesystem::path gamePassPath = g_PathTranslator->TranslateObsePath(libPath);
-
-                // Convert back to wide string
-                wchar_t wideGamePassPath[MAX_PATH];
-                MultiByteToWideChar(CP_ACP, 0, gamePassPath.string().c_str(), -1, wideGamePassPath, MAX_PATH);
-
-                Log(LogLevel::Debug, "Redirecting LoadLibraryW to: %s", gamePassPath.string().c_str());
-
-                // Create directories if needed
-                std::filesystem::path dirPath = gamePassPath.parent_path();
-                if (!std::filesystem::exists(dirPath))
-                {
-                    Log(LogLevel::Info, "Creating directory for DLL: %s", dirPath.string().c_str());
-                    std::filesystem::create_directories(dirPath);
-                }
+                Log(LogLevel::Debug, "Redirecting LoadLibraryW to: %ls", gamePassPath.Data());
 
                 // Call original function with translated path
-                return OriginalLoadLibraryW(wideGamePassPath);
+                return OriginalLoadLibraryW(gamePassPath.Data());
             }
         }
 
@@ -205,6 +286,24 @@ namespace ObseGPCompat
         return OriginalLoadLibraryW(lpLibFileName);
     }
 
+    BOOL WINAPI HookedSetCurrentDirectoryA(LPCSTR lpPathName)
+    {
+        BOOL result = OriginalSetCurrentDirectoryA(lpPathName);
+
+        // Relative paths resolve against the new directory from now on
+        WorkingDirectory::Invalidate();
+        return result;
+    }
+
+    BOOL WINAPI HookedSetCurrentDirectoryW(LPCWSTR lpPathName)
+    {
+        BOOL result = OriginalSetCurrentDirectoryW(lpPathName);
+
+        // Relative paths resolve against the new directory from now on
+        WorkingDirectory::Invalidate();
+        return result;
+    }
+
     APIHookManager::APIHookManager()
     {
         // Constructor
@@ -229,12 +328,16 @@ namespace ObseGPCompat
         DetourAttach(&(PVOID &)OriginalCreateFileA, HookedCreateFileA);
         DetourAttach(&(PVOID &)OriginalLoadLibraryA, HookedLoadLibraryA);
         DetourAttach(&(PVOID &)OriginalLoadLibraryW, HookedLoadLibraryW);
+        DetourAttach(&(PVOID &)OriginalSetCurrentDirectoryA, HookedSetCurrentDirectoryA);
+        DetourAttach(&(PVOID &)OriginalSetCurrentDirectoryW, HookedSetCurrentDirectoryW);
 
         // Add hook info to our list
         m_Hooks.push_back({(void *)OriginalCreateFileW, (void *)HookedCreateFileW, "kernel32.dll", "CreateFileW"});
         m_Hooks.push_back({(void *)OriginalCreateFileA, (void *)HookedCreateFileA, "kernel32.dll", "CreateFileA"});
         m_Hooks.push_back({(void *)OriginalLoadLibraryA, (void *)HookedLoadLibraryA, "kernel32.dll", "LoadLibraryA"});
         m_Hooks.push_back({(void *)OriginalLoadLibraryW, (void *)HookedLoadLibraryW, "kernel32.dll", "LoadLibraryW"});
+        m_Hooks.push_back({(void *)OriginalSetCurrentDirectoryA, (void *)HookedSetCurrentDirectoryA, "kernel32.dll", "SetCurrentDirectoryA"});
+        m_Hooks.push_back({(void *)OriginalSetCurrentDirectoryW, (void *)HookedSetCurrentDirectoryW, "kernel32.dll", "SetCurrentDirectoryW"});
 
         // Commit transaction
         LONG result = DetourTransactionCommit();
@@ -0,0 +1,314 @@
+#include "BsaArchive.h"
+#include "ObseGPCompat.h"
+#include "MappedFile.h"
+#include "PathUtils.h"
+
+#include <cstring>
+
+namespace ObseGPCompat
+{
+
+    namespace
+    {
+        constexpr uint32_t ArchiveMagic = 0x00415342; // "BSA\0"
+
+        constexpr uint32_t FlagDirectoryNames = 0x1;
+        constexpr uint32_t FlagFileNames = 0x2;
+        constexpr uint32_t FlagCompressed = 0x4;
+
+        constexpr uint32_t FileSizeCompressionToggle = 0x40000000;
+        constexpr uint32_t FileSizeMask = 0x3FFFFFFF;
+
+        struct ArchiveHeader
+        {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t folderRecordOffset;
+            uint32_t archiveFlags;
+            uint32_t folderCount;
+            uint32_t fileCount;
+            uint32_t totalFolderNameLength;
+            uint32_t totalFileNameLength;
+            uint32_t fileFlags;
+        };
+
+        struct FolderRecord
+        {
+            uint64_t nameHash;
+            uint32_t fileCount;
+            uint32_t offset;
+        };
+
+        struct FileRecord
+        {
+            uint64_t nameHash;
+            uint32_t size;
+            uint32_t offset;
+        };
+
+        static_assert(sizeof(ArchiveHeader) == 36, "BSA header layout");
+        static_assert(sizeof(FolderRecord) == 16, "BSA folder record layout");
+        static_assert(sizeof(FileRecord) == 16, "BSA file record layout");
+
+        // Bounds-checked reads from the archive bytes
+        class Reader
+        {
+        public:
+            Reader(const uint8_t *data, size_t size) : m_Data(data), m_Size(size), m_Position(0) {}
+
+            bool Seek(size_t position)
+            {
+                if (position > m_Size)
+                {
+                    return false;
+                }
+                m_Position = position;
+                return true;
+            }
+
+            template <typename T>
+            bool Read(T &value)
+            {
+                if (m_Size - m_Position < sizeof(T))
+                {
+                    return false;
+                }
+                std::memcpy(&value, m_Data + m_Position, sizeof(T));
+                m_Position += sizeof(T);
+                return true;
+            }
+
+            // A length byte that counts the terminating zero, then the name
+            bool ReadLengthPrefixedName(std::string_view &name)
+            {
+                uint8_t length = 0;
+                if (!Read(length) || length == 0 || m_Size - m_Position < length)
+                {
+                    return false;
+                }
+                name = std::string_view(reinterpret_cast<const char *>(m_Data + m_Position), length - 1);
+                m_Position += length;
+                return true;
+            }
+
+            bool ReadZeroTerminatedName(std::string_view &name)
+            {
+                const void *end = std::memchr(m_Data + m_Position, 0, m_Size - m_Position);
+                if (!end)
+                {
+                    return false;
+                }
+                size_t length = static_cast<const uint8_t *>(end) - (m_Data + m_Position);
+                name = std::string_view(reinterpret_cast<const char *>(m_Data + m_Position), length);
+                m_Position += length + 1;
+                return true;
+            }
+
+        private:
+            const uint8_t *m_Data;
+            size_t m_Size;
+            size_t m_Position;
+        };
+    }
+
+    BsaArchive::BsaArchive()
+    {
+    }
+
+    std::string BsaArchive::MakeKey(std::string_view relativePath)
+    {
+        // Folded, '\\'-separated, without leading or trailing separators
+        while (!relativePath.empty() && IsPathSeparator(relativePath.front()))
+        {
+            relativePath.remove_prefix(1);
+        }
+        while (!relativePath.empty() && IsPathSeparator(relativePath.back()))
+        {
+            relativePath.remove_suffix(1);
+        }
+
+        // Files at the root of an archive sit in a folder named "."
+        if (relativePath == ".")
+        {
+            return std::string();
+        }
+
+        std::string key(relativePath);
+        for (char &c : key)
+        {
+            c = IsPathSeparator(c) ? '\\' : FoldPathChar(c);
+        }
+        return key;
+    }
+
+    ArchiveFolder &BsaArchive::AddFolder(const std::string &key)
+    {
+        auto inserted = m_Folders.try_emplace(key);
+        if (inserted.second && !key.empty())
+        {
+            // A new folder is also a new child of its parent, which may itself be new
+            size_t separator = key.rfind('\\');
+            std::string parent = separator == std::string::npos ? std::string() : key.substr(0, separator);
+            std::string name = separator == std::string::npos ? key : key.substr(separator + 1);
+            AddFolder(parent).folders.push_back(std::move(name));
+        }
+        return m_Folders[key];
+    }
+
+    bool BsaArchive::Open(const std::filesystem::path &archivePath)
+    {
+        MappedFile file;
+        if (!file.Open(archivePath))
+        {
+            Log(LogLevel::Warning, "Failed to open archive: %s", archivePath.string().c_str());
+            return false;
+        }
+
+        if (!Load(file.Data(), file.Size()))
+        {
+            Log(LogLevel::Warning, "Not a supported archive: %s", archivePath.string().c_str());
+            return false;
+        }
+
+        m_Path = archivePath;
+        return true;
+    }
+
+    bool BsaArchive::Load(const uint8_t *data, size_t size)
+    {
+        m_Files.clear();
+        m_Folders.clear();
+
+        Reader reader(data, size);
+        ArchiveHeader header = {};
+        if (!reader.Read(header) || header.magic != ArchiveMagic || header.version != Version)
+        {
+            return false;
+        }
+
+        // Without names only the hashes could be matched
+        if ((header.archiveFlags & (FlagDirectoryNames | FlagFileNames)) != (FlagDirectoryNames | FlagFileNames))
+        {
+            return false;
+        }
+
+        // The counts size the allocations below, so they must fit in the file first: every
+        // folder takes a record, every file a record and at least a terminated name
+        if (header.folderRecordOffset > size ||
+            header.folderCount > (size - header.folderRecordOffset) / sizeof(FolderRecord))
+        {
+            return false;
+        }
+        size_t remaining = size - header.folderRecordOffset - header.folderCount * sizeof(FolderRecord);
+        if (header.fileCount > remaining / (sizeof(FileRecord) + 1))
+        {
+            return false;
+        }
+
+        std::vector<FolderRecord> folderRecords(header.folderCount);
+        if (!reader.Seek(header.folderRecordOffset))
+        {
+            return false;
+        }
+        for (FolderRecord &record : folderRecords)
+        {
+            if (!reader.Read(record))
+            {
+                return false;
+            }
+        }
+
+        // Each folder's name and file records follow the folder table, in folder order
+        struct PendingFile
+        {
+            const std::string *folder;
+            ArchiveFile file;
+        };
+        std::vector<PendingFile> files;
+        files.reserve(header.fileCount);
+        std::vector<std::string> folderKeys;
+        folderKeys.reserve(header.folderCount);
+
+        for (const FolderRecord &folderRecord : folderRecords)
+        {
+            std::string_view folderName;
+            if (!reader.ReadLengthPrefixedName(folderName))
+            {
+                return false;
+            }
+            folderKeys.push_back(MakeKey(folderName));
+
+            for (uint32_t i = 0; i < folderRecord.fileCount; ++i)
+            {
+                FileRecord record = {};
+                if (!reader.Read(record) || files.size() >= header.fileCount)
+                {
+                    return false;
+                }
+
+                bool compressed = (header.archiveFlags & FlagCompressed) != 0;
+                if (record.size & FileSizeCompressionToggle)
+                {
+                    compressed = !compressed;
+                }
+                files.push_back({nullptr, {record.size & FileSizeMask, record.offset, compressed}});
+            }
+        }
+
+        if (files.size() != header.fileCount)
+        {
+            return false;
+        }
+
+        // folderKeys no longer grows, so the pointers into it stay valid
+        size_t fileIndex = 0;
+        for (size_t i = 0; i < folderRecords.size(); ++i)
+        {
+            for (uint32_t j = 0; j < folderRecords[i].fileCount; ++j)
+            {
+                files[fileIndex++].folder = &folderKeys[i];
+            }
+        }
+
+        // Then all file names, in file record order
+        m_Files.reserve(files.size());
+        for (const PendingFile &pending : files)
+        {
+            std::string_view fileName;
+            if (!reader.ReadZeroTerminatedName(fileName))
+            {
+                m_Files.clear();
+                m_Folders.clear();
+                return false;
+            }
+
+            std::string name = MakeKey(fileName);
+            std::string key = pending.folder->empty() ? name : *pending.folder + '\\' + name;
+            if (m_Files.emplace(std::move(key), pending.file).second)
+            {
+                AddFolder(*pending.folder).files.push_back(std::move(name));
+            }
+        }
+
+        // Folders without files still exist
+        for (const std::string &folderKey : folderKeys)
+        {
+            AddFolder(folderKey);
+        }
+
+        return true;
+    }
+
+    const ArchiveFile *BsaArchive::FindFile(std::string_view relativePath) const
+    {
+        auto it = m_Files.find(MakeKey(relativePath));
+        return it != m_Files.end() ? &it->second : nullptr;
+    }
+
+    const ArchiveFolder *BsaArchive::FindFolder(std::string_view relativePath) const
+    {
+        auto it = m_Folders.find(MakeKey(relativePath));
+        return it != m_Folders.end() ? &it->second : nullptr;
+    }
+
+} // namespace ObseGPCompat
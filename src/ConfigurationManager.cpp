@@ -2,8 +2,6 @@
 #include "ObseGPCompat.h"
 #include <fstream>
 #include <sstream>
-#include <Windows.h>
-#include <shlobj.h>
 #include <algorithm>
 
 namespace ObseGPCompat
@@ -25,14 +23,14 @@ namespace ObseGPCompat
         Log(LogLevel::Info, "Initializing ConfigurationManager");
 
         // Set default config path
-        char localAppData[MAX_PATH];
-        if (FAILED(SHGetFolderPathA(NULL, CSIDL_LOCAL_APPDATA, NULL, 0, localAppData)))
+        std::filesystem::path localAppData = GetLocalAppDataPath();
+        if (localAppData.empty())
         {
             Log(LogLevel::Error, "Failed to get Local AppData path");
             return false;
         }
 
-        m_ConfigPath = std::filesystem::path(localAppData) / "OBSE64GP" / "config.ini";
+        m_ConfigPath = localAppData / "OBSE64GP" / "config.ini";
         Log(LogLevel::Info, "Config path: %s", m_ConfigPath.string().c_str());
 
         // Create directory if it doesn't exist
@@ -51,9 +49,18 @@ namespace ObseGPCompat
         {
             // Create default configuration
             SetString("Paths", "GamePassInstall", "");
+            SetString("Paths", "ContentStore", "");
             SetBool("Settings", "AutoDetectPaths", true);
             SetBool("Settings", "EnableLogging", true);
             SetInt("Settings", "LogLevel", static_cast<int>(LogLevel::Info));
+            SetInt("Settings", "MetadataCacheTTLMs", 0);
+            SetBool("Settings", "EnableDirectoryIndex", true);
+            SetBool("Settings", "MountArchives", true);
+            SetBool("Settings", "ScanPlugins", true);
+            SetBool("Settings", "CheckLoadOrder", true);
+            SetBool("Settings", "DeployMode", false);
+            SetBool("Settings", "WatchDirectories", true);
+            SetInt("Settings", "BatchWorkerThreads", 0);
 
             // Save default configuration
             if (!Save())
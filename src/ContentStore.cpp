@@ -0,0 +1,301 @@
+#include "ContentStore.h"
+#include "ObseGPCompat.h"
+#include "MappedFile.h"
+#include "Platform.h"
+
+#include <cstring>
+
+namespace ObseGPCompat
+{
+
+    namespace
+    {
+        constexpr uint64_t Prime1 = 11400714785074694791ull;
+        constexpr uint64_t Prime2 = 14029467366897019727ull;
+        constexpr uint64_t Prime3 = 1609587929392839161ull;
+        constexpr uint64_t Prime4 = 9650029242287828579ull;
+        constexpr uint64_t Prime5 = 2870177450012600261ull;
+
+        inline uint64_t RotateLeft(uint64_t value, int bits)
+        {
+            return (value << bits) | (value >> (64 - bits));
+        }
+
+        inline uint64_t Read64(const uint8_t *p)
+        {
+            uint64_t value;
+            std::memcpy(&value, p, sizeof(value));
+            return value;
+        }
+
+        inline uint32_t Read32(const uint8_t *p)
+        {
+            uint32_t value;
+            std::memcpy(&value, p, sizeof(value));
+            return value;
+        }
+
+        inline uint64_t Round(uint64_t accumulator, uint64_t input)
+        {
+            accumulator += input * Prime2;
+            accumulator = RotateLeft(accumulator, 31);
+            return accumulator * Prime1;
+        }
+
+        inline uint64_t MergeRound(uint64_t hash, uint64_t accumulator)
+        {
+            hash ^= Round(0, accumulator);
+            return hash * Prime1 + Prime4;
+        }
+    }
+
+    uint64_t HashContent(const void *data, size_t length, uint64_t seed)
+    {
+        const uint8_t *p = static_cast<const uint8_t *>(data);
+        const uint8_t *end = p + length;
+        uint64_t hash;
+
+        if (length >= 32)
+        {
+            // Four lanes with no dependency on each other, 32 bytes per step
+            uint64_t v1 = seed + Prime1 + Prime2;
+            uint64_t v2 = seed + Prime2;
+            uint64_t v3 = seed;
+            uint64_t v4 = seed - Prime1;
+            for (const uint8_t *limit = end - 32; p <= limit; p += 32)
+            {
+                v1 = Round(v1, Read64(p));
+                v2 = Round(v2, Read64(p + 8));
+                v3 = Round(v3, Read64(p + 16));
+                v4 = Round(v4, Read64(p + 24));
+            }
+
+            hash = RotateLeft(v1, 1) + RotateLeft(v2, 7) + RotateLeft(v3, 12) + RotateLeft(v4, 18);
+            hash = MergeRound(hash, v1);
+            hash = MergeRound(hash, v2);
+            hash = MergeRound(hash, v3);
+            hash = MergeRound(hash, v4);
+        }
+        else
+        {
+            hash = seed + Prime5;
+        }
+
+        hash += static_cast<uint64_t>(length);
+
+        for (; p + 8 <= end; p += 8)
+        {
+            hash ^= Round(0, Read64(p));
+            hash = RotateLeft(hash, 27) * Prime1 + Prime4;
+        }
+        if (p + 4 <= end)
+        {
+            hash ^= static_cast<uint64_t>(Read32(p)) * Prime1;
+            hash = RotateLeft(hash, 23) * Prime2 + Prime3;
+            p += 4;
+        }
+        for (; p < end; ++p)
+        {
+            hash ^= static_cast<uint64_t>(*p) * Prime5;
+            hash = RotateLeft(hash, 11) * Prime1;
+        }
+
+        hash ^= hash >> 33;
+        hash *= Prime2;
+        hash ^= hash >> 29;
+        hash *= Prime3;
+        hash ^= hash >> 32;
+        return hash;
+    }
+
+    std::wstring ContentId::ToString() const
+    {
+        static const wchar_t digits[] = L"0123456789abcdef";
+        std::wstring text(16, L'0');
+        for (int i = 0; i < 16; ++i)
+        {
+            text[15 - i] = digits[(hash >> (4 * i)) & 0xF];
+        }
+        text += L'-';
+        text += std::to_wstring(size);
+        return text;
+    }
+
+    ContentStore::ContentStore()
+        : m_Stored(0),
+          m_Deduplicated(0),
+          m_BytesSaved(0),
+          m_Links(0)
+    {
+    }
+
+    bool ContentStore::Initialize(const std::filesystem::path &root)
+    {
+        std::error_code ec;
+        std::filesystem::create_directories(root, ec);
+        if (ec)
+        {
+            Log(LogLevel::Warning, "Failed to create content store at '%s': %s", root.string().c_str(), ec.message().c_str());
+            return false;
+        }
+
+        m_Root = root;
+        Log(LogLevel::Info, "Content store at %s", m_Root.string().c_str());
+        return true;
+    }
+
+    std::filesystem::path ContentStore::GetObjectPath(const ContentId &id) const
+    {
+        std::wstring name = id.ToString();
+        return m_Root / name.substr(0, 2) / name;
+    }
+
+    bool ContentStore::Contains(const ContentId &id) const
+    {
+        std::error_code ec;
+        return IsInitialized() && std::filesystem::is_regular_file(GetObjectPath(id), ec);
+    }
+
+    bool ContentStore::HashFile(const std::filesystem::path &file, ContentId &id)
+    {
+        std::error_code ec;
+        uint64_t size = std::filesystem::file_size(file, ec);
+        if (ec)
+        {
+            return false;
+        }
+
+        // Empty files cannot be mapped, and need not be
+        if (size == 0)
+        {
+            id = {HashContent(nullptr, 0), 0};
+            return true;
+        }
+
+        MappedFile view;
+        if (!view.Open(file))
+        {
+            return false;
+        }
+        id = {HashContent(view.Data(), view.Size()), view.Size()};
+        return true;
+    }
+
+    bool ContentStore::SameContent(const std::filesystem::path &a, const std::filesystem::path &b)
+    {
+        MappedFile viewA;
+        MappedFile viewB;
+        bool openedA = viewA.Open(a);
+        bool openedB = viewB.Open(b);
+        if (!openedA || !openedB)
+        {
+            // Only two empty files fail to map and still match
+            std::error_code ec;
+            return !openedA && !openedB && std::filesystem::file_size(a, ec) == 0 && std::filesystem::file_size(b, ec) == 0;
+        }
+        return viewA.Size() == viewB.Size() && std::memcmp(viewA.Data(), viewB.Data(), viewA.Size()) == 0;
+    }
+
+    bool ContentStore::Add(const std::filesystem::path &file, ContentId &id)
+    {
+        if (!IsInitialized())
+        {
+            return false;
+        }
+
+        if (!HashFile(file, id))
+        {
+            Log(LogLevel::Error, "Failed to read '%s' for the content store", file.string().c_str());
+            return false;
+        }
+
+        std::filesystem::path object = GetObjectPath(id);
+        std::error_code ec;
+        if (std::filesystem::exists(object, ec))
+        {
+            // A 64-bit hash plus the size makes a collision unlikely, not impossible
+            if (!SameContent(file, object))
+            {
+                Log(LogLevel::Error, "Content hash collision between '%s' and '%s'",
+                    file.string().c_str(), object.string().c_str());
+                return false;
+            }
+
+            // Objects stored before they were made read-only
+            Platform::SetReadOnly(object);
+            m_Deduplicated.fetch_add(1, std::memory_order_relaxed);
+            m_BytesSaved.fetch_add(id.size, std::memory_order_relaxed);
+            return true;
+        }
+
+        // Copy beside the object and move it into place, so a concurrent Add of the same
+        // content either wins the move or finds a finished object
+        std::filesystem::create_directories(object.parent_path(), ec);
+        std::filesystem::path temporary = object;
+        temporary += L"." + std::to_wstring(Platform::GetCurrentThreadId()) + L".tmp";
+
+        CopyResult copied = m_CopyEngine.Copy(file, temporary, true);
+        ContentId stored = {};
+        if (!copied.success || !HashFile(temporary, stored) || stored.hash != id.hash || stored.size != id.size)
+        {
+            // The source changed while it was being added, or could not be copied
+            Log(LogLevel::Error, "Failed to store '%s' in the content store", file.string().c_str());
+            Platform::RemoveFile(temporary);
+            return false;
+        }
+
+        // Read-only before it is visible, so a link to it cannot be opened for writing
+        Platform::SetReadOnly(temporary);
+        if (!Platform::RenameFile(temporary, object, false))
+        {
+            Platform::FileError error = Platform::GetLastFileError();
+            Platform::RemoveFile(temporary);
+            if (error != Platform::FileError::AlreadyExists)
+            {
+                Log(LogLevel::Error, "Failed to store '%s' as '%s': %s",
+                    file.string().c_str(), object.string().c_str(), Platform::GetFileErrorName(error));
+                return false;
+            }
+
+            m_Deduplicated.fetch_add(1, std::memory_order_relaxed);
+            m_BytesSaved.fetch_add(id.size, std::memory_order_relaxed);
+            return true;
+        }
+
+        m_Stored.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool ContentStore::Link(const ContentId &id, const std::filesystem::path &target)
+    {
+        // Link under a temporary name and move over the target, so readers never see it missing
+        std::filesystem::path object = GetObjectPath(id);
+        std::filesystem::path temporary = target;
+        temporary += L".obse64gp-link";
+        Platform::RemoveFile(temporary);
+
+        // Fails with NotSameDevice across volumes, or TooManyLinks
+        if (!Platform::LinkFile(temporary, object))
+        {
+            return false;
+        }
+
+        if (!Platform::RenameFile(temporary, target, true))
+        {
+            Platform::RemoveFile(temporary);
+            return false;
+        }
+
+        m_Links.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    ContentStoreStats ContentStore::GetStats() const
+    {
+        return {m_Stored.load(std::memory_order_relaxed),
+                m_Deduplicated.load(std::memory_order_relaxed),
+                m_BytesSaved.load(std::memory_order_relaxed),
+                m_Links.load(std::memory_order_relaxed)};
+    }
+
+} // namespace ObseGPCompat
@@ -0,0 +1,620 @@
+#include "CopyEngine.h"
+
+#ifdef _WIN32
+#include "WindowsWrapper.h"
+#include <winioctl.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/fs.h>
+#endif
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ObseGPCompat
+{
+
+    const char *GetCopyMethodName(CopyMethod method)
+    {
+        switch (method)
+        {
+        case CopyMethod::BlockClone:
+            return "block clone";
+        case CopyMethod::Chunked:
+            return "chunked";
+        case CopyMethod::ParallelChunked:
+            return "parallel chunked";
+        default:
+            return "none";
+        }
+    }
+
+    CopyEngine::CopyEngine()
+        : m_ChunkSize(DefaultChunkSize),
+          m_ParallelThreshold(DefaultParallelThreshold),
+          m_MaxWorkers(std::min(std::max(std::thread::hardware_concurrency(), 1u), 4u)),
+          m_BlockCloneEnabled(true)
+    {
+    }
+
+#ifdef _WIN32
+    namespace
+    {
+        // Each clone request stays well below the 4 GB the file system accepts at once
+        constexpr uint64_t MaxCloneBytes = 1ull << 30;
+
+        class ScopedHandle
+        {
+        public:
+            explicit ScopedHandle(HANDLE handle) : m_Handle(handle) {}
+            ~ScopedHandle()
+            {
+                if (IsValid())
+                {
+                    CloseHandle(m_Handle);
+                }
+            }
+
+            ScopedHandle(const ScopedHandle &) = delete;
+            ScopedHandle &operator=(const ScopedHandle &) = delete;
+
+            bool IsValid() const { return m_Handle != INVALID_HANDLE_VALUE && m_Handle != nullptr; }
+            HANDLE Get() const { return m_Handle; }
+
+            void Close()
+            {
+                if (IsValid())
+                {
+                    CloseHandle(m_Handle);
+                }
+                m_Handle = INVALID_HANDLE_VALUE;
+            }
+
+        private:
+            HANDLE m_Handle;
+        };
+
+        // One in-flight request on an overlapped handle, waited for synchronously
+        class OverlappedRequest
+        {
+        public:
+            OverlappedRequest() : m_Overlapped{}
+            {
+                m_Overlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+            }
+
+            ~OverlappedRequest()
+            {
+                if (m_Overlapped.hEvent)
+                {
+                    CloseHandle(m_Overlapped.hEvent);
+                }
+            }
+
+            OVERLAPPED *At(uint64_t offset)
+            {
+                HANDLE event = m_Overlapped.hEvent;
+                m_Overlapped = {};
+                m_Overlapped.hEvent = event;
+                m_Overlapped.Offset = static_cast<DWORD>(offset);
+                m_Overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+                return &m_Overlapped;
+            }
+
+            // issued is what the ReadFile/WriteFile/DeviceIoControl call returned
+            bool Wait(HANDLE file, BOOL issued, DWORD &transferred)
+            {
+                if (!issued && GetLastError() != ERROR_IO_PENDING)
+                {
+                    return false;
+                }
+                return GetOverlappedResult(file, &m_Overlapped, &transferred, TRUE) != FALSE;
+            }
+
+        private:
+            OVERLAPPED m_Overlapped;
+        };
+
+        bool ReadAt(HANDLE file, uint8_t *buffer, DWORD length, uint64_t offset, OverlappedRequest &request)
+        {
+            while (length > 0)
+            {
+                DWORD transferred = 0;
+                BOOL issued = ReadFile(file, buffer, length, nullptr, request.At(offset));
+                if (!request.Wait(file, issued, transferred) || transferred == 0)
+                {
+                    return false;
+                }
+                buffer += transferred;
+                length -= transferred;
+                offset += transferred;
+            }
+            return true;
+        }
+
+        bool WriteAt(HANDLE file, const uint8_t *buffer, DWORD length, uint64_t offset, OverlappedRequest &request)
+        {
+            while (length > 0)
+            {
+                DWORD transferred = 0;
+                BOOL issued = WriteFile(file, buffer, length, nullptr, request.At(offset));
+                if (!request.Wait(file, issued, transferred) || transferred == 0)
+                {
+                    return false;
+                }
+                buffer += transferred;
+                length -= transferred;
+                offset += transferred;
+            }
+            return true;
+        }
+
+        uint64_t GetClusterSize(const std::filesystem::path &path)
+        {
+            wchar_t volume[MAX_PATH];
+            DWORD sectorsPerCluster = 0;
+            DWORD bytesPerSector = 0;
+            DWORD freeClusters = 0;
+            DWORD totalClusters = 0;
+            if (!GetVolumePathNameW(path.wstring().c_str(), volume, MAX_PATH) ||
+                !GetDiskFreeSpaceW(volume, &sectorsPerCluster, &bytesPerSector, &freeClusters, &totalClusters))
+            {
+                return 0;
+            }
+            return static_cast<uint64_t>(sectorsPerCluster) * bytesPerSector;
+        }
+
+        // Whether the path names the file already open, through any of its links
+        bool IsSameFile(const std::filesystem::path &path, const BY_HANDLE_FILE_INFORMATION &info)
+        {
+            ScopedHandle file(CreateFileW(path.wstring().c_str(), 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                          nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, nullptr));
+            BY_HANDLE_FILE_INFORMATION other = {};
+            return file.IsValid() && GetFileInformationByHandle(file.Get(), &other) &&
+                   other.dwVolumeSerialNumber == info.dwVolumeSerialNumber &&
+                   other.nFileIndexHigh == info.nFileIndexHigh && other.nFileIndexLow == info.nFileIndexLow;
+        }
+    }
+
+    bool CopyEngine::TryBlockClone(HANDLE source, HANDLE destination, const std::filesystem::path &destinationPath,
+                                   uint64_t size, const CopyProgressCallback &progress) const
+    {
+        // Clone ranges must be whole clusters; the last one may run past the end of file.
+        // Volumes without block cloning (or two different volumes) fail the first request.
+        uint64_t clusterSize = GetClusterSize(destinationPath);
+        if (clusterSize == 0)
+        {
+            return false;
+        }
+
+        OverlappedRequest request;
+        for (uint64_t offset = 0; offset < size;)
+        {
+            uint64_t length = std::min(size - offset, MaxCloneBytes);
+            DUPLICATE_EXTENTS_DATA extents = {};
+            extents.FileHandle = source;
+            extents.SourceFileOffset.QuadPart = static_cast<LONGLONG>(offset);
+            extents.TargetFileOffset.QuadPart = static_cast<LONGLONG>(offset);
+            extents.ByteCount.QuadPart = static_cast<LONGLONG>((length + clusterSize - 1) / clusterSize * clusterSize);
+
+            DWORD returned = 0;
+            BOOL issued = DeviceIoControl(destination, FSCTL_DUPLICATE_EXTENTS_TO_FILE, &extents, sizeof(extents),
+                                          nullptr, 0, nullptr, request.At(0));
+            if (!request.Wait(destination, issued, returned))
+            {
+                return false;
+            }
+
+            offset += length;
+            if (progress)
+            {
+                progress({offset, size});
+            }
+        }
+        return true;
+    }
+
+    bool CopyEngine::CopyChunks(HANDLE source, HANDLE destination, uint64_t size, unsigned workers,
+                                const CopyProgressCallback &progress) const
+    {
+        uint64_t chunkCount = (size + m_ChunkSize - 1) / m_ChunkSize;
+        std::atomic<uint64_t> nextChunk{0};
+        std::atomic<bool> failed{false};
+        std::atomic<DWORD> error{ERROR_SUCCESS};
+        std::mutex progressMutex;
+        uint64_t copied = 0;
+
+        // Workers take the next chunk until none are left, so a slow chunk never stalls the rest
+        auto worker = [&]()
+        {
+            std::unique_ptr<uint8_t[]> buffer(new uint8_t[m_ChunkSize]);
+            OverlappedRequest request;
+            for (uint64_t chunk = nextChunk.fetch_add(1); chunk < chunkCount && !failed.load(); chunk = nextChunk.fetch_add(1))
+            {
+                uint64_t offset = chunk * m_ChunkSize;
+                DWORD length = static_cast<DWORD>(std::min<uint64_t>(m_ChunkSize, size - offset));
+                if (!ReadAt(source, buffer.get(), length, offset, request) ||
+                    !WriteAt(destination, buffer.get(), length, offset, request))
+                {
+                    error.store(GetLastError());
+                    failed.store(true);
+                    return;
+                }
+
+                if (progress)
+                {
+                    std::lock_guard<std::mutex> lock(progressMutex);
+                    copied += length;
+                    progress({copied, size});
+                }
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (unsigned i = 1; i < workers; ++i)
+        {
+            threads.emplace_back(worker);
+        }
+        worker();
+        for (std::thread &thread : threads)
+        {
+            thread.join();
+        }
+
+        if (failed.load())
+        {
+            SetLastError(error.load());
+            return false;
+        }
+        return true;
+    }
+
+    CopyResult CopyEngine::Copy(const std::filesystem::path &source, const std::filesystem::path &destination,
+                                bool overwrite, const CopyProgressCallback &progress) const
+    {
+        CopyResult result = {false, CopyMethod::None, 0, 0.0, Platform::FileError::None};
+        auto start = std::chrono::steady_clock::now();
+
+        ScopedHandle sourceFile(CreateFileW(source.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                            OPEN_EXISTING, FILE_FLAG_OVERLAPPED, nullptr));
+        BY_HANDLE_FILE_INFORMATION info = {};
+        if (!sourceFile.IsValid() || !GetFileInformationByHandle(sourceFile.Get(), &info))
+        {
+            result.error = Platform::GetLastFileError();
+            return result;
+        }
+        uint64_t size = (static_cast<uint64_t>(info.nFileSizeHigh) << 32) | info.nFileSizeLow;
+
+        // An overwrite goes to a new file beside the destination that is renamed over it once
+        // complete, so a failed copy leaves the old file alone and a link is replaced rather
+        // than written through
+        std::filesystem::path target = destination;
+        if (overwrite)
+        {
+            if (IsSameFile(destination, info))
+            {
+                // The same file under either name, as std::filesystem::copy_file refuses it
+                result.error = Platform::FileError::AlreadyExists;
+                return result;
+            }
+            target += L"." + std::to_wstring(Platform::GetCurrentThreadId()) + L".tmp";
+            DeleteFileW(target.wstring().c_str());
+        }
+
+        // CREATE_NEW refuses an existing destination without a separate existence check
+        ScopedHandle destinationFile(CreateFileW(target.wstring().c_str(), GENERIC_READ | GENERIC_WRITE | DELETE, 0, nullptr,
+                                                 CREATE_NEW, FILE_FLAG_OVERLAPPED, nullptr));
+        if (!destinationFile.IsValid())
+        {
+            result.error = Platform::GetLastFileError();
+            return result;
+        }
+
+        // Preallocating lets chunks land at any offset and keeps the file in one piece
+        FILE_END_OF_FILE_INFO endOfFile = {};
+        endOfFile.EndOfFile.QuadPart = static_cast<LONGLONG>(size);
+        bool copied = size == 0 || SetFileInformationByHandle(destinationFile.Get(), FileEndOfFileInfo, &endOfFile, sizeof(endOfFile));
+
+        if (copied && size > 0)
+        {
+            if (m_BlockCloneEnabled && TryBlockClone(sourceFile.Get(), destinationFile.Get(), target, size, progress))
+            {
+                result.method = CopyMethod::BlockClone;
+            }
+            else
+            {
+                uint64_t chunkCount = (size + m_ChunkSize - 1) / m_ChunkSize;
+                unsigned workers = size >= m_ParallelThreshold ? static_cast<unsigned>(std::min<uint64_t>(m_MaxWorkers, chunkCount)) : 1;
+                result.method = workers > 1 ? CopyMethod::ParallelChunked : CopyMethod::Chunked;
+                copied = CopyChunks(sourceFile.Get(), destinationFile.Get(), size, workers, progress);
+            }
+        }
+        else if (copied)
+        {
+            result.method = CopyMethod::Chunked;
+        }
+
+        if (!copied)
+        {
+            // Delete through the handle, so nothing else can open the partial file first; it is
+            // only ever the file this call created
+            result.error = Platform::GetLastFileError();
+            result.method = CopyMethod::None;
+            FILE_DISPOSITION_INFO disposition = {};
+            disposition.DeleteFile = TRUE;
+            SetFileInformationByHandle(destinationFile.Get(), FileDispositionInfo, &disposition, sizeof(disposition));
+            return result;
+        }
+
+        // Keep the source's write time and attributes, as CopyFile does; zero times stay as they are
+        FILE_BASIC_INFO basic = {};
+        basic.LastWriteTime.LowPart = info.ftLastWriteTime.dwLowDateTime;
+        basic.LastWriteTime.HighPart = static_cast<LONG>(info.ftLastWriteTime.dwHighDateTime);
+        basic.FileAttributes = info.dwFileAttributes & (FILE_ATTRIBUTE_READONLY | FILE_ATTRIBUTE_HIDDEN |
+                                                        FILE_ATTRIBUTE_SYSTEM | FILE_ATTRIBUTE_ARCHIVE);
+        if (basic.FileAttributes == 0)
+        {
+            basic.FileAttributes = FILE_ATTRIBUTE_NORMAL;
+        }
+        SetFileInformationByHandle(destinationFile.Get(), FileBasicInfo, &basic, sizeof(basic));
+
+        // By name once closed: RenameFile also replaces a read-only destination, such as a link
+        // into the content store, without changing the file its other links share
+        if (overwrite)
+        {
+            destinationFile.Close();
+            if (!Platform::RenameFile(target, destination, true))
+            {
+                result.error = Platform::GetLastFileError();
+                result.method = CopyMethod::None;
+                Platform::RemoveFile(target);
+                return result;
+            }
+        }
+
+        result.success = true;
+        result.bytes = size;
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return result;
+    }
+#else
+    namespace
+    {
+        class ScopedFile
+        {
+        public:
+            explicit ScopedFile(int file) : m_File(file) {}
+            ~ScopedFile()
+            {
+                if (IsValid())
+                {
+                    close(m_File);
+                }
+            }
+
+            ScopedFile(const ScopedFile &) = delete;
+            ScopedFile &operator=(const ScopedFile &) = delete;
+
+            bool IsValid() const { return m_File >= 0; }
+            int Get() const { return m_File; }
+
+        private:
+            int m_File;
+        };
+
+        bool ReadAt(int file, uint8_t *buffer, size_t length, uint64_t offset)
+        {
+            while (length > 0)
+            {
+                ssize_t transferred = pread(file, buffer, length, static_cast<off_t>(offset));
+                if (transferred < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+                if (transferred <= 0)
+                {
+                    return false;
+                }
+                buffer += transferred;
+                length -= static_cast<size_t>(transferred);
+                offset += static_cast<uint64_t>(transferred);
+            }
+            return true;
+        }
+
+        bool WriteAt(int file, const uint8_t *buffer, size_t length, uint64_t offset)
+        {
+            while (length > 0)
+            {
+                ssize_t transferred = pwrite(file, buffer, length, static_cast<off_t>(offset));
+                if (transferred < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+                if (transferred <= 0)
+                {
+                    return false;
+                }
+                buffer += transferred;
+                length -= static_cast<size_t>(transferred);
+                offset += static_cast<uint64_t>(transferred);
+            }
+            return true;
+        }
+    }
+
+    bool CopyEngine::TryBlockClone(int source, int destination, [[maybe_unused]] const std::filesystem::path &destinationPath,
+                                   uint64_t size, const CopyProgressCallback &progress) const
+    {
+#ifdef FICLONE
+        // The whole file at once; file systems without reflinks (or two of them) refuse it
+        if (ioctl(destination, FICLONE, source) != 0)
+        {
+            return false;
+        }
+        if (progress)
+        {
+            progress({size, size});
+        }
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    bool CopyEngine::CopyChunks(int source, int destination, uint64_t size, unsigned workers,
+                                const CopyProgressCallback &progress) const
+    {
+        uint64_t chunkCount = (size + m_ChunkSize - 1) / m_ChunkSize;
+        std::atomic<uint64_t> nextChunk{0};
+        std::atomic<bool> failed{false};
+        std::atomic<int> error{0};
+        std::mutex progressMutex;
+        uint64_t copied = 0;
+
+        // Workers take the next chunk until none are left, so a slow chunk never stalls the rest
+        auto worker = [&]()
+        {
+            std::unique_ptr<uint8_t[]> buffer(new uint8_t[m_ChunkSize]);
+            for (uint64_t chunk = nextChunk.fetch_add(1); chunk < chunkCount && !failed.load(); chunk = nextChunk.fetch_add(1))
+            {
+                uint64_t offset = chunk * m_ChunkSize;
+                size_t length = static_cast<size_t>(std::min<uint64_t>(m_ChunkSize, size - offset));
+                if (!ReadAt(source, buffer.get(), length, offset) ||
+                    !WriteAt(destination, buffer.get(), length, offset))
+                {
+                    error.store(errno);
+                    failed.store(true);
+                    return;
+                }
+
+                if (progress)
+                {
+                    std::lock_guard<std::mutex> lock(progressMutex);
+                    copied += length;
+                    progress({copied, size});
+                }
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (unsigned i = 1; i < workers; ++i)
+        {
+            threads.emplace_back(worker);
+        }
+        worker();
+        for (std::thread &thread : threads)
+        {
+            thread.join();
+        }
+
+        if (failed.load())
+        {
+            errno = error.load();
+            return false;
+        }
+        return true;
+    }
+
+    CopyResult CopyEngine::Copy(const std::filesystem::path &source, const std::filesystem::path &destination,
+                                bool overwrite, const CopyProgressCallback &progress) const
+    {
+        CopyResult result = {false, CopyMethod::None, 0, 0.0, Platform::FileError::None};
+        auto start = std::chrono::steady_clock::now();
+
+        ScopedFile sourceFile(open(source.c_str(), O_RDONLY | O_CLOEXEC));
+        struct stat info = {};
+        if (!sourceFile.IsValid() || fstat(sourceFile.Get(), &info) != 0)
+        {
+            result.error = Platform::GetLastFileError();
+            return result;
+        }
+        uint64_t size = static_cast<uint64_t>(info.st_size);
+
+        // An overwrite goes to a new file beside the destination that is renamed over it once
+        // complete, so a failed copy leaves the old file alone and a link is replaced rather
+        // than written through
+        std::filesystem::path target = destination;
+        if (overwrite)
+        {
+            struct stat existing = {};
+            if (stat(destination.c_str(), &existing) == 0 && existing.st_dev == info.st_dev && existing.st_ino == info.st_ino)
+            {
+                // The same file under either name, as std::filesystem::copy_file refuses it
+                result.error = Platform::FileError::AlreadyExists;
+                return result;
+            }
+            target += "." + std::to_string(Platform::GetCurrentThreadId()) + ".tmp";
+            unlink(target.c_str());
+        }
+
+        // O_EXCL refuses an existing destination without a separate existence check
+        ScopedFile destinationFile(open(target.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0666));
+        if (!destinationFile.IsValid())
+        {
+            result.error = Platform::GetLastFileError();
+            return result;
+        }
+
+        // Sizing the file up front lets chunks land at any offset
+        bool copied = size == 0 || ftruncate(destinationFile.Get(), static_cast<off_t>(size)) == 0;
+
+        if (copied && size > 0)
+        {
+            if (m_BlockCloneEnabled && TryBlockClone(sourceFile.Get(), destinationFile.Get(), target, size, progress))
+            {
+                result.method = CopyMethod::BlockClone;
+            }
+            else
+            {
+                uint64_t chunkCount = (size + m_ChunkSize - 1) / m_ChunkSize;
+                unsigned workers = size >= m_ParallelThreshold ? static_cast<unsigned>(std::min<uint64_t>(m_MaxWorkers, chunkCount)) : 1;
+                result.method = workers > 1 ? CopyMethod::ParallelChunked : CopyMethod::Chunked;
+                copied = CopyChunks(sourceFile.Get(), destinationFile.Get(), size, workers, progress);
+            }
+        }
+        else if (copied)
+        {
+            result.method = CopyMethod::Chunked;
+        }
+
+        if (copied)
+        {
+            // Keep the source's write time and permission bits, as cp -p does
+            struct timespec times[2] = {};
+            times[0].tv_nsec = UTIME_OMIT;
+            times[1] = info.st_mtim;
+            futimens(destinationFile.Get(), times);
+            fchmod(destinationFile.Get(), info.st_mode & 07777);
+            copied = !overwrite || rename(target.c_str(), destination.c_str()) == 0;
+        }
+
+        if (!copied)
+        {
+            // Only ever the file this call created
+            result.error = Platform::GetLastFileError();
+            result.method = CopyMethod::None;
+            unlink(target.c_str());
+            return result;
+        }
+
+        result.success = true;
+        result.bytes = size;
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return result;
+    }
+#endif
+
+} // namespace ObseGPCompat
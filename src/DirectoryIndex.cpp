@@ -0,0 +1,706 @@
+#include "DirectoryIndex.h"
+#include "ObseGPCompat.h"
+#include "PathUtils.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+namespace ObseGPCompat
+{
+
+    namespace
+    {
+        constexpr uint32_t SnapshotMagic = 0x5844474F; // "OGDX"
+        constexpr uint32_t SnapshotVersion = 1;
+
+        int CompareFolded(std::wstring_view a, std::wstring_view b)
+        {
+            size_t length = std::min(a.size(), b.size());
+            for (size_t i = 0; i < length; ++i)
+            {
+                wchar_t x = FoldPathChar(a[i]);
+                wchar_t y = FoldPathChar(b[i]);
+                if (x != y)
+                {
+                    return x < y ? -1 : 1;
+                }
+            }
+            return a.size() == b.size() ? 0 : (a.size() < b.size() ? -1 : 1);
+        }
+
+        // Separator runs collapsed to a single '\\', trailing separators dropped
+        std::wstring CanonicalRoot(const std::filesystem::path &root)
+        {
+            std::wstring canonical;
+            for (wchar_t c : root.wstring())
+            {
+                if (IsPathSeparator(c))
+                {
+                    if (!canonical.empty() && canonical.back() == L'\\')
+                    {
+                        continue;
+                    }
+                    c = L'\\';
+                }
+                canonical.push_back(c);
+            }
+            while (canonical.size() > 1 && canonical.back() == L'\\')
+            {
+                canonical.pop_back();
+            }
+            return canonical;
+        }
+
+        // Length of path consumed by root when path lies inside it, or npos
+        size_t MatchRoot(std::wstring_view path, std::wstring_view root)
+        {
+            size_t i = 0;
+            for (size_t j = 0; j < root.size(); ++j)
+            {
+                if (root[j] == L'\\')
+                {
+                    if (i >= path.size() || !IsPathSeparator(path[i]))
+                    {
+                        return std::wstring_view::npos;
+                    }
+                    while (i < path.size() && IsPathSeparator(path[i]))
+                    {
+                        ++i;
+                    }
+                    continue;
+                }
+
+                if (i >= path.size() || FoldPathChar(path[i]) != FoldPathChar(root[j]))
+                {
+                    return std::wstring_view::npos;
+                }
+                ++i;
+            }
+
+            return (i == path.size() || IsPathSeparator(path[i])) ? i : std::wstring_view::npos;
+        }
+
+        uint64_t HashRoots(const std::vector<std::wstring> &rootNames)
+        {
+            // FNV-1a over the folded roots, each terminated by a zero
+            uint64_t hash = 14695981039346656037ull;
+            for (const std::wstring &root : rootNames)
+            {
+                for (wchar_t c : root)
+                {
+                    hash = (hash ^ static_cast<uint64_t>(FoldPathChar(c))) * 1099511628211ull;
+                }
+                hash *= 1099511628211ull;
+            }
+            return hash;
+        }
+    }
+
+    DirectoryIndex::DirectoryIndex()
+        : m_Entries(nullptr),
+          m_Names(nullptr),
+          m_EntryCount(0),
+          m_RootCount(0),
+          m_Stats{}
+    {
+    }
+
+    bool DirectoryIndex::MapSnapshot(const std::filesystem::path &snapshotPath, uint64_t rootsHash)
+    {
+        if (!m_Snapshot.Open(snapshotPath))
+        {
+            return false;
+        }
+
+        const uint8_t *data = m_Snapshot.Data();
+        const SnapshotHeader *header = reinterpret_cast<const SnapshotHeader *>(data);
+        bool valid = m_Snapshot.Size() >= sizeof(SnapshotHeader) &&
+                     header->magic == SnapshotMagic && header->version == SnapshotVersion &&
+                     header->charSize == sizeof(wchar_t) && header->rootsHash == rootsHash &&
+                     header->rootCount <= header->entryCount &&
+                     m_Snapshot.Size() == sizeof(SnapshotHeader) + header->entryCount * sizeof(Entry) +
+                                              header->nameLength * sizeof(wchar_t);
+
+        // No parsing, but a truncated or foreign file must not send lookups out of bounds
+        const Entry *entries = reinterpret_cast<const Entry *>(data + sizeof(SnapshotHeader));
+        for (uint32_t i = 0; valid && i < header->entryCount; ++i)
+        {
+            const Entry &entry = entries[i];
+            valid = entry.nameOffset <= header->nameLength &&
+                    entry.nameLength <= header->nameLength - entry.nameOffset &&
+                    (entry.childCount == 0 || (entry.firstChild > i && entry.firstChild <= header->entryCount &&
+                                               entry.childCount <= header->entryCount - entry.firstChild));
+        }
+
+        if (!valid)
+        {
+            Log(LogLevel::Info, "Directory index snapshot is outdated or unreadable; rebuilding");
+            m_Snapshot.Close();
+            return false;
+        }
+
+        m_Entries = entries;
+        m_Names = reinterpret_cast<const wchar_t *>(data + sizeof(SnapshotHeader) + header->entryCount * sizeof(Entry));
+        m_EntryCount = header->entryCount;
+        m_RootCount = header->rootCount;
+        return true;
+    }
+
+    bool DirectoryIndex::ListChildren(ScanNode &node, std::vector<std::pair<size_t, uint32_t>> &subdirectories) const
+    {
+        const Entry *previous = node.previous != NoEntry ? &m_Entries[node.previous] : nullptr;
+
+        std::error_code ec;
+        std::filesystem::file_time_type lastWriteTime = std::filesystem::last_write_time(node.path, ec);
+        if (ec)
+        {
+            // Only a change if the snapshot could still read this directory
+            node.opaque = true;
+            return !previous || !(previous->flags & Opaque) || previous->lastWriteTime != 0;
+        }
+        node.lastWriteTime = static_cast<int64_t>(lastWriteTime.time_since_epoch().count());
+
+        // Unchanged since the snapshot: take its listing, subdirectories are still checked
+        if (previous && !(previous->flags & Opaque) && previous->lastWriteTime == node.lastWriteTime)
+        {
+            node.children.reserve(previous->childCount);
+            for (uint32_t child = previous->firstChild; child < previous->firstChild + previous->childCount; ++child)
+            {
+                uint32_t flags = m_Entries[child].flags;
+                node.children.push_back({std::wstring(Name(child)), flags, NoEntry});
+                if ((flags & (Directory | Opaque)) == Directory)
+                {
+                    subdirectories.emplace_back(node.children.size() - 1, child);
+                }
+            }
+            return false;
+        }
+
+        std::filesystem::directory_iterator it(node.path, std::filesystem::directory_options::skip_permission_denied, ec);
+        for (; !ec && it != std::filesystem::directory_iterator(); it.increment(ec))
+        {
+            std::error_code typeEc;
+            uint32_t flags = 0;
+            if (it->is_directory(typeEc))
+            {
+                // Links and junctions are not followed, so a loop cannot make the scan endless
+                flags = Directory;
+                if (it->symlink_status(typeEc).type() != std::filesystem::file_type::directory)
+                {
+                    flags |= Opaque;
+                }
+            }
+            node.children.push_back({it->path().filename().wstring(), flags, NoEntry});
+        }
+
+        if (ec)
+        {
+            Log(LogLevel::Warning, "Failed to index directory '%s': %s",
+                node.path.string().c_str(), ec.message().c_str());
+            node.children.clear();
+            node.opaque = true;
+            return true;
+        }
+
+        std::sort(node.children.begin(), node.children.end(),
+                  [](const ScanChild &a, const ScanChild &b)
+                  { return CompareFolded(a.name, b.name) < 0; });
+
+        for (size_t i = 0; i < node.children.size(); ++i)
+        {
+            if ((node.children[i].flags & (Directory | Opaque)) == Directory)
+            {
+                // A new listing can still contain directories the snapshot knows
+                uint32_t known = previous && !(previous->flags & Opaque) ? FindChild(node.previous, node.children[i].name) : NoEntry;
+                subdirectories.emplace_back(i, known);
+            }
+        }
+        return true;
+    }
+
+    void DirectoryIndex::Build(const std::vector<std::filesystem::path> &roots, const std::filesystem::path &snapshotPath)
+    {
+        m_Snapshot.Close();
+        m_OwnedEntries.clear();
+        m_OwnedNames.clear();
+        m_Entries = nullptr;
+        m_Names = nullptr;
+        m_EntryCount = 0;
+        m_RootCount = 0;
+        m_States.reset();
+        m_Overlays.clear();
+        m_StaleDirectories.clear();
+        m_Stats = {};
+
+        // Roots nested inside another root are already covered by it
+        std::vector<std::wstring> rootNames;
+        std::vector<std::filesystem::path> rootPaths;
+        for (const std::filesystem::path &root : roots)
+        {
+            std::wstring name = CanonicalRoot(root);
+            bool covered = std::any_of(roots.begin(), roots.end(),
+                                       [&name](const std::filesystem::path &other)
+                                       {
+                                           std::wstring otherName = CanonicalRoot(other);
+                                           return otherName.size() < name.size() && MatchRoot(name, otherName) != std::wstring_view::npos;
+                                       });
+            bool duplicate = std::any_of(rootNames.begin(), rootNames.end(),
+                                         [&name](const std::wstring &other)
+                                         { return CompareFolded(name, other) == 0; });
+            if (!name.empty() && !covered && !duplicate)
+            {
+                rootNames.push_back(name);
+                rootPaths.push_back(root);
+            }
+        }
+
+        uint64_t rootsHash = HashRoots(rootNames);
+        bool mapped = !snapshotPath.empty() && MapSnapshot(snapshotPath, rootsHash);
+
+        // Every directory becomes one task; workers queue the subdirectories they find
+        std::deque<ScanNode> nodes;
+        std::vector<uint32_t> pending;
+        for (uint32_t i = 0; i < rootPaths.size(); ++i)
+        {
+            nodes.push_back({rootPaths[i], mapped ? i : NoEntry, 0, false, {}});
+            pending.push_back(i);
+        }
+
+        std::mutex mutex;
+        std::condition_variable wake;
+        size_t active = 0;
+        std::atomic<size_t> rescanned{0};
+
+        auto worker = [&]()
+        {
+            std::vector<std::pair<size_t, uint32_t>> subdirectories;
+            std::unique_lock<std::mutex> lock(mutex);
+            for (;;)
+            {
+                wake.wait(lock, [&]()
+                          { return !pending.empty() || active == 0; });
+                if (pending.empty())
+                {
+                    return;
+                }
+
+                ScanNode &node = nodes[pending.back()];
+                pending.pop_back();
+                ++active;
+                lock.unlock();
+
+                subdirectories.clear();
+                if (ListChildren(node, subdirectories))
+                {
+                    rescanned.fetch_add(1, std::memory_order_relaxed);
+                }
+
+                lock.lock();
+                for (const auto &subdirectory : subdirectories)
+                {
+                    ScanChild &child = node.children[subdirectory.first];
+                    child.node = static_cast<uint32_t>(nodes.size());
+                    nodes.push_back({node.path / child.name, subdirectory.second, 0, false, {}});
+                    pending.push_back(child.node);
+                }
+                --active;
+                wake.notify_all();
+            }
+        };
+
+        unsigned threadCount = std::min(std::max(std::thread::hardware_concurrency(), 1u), 16u);
+        std::vector<std::thread> threads;
+        for (unsigned i = 1; i < threadCount; ++i)
+        {
+            threads.emplace_back(worker);
+        }
+        worker();
+        for (std::thread &thread : threads)
+        {
+            thread.join();
+        }
+
+        m_Stats.rescannedDirectories = rescanned.load();
+        m_Stats.snapshotReused = mapped && m_Stats.rescannedDirectories == 0;
+
+        if (!m_Stats.snapshotReused)
+        {
+            // The listings now hold their own copies, so the old mapping can go
+            Assemble(nodes, rootNames);
+            m_Snapshot.Close();
+            m_Entries = m_OwnedEntries.data();
+            m_Names = m_OwnedNames.data();
+            m_EntryCount = static_cast<uint32_t>(m_OwnedEntries.size());
+            m_RootCount = static_cast<uint32_t>(rootNames.size());
+            if (!snapshotPath.empty())
+            {
+                WriteSnapshot(snapshotPath, rootsHash);
+            }
+        }
+
+        m_States.reset(new std::atomic<EntryState>[m_EntryCount]());
+        for (uint32_t i = 0; i < m_EntryCount; ++i)
+        {
+            if (m_Entries[i].flags & Directory)
+            {
+                ++m_Stats.directories;
+            }
+            else
+            {
+                ++m_Stats.files;
+            }
+        }
+    }
+
+    void DirectoryIndex::Assemble(const std::deque<ScanNode> &nodes, const std::vector<std::wstring> &rootNames)
+    {
+        m_OwnedEntries.clear();
+        m_OwnedNames.clear();
+
+        // Breadth-first, so each directory's children land next to each other
+        std::vector<uint32_t> entryNodes;
+        auto append = [this, &entryNodes, &nodes](std::wstring_view name, uint32_t flags, uint32_t node)
+        {
+            int64_t lastWriteTime = 0;
+            if (node != NoEntry)
+            {
+                lastWriteTime = nodes[node].lastWriteTime;
+                flags |= nodes[node].opaque ? static_cast<uint32_t>(Opaque) : 0u;
+            }
+            m_OwnedEntries.push_back({static_cast<uint32_t>(m_OwnedNames.size()), static_cast<uint32_t>(name.size()),
+                                      0, 0, lastWriteTime, flags, 0});
+            m_OwnedNames.append(name);
+            entryNodes.push_back(node);
+        };
+
+        for (uint32_t i = 0; i < rootNames.size(); ++i)
+        {
+            append(rootNames[i], Directory, i);
+        }
+
+        for (size_t entry = 0; entry < m_OwnedEntries.size(); ++entry)
+        {
+            if (entryNodes[entry] == NoEntry)
+            {
+                continue;
+            }
+
+            const ScanNode &node = nodes[entryNodes[entry]];
+            m_OwnedEntries[entry].firstChild = static_cast<uint32_t>(m_OwnedEntries.size());
+            m_OwnedEntries[entry].childCount = static_cast<uint32_t>(node.children.size());
+            for (const ScanChild &child : node.children)
+            {
+                append(child.name, child.flags, child.node);
+            }
+        }
+    }
+
+    void DirectoryIndex::WriteSnapshot(const std::filesystem::path &snapshotPath, uint64_t rootsHash) const
+    {
+        SnapshotHeader header = {SnapshotMagic, SnapshotVersion, sizeof(wchar_t), m_RootCount, m_EntryCount,
+                                 static_cast<uint32_t>(m_OwnedNames.size()), rootsHash};
+
+        // Write beside the snapshot and swap it in, so a crash never leaves half a file
+        std::filesystem::path temporaryPath = snapshotPath;
+        temporaryPath += ".tmp";
+        {
+            std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char *>(m_OwnedEntries.data()), m_OwnedEntries.size() * sizeof(Entry));
+            file.write(reinterpret_cast<const char *>(m_OwnedNames.data()), m_OwnedNames.size() * sizeof(wchar_t));
+            if (!file)
+            {
+                Log(LogLevel::Warning, "Failed to write directory index snapshot '%s'", temporaryPath.string().c_str());
+                return;
+            }
+        }
+
+        std::error_code ec;
+        std::filesystem::rename(temporaryPath, snapshotPath, ec);
+        if (ec)
+        {
+            Log(LogLevel::Warning, "Failed to replace directory index snapshot '%s': %s",
+                snapshotPath.string().c_str(), ec.message().c_str());
+            std::filesystem::remove(temporaryPath, ec);
+        }
+    }
+
+    uint32_t DirectoryIndex::FindChild(uint32_t directory, std::wstring_view name) const
+    {
+        const Entry &entry = m_Entries[directory];
+        uint32_t low = entry.firstChild;
+        uint32_t high = entry.firstChild + entry.childCount;
+        while (low < high)
+        {
+            uint32_t middle = low + (high - low) / 2;
+            int order = CompareFolded(Name(middle), name);
+            if (order == 0)
+            {
+                return middle;
+            }
+            if (order < 0)
+            {
+                low = middle + 1;
+            }
+            else
+            {
+                high = middle;
+            }
+        }
+        return NoEntry;
+    }
+
+    std::shared_ptr<const DirectoryIndex::Overlay> DirectoryIndex::GetOverlay(uint32_t entry) const
+    {
+        std::lock_guard<std::mutex> lock(m_OverlayMutex);
+        auto it = m_Overlays.find(entry);
+        return it != m_Overlays.end() ? it->second : nullptr;
+    }
+
+    DirectoryIndex::Presence DirectoryIndex::Walk(std::wstring_view path, uint32_t *searched, size_t *searchedLength) const
+    {
+        *searched = NoEntry;
+        *searchedLength = 0;
+        size_t prefixLength = 0;
+        if (HasLongPathPrefix(path))
+        {
+            path.remove_prefix(4);
+            prefixLength = 4;
+        }
+
+        uint32_t current = NoEntry;
+        size_t pos = std::wstring_view::npos;
+        for (uint32_t root = 0; root < m_RootCount && pos == std::wstring_view::npos; ++root)
+        {
+            pos = MatchRoot(path, Name(root));
+            current = root;
+        }
+        if (pos == std::wstring_view::npos)
+        {
+            return Presence::NotIndexed;
+        }
+
+        // Flags of current as the listing that led here has them; end is where its name ends
+        uint32_t flags = m_Entries[current].flags;
+        size_t end = pos;
+        std::shared_ptr<const Overlay> overlay; // Keeps the listing being searched alive
+        for (;;)
+        {
+            while (pos < path.size() && IsPathSeparator(path[pos]))
+            {
+                ++pos;
+            }
+            if (pos == path.size())
+            {
+                if (*searched == NoEntry)
+                {
+                    *searched = current;
+                    *searchedLength = prefixLength + end;
+                }
+                return (flags & Directory) ? Presence::Directory : Presence::File;
+            }
+
+            size_t start = pos;
+            while (pos < path.size() && !IsPathSeparator(path[pos]))
+            {
+                ++pos;
+            }
+            std::wstring_view component = path.substr(start, pos - start);
+
+            if (!(flags & Directory))
+            {
+                // The path continues below a file
+                return Presence::Missing;
+            }
+            if (current == NoEntry)
+            {
+                // Created since Build, or a link; its children are unknown
+                return Presence::NotIndexed;
+            }
+
+            *searched = current;
+            *searchedLength = prefixLength + end;
+            if (component == L"." || component == L"..")
+            {
+                return Presence::NotIndexed;
+            }
+
+            EntryState state = m_States[current].load(std::memory_order_acquire);
+            if (state == EntryState::Relisted)
+            {
+                overlay = GetOverlay(current);
+                if (!overlay || overlay->opaque)
+                {
+                    return Presence::NotIndexed;
+                }
+                auto child = std::lower_bound(overlay->children.begin(), overlay->children.end(), component,
+                                              [](const OverlayChild &child, std::wstring_view name)
+                                              { return CompareFolded(child.name, name) < 0; });
+                if (child == overlay->children.end() || CompareFolded(child->name, component) != 0)
+                {
+                    return Presence::Missing;
+                }
+                flags = child->flags;
+                current = child->entry;
+            }
+            else
+            {
+                if (state == EntryState::Stale || (m_Entries[current].flags & Opaque))
+                {
+                    return Presence::NotIndexed;
+                }
+                current = FindChild(current, component);
+                if (current == NoEntry)
+                {
+                    return Presence::Missing;
+                }
+                flags = m_Entries[current].flags;
+            }
+            end = pos;
+        }
+    }
+
+    DirectoryIndex::Presence DirectoryIndex::Find(const std::filesystem::path &realPath) const
+    {
+        uint32_t searched;
+        size_t searchedLength;
+        return Walk(realPath.wstring(), &searched, &searchedLength);
+    }
+
+    void DirectoryIndex::MarkStale(const std::filesystem::path &realPath, bool subtree)
+    {
+        if (!m_States)
+        {
+            return;
+        }
+
+        // The directory whose listing changes is the last one the lookup searched (or the
+        // root, when realPath is a root itself)
+        std::wstring path = realPath.wstring();
+        uint32_t searched;
+        size_t searchedLength;
+        Walk(path, &searched, &searchedLength);
+        if (searched == NoEntry)
+        {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(m_OverlayMutex);
+        m_States[searched].store(EntryState::Stale, std::memory_order_release);
+        StaleDirectory &directory = m_StaleDirectories[searched];
+        if (directory.path.empty())
+        {
+            directory.path = path.substr(0, searchedLength);
+        }
+        directory.subtree = directory.subtree || subtree;
+    }
+
+    size_t DirectoryIndex::Refresh()
+    {
+        std::unordered_map<uint32_t, StaleDirectory> stale;
+        {
+            std::lock_guard<std::mutex> lock(m_OverlayMutex);
+            stale.swap(m_StaleDirectories);
+        }
+
+        std::unordered_set<uint32_t> listed;
+        for (const auto &directory : stale)
+        {
+            Relist(directory.first, directory.second.path, directory.second.subtree, listed);
+        }
+        return listed.size();
+    }
+
+    void DirectoryIndex::Relist(uint32_t entry, const std::filesystem::path &path, bool subtree, std::unordered_set<uint32_t> &listed)
+    {
+        if (!listed.insert(entry).second)
+        {
+            return;
+        }
+
+        // Read before listing, so a change made meanwhile shows as a newer time next round
+        auto overlay = std::make_shared<Overlay>();
+        overlay->lastWriteTime = 0;
+        overlay->opaque = true;
+        std::error_code ec;
+        std::filesystem::file_time_type lastWriteTime = std::filesystem::last_write_time(path, ec);
+        if (!ec && std::filesystem::symlink_status(path, ec).type() == std::filesystem::file_type::directory)
+        {
+            overlay->lastWriteTime = static_cast<int64_t>(lastWriteTime.time_since_epoch().count());
+            std::filesystem::directory_iterator it(path, std::filesystem::directory_options::skip_permission_denied, ec);
+            for (; !ec && it != std::filesystem::directory_iterator(); it.increment(ec))
+            {
+                std::error_code typeEc;
+                uint32_t flags = 0;
+                if (it->is_directory(typeEc))
+                {
+                    flags = Directory;
+                    if (it->symlink_status(typeEc).type() != std::filesystem::file_type::directory)
+                    {
+                        flags |= Opaque;
+                    }
+                }
+                overlay->children.push_back({it->path().filename().wstring(), flags, NoEntry});
+            }
+            overlay->opaque = static_cast<bool>(ec);
+        }
+        if (overlay->opaque)
+        {
+            overlay->children.clear();
+        }
+        std::sort(overlay->children.begin(), overlay->children.end(),
+                  [](const OverlayChild &a, const OverlayChild &b)
+                  { return CompareFolded(a.name, b.name) < 0; });
+
+        // Subdirectories the table knows keep their entries, from the listing this one
+        // replaces; the ones whose time moved (or, for a subtree, all of them) are listed too
+        std::shared_ptr<const Overlay> previous = GetOverlay(entry);
+        for (OverlayChild &child : overlay->children)
+        {
+            if ((child.flags & (Directory | Opaque)) != Directory)
+            {
+                continue;
+            }
+
+            uint32_t known = NoEntry;
+            if (previous && !previous->opaque)
+            {
+                auto it = std::lower_bound(previous->children.begin(), previous->children.end(), child.name,
+                                           [](const OverlayChild &other, const std::wstring &name)
+                                           { return CompareFolded(other.name, name) < 0; });
+                known = it != previous->children.end() && CompareFolded(it->name, child.name) == 0 ? it->entry : NoEntry;
+            }
+            else if (!(m_Entries[entry].flags & Opaque))
+            {
+                known = FindChild(entry, child.name);
+            }
+            if (known == NoEntry || !(m_Entries[known].flags & Directory))
+            {
+                continue;
+            }
+
+            child.entry = known;
+            std::filesystem::path childPath = path / child.name;
+            std::shared_ptr<const Overlay> knownOverlay = GetOverlay(known);
+            int64_t knownTime = knownOverlay ? knownOverlay->lastWriteTime : m_Entries[known].lastWriteTime;
+            std::filesystem::file_time_type childTime = std::filesystem::last_write_time(childPath, ec);
+            if (subtree || ec || static_cast<int64_t>(childTime.time_since_epoch().count()) != knownTime)
+            {
+                Relist(known, childPath, subtree, listed);
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(m_OverlayMutex);
+        m_Overlays[entry] = std::move(overlay);
+
+        // Marked again while it was being listed: the listing may already be behind
+        if (!m_StaleDirectories.count(entry))
+        {
+            m_States[entry].store(EntryState::Relisted, std::memory_order_release);
+        }
+    }
+
+} // namespace ObseGPCompat
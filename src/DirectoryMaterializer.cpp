@@ -0,0 +1,186 @@
+#include "DirectoryMaterializer.h"
+#include "ObseGPCompat.h"
+#include "PathUtils.h"
+#include "Platform.h"
+
+#include <array>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <type_traits>
+#include <unordered_set>
+
+namespace ObseGPCompat
+{
+
+    namespace
+    {
+        // Read-mostly: every write-intent open looks up, only the first one per directory inserts
+        template <typename CharT>
+        class KnownDirectories
+        {
+        public:
+            using Key = std::basic_string<CharT>;
+
+            bool Contains(const Key &key)
+            {
+                Shard &shard = GetShard(key);
+                std::shared_lock<std::shared_mutex> lock(shard.mutex);
+                return shard.keys.count(key) != 0;
+            }
+
+            void Insert(Key key)
+            {
+                Shard &shard = GetShard(key);
+                std::unique_lock<std::shared_mutex> lock(shard.mutex);
+                shard.keys.insert(std::move(key));
+            }
+
+            void Erase(const Key &key)
+            {
+                Shard &shard = GetShard(key);
+                std::unique_lock<std::shared_mutex> lock(shard.mutex);
+                shard.keys.erase(key);
+            }
+
+        private:
+            static constexpr size_t ShardCount = 16; // Power of two
+
+            struct Shard
+            {
+                std::shared_mutex mutex;
+                std::unordered_set<Key> keys;
+            };
+
+            Shard &GetShard(const Key &key)
+            {
+                return m_Shards[std::hash<Key>()(key) & (ShardCount - 1)];
+            }
+
+            std::array<Shard, ShardCount> m_Shards;
+        };
+
+        template <typename CharT>
+        KnownDirectories<CharT> &Known()
+        {
+            static KnownDirectories<CharT> known;
+            return known;
+        }
+
+        // Folded, '\\'-separated, so different spellings of one directory share an entry
+        template <typename CharT>
+        std::basic_string<CharT> MakeKey(std::basic_string_view<CharT> directory)
+        {
+            std::basic_string<CharT> key(directory);
+            for (CharT &c : key)
+            {
+                c = IsPathSeparator(c) ? CharT('\\') : FoldPathChar(c);
+            }
+            return key;
+        }
+
+        // Directory part of path without trailing separators; empty when there is none
+        template <typename CharT>
+        std::basic_string_view<CharT> ParentOf(std::basic_string_view<CharT> path)
+        {
+            size_t end = path.size();
+            while (end > 0 && IsPathSeparator(path[end - 1]))
+            {
+                --end;
+            }
+            while (end > 0 && !IsPathSeparator(path[end - 1]))
+            {
+                --end;
+            }
+            while (end > 0 && IsPathSeparator(path[end - 1]))
+            {
+                --end;
+            }
+            return path.substr(0, end);
+        }
+
+    }
+
+    template <typename CharT>
+    bool DirectoryMaterializer::EnsureDirectory(std::basic_string_view<CharT> directory)
+    {
+        // A drive (also behind \\?\) always exists
+        if (directory.empty() || directory.back() == CharT(':'))
+        {
+            return true;
+        }
+
+        std::basic_string<CharT> key = MakeKey(directory);
+        if (Known<CharT>().Contains(key))
+        {
+            return true;
+        }
+
+        // Creating doubles as the existence check: "already exists" is just as good
+        std::basic_string<CharT> path(directory);
+        bool created = Platform::MakeDirectory(directory);
+        Platform::FileError error = created ? Platform::FileError::None : Platform::GetLastFileError();
+        if (error == Platform::FileError::PathNotFound || error == Platform::FileError::NotFound) // POSIX says the latter
+        {
+            // The parent is missing, even if it was remembered before something removed it
+            std::basic_string_view<CharT> parent = ParentOf(directory);
+            Forget(parent);
+            if (parent.empty() || !EnsureDirectory(parent))
+            {
+                return false;
+            }
+
+            created = Platform::MakeDirectory(directory);
+            error = created ? Platform::FileError::None : Platform::GetLastFileError();
+        }
+
+        if (!created && error != Platform::FileError::AlreadyExists)
+        {
+            return false;
+        }
+
+        if (created)
+        {
+            if constexpr (std::is_same_v<CharT, char>)
+            {
+                Log(LogLevel::Info, "Created directory: %s", path.c_str());
+            }
+            else
+            {
+                Log(LogLevel::Info, "Created directory: %ls", path.c_str());
+            }
+        }
+
+        Known<CharT>().Insert(std::move(key));
+        return true;
+    }
+
+    template <typename CharT>
+    bool DirectoryMaterializer::EnsureParentDirectory(std::basic_string_view<CharT> filePath)
+    {
+        return EnsureDirectory(ParentOf(filePath));
+    }
+
+    template <typename CharT>
+    void DirectoryMaterializer::ForgetParentDirectory(std::basic_string_view<CharT> filePath)
+    {
+        Forget(ParentOf(filePath));
+    }
+
+    template <typename CharT>
+    void DirectoryMaterializer::Forget(std::basic_string_view<CharT> directory)
+    {
+        if (!directory.empty())
+        {
+            Known<CharT>().Erase(MakeKey(directory));
+        }
+    }
+
+    template bool DirectoryMaterializer::EnsureParentDirectory<char>(std::basic_string_view<char> filePath);
+    template bool DirectoryMaterializer::EnsureParentDirectory<wchar_t>(std::basic_string_view<wchar_t> filePath);
+    template void DirectoryMaterializer::ForgetParentDirectory<char>(std::basic_string_view<char> filePath);
+    template void DirectoryMaterializer::ForgetParentDirectory<wchar_t>(std::basic_string_view<wchar_t> filePath);
+    template void DirectoryMaterializer::Forget<char>(std::basic_string_view<char> directory);
+    template void DirectoryMaterializer::Forget<wchar_t>(std::basic_string_view<wchar_t> directory);
+
+} // namespace ObseGPCompat
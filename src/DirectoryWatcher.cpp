@@ -0,0 +1,536 @@
+#include "DirectoryWatcher.h"
+#include "ObseGPCompat.h"
+#include "PathUtils.h"
+
+#ifdef _WIN32
+#include "WindowsWrapper.h"
+#else
+#include <cerrno>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+
+namespace ObseGPCompat
+{
+
+    namespace
+    {
+        // What a path went through between two batches, as far as the handler cares
+        FileChangeKind Coalesce(FileChangeKind earlier, FileChangeKind later)
+        {
+            if (later == FileChangeKind::Removed)
+            {
+                return FileChangeKind::Removed;
+            }
+            if (earlier == FileChangeKind::Removed)
+            {
+                // Gone and back: replaced
+                return FileChangeKind::Modified;
+            }
+            // Added stays added however often it is written afterwards
+            return earlier;
+        }
+
+#ifdef _WIN32
+        // One overlapped ReadDirectoryChangesW at a time over the whole tree. Between reads
+        // the system keeps collecting changes in its own buffer for the handle.
+        class WindowsChangeSource : public ChangeSource
+        {
+        public:
+            explicit WindowsChangeSource(std::filesystem::path root)
+                : m_Root(std::move(root)),
+                  m_Directory(INVALID_HANDLE_VALUE),
+                  m_Cancel(nullptr),
+                  m_Overlapped{},
+                  m_Buffer(BufferSize / sizeof(DWORD))
+            {
+            }
+
+            ~WindowsChangeSource() override
+            {
+                if (m_Directory != INVALID_HANDLE_VALUE)
+                {
+                    CloseHandle(m_Directory);
+                }
+                if (m_Overlapped.hEvent)
+                {
+                    CloseHandle(m_Overlapped.hEvent);
+                }
+                if (m_Cancel)
+                {
+                    CloseHandle(m_Cancel);
+                }
+            }
+
+            bool Open()
+            {
+                m_Directory = CreateFileW(m_Root.wstring().c_str(), FILE_LIST_DIRECTORY,
+                                          FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                                          FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+                m_Overlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+                m_Cancel = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+                return m_Directory != INVALID_HANDLE_VALUE && m_Overlapped.hEvent && m_Cancel;
+            }
+
+            bool Wait(std::vector<FileChange> &changes, bool &overflow) override
+            {
+                ResetEvent(m_Overlapped.hEvent);
+                if (!ReadDirectoryChangesW(m_Directory, m_Buffer.data(), BufferSize, TRUE, NotifyFilter, nullptr, &m_Overlapped, nullptr))
+                {
+                    return false;
+                }
+
+                HANDLE handles[] = {m_Overlapped.hEvent, m_Cancel};
+                if (WaitForMultipleObjects(2, handles, FALSE, INFINITE) != WAIT_OBJECT_0)
+                {
+                    // The read must be finished before the buffer and the OVERLAPPED go away
+                    DWORD ignored = 0;
+                    CancelIoEx(m_Directory, &m_Overlapped);
+                    GetOverlappedResult(m_Directory, &m_Overlapped, &ignored, TRUE);
+                    return false;
+                }
+
+                DWORD bytes = 0;
+                if (!GetOverlappedResult(m_Directory, &m_Overlapped, &bytes, FALSE))
+                {
+                    if (GetLastError() != ERROR_NOTIFY_ENUM_DIR)
+                    {
+                        return false;
+                    }
+                    bytes = 0;
+                }
+                if (bytes == 0)
+                {
+                    // More happened than the buffer could hold
+                    overflow = true;
+                    return true;
+                }
+
+                const uint8_t *p = reinterpret_cast<const uint8_t *>(m_Buffer.data());
+                for (;;)
+                {
+                    const FILE_NOTIFY_INFORMATION *info = reinterpret_cast<const FILE_NOTIFY_INFORMATION *>(p);
+                    std::wstring name(info->FileName, info->FileNameLength / sizeof(wchar_t));
+
+                    FileChangeKind kind = FileChangeKind::Modified;
+                    if (info->Action == FILE_ACTION_ADDED || info->Action == FILE_ACTION_RENAMED_NEW_NAME)
+                    {
+                        kind = FileChangeKind::Added;
+                    }
+                    else if (info->Action == FILE_ACTION_REMOVED || info->Action == FILE_ACTION_RENAMED_OLD_NAME)
+                    {
+                        kind = FileChangeKind::Removed;
+                    }
+                    changes.push_back({m_Root / name, kind});
+
+                    if (info->NextEntryOffset == 0)
+                    {
+                        break;
+                    }
+                    p += info->NextEntryOffset;
+                }
+                return true;
+            }
+
+            void Cancel() override
+            {
+                SetEvent(m_Cancel);
+            }
+
+        private:
+            // The documented limit for directories on network shares
+            static constexpr DWORD BufferSize = 64 * 1024;
+            static constexpr DWORD NotifyFilter = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME |
+                                                  FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE;
+
+            std::filesystem::path m_Root;
+            HANDLE m_Directory;
+            HANDLE m_Cancel;
+            OVERLAPPED m_Overlapped;
+            std::vector<DWORD> m_Buffer; // FILE_NOTIFY_INFORMATION must be DWORD-aligned
+        };
+#else
+        // inotify watches single directories, so every directory in the tree gets its own
+        // watch, and directories that appear later are added as they are reported
+        class InotifyChangeSource : public ChangeSource
+        {
+        public:
+            explicit InotifyChangeSource(std::filesystem::path root)
+                : m_Root(std::move(root)),
+                  m_Inotify(-1),
+                  m_Cancel(-1),
+                  m_RootWatch(-1)
+            {
+            }
+
+            ~InotifyChangeSource() override
+            {
+                if (m_Inotify >= 0)
+                {
+                    close(m_Inotify);
+                }
+                if (m_Cancel >= 0)
+                {
+                    close(m_Cancel);
+                }
+            }
+
+            bool Open()
+            {
+                m_Inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+                m_Cancel = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+                if (m_Inotify < 0 || m_Cancel < 0)
+                {
+                    return false;
+                }
+                m_RootWatch = AddWatch(m_Root);
+                if (m_RootWatch < 0)
+                {
+                    return false;
+                }
+                AddTree(m_Root, nullptr);
+                return true;
+            }
+
+            bool Wait(std::vector<FileChange> &changes, bool &overflow) override
+            {
+                size_t reported = changes.size();
+                for (;;)
+                {
+                    pollfd fds[2] = {{m_Inotify, POLLIN, 0}, {m_Cancel, POLLIN, 0}};
+                    if (poll(fds, 2, -1) < 0)
+                    {
+                        if (errno == EINTR)
+                        {
+                            continue;
+                        }
+                        return false;
+                    }
+                    if (fds[1].revents)
+                    {
+                        return false;
+                    }
+
+                    alignas(inotify_event) char buffer[16 * 1024];
+                    ssize_t length;
+                    while ((length = read(m_Inotify, buffer, sizeof(buffer))) > 0)
+                    {
+                        for (const char *p = buffer; p < buffer + length;)
+                        {
+                            const inotify_event *event = reinterpret_cast<const inotify_event *>(p);
+                            p += sizeof(inotify_event) + event->len;
+                            if (!Translate(*event, changes, overflow))
+                            {
+                                return false;
+                            }
+                        }
+                    }
+
+                    if (overflow || changes.size() > reported)
+                    {
+                        return true;
+                    }
+                }
+            }
+
+            void Cancel() override
+            {
+                uint64_t one = 1;
+                ssize_t written = write(m_Cancel, &one, sizeof(one));
+                (void)written;
+            }
+
+        private:
+            static constexpr uint32_t WatchMask = IN_CREATE | IN_DELETE | IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE |
+                                                  IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR;
+
+            int AddWatch(const std::filesystem::path &directory)
+            {
+                int watch = inotify_add_watch(m_Inotify, directory.c_str(), WatchMask);
+                if (watch >= 0)
+                {
+                    m_Watches[watch] = directory;
+                }
+                return watch;
+            }
+
+            // Watches every directory below directory; with found, also reports what is already
+            // there, since it arrived before the watches did
+            void AddTree(const std::filesystem::path &directory, std::vector<FileChange> *found)
+            {
+                std::error_code ec;
+                std::filesystem::recursive_directory_iterator it(directory, std::filesystem::directory_options::skip_permission_denied, ec);
+                for (std::filesystem::recursive_directory_iterator end; !ec && it != end; it.increment(ec))
+                {
+                    std::error_code entryError;
+                    if (it->is_directory(entryError) && !it->is_symlink(entryError))
+                    {
+                        AddWatch(it->path());
+                    }
+                    if (found)
+                    {
+                        found->push_back({it->path(), FileChangeKind::Added});
+                    }
+                }
+            }
+
+            // Drops the watches of a directory that moved away, so its old path is not reported
+            void RemoveTree(const std::filesystem::path &directory)
+            {
+                std::string prefix = directory.native() + '/';
+                for (auto it = m_Watches.begin(); it != m_Watches.end();)
+                {
+                    const std::string &path = it->second.native();
+                    if (path == directory.native() || path.compare(0, prefix.size(), prefix) == 0)
+                    {
+                        inotify_rm_watch(m_Inotify, it->first);
+                        it = m_Watches.erase(it);
+                    }
+                    else
+                    {
+                        ++it;
+                    }
+                }
+            }
+
+            // False once the root itself is gone
+            bool Translate(const inotify_event &event, std::vector<FileChange> &changes, bool &overflow)
+            {
+                if (event.mask & IN_Q_OVERFLOW)
+                {
+                    overflow = true;
+                    return true;
+                }
+
+                auto watch = m_Watches.find(event.wd);
+                if (watch == m_Watches.end())
+                {
+                    return true;
+                }
+                if (event.mask & IN_IGNORED)
+                {
+                    m_Watches.erase(watch);
+                    return event.wd != m_RootWatch;
+                }
+                if (event.len == 0)
+                {
+                    return true;
+                }
+
+                std::filesystem::path path = watch->second / event.name;
+                if (event.mask & (IN_CREATE | IN_MOVED_TO))
+                {
+                    changes.push_back({path, FileChangeKind::Added});
+                    if ((event.mask & IN_ISDIR) && AddWatch(path) >= 0)
+                    {
+                        AddTree(path, &changes);
+                    }
+                }
+                else if (event.mask & (IN_DELETE | IN_MOVED_FROM))
+                {
+                    changes.push_back({path, FileChangeKind::Removed});
+                    if ((event.mask & (IN_ISDIR | IN_MOVED_FROM)) == (IN_ISDIR | IN_MOVED_FROM))
+                    {
+                        RemoveTree(path);
+                    }
+                }
+                else
+                {
+                    changes.push_back({path, FileChangeKind::Modified});
+                }
+                return true;
+            }
+
+            std::filesystem::path m_Root;
+            int m_Inotify;
+            int m_Cancel; // eventfd that wakes Wait
+            int m_RootWatch;
+            std::unordered_map<int, std::filesystem::path> m_Watches;
+        };
+#endif
+    }
+
+    std::unique_ptr<ChangeSource> ChangeSource::Create(const std::filesystem::path &root)
+    {
+#ifdef _WIN32
+        auto source = std::make_unique<WindowsChangeSource>(root);
+#else
+        auto source = std::make_unique<InotifyChangeSource>(root);
+#endif
+        if (!source->Open())
+        {
+            return nullptr;
+        }
+        return source;
+    }
+
+    DirectoryWatcher::DirectoryWatcher()
+        : m_SettleTime(DefaultSettleTime),
+          m_Stopping(false),
+          m_Stats{}
+    {
+    }
+
+    DirectoryWatcher::~DirectoryWatcher()
+    {
+        Stop();
+    }
+
+    bool DirectoryWatcher::Watch(const std::filesystem::path &root)
+    {
+        std::unique_ptr<ChangeSource> changes = ChangeSource::Create(root);
+        if (!changes)
+        {
+            Log(LogLevel::Warning, "Cannot watch %s for changes", root.string().c_str());
+            return false;
+        }
+
+        auto source = std::make_unique<Source>();
+        source->root = root;
+        source->changes = std::move(changes);
+        m_Sources.push_back(std::move(source));
+        return true;
+    }
+
+    bool DirectoryWatcher::Start(ChangeHandler handler, std::chrono::milliseconds settleTime)
+    {
+        if (m_Dispatcher.joinable() || m_Sources.empty())
+        {
+            return false;
+        }
+
+        m_Handler = std::move(handler);
+        m_SettleTime = settleTime;
+        for (std::unique_ptr<Source> &source : m_Sources)
+        {
+            source->thread = std::thread([this, s = source.get()]()
+                                         { Listen(*s); });
+        }
+        m_Dispatcher = std::thread([this]()
+                                   { Dispatch(); });
+        return true;
+    }
+
+    void DirectoryWatcher::Stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Stopping = true;
+        }
+        m_Changed.notify_all();
+
+        for (std::unique_ptr<Source> &source : m_Sources)
+        {
+            source->changes->Cancel();
+            if (source->thread.joinable())
+            {
+                source->thread.join();
+            }
+        }
+        if (m_Dispatcher.joinable())
+        {
+            m_Dispatcher.join();
+        }
+    }
+
+    DirectoryWatcherStats DirectoryWatcher::GetStats() const
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        return m_Stats;
+    }
+
+    void DirectoryWatcher::Listen(Source &source)
+    {
+        std::vector<FileChange> changes;
+        for (;;)
+        {
+            changes.clear();
+            bool overflow = false;
+            if (!source.changes->Wait(changes, overflow))
+            {
+                break;
+            }
+
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            auto now = std::chrono::steady_clock::now();
+            if (m_Pending.empty() && m_Overflowed.empty())
+            {
+                m_FirstNotification = now;
+            }
+            m_LastNotification = now;
+
+            m_Stats.notifications += changes.size();
+            for (FileChange &change : changes)
+            {
+                auto inserted = m_PendingIndex.emplace(FoldPath(std::wstring_view(change.path.wstring())), m_Pending.size());
+                if (inserted.second)
+                {
+                    m_Pending.push_back(std::move(change));
+                }
+                else
+                {
+                    FileChange &pending = m_Pending[inserted.first->second];
+                    pending.kind = Coalesce(pending.kind, change.kind);
+                }
+            }
+            if (overflow)
+            {
+                ++m_Stats.overflows;
+                if (std::find(m_Overflowed.begin(), m_Overflowed.end(), source.root) == m_Overflowed.end())
+                {
+                    m_Overflowed.push_back(source.root);
+                }
+            }
+            m_Changed.notify_one();
+        }
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (!m_Stopping)
+        {
+            Log(LogLevel::Warning, "Stopped watching %s for changes", source.root.string().c_str());
+        }
+    }
+
+    void DirectoryWatcher::Dispatch()
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        for (;;)
+        {
+            m_Changed.wait(lock, [this]()
+                           { return m_Stopping || !m_Pending.empty() || !m_Overflowed.empty(); });
+
+            // Copying a mod in arrives as a stream of notifications; wait for it to end, but
+            // not forever when something keeps writing
+            for (;;)
+            {
+                if (m_Stopping)
+                {
+                    return;
+                }
+                auto deadline = std::min(m_LastNotification + m_SettleTime, m_FirstNotification + m_SettleTime * 10);
+                if (std::chrono::steady_clock::now() >= deadline)
+                {
+                    break;
+                }
+                m_Changed.wait_until(lock, deadline);
+            }
+
+            std::vector<FileChange> changes;
+            std::vector<std::filesystem::path> overflowed;
+            changes.swap(m_Pending);
+            overflowed.swap(m_Overflowed);
+            m_PendingIndex.clear();
+            m_Stats.dispatched += changes.size();
+            ++m_Stats.batches;
+
+            lock.unlock();
+            m_Handler(changes, overflowed);
+            lock.lock();
+        }
+    }
+
+} // namespace ObseGPCompat
@@ -0,0 +1,137 @@
+#include "EpochReclaimer.h"
+
+#include <algorithm>
+
+namespace ObseGPCompat
+{
+
+    EpochReclaimer::Slot EpochReclaimer::s_Slots[EpochReclaimer::SlotCount];
+    std::atomic<uint64_t> EpochReclaimer::s_Epoch{1};
+    std::atomic<uint64_t> EpochReclaimer::s_OverflowReaders{0};
+    std::mutex EpochReclaimer::s_RetireMutex;
+    std::vector<EpochReclaimer::Retired> EpochReclaimer::s_Retired;
+
+    namespace
+    {
+        constexpr size_t NoSlot = SIZE_MAX;
+
+        // The reader slot a thread claimed on first use, released when the thread exits
+        struct ThreadReaderState
+        {
+            size_t slot = NoSlot;
+            size_t depth = 0;
+            bool claimed = false;
+            std::atomic<bool> *owned = nullptr;
+
+            ~ThreadReaderState()
+            {
+                if (owned)
+                {
+                    owned->store(false, std::memory_order_release);
+                }
+            }
+        };
+
+        thread_local ThreadReaderState t_Reader;
+    }
+
+    void EpochReclaimer::Enter()
+    {
+        ThreadReaderState &state = t_Reader;
+        if (state.depth++ > 0)
+        {
+            return;
+        }
+
+        if (!state.claimed)
+        {
+            state.claimed = true;
+            for (size_t i = 0; i < SlotCount; ++i)
+            {
+                bool expected = false;
+                if (s_Slots[i].owned.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+                {
+                    state.slot = i;
+                    state.owned = &s_Slots[i].owned;
+                    break;
+                }
+            }
+        }
+
+        // Sequentially consistent so the announcement is ordered before the reader's loads
+        if (state.slot == NoSlot)
+        {
+            s_OverflowReaders.fetch_add(1);
+        }
+        else
+        {
+            s_Slots[state.slot].epoch.store(s_Epoch.load());
+        }
+    }
+
+    void EpochReclaimer::Leave()
+    {
+        ThreadReaderState &state = t_Reader;
+        if (--state.depth > 0)
+        {
+            return;
+        }
+
+        if (state.slot == NoSlot)
+        {
+            s_OverflowReaders.fetch_sub(1, std::memory_order_release);
+        }
+        else
+        {
+            s_Slots[state.slot].epoch.store(0, std::memory_order_release);
+        }
+    }
+
+    void EpochReclaimer::Retire(std::function<void()> deleter)
+    {
+        std::lock_guard<std::mutex> lock(s_RetireMutex);
+
+        // Readers that enter from now on see the new epoch, and therefore the new object
+        uint64_t epoch = s_Epoch.fetch_add(1);
+        s_Retired.push_back({epoch, std::move(deleter)});
+        ReclaimLocked();
+    }
+
+    size_t EpochReclaimer::Reclaim()
+    {
+        std::lock_guard<std::mutex> lock(s_RetireMutex);
+        return ReclaimLocked();
+    }
+
+    size_t EpochReclaimer::ReclaimLocked()
+    {
+        // Readers without a slot are not tracked by epoch; wait until they are gone
+        if (s_OverflowReaders.load() != 0)
+        {
+            return s_Retired.size();
+        }
+
+        uint64_t oldestReader = UINT64_MAX;
+        for (const Slot &slot : s_Slots)
+        {
+            uint64_t epoch = slot.epoch.load();
+            if (epoch != 0)
+            {
+                oldestReader = std::min(oldestReader, epoch);
+            }
+        }
+
+        // An object retired at epoch E is unreachable once every active reader entered after E
+        auto reachable = std::partition(s_Retired.begin(), s_Retired.end(),
+                                        [oldestReader](const Retired &retired)
+                                        { return retired.epoch >= oldestReader; });
+        for (auto it = reachable; it != s_Retired.end(); ++it)
+        {
+            it->deleter();
+        }
+        s_Retired.erase(reachable, s_Retired.end());
+
+        return s_Retired.size();
+    }
+
+} // namespace ObseGPCompat
@@ -0,0 +1,107 @@
+#include "FileViewCache.h"
+
+namespace ObseGPCompat
+{
+
+    FileViewCache::FileViewCache(size_t capacity)
+        : m_Capacity(capacity ? capacity : 1),
+          m_Clock(0),
+          m_Stats{}
+    {
+    }
+
+    FileView FileViewCache::Get(const std::filesystem::path &path, uint64_t size, std::filesystem::file_time_type lastWriteTime)
+    {
+        const Key &key = path.native();
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            auto it = m_Entries.find(key);
+            if (it != m_Entries.end())
+            {
+                std::shared_ptr<const MappedFile> file = it->second.file.lock();
+                if (file && it->second.size == size && it->second.lastWriteTime == lastWriteTime)
+                {
+                    it->second.lastUse = ++m_Clock;
+                    ++m_Stats.hits;
+                    return FileView(std::move(file));
+                }
+                m_Entries.erase(it);
+            }
+            ++m_Stats.misses;
+        }
+
+        // Map outside the lock; empty files have nothing to map but are still readable
+        auto file = std::make_shared<MappedFile>();
+        if (size > 0 && !file->Open(path))
+        {
+            return FileView();
+        }
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (m_Entries.find(key) == m_Entries.end())
+        {
+            if (m_Entries.size() >= m_Capacity)
+            {
+                EvictOldest();
+            }
+            m_Entries.emplace(key, Entry{file, size, lastWriteTime, ++m_Clock});
+        }
+        return FileView(std::move(file));
+    }
+
+    void FileViewCache::EvictOldest()
+    {
+        // Entries whose views are all gone go first and do not count as evictions
+        for (auto it = m_Entries.begin(); it != m_Entries.end();)
+        {
+            it = it->second.file.expired() ? m_Entries.erase(it) : std::next(it);
+        }
+        if (m_Entries.size() < m_Capacity)
+        {
+            return;
+        }
+
+        // Linear, but the cache is small and this only runs on a miss
+        auto oldest = m_Entries.begin();
+        for (auto it = m_Entries.begin(); it != m_Entries.end(); ++it)
+        {
+            if (it->second.lastUse < oldest->second.lastUse)
+            {
+                oldest = it;
+            }
+        }
+        if (oldest != m_Entries.end())
+        {
+            m_Entries.erase(oldest);
+            ++m_Stats.evictions;
+        }
+    }
+
+    void FileViewCache::Invalidate(const std::filesystem::path &path)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Entries.erase(path.native());
+    }
+
+    void FileViewCache::InvalidateWhere(const std::function<bool(const Key &)> &predicate)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        for (auto it = m_Entries.begin(); it != m_Entries.end();)
+        {
+            it = predicate(it->first) ? m_Entries.erase(it) : std::next(it);
+        }
+    }
+
+    void FileViewCache::Clear()
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Entries.clear();
+    }
+
+    FileViewCacheStats FileViewCache::GetStats() const
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        return m_Stats;
+    }
+
+} // namespace ObseGPCompat
@@ -0,0 +1,473 @@
+#include "LinkDeployer.h"
+#include "ObseGPCompat.h"
+#include "CacheFile.h"
+#include "DirectoryMaterializer.h"
+#include "PathUtils.h"
+#include "Platform.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+namespace ObseGPCompat
+{
+
+    namespace
+    {
+        constexpr uint32_t ManifestMagic = 0x4450474F; // "OGPD"
+        constexpr uint32_t ManifestVersion = 2;
+
+        using PathString = std::filesystem::path::string_type;
+        using PathStringView = std::basic_string_view<std::filesystem::path::value_type>;
+
+        // Folded, '\\'-separated, without trailing separators, so spellings of a path compare
+        // equal. Built from the native string, so nothing is transcoded per file.
+        PathString MakeKey(PathStringView path)
+        {
+            return FoldPath(path);
+        }
+
+        bool SameSource(const DeployEntry &a, const DeployEntry &b)
+        {
+            return a.size == b.size && a.lastWriteTime == b.lastWriteTime &&
+                   (a.source.native() == b.source.native() || MakeKey(a.source.native()) == MakeKey(b.source.native()));
+        }
+    }
+
+    LinkDeployer::LinkDeployer()
+    {
+    }
+
+    std::vector<DeployEntry> LinkDeployer::Plan(const MappingSnapshot &mappings)
+    {
+        // Links from the last deployment can sit inside a real root; they are not sources
+        std::unordered_set<PathString> deployedTargets;
+        for (const DeployEntry &entry : m_Deployed)
+        {
+            deployedTargets.insert(MakeKey(entry.target.native()));
+        }
+
+        std::unordered_map<PathString, const DeployDirectory *> recorded;
+        for (const DeployDirectory &directory : m_Directories)
+        {
+            recorded.emplace(MakeKey(directory.path.native()), &directory);
+        }
+
+        // A directory changed during this listing has a write time from now on; only
+        // older ones can be trusted to mean the same contents next time
+        int64_t listingStart = std::filesystem::file_time_type::clock::now().time_since_epoch().count();
+
+        // Real roots with the virtual root each one appears under
+        std::vector<std::pair<std::filesystem::path, std::filesystem::path>> roots;
+        for (const PathMapping &mapping : mappings.GetMappings())
+        {
+            roots.emplace_back(mapping.gamePathW, mapping.obsePathW);
+        }
+        for (const OverlayMount &overlay : mappings.GetOverlays())
+        {
+            for (size_t i = 0; i < overlay.index->LayerCount(); ++i)
+            {
+                roots.emplace_back(overlay.index->GetLayer(static_cast<uint32_t>(i)).root, overlay.virtualPathW);
+            }
+        }
+
+        std::vector<DeployEntry> planned;
+        std::unordered_set<PathString> plannedTargets;
+        std::vector<DeployDirectory> listed;
+        std::unordered_set<PathString> listedKeys;
+        for (const auto &root : roots)
+        {
+            // A root mapped onto itself needs nothing
+            if (MakeKey(root.first.native()) == MakeKey(root.second.native()))
+            {
+                continue;
+            }
+
+            // Real directories with the virtual directory each one appears as
+            std::vector<std::pair<std::filesystem::path, std::filesystem::path>> pending = {root};
+            while (!pending.empty())
+            {
+                std::filesystem::path directoryPath = std::move(pending.back().first);
+                std::filesystem::path targetDirectory = std::move(pending.back().second);
+                pending.pop_back();
+
+                std::error_code ec;
+                std::filesystem::file_time_type writeTime = std::filesystem::last_write_time(directoryPath, ec);
+                if (ec)
+                {
+                    continue;
+                }
+
+                // Reuse the last listing while the directory is unchanged, else read it again
+                PathString directoryKey = MakeKey(directoryPath.native());
+                auto previous = recorded.find(directoryKey);
+                DeployDirectory directory;
+                if (previous != recorded.end() && previous->second->lastWriteTime == writeTime.time_since_epoch().count())
+                {
+                    directory = *previous->second;
+                }
+                else
+                {
+                    directory.path = directoryPath;
+                    directory.lastWriteTime = writeTime.time_since_epoch().count();
+                    for (std::filesystem::directory_iterator it(directoryPath, std::filesystem::directory_options::skip_permission_denied, ec), end;
+                         !ec && it != end; it.increment(ec))
+                    {
+                        // Like the recursive iterator before: links to directories are not followed
+                        std::error_code entryError;
+                        if (it->is_directory(entryError) && !it->is_symlink(entryError))
+                        {
+                            directory.subdirectories.push_back(it->path().filename().u8string());
+                        }
+                        else if (it->is_regular_file(entryError))
+                        {
+                            uint64_t size = it->file_size(entryError);
+                            int64_t lastWriteTime = it->last_write_time(entryError).time_since_epoch().count();
+                            directory.files.push_back({it->path().filename().u8string(), size, lastWriteTime});
+                        }
+                    }
+                }
+
+                for (const std::string &name : directory.subdirectories)
+                {
+                    std::filesystem::path child = std::filesystem::u8path(name);
+                    pending.emplace_back(directoryPath / child, targetDirectory / child);
+                }
+
+                for (const DeployDirectory::File &file : directory.files)
+                {
+                    std::filesystem::path name = std::filesystem::u8path(file.name);
+                    std::filesystem::path source = directoryPath / name;
+                    PathString sourceKey = MakeKey(source.native());
+                    if (deployedTargets.count(sourceKey))
+                    {
+                        continue;
+                    }
+
+                    // Keep the pair only where the translation agrees: a longer mapping or a
+                    // higher overlay layer may provide this virtual path instead
+                    std::filesystem::path target = targetDirectory / name;
+                    PathStringView targetString = target.native();
+                    size_t matchedLength = 0;
+                    const PathString *resolvedRoot = mappings.FindTarget(MappingDirection::ObseToGame, targetString, &matchedLength);
+                    if (!resolvedRoot || MakeKey(*resolvedRoot + PathString(targetString.substr(matchedLength))) != sourceKey ||
+                        !plannedTargets.insert(MakeKey(targetString)).second)
+                    {
+                        continue;
+                    }
+
+                    planned.push_back({std::move(target), std::move(source), file.size, file.lastWriteTime, LinkKind::HardLink});
+                }
+
+                if (directory.lastWriteTime < listingStart && listedKeys.insert(std::move(directoryKey)).second)
+                {
+                    listed.push_back(std::move(directory));
+                }
+            }
+        }
+
+        m_Directories = std::move(listed);
+        return planned;
+    }
+
+    bool LinkDeployer::CreateLink(const DeployEntry &entry, const std::filesystem::path &linkPath, LinkKind &kind)
+    {
+        if (Platform::LinkFile(linkPath, entry.source))
+        {
+            kind = LinkKind::HardLink;
+            return true;
+        }
+
+        // Symbolic links reach other volumes, but need developer mode or the privilege
+        Platform::FileError error = Platform::GetLastFileError();
+        if ((error == Platform::FileError::NotSameDevice || error == Platform::FileError::TooManyLinks) &&
+            Platform::SymlinkFile(linkPath, entry.source))
+        {
+            kind = LinkKind::SymbolicLink;
+            return true;
+        }
+        return false;
+    }
+
+    bool LinkDeployer::CreateLinkIn(const DeployEntry &entry, const std::filesystem::path &linkPath, LinkKind &kind)
+    {
+        PathStringView path = linkPath.native();
+        DirectoryMaterializer::EnsureParentDirectory(path);
+        if (CreateLink(entry, linkPath, kind))
+        {
+            return true;
+        }
+
+        // The directory was removed after it was remembered; create it again once
+        Platform::FileError error = Platform::GetLastFileError();
+        if (error != Platform::FileError::PathNotFound && error != Platform::FileError::NotFound)
+        {
+            return false;
+        }
+        DirectoryMaterializer::ForgetParentDirectory(path);
+        return DirectoryMaterializer::EnsureParentDirectory(path) && CreateLink(entry, linkPath, kind);
+    }
+
+    DeployStats LinkDeployer::Apply(std::vector<DeployEntry> planned)
+    {
+        enum class Outcome
+        {
+            Unchanged,
+            Added,
+            Updated,
+            Removed,
+            Conflict,
+            Failed
+        };
+
+        std::unordered_map<PathString, size_t> previous;
+        for (size_t i = 0; i < m_Deployed.size(); ++i)
+        {
+            previous.emplace(MakeKey(m_Deployed[i].target.native()), i);
+        }
+
+        // Work items: planned entries (with the deployed entry they replace, if any), then removals
+        struct Work
+        {
+            size_t planned;  // Index into planned, or SIZE_MAX for a removal
+            size_t deployed; // Index into m_Deployed, or SIZE_MAX for a new target
+        };
+        std::vector<Work> work;
+        work.reserve(planned.size() + m_Deployed.size());
+        for (size_t i = 0; i < planned.size(); ++i)
+        {
+            auto it = previous.find(MakeKey(planned[i].target.native()));
+            if (it != previous.end())
+            {
+                work.push_back({i, it->second});
+                previous.erase(it);
+            }
+            else
+            {
+                work.push_back({i, SIZE_MAX});
+            }
+        }
+        for (const auto &removal : previous)
+        {
+            work.push_back({SIZE_MAX, removal.second});
+        }
+
+        std::vector<Outcome> outcomes(work.size(), Outcome::Failed);
+        auto run = [this, &planned, &work](size_t index) -> Outcome
+        {
+            const Work &item = work[index];
+            if (item.planned == SIZE_MAX)
+            {
+                const std::filesystem::path &target = m_Deployed[item.deployed].target;
+                if (Platform::RemoveFile(target))
+                {
+                    return Outcome::Removed;
+                }
+                Platform::FileError error = Platform::GetLastFileError();
+                return error == Platform::FileError::NotFound || error == Platform::FileError::PathNotFound ? Outcome::Removed : Outcome::Failed;
+            }
+
+            DeployEntry &entry = planned[item.planned];
+            if (item.deployed == SIZE_MAX)
+            {
+                if (CreateLinkIn(entry, entry.target, entry.kind))
+                {
+                    return Outcome::Added;
+                }
+                return Platform::GetLastFileError() == Platform::FileError::AlreadyExists ? Outcome::Conflict : Outcome::Failed;
+            }
+
+            const DeployEntry &deployed = m_Deployed[item.deployed];
+            if (SameSource(entry, deployed))
+            {
+                entry.kind = deployed.kind;
+                return Outcome::Unchanged;
+            }
+
+            // Link beside the old one and move it over, so the target never goes missing
+            std::filesystem::path temporary = entry.target;
+            temporary += L".obse64gp-link";
+            Platform::RemoveFile(temporary);
+            if (CreateLinkIn(entry, temporary, entry.kind))
+            {
+                if (Platform::RenameFile(temporary, entry.target, true))
+                {
+                    return Outcome::Updated;
+                }
+                Platform::RemoveFile(temporary);
+            }
+            return Outcome::Failed;
+        };
+
+        // Each item is a few metadata operations; several threads keep the volume busy
+        std::atomic<size_t> next{0};
+        auto worker = [&]()
+        {
+            for (size_t index = next.fetch_add(1); index < work.size(); index = next.fetch_add(1))
+            {
+                outcomes[index] = run(index);
+            }
+        };
+        unsigned workerCount = std::min(std::max(std::thread::hardware_concurrency(), 1u), 8u);
+        std::vector<std::thread> threads;
+        for (unsigned i = 1; i < workerCount && i < work.size(); ++i)
+        {
+            threads.emplace_back(worker);
+        }
+        worker();
+        for (std::thread &thread : threads)
+        {
+            thread.join();
+        }
+
+        // The new manifest: whatever is on disk now, including old links that could not be
+        // replaced or removed, so the next run tries again
+        DeployStats stats = {};
+        std::vector<DeployEntry> deployed;
+        deployed.reserve(planned.size());
+        for (size_t i = 0; i < work.size(); ++i)
+        {
+            const Work &item = work[i];
+            switch (outcomes[i])
+            {
+            case Outcome::Unchanged:
+                ++stats.unchanged;
+                deployed.push_back(std::move(planned[item.planned]));
+                break;
+            case Outcome::Added:
+                ++stats.added;
+                deployed.push_back(std::move(planned[item.planned]));
+                break;
+            case Outcome::Updated:
+                ++stats.updated;
+                deployed.push_back(std::move(planned[item.planned]));
+                break;
+            case Outcome::Removed:
+                ++stats.removed;
+                break;
+            case Outcome::Conflict:
+                ++stats.conflicts;
+                Log(LogLevel::Warning, "Not deploying over existing file: %s", planned[item.planned].target.string().c_str());
+                break;
+            case Outcome::Failed:
+                ++stats.failed;
+                Log(LogLevel::Warning, "Failed to deploy %s",
+                    (item.planned != SIZE_MAX ? planned[item.planned].target : m_Deployed[item.deployed].target).string().c_str());
+                if (item.deployed != SIZE_MAX)
+                {
+                    deployed.push_back(m_Deployed[item.deployed]);
+                }
+                break;
+            }
+        }
+
+        m_Deployed = std::move(deployed);
+        return stats;
+    }
+
+    bool LinkDeployer::LoadManifest(const std::filesystem::path &manifestPath)
+    {
+        CacheReader reader;
+        if (!reader.Open(manifestPath))
+        {
+            return false;
+        }
+
+        uint32_t magic = 0;
+        uint32_t version = 0;
+        uint32_t count = 0;
+        if (!reader.Read(magic) || magic != ManifestMagic || !reader.Read(version) || version != ManifestVersion ||
+            !reader.Read(count))
+        {
+            Log(LogLevel::Warning, "Ignoring deployment manifest in an unknown format: %s", manifestPath.string().c_str());
+            return false;
+        }
+
+        std::vector<DeployEntry> deployed;
+        deployed.reserve(std::min(count, CacheReader::MaxCount));
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            DeployEntry entry = {};
+            std::string target;
+            std::string source;
+            if (!reader.Read(target) || !reader.Read(source) || !reader.Read(entry.size) ||
+                !reader.Read(entry.lastWriteTime) || !reader.Read(entry.kind))
+            {
+                Log(LogLevel::Warning, "Ignoring truncated deployment manifest: %s", manifestPath.string().c_str());
+                return false;
+            }
+            entry.target = std::filesystem::u8path(target);
+            entry.source = std::filesystem::u8path(source);
+            deployed.push_back(std::move(entry));
+        }
+
+        // Then the directory listings Plan may reuse
+        std::vector<DeployDirectory> directories;
+        if (!reader.Read(count) || count > CacheReader::MaxCount)
+        {
+            Log(LogLevel::Warning, "Ignoring truncated deployment manifest: %s", manifestPath.string().c_str());
+            return false;
+        }
+        directories.resize(count);
+        for (DeployDirectory &directory : directories)
+        {
+            std::string path;
+            uint32_t fileCount = 0;
+            if (!reader.Read(path) || !reader.Read(directory.lastWriteTime) || !reader.Read(directory.subdirectories) ||
+                !reader.Read(fileCount) || fileCount > CacheReader::MaxCount)
+            {
+                Log(LogLevel::Warning, "Ignoring truncated deployment manifest: %s", manifestPath.string().c_str());
+                return false;
+            }
+            directory.path = std::filesystem::u8path(path);
+            directory.files.resize(fileCount);
+            for (DeployDirectory::File &file : directory.files)
+            {
+                if (!reader.Read(file.name) || !reader.Read(file.size) || !reader.Read(file.lastWriteTime))
+                {
+                    Log(LogLevel::Warning, "Ignoring truncated deployment manifest: %s", manifestPath.string().c_str());
+                    return false;
+                }
+            }
+        }
+
+        m_Deployed = std::move(deployed);
+        m_Directories = std::move(directories);
+        return true;
+    }
+
+    bool LinkDeployer::SaveManifest(const std::filesystem::path &manifestPath) const
+    {
+        CacheWriter writer(manifestPath);
+        writer.Write(ManifestMagic);
+        writer.Write(ManifestVersion);
+        writer.Write(static_cast<uint32_t>(m_Deployed.size()));
+        for (const DeployEntry &entry : m_Deployed)
+        {
+            writer.Write(entry.target.u8string());
+            writer.Write(entry.source.u8string());
+            writer.Write(entry.size);
+            writer.Write(entry.lastWriteTime);
+            writer.Write(entry.kind);
+        }
+        writer.Write(static_cast<uint32_t>(m_Directories.size()));
+        for (const DeployDirectory &directory : m_Directories)
+        {
+            writer.Write(directory.path.u8string());
+            writer.Write(directory.lastWriteTime);
+            writer.Write(directory.subdirectories);
+            writer.Write(static_cast<uint32_t>(directory.files.size()));
+            for (const DeployDirectory::File &file : directory.files)
+            {
+                writer.Write(file.name);
+                writer.Write(file.size);
+                writer.Write(file.lastWriteTime);
+            }
+        }
+        return writer.Commit();
+    }
+
+} // namespace ObseGPCompat
@@ -0,0 +1,53 @@
+#include "MappedFile.h"
+#include "Platform.h"
+
+namespace ObseGPCompat
+{
+
+    MappedFile::MappedFile()
+        : m_View(nullptr),
+          m_Size(0)
+    {
+    }
+
+    MappedFile::~MappedFile()
+    {
+        Close();
+    }
+
+    bool MappedFile::Open(const std::filesystem::path &path)
+    {
+        Close();
+        return Platform::MapFile(path, m_View, m_Size);
+    }
+
+    void MappedFile::Prefetch() const
+    {
+        if (!m_View)
+        {
+            return;
+        }
+
+        // Queue the reads for the whole range, then touch each page to wait for them
+        Platform::PrefetchMemory(m_View, m_Size);
+
+        const volatile uint8_t *bytes = static_cast<const volatile uint8_t *>(m_View);
+        uint8_t sink = 0;
+        for (size_t offset = 0; offset < m_Size; offset += 4096)
+        {
+            sink ^= bytes[offset];
+        }
+        (void)sink;
+    }
+
+    void MappedFile::Close()
+    {
+        if (m_View)
+        {
+            Platform::UnmapFile(m_View, m_Size);
+            m_View = nullptr;
+        }
+        m_Size = 0;
+    }
+
+} // namespace ObseGPCompat
@@ -0,0 +1,423 @@
+#include "MappingRegistry.h"
+#include "ObseGPCompat.h"
+#include "PathUtils.h"
+#include "TranslationCache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <type_traits>
+#include <unordered_map>
+
+namespace ObseGPCompat
+{
+
+    namespace
+    {
+        // Source of MappingSnapshot ids; zero is never handed out
+        std::atomic<uint64_t> g_NextSnapshotId{1};
+
+        PathMapping MakeMapping(const std::filesystem::path &obsePath, const std::filesystem::path &gamePath)
+        {
+            // Keep narrow and UTF-16 copies so neither hook flavour has to transcode
+            return {obsePath.string(), gamePath.string(), obsePath.wstring(), gamePath.wstring()};
+        }
+
+        // The root as BasicPathPrefixTable keys it: folded, with runs of separators collapsed,
+        // so every spelling of one root is one mapping
+        std::string RootKey(const std::string &path)
+        {
+            std::string key;
+            key.reserve(path.size());
+            for (char c : path)
+            {
+                if (!IsPathSeparator(c))
+                {
+                    key.push_back(FoldPathChar(c));
+                }
+                else if (!key.empty() && key.back() != '\\')
+                {
+                    key.push_back('\\');
+                }
+            }
+            if (!key.empty() && key.back() == '\\')
+            {
+                key.pop_back();
+            }
+            return key;
+        }
+
+        // Picks the narrow or UTF-16 copy of each root
+        template <typename CharT>
+        const std::basic_string<CharT> &ObseRoot(const PathMapping &mapping)
+        {
+            if constexpr (std::is_same_v<CharT, char>)
+            {
+                return mapping.obsePath;
+            }
+            else
+            {
+                return mapping.obsePathW;
+            }
+        }
+
+        template <typename CharT>
+        const std::basic_string<CharT> &GameRoot(const PathMapping &mapping)
+        {
+            if constexpr (std::is_same_v<CharT, char>)
+            {
+                return mapping.gamePath;
+            }
+            else
+            {
+                return mapping.gamePathW;
+            }
+        }
+
+        template <typename CharT>
+        const std::basic_string<CharT> &VirtualRoot(const OverlayMount &mount)
+        {
+            if constexpr (std::is_same_v<CharT, char>)
+            {
+                return mount.virtualPath;
+            }
+            else
+            {
+                return mount.virtualPathW;
+            }
+        }
+
+        template <typename CharT>
+        const std::basic_string<CharT> &LayerRoot(const OverlayIndex::Layer &layer)
+        {
+            if constexpr (std::is_same_v<CharT, char>)
+            {
+                return layer.rootString;
+            }
+            else
+            {
+                return layer.rootStringW;
+            }
+        }
+    }
+
+    MappingSnapshot::MappingSnapshot(std::vector<PathMapping> mappings, std::vector<OverlayMount> overlays)
+        : m_Id(g_NextSnapshotId.fetch_add(1, std::memory_order_relaxed)),
+          m_Mappings(std::move(mappings)),
+          m_Overlays(std::move(overlays))
+    {
+        for (uint32_t mount = 0; mount < m_Overlays.size(); ++mount)
+        {
+            for (size_t layer = 0; layer < m_Overlays[mount].index->LayerCount(); ++layer)
+            {
+                m_OverlayLayerMounts.push_back(mount);
+            }
+        }
+
+        BuildTables(m_Narrow);
+        BuildTables(m_Wide);
+    }
+
+    template <typename CharT>
+    void MappingSnapshot::BuildTables(Tables<CharT> &tables)
+    {
+        std::vector<std::basic_string_view<CharT>> obseRoots;
+        for (uint32_t index = 0; index < m_Mappings.size(); ++index)
+        {
+            const PathMapping &mapping = m_Mappings[index];
+            tables.obseToGame.Insert(ObseRoot<CharT>(mapping), index);
+            tables.gameToObse.Insert(GameRoot<CharT>(mapping), index);
+            obseRoots.push_back(ObseRoot<CharT>(mapping));
+        }
+
+        uint32_t layerValue = 0;
+        for (uint32_t mount = 0; mount < m_Overlays.size(); ++mount)
+        {
+            const OverlayMount &overlay = m_Overlays[mount];
+            tables.overlayMounts.Insert(VirtualRoot<CharT>(overlay), mount);
+            obseRoots.push_back(VirtualRoot<CharT>(overlay));
+
+            for (size_t layer = 0; layer < overlay.index->LayerCount(); ++layer)
+            {
+                tables.overlayLayers.Insert(LayerRoot<CharT>(overlay.index->GetLayer(static_cast<uint32_t>(layer))), layerValue++);
+            }
+        }
+
+        tables.obsePrefilter.Build(obseRoots);
+    }
+
+    MappingRegistry::MappingRegistry()
+    {
+        // Readers always find a snapshot, even before Initialize
+        m_Snapshot.Publish(std::make_unique<MappingSnapshot>(std::vector<PathMapping>(), std::vector<OverlayMount>()));
+    }
+
+    MappingRegistry::~MappingRegistry()
+    {
+        // Destructor
+    }
+
+    bool MappingRegistry::Initialize()
+    {
+        Log(LogLevel::Info, "Initializing MappingRegistry");
+
+        // Ensure paths are set
+        if (g_GamePassInstallPath.empty())
+        {
+            Log(LogLevel::Error, "Game Pass installation path is not set");
+            return false;
+        }
+
+        if (g_ObsePath.empty())
+        {
+            Log(LogLevel::Error, "OBSE installation path is not set");
+            return false;
+        }
+
+        std::vector<PathMapping> mappings;
+        auto addMapping = [&mappings](const std::filesystem::path &obsePath, const std::filesystem::path &gamePath)
+        {
+            mappings.push_back(MakeMapping(obsePath, gamePath));
+        };
+
+        // Game Pass path structure:
+        // C:\XboxGames\The Elder Scrolls IV- Oblivion Remastered\Content\OblivionRemastered\Binaries\WinGDK
+        // or
+        // C:\Program Files\ModifiableWindowsApps\The Elder Scrolls IV- Oblivion Remastered\Content\OblivionRemastered\Binaries\WinGDK
+        std::filesystem::path gamePassContent = g_GamePassInstallPath / "Content" / "OblivionRemastered";
+        std::filesystem::path obsePath = g_ObsePath;
+
+        // Main executable directory (this also covers the OBSE directory next to it)
+        addMapping(obsePath, gamePassContent / "Binaries" / "WinGDK");
+
+        // Content directory
+        addMapping(obsePath / "Content", gamePassContent / "Content");
+
+        // Data directory
+        addMapping(obsePath / "Data", gamePassContent / "Content" / "Dev" / "ObvData" / "data");
+
+        // OBSE64 plugins live under Win64, where the README tells users to install them
+        addMapping(obsePath / "OBSE" / "Plugins", gamePassContent / "Binaries" / "Win64" / "OBSE" / "Plugins");
+
+        // OBSE64 logs directory
+        std::filesystem::path localAppData = GetLocalAppDataPath();
+        if (!localAppData.empty())
+        {
+            addMapping(obsePath / "OBSE" / "Logs", localAppData / "My Games" / "Oblivion Remastered GP" / "OBSE" / "Logs");
+        }
+        else
+        {
+            Log(LogLevel::Warning, "Local AppData path not found, OBSE logs will not be redirected");
+        }
+
+        // Mapped directories are not created here; the hooks create them on the first
+        // open that writes into them
+
+        // Log the mappings
+        Log(LogLevel::Debug, "Path mappings created:");
+        for (const auto &mapping : mappings)
+        {
+            Log(LogLevel::Debug, "  OBSE -> Game Pass: '%s' -> '%s'",
+                mapping.obsePath.c_str(), mapping.gamePath.c_str());
+        }
+
+        size_t mappingCount = mappings.size();
+        {
+            std::lock_guard<std::mutex> lock(m_WriteMutex);
+            Publish(std::move(mappings), m_Snapshot.Load()->GetOverlays());
+        }
+
+        Log(LogLevel::Info, "MappingRegistry initialized with %zu mappings", mappingCount);
+        return true;
+    }
+
+    void MappingRegistry::AddMapping(const std::filesystem::path &obsePath, const std::filesystem::path &gamePath)
+    {
+        AddMappings({{obsePath, gamePath}});
+    }
+
+    void MappingRegistry::AddMappings(const std::vector<std::pair<std::filesystem::path, std::filesystem::path>> &roots)
+    {
+        std::vector<PathMapping> added;
+        added.reserve(roots.size());
+        for (const auto &root : roots)
+        {
+            added.push_back(MakeMapping(root.first, root.second));
+        }
+
+        // Copy-on-write: only writers touch the current snapshot's mappings here, and they hold the lock
+        std::lock_guard<std::mutex> lock(m_WriteMutex);
+        const MappingSnapshot *current = m_Snapshot.Load();
+        std::vector<PathMapping> mappings = current->GetMappings();
+
+        // Index the roots once rather than searching the list for every addition
+        std::unordered_map<std::string, size_t> positions;
+        positions.reserve(mappings.size() + added.size());
+        for (size_t i = 0; i < mappings.size(); ++i)
+        {
+            positions.emplace(RootKey(mappings[i].obsePath), i);
+        }
+
+        // Re-adding a root, under any spelling, replaces the previous target
+        for (PathMapping &mapping : added)
+        {
+            auto inserted = positions.emplace(RootKey(mapping.obsePath), mappings.size());
+            if (inserted.second)
+            {
+                mappings.push_back(std::move(mapping));
+            }
+            else
+            {
+                mappings[inserted.first->second] = std::move(mapping);
+            }
+        }
+
+        Publish(std::move(mappings), current->GetOverlays());
+    }
+
+    bool MappingRegistry::MountOverlay(const std::filesystem::path &virtualPath, const std::vector<OverlayLayer> &layers)
+    {
+        Log(LogLevel::Info, "Mounting overlay at %s with %zu layers", virtualPath.string().c_str(), layers.size());
+
+        // Scan the layers without holding up other writers; readers are never held up anyway
+        auto start = std::chrono::steady_clock::now();
+        auto index = std::make_shared<OverlayIndex>();
+        index->Build(layers);
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+
+        Log(LogLevel::Info, "Overlay index for %s: %zu files, %zu conflicts resolved by priority, built in %lld ms",
+            virtualPath.string().c_str(), index->FileCount(), index->ConflictCount(),
+            static_cast<long long>(elapsed.count()));
+
+        OverlayMount mount = {virtualPath.string(), virtualPath.wstring(), std::move(index)};
+
+        std::lock_guard<std::mutex> lock(m_WriteMutex);
+        const MappingSnapshot *current = m_Snapshot.Load();
+        std::vector<OverlayMount> overlays = current->GetOverlays();
+
+        // Mounting again at the same point, under any spelling, replaces the previous overlay
+        std::string key = RootKey(mount.virtualPath);
+        auto existing = std::find_if(overlays.begin(), overlays.end(),
+                                     [&key](const OverlayMount &overlay)
+                                     { return RootKey(overlay.virtualPath) == key; });
+        if (existing != overlays.end())
+        {
+            *existing = std::move(mount);
+        }
+        else
+        {
+            overlays.push_back(std::move(mount));
+        }
+
+        Publish(current->GetMappings(), std::move(overlays));
+        return true;
+    }
+
+    void MappingRegistry::Publish(std::vector<PathMapping> mappings, std::vector<OverlayMount> overlays)
+    {
+        auto snapshot = std::make_unique<MappingSnapshot>(std::move(mappings), std::move(overlays));
+
+        // Drop translations cached against the previous mappings on every thread, before
+        // anyone can see the new ones. The cache is keyed by snapshot id rather than
+        // address, so entries a reader still finishing with a retired snapshot leaves
+        // behind cannot match a later snapshot allocated in its place.
+        TranslationCache::Invalidate();
+        m_Snapshot.Publish(std::move(snapshot));
+    }
+
+    template <typename CharT>
+    const MappingSnapshot::Tables<CharT> &MappingSnapshot::GetTables() const
+    {
+        if constexpr (std::is_same_v<CharT, char>)
+        {
+            return m_Narrow;
+        }
+        else
+        {
+            return m_Wide;
+        }
+    }
+
+    template <typename CharT>
+    uint32_t MappingSnapshot::FindLongest(MappingDirection direction, std::basic_string_view<CharT> path, size_t *matchedLength) const
+    {
+        const Tables<CharT> &tables = GetTables<CharT>();
+        const BasicPathPrefixTable<CharT> &table = direction == MappingDirection::ObseToGame ? tables.obseToGame : tables.gameToObse;
+
+        // Repeated lookups of the same path are answered from the calling thread's cache
+        uint64_t owner = m_Id * 2 + (direction == MappingDirection::ObseToGame ? 0 : 1);
+        return TranslationCache::FindLongest(owner, path, matchedLength,
+                                             [&table](std::basic_string_view<CharT> key, size_t *length)
+                                             { return table.FindLongest(key, length); });
+    }
+
+    template <typename CharT>
+    const std::basic_string<CharT> &MappingSnapshot::TargetRoot(MappingDirection direction, uint32_t index) const
+    {
+        const PathMapping &mapping = m_Mappings[index];
+        return direction == MappingDirection::ObseToGame ? GameRoot<CharT>(mapping) : ObseRoot<CharT>(mapping);
+    }
+
+    template <typename CharT>
+    const std::basic_string<CharT> *MappingSnapshot::FindTarget(MappingDirection direction, std::basic_string_view<CharT> path, size_t *matchedLength) const
+    {
+        const Tables<CharT> &tables = GetTables<CharT>();
+
+        size_t overlayLength = 0;
+        const std::basic_string<CharT> *overlayTarget = nullptr;
+        if (!m_Overlays.empty())
+        {
+            if (direction == MappingDirection::ObseToGame)
+            {
+                // One probe into the mount's winner index picks the layer providing the file
+                uint32_t mount = tables.overlayMounts.FindLongest(path, &overlayLength);
+                if (mount != BasicPathPrefixTable<CharT>::NoValue)
+                {
+                    const OverlayIndex &index = *m_Overlays[mount].index;
+                    uint32_t layer = index.FindWinner(path.substr(overlayLength));
+                    if (layer != OverlayIndex::NoLayer)
+                    {
+                        *matchedLength = overlayLength;
+                        return &LayerRoot<CharT>(index.GetLayer(layer));
+                    }
+                }
+            }
+            else
+            {
+                // A file inside any layer maps back to the mount point
+                uint32_t layer = tables.overlayLayers.FindLongest(path, &overlayLength);
+                if (layer != BasicPathPrefixTable<CharT>::NoValue)
+                {
+                    overlayTarget = &VirtualRoot<CharT>(m_Overlays[m_OverlayLayerMounts[layer]]);
+                }
+            }
+        }
+
+        size_t mappedLength = 0;
+        uint32_t index = FindLongest(direction, path, &mappedLength);
+        if (index != NoMapping && (!overlayTarget || mappedLength > overlayLength))
+        {
+            *matchedLength = mappedLength;
+            return &TargetRoot<CharT>(direction, index);
+        }
+
+        *matchedLength = overlayLength;
+        return overlayTarget;
+    }
+
+    template <typename CharT>
+    bool MappingSnapshot::MayMatchObsePath(std::basic_string_view<CharT> path) const
+    {
+        return GetTables<CharT>().obsePrefilter.MayMatch(path);
+    }
+
+    template uint32_t MappingSnapshot::FindLongest<char>(MappingDirection direction, std::basic_string_view<char> path, size_t *matchedLength) const;
+    template uint32_t MappingSnapshot::FindLongest<wchar_t>(MappingDirection direction, std::basic_string_view<wchar_t> path, size_t *matchedLength) const;
+    template const std::basic_string<char> &MappingSnapshot::TargetRoot<char>(MappingDirection direction, uint32_t index) const;
+    template const std::basic_string<wchar_t> &MappingSnapshot::TargetRoot<wchar_t>(MappingDirection direction, uint32_t index) const;
+    template const std::basic_string<char> *MappingSnapshot::FindTarget<char>(MappingDirection direction, std::basic_string_view<char> path, size_t *matchedLength) const;
+    template const std::basic_string<wchar_t> *MappingSnapshot::FindTarget<wchar_t>(MappingDirection direction, std::basic_string_view<wchar_t> path, size_t *matchedLength) const;
+    template bool MappingSnapshot::MayMatchObsePath<char>(std::basic_string_view<char> path) const;
+    template bool MappingSnapshot::MayMatchObsePath<wchar_t>(std::basic_string_view<wchar_t> path) const;
+
+} // namespace ObseGPCompat
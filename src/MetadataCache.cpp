@@ -0,0 +1,202 @@
+#include "MetadataCache.h"
+#include "PathUtils.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace ObseGPCompat
+{
+
+    MetadataCache::MetadataCache(size_t capacity)
+        : m_ShardCapacity(std::max<size_t>(capacity / ShardCount, 1)),
+          m_TimeToLive(0),
+          m_Hits(0),
+          m_NegativeHits(0),
+          m_Misses(0),
+          m_Expirations(0),
+          m_Invalidations(0),
+          m_Evictions(0)
+    {
+    }
+
+    MetadataCache::Key MetadataCache::MakeKey(const std::filesystem::path &path)
+    {
+        return FoldPath(std::basic_string_view<Key::value_type>(path.native()));
+    }
+
+    MetadataCache::Shard &MetadataCache::GetShard(const Key &key)
+    {
+        return m_Shards[std::hash<Key>()(key) & (ShardCount - 1)];
+    }
+
+    FileMetadata MetadataCache::Query(const std::filesystem::path &path)
+    {
+        FileMetadata metadata = {};
+
+        std::error_code ec;
+        std::filesystem::file_status status = std::filesystem::status(path, ec);
+        metadata.exists = !ec && std::filesystem::exists(status);
+        metadata.type = status.type();
+        metadata.permissions = status.permissions();
+
+        if (metadata.exists)
+        {
+            if (std::filesystem::is_regular_file(status))
+            {
+                uint64_t size = std::filesystem::file_size(path, ec);
+                metadata.size = ec ? 0 : size;
+            }
+
+            std::filesystem::file_time_type lastWriteTime = std::filesystem::last_write_time(path, ec);
+            if (!ec)
+            {
+                metadata.lastWriteTime = lastWriteTime;
+            }
+        }
+
+        return metadata;
+    }
+
+    FileMetadata MetadataCache::Get(const std::filesystem::path &path)
+    {
+        Key key = MakeKey(path);
+        Shard &shard = GetShard(key);
+        auto now = std::chrono::steady_clock::now();
+        uint64_t generation;
+
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            generation = shard.generation;
+            auto it = shard.entries.find(key);
+            if (it != shard.entries.end())
+            {
+                if (m_TimeToLive.count() == 0 || now - it->second.cachedAt < m_TimeToLive)
+                {
+                    m_Hits.fetch_add(1, std::memory_order_relaxed);
+                    if (!it->second.metadata.exists)
+                    {
+                        m_NegativeHits.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    return it->second.metadata;
+                }
+
+                m_Expirations.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        // Query without holding the shard, so a slow disk only stalls this caller
+        m_Misses.fetch_add(1, std::memory_order_relaxed);
+        FileMetadata metadata = Query(path);
+
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (shard.generation == generation)
+        {
+            if (shard.entries.size() >= m_ShardCapacity && !shard.entries.count(key))
+            {
+                Evict(shard, now);
+            }
+            shard.entries[std::move(key)] = {metadata, now};
+        }
+        return metadata;
+    }
+
+    void MetadataCache::Evict(Shard &shard, std::chrono::steady_clock::time_point now)
+    {
+        size_t before = shard.entries.size();
+        if (m_TimeToLive.count() != 0)
+        {
+            for (auto it = shard.entries.begin(); it != shard.entries.end();)
+            {
+                it = now - it->second.cachedAt >= m_TimeToLive ? shard.entries.erase(it) : std::next(it);
+            }
+        }
+
+        // Otherwise the oldest quarter goes in one pass, so the scan is paid once per
+        // quarter of the shard's inserts rather than on every one
+        if (shard.entries.size() >= m_ShardCapacity)
+        {
+            std::vector<std::chrono::steady_clock::time_point> ages;
+            ages.reserve(shard.entries.size());
+            for (const auto &entry : shard.entries)
+            {
+                ages.push_back(entry.second.cachedAt);
+            }
+            size_t count = std::max<size_t>(ages.size() / 4, 1);
+            std::nth_element(ages.begin(), ages.begin() + (count - 1), ages.end());
+            auto cutoff = ages[count - 1];
+            for (auto it = shard.entries.begin(); it != shard.entries.end();)
+            {
+                it = it->second.cachedAt <= cutoff ? shard.entries.erase(it) : std::next(it);
+            }
+        }
+        m_Evictions.fetch_add(before - shard.entries.size(), std::memory_order_relaxed);
+    }
+
+    void MetadataCache::Invalidate(const std::filesystem::path &path)
+    {
+        Key key = MakeKey(path);
+        Shard &shard = GetShard(key);
+
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        ++shard.generation;
+        if (shard.entries.erase(key))
+        {
+            m_Invalidations.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void MetadataCache::InvalidateWithAncestors(const std::filesystem::path &path)
+    {
+        for (std::filesystem::path current = path; !current.empty(); current = current.parent_path())
+        {
+            Invalidate(current);
+            if (current == current.root_path())
+            {
+                break;
+            }
+        }
+    }
+
+    void MetadataCache::InvalidateWhere(const std::function<bool(const Key &)> &predicate)
+    {
+        for (Shard &shard : m_Shards)
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            ++shard.generation;
+            for (auto it = shard.entries.begin(); it != shard.entries.end();)
+            {
+                if (predicate(it->first))
+                {
+                    it = shard.entries.erase(it);
+                    m_Invalidations.fetch_add(1, std::memory_order_relaxed);
+                }
+                else
+                {
+                    ++it;
+                }
+            }
+        }
+    }
+
+    void MetadataCache::Clear()
+    {
+        for (Shard &shard : m_Shards)
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            ++shard.generation;
+            m_Invalidations.fetch_add(shard.entries.size(), std::memory_order_relaxed);
+            shard.entries.clear();
+        }
+    }
+
+    MetadataCacheStats MetadataCache::GetStats() const
+    {
+        return {m_Hits.load(std::memory_order_relaxed),
+                m_NegativeHits.load(std::memory_order_relaxed),
+                m_Misses.load(std::memory_order_relaxed),
+                m_Expirations.load(std::memory_order_relaxed),
+                m_Invalidations.load(std::memory_order_relaxed),
+                m_Evictions.load(std::memory_order_relaxed)};
+    }
+
+} // namespace ObseGPCompat
@@ -0,0 +1,375 @@
+#include "ModFileScanner.h"
+#include "ObseGPCompat.h"
+#include "CacheFile.h"
+#include "MappedFile.h"
+#include "PathUtils.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <unordered_set>
+
+namespace ObseGPCompat
+{
+
+    namespace
+    {
+        constexpr size_t RecordHeaderSize = 20; // Oblivion; later games added a version field
+        constexpr size_t SubrecordHeaderSize = 6;
+        constexpr uint32_t FlagMaster = 0x1;
+
+        constexpr uint32_t CacheMagic = 0x4D50474F; // "OGPM"
+        constexpr uint32_t CacheVersion = 1;
+
+        bool IsType(const uint8_t *p, const char *type)
+        {
+            return std::memcmp(p, type, 4) == 0;
+        }
+
+        std::string ReadZeroTerminated(const uint8_t *data, size_t length)
+        {
+            const void *end = std::memchr(data, 0, length);
+            size_t used = end ? static_cast<const uint8_t *>(end) - data : length;
+            return std::string(reinterpret_cast<const char *>(data), used);
+        }
+
+        std::string FoldName(const std::string &name)
+        {
+            std::string folded = name;
+            std::transform(folded.begin(), folded.end(), folded.begin(), [](char c)
+                           { return FoldPathChar(c); });
+            return folded;
+        }
+
+        bool IsModFile(const std::filesystem::path &path)
+        {
+            std::string extension = FoldName(path.extension().string());
+            return extension == ".esp" || extension == ".esm";
+        }
+    }
+
+    const char *GetLoadOrderIssueName(LoadOrderIssue issue)
+    {
+        switch (issue)
+        {
+        case LoadOrderIssue::MissingMaster:
+            return "missing master";
+        case LoadOrderIssue::InactiveMaster:
+            return "inactive master";
+        case LoadOrderIssue::MasterLoadsLater:
+            return "master loads later";
+        default:
+            return "unknown";
+        }
+    }
+
+    ModFileScanner::ModFileScanner()
+        : m_CacheChanged(false),
+          m_Parsed(0)
+    {
+    }
+
+    bool ModFileScanner::Parse(const uint8_t *data, size_t size, ModFileInfo &info)
+    {
+        info.valid = false;
+        info.masters.clear();
+
+        uint32_t dataSize = 0;
+        uint32_t flags = 0;
+        if (size < RecordHeaderSize || !IsType(data, "TES4"))
+        {
+            return false;
+        }
+        std::memcpy(&dataSize, data + 4, sizeof(dataSize));
+        std::memcpy(&flags, data + 8, sizeof(flags));
+        if (dataSize > size - RecordHeaderSize)
+        {
+            return false;
+        }
+        info.isMaster = (flags & FlagMaster) != 0;
+
+        // Subrecords: a type, a 16-bit size, the data. XXXX gives the next one a 32-bit size.
+        const uint8_t *p = data + RecordHeaderSize;
+        const uint8_t *end = p + dataSize;
+        uint32_t largeSize = 0;
+        bool hasLargeSize = false;
+        while (static_cast<size_t>(end - p) >= SubrecordHeaderSize)
+        {
+            const uint8_t *type = p;
+            uint16_t length16 = 0;
+            std::memcpy(&length16, p + 4, sizeof(length16));
+            p += SubrecordHeaderSize;
+
+            size_t length = hasLargeSize ? largeSize : length16;
+            hasLargeSize = false;
+            if (length > static_cast<size_t>(end - p))
+            {
+                return false;
+            }
+
+            if (IsType(type, "XXXX") && length == 4)
+            {
+                std::memcpy(&largeSize, p, sizeof(largeSize));
+                hasLargeSize = true;
+            }
+            else if (IsType(type, "HEDR") && length >= 8)
+            {
+                int32_t recordCount = 0;
+                std::memcpy(&info.version, p, sizeof(info.version));
+                std::memcpy(&recordCount, p + 4, sizeof(recordCount));
+                info.recordCount = recordCount > 0 ? static_cast<uint32_t>(recordCount) : 0;
+            }
+            else if (IsType(type, "CNAM"))
+            {
+                info.author = ReadZeroTerminated(p, length);
+            }
+            else if (IsType(type, "MAST"))
+            {
+                info.masters.push_back(ReadZeroTerminated(p, length));
+            }
+            p += length;
+        }
+
+        info.valid = true;
+        return true;
+    }
+
+    ModFileInfo ModFileScanner::ScanFile(const std::filesystem::path &file, uint64_t size, int64_t lastWriteTime)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            auto it = m_Cache.find(file.native());
+            if (it != m_Cache.end() && it->second.size == size && it->second.lastWriteTime == lastWriteTime)
+            {
+                return it->second;
+            }
+        }
+
+        // Mapping costs nothing up front; only the pages of the header record are read
+        ModFileInfo info = {};
+        info.path = file;
+        info.size = size;
+        info.lastWriteTime = lastWriteTime;
+        MappedFile view;
+        if (view.Open(file))
+        {
+            Parse(view.Data(), view.Size(), info);
+        }
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Cache[file.native()] = info;
+        m_CacheChanged = true;
+        ++m_Parsed;
+        return info;
+    }
+
+    std::vector<ModFileInfo> ModFileScanner::Scan(const std::filesystem::path &directory, WorkerPool &pool)
+    {
+        struct Candidate
+        {
+            std::filesystem::path path;
+            uint64_t size;
+            int64_t lastWriteTime;
+        };
+
+        std::vector<Candidate> candidates;
+        std::error_code ec;
+        for (std::filesystem::directory_iterator it(directory, ec), end; !ec && it != end; it.increment(ec))
+        {
+            std::error_code entryError;
+            if (!IsModFile(it->path()) || !it->is_regular_file(entryError))
+            {
+                continue;
+            }
+            uint64_t size = it->file_size(entryError);
+            int64_t lastWriteTime = it->last_write_time(entryError).time_since_epoch().count();
+            candidates.push_back({it->path(), entryError ? 0 : size, entryError ? 0 : lastWriteTime});
+        }
+        std::sort(candidates.begin(), candidates.end(), [](const Candidate &a, const Candidate &b)
+                  { return a.path < b.path; });
+
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Parsed = 0;
+        }
+
+        // One task per plugin; the caller waits for all of them
+        std::vector<ModFileInfo> results(candidates.size());
+        std::mutex doneMutex;
+        std::condition_variable done;
+        size_t remaining = candidates.size();
+        for (size_t i = 0; i < candidates.size(); ++i)
+        {
+            pool.Submit([this, &candidates, &results, &doneMutex, &done, &remaining, i]()
+                        {
+                            results[i] = ScanFile(candidates[i].path, candidates[i].size, candidates[i].lastWriteTime);
+
+                            // Notify under the lock; the waiter's locals go away as soon as it wakes
+                            std::lock_guard<std::mutex> lock(doneMutex);
+                            --remaining;
+                            done.notify_one();
+                        });
+        }
+        {
+            std::unique_lock<std::mutex> lock(doneMutex);
+            done.wait(lock, [&remaining]()
+                      { return remaining == 0; });
+        }
+
+        // Forget plugins that have left the directory
+        std::unordered_set<std::filesystem::path::string_type> present;
+        for (const Candidate &candidate : candidates)
+        {
+            present.insert(candidate.path.native());
+        }
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        for (auto it = m_Cache.begin(); it != m_Cache.end();)
+        {
+            if (it->second.path.parent_path() == directory && !present.count(it->first))
+            {
+                it = m_Cache.erase(it);
+                m_CacheChanged = true;
+            }
+            else
+            {
+                ++it;
+            }
+        }
+
+        return results;
+    }
+
+    std::vector<LoadOrderProblem> ModFileScanner::CheckLoadOrder(const std::vector<ModFileInfo> &files,
+                                                                 std::vector<std::string> loadOrder)
+    {
+        std::unordered_map<std::string, const ModFileInfo *> byName;
+        for (const ModFileInfo &file : files)
+        {
+            byName[FoldName(file.path.filename().string())] = &file;
+        }
+
+        // Without a list, the original rule: masters first, then oldest to newest
+        if (loadOrder.empty())
+        {
+            std::vector<const ModFileInfo *> ordered;
+            for (const ModFileInfo &file : files)
+            {
+                ordered.push_back(&file);
+            }
+            std::stable_sort(ordered.begin(), ordered.end(), [](const ModFileInfo *a, const ModFileInfo *b)
+                             { return a->isMaster != b->isMaster ? a->isMaster : a->lastWriteTime < b->lastWriteTime; });
+            for (const ModFileInfo *file : ordered)
+            {
+                loadOrder.push_back(file->path.filename().string());
+            }
+        }
+
+        std::unordered_map<std::string, size_t> positions;
+        for (size_t i = 0; i < loadOrder.size(); ++i)
+        {
+            positions.emplace(FoldName(loadOrder[i]), i);
+        }
+
+        std::vector<LoadOrderProblem> problems;
+        for (size_t i = 0; i < loadOrder.size(); ++i)
+        {
+            auto plugin = byName.find(FoldName(loadOrder[i]));
+            if (plugin == byName.end())
+            {
+                continue;
+            }
+
+            for (const std::string &master : plugin->second->masters)
+            {
+                std::string key = FoldName(master);
+                auto position = positions.find(key);
+                if (!byName.count(key))
+                {
+                    problems.push_back({LoadOrderIssue::MissingMaster, loadOrder[i], master});
+                }
+                else if (position == positions.end())
+                {
+                    problems.push_back({LoadOrderIssue::InactiveMaster, loadOrder[i], master});
+                }
+                else if (position->second > i)
+                {
+                    problems.push_back({LoadOrderIssue::MasterLoadsLater, loadOrder[i], master});
+                }
+            }
+        }
+        return problems;
+    }
+
+    bool ModFileScanner::LoadCache(const std::filesystem::path &cachePath)
+    {
+        CacheReader reader;
+        if (!reader.Open(cachePath))
+        {
+            return false;
+        }
+
+        uint32_t magic = 0;
+        uint32_t version = 0;
+        uint32_t count = 0;
+        if (!reader.Read(magic) || magic != CacheMagic || !reader.Read(version) || version != CacheVersion ||
+            !reader.Read(count))
+        {
+            Log(LogLevel::Warning, "Ignoring plugin header cache in an unknown format: %s", cachePath.string().c_str());
+            return false;
+        }
+
+        std::unordered_map<std::filesystem::path::string_type, ModFileInfo> cache;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            ModFileInfo info = {};
+            std::string path;
+            uint8_t valid = 0;
+            uint8_t isMaster = 0;
+            if (!reader.Read(path) || !reader.Read(info.size) || !reader.Read(info.lastWriteTime) ||
+                !reader.Read(valid) || !reader.Read(isMaster) || !reader.Read(info.version) ||
+                !reader.Read(info.recordCount) || !reader.Read(info.author) || !reader.Read(info.masters))
+            {
+                Log(LogLevel::Warning, "Ignoring truncated plugin header cache: %s", cachePath.string().c_str());
+                return false;
+            }
+            info.path = std::filesystem::u8path(path);
+            info.valid = valid != 0;
+            info.isMaster = isMaster != 0;
+            cache[info.path.native()] = std::move(info);
+        }
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Cache = std::move(cache);
+        m_CacheChanged = false;
+        return true;
+    }
+
+    bool ModFileScanner::SaveCache(const std::filesystem::path &cachePath) const
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (!m_CacheChanged)
+        {
+            return true;
+        }
+
+        CacheWriter writer(cachePath);
+        writer.Write(CacheMagic);
+        writer.Write(CacheVersion);
+        writer.Write(static_cast<uint32_t>(m_Cache.size()));
+        for (const auto &entry : m_Cache)
+        {
+            const ModFileInfo &info = entry.second;
+            writer.Write(info.path.u8string());
+            writer.Write(info.size);
+            writer.Write(info.lastWriteTime);
+            writer.Write(static_cast<uint8_t>(info.valid));
+            writer.Write(static_cast<uint8_t>(info.isMaster));
+            writer.Write(info.version);
+            writer.Write(info.recordCount);
+            writer.Write(info.author);
+            writer.Write(info.masters);
+        }
+        return writer.Commit();
+    }
+
+} // namespace ObseGPCompat
@@ -0,0 +1,83 @@
+#include "ObseGPCompat.h"
+#include "ConfigurationManager.h"
+#include "MappingRegistry.h"
+#include "PathTranslator.h"
+#include "Platform.h"
+#include "VirtualFileSystem.h"
+
+#include <cstdarg>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+
+namespace ObseGPCompat
+{
+    // Global variables
+    std::filesystem::path g_GamePassInstallPath;
+    std::filesystem::path g_ObsePath;
+    std::filesystem::path g_CompatLayerPath;
+
+    // Global components; the hook manager is defined with the hooks
+    std::unique_ptr<MappingRegistry> g_MappingRegistry;
+    std::unique_ptr<PathTranslator> g_PathTranslator;
+    std::unique_ptr<VirtualFileSystem> g_VirtualFileSystem;
+    std::unique_ptr<ConfigurationManager> g_ConfigurationManager;
+
+    // Log file handle
+    static std::ofstream g_LogFile;
+    static std::mutex g_LogMutex;
+
+    // Helper function to get Local AppData path
+    std::filesystem::path GetLocalAppDataPath()
+    {
+        return Platform::GetKnownFolder(Platform::KnownFolder::LocalAppData);
+    }
+
+    bool OpenLogFile(const std::filesystem::path &path)
+    {
+        std::lock_guard<std::mutex> lock(g_LogMutex);
+        g_LogFile.open(path);
+        return g_LogFile.is_open();
+    }
+
+    void CloseLogFile()
+    {
+        std::lock_guard<std::mutex> lock(g_LogMutex);
+        g_LogFile.close();
+    }
+
+    // Log a message
+    void Log(LogLevel level, const char *format, ...)
+    {
+        static const char *levelStrings[] = {
+            "DEBUG",
+            "INFO",
+            "WARNING",
+            "ERROR"};
+
+        // Format time
+        Platform::LocalTime now = Platform::GetLocalTime();
+        char timeStr[20];
+        snprintf(timeStr, sizeof(timeStr), "%02d:%02d:%02d.%03d",
+                 now.hour, now.minute, now.second, now.millisecond);
+
+        // Format message
+        char buffer[4096];
+        va_list args;
+        va_start(args, format);
+        vsnprintf(buffer, sizeof(buffer), format, args);
+        va_end(args);
+
+        // Write to log file; workers log too, so whole lines go out one at a time
+        std::lock_guard<std::mutex> lock(g_LogMutex);
+        if (g_LogFile.is_open())
+        {
+            g_LogFile << timeStr << " [" << levelStrings[static_cast<int>(level)] << "] " << buffer << std::endl;
+            g_LogFile.flush();
+        }
+
+        // Also write to console if available
+        printf("%s [%s] %s\n", timeStr, levelStrings[static_cast<int>(level)], buffer);
+    }
+
+} // namespace ObseGPCompat
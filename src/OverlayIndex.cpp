@@ -0,0 +1,220 @@
+#include "OverlayIndex.h"
+#include "ObseGPCompat.h"
+
+#include <algorithm>
+#include <type_traits>
+
+namespace ObseGPCompat
+{
+
+    namespace
+    {
+        constexpr uint32_t EmptySlot = UINT32_MAX;
+
+        // Feeds the canonical form of path to emit: components folded and joined by a
+        // single '\\', leading and trailing separators dropped. Stops when emit returns false.
+        template <typename CharT, typename EmitFn>
+        bool ForEachCanonicalChar(std::basic_string_view<CharT> path, EmitFn &&emit)
+        {
+            bool pendingSeparator = false;
+            bool first = true;
+            for (CharT c : path)
+            {
+                if (IsPathSeparator(c))
+                {
+                    pendingSeparator = !first;
+                    continue;
+                }
+
+                if (pendingSeparator && !emit(wchar_t('\\')))
+                {
+                    return false;
+                }
+                pendingSeparator = false;
+                first = false;
+
+                if (!emit(static_cast<wchar_t>(FoldPathChar(c))))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        inline uint64_t HashStep(uint64_t hash, wchar_t c)
+        {
+            // FNV-1a over UTF-16 code units
+            hash ^= static_cast<uint64_t>(c);
+            return hash * 1099511628211ull;
+        }
+    }
+
+    OverlayIndex::OverlayIndex()
+        : m_FileCount(0),
+          m_ConflictCount(0)
+    {
+    }
+
+    void OverlayIndex::Build(const std::vector<OverlayLayer> &layers)
+    {
+        m_Layers.clear();
+        m_Slots.clear();
+        m_Keys.clear();
+        m_FileCount = 0;
+        m_ConflictCount = 0;
+
+        // Scan from lowest to highest priority so every later insert simply overrides
+        std::vector<OverlayLayer> ordered(layers);
+        std::stable_sort(ordered.begin(), ordered.end(),
+                         [](const OverlayLayer &a, const OverlayLayer &b)
+                         { return a.priority < b.priority; });
+
+        for (const OverlayLayer &layer : ordered)
+        {
+            m_Layers.push_back({layer.root, layer.priority, layer.root.string(), layer.root.wstring()});
+        }
+
+        std::wstring folded;
+        for (uint32_t layerIndex = 0; layerIndex < m_Layers.size(); ++layerIndex)
+        {
+            const std::filesystem::path &root = m_Layers[layerIndex].root;
+
+            std::error_code ec;
+            std::filesystem::recursive_directory_iterator it(root, std::filesystem::directory_options::skip_permission_denied, ec);
+            for (; !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec))
+            {
+                std::error_code typeEc;
+                if (!it->is_regular_file(typeEc))
+                {
+                    continue;
+                }
+
+                std::wstring relative = it->path().lexically_relative(root).wstring();
+                folded.clear();
+                ForEachCanonicalChar(std::wstring_view(relative), [&folded](wchar_t c)
+                                     {
+                                         folded.push_back(c);
+                                         return true;
+                                     });
+                Insert(folded, layerIndex);
+            }
+
+            if (ec)
+            {
+                Log(LogLevel::Warning, "Failed to scan overlay layer '%s': %s",
+                    m_Layers[layerIndex].rootString.c_str(), ec.message().c_str());
+            }
+        }
+    }
+
+    void OverlayIndex::Grow()
+    {
+        std::vector<Slot> slots(std::max<size_t>(64, m_Slots.size() * 2), Slot{0, EmptySlot, 0, 0});
+        size_t mask = slots.size() - 1;
+
+        for (const Slot &slot : m_Slots)
+        {
+            if (slot.keyOffset == EmptySlot)
+            {
+                continue;
+            }
+
+            size_t index = slot.hash & mask;
+            while (slots[index].keyOffset != EmptySlot)
+            {
+                index = (index + 1) & mask;
+            }
+            slots[index] = slot;
+        }
+
+        m_Slots.swap(slots);
+    }
+
+    void OverlayIndex::Insert(std::wstring_view folded, uint32_t layer)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        for (wchar_t c : folded)
+        {
+            hash = HashStep(hash, c);
+        }
+
+        if ((m_FileCount + 1) * 2 > m_Slots.size())
+        {
+            Grow();
+        }
+
+        size_t mask = m_Slots.size() - 1;
+        size_t index = hash & mask;
+        for (; m_Slots[index].keyOffset != EmptySlot; index = (index + 1) & mask)
+        {
+            Slot &slot = m_Slots[index];
+            if (slot.hash == hash && std::wstring_view(m_Keys).substr(slot.keyOffset, slot.keyLength) == folded)
+            {
+                // A higher-priority layer provides the same file
+                slot.layer = layer;
+                ++m_ConflictCount;
+                return;
+            }
+        }
+
+        m_Slots[index] = {hash, static_cast<uint32_t>(m_Keys.size()), static_cast<uint32_t>(folded.size()), layer};
+        m_Keys.append(folded);
+        ++m_FileCount;
+    }
+
+    template <typename CharT>
+    uint32_t OverlayIndex::FindWinner(std::basic_string_view<CharT> relativePath) const
+    {
+        if (m_Slots.empty())
+        {
+            return NoLayer;
+        }
+
+        // Keys are UTF-16; narrow paths outside ASCII need a proper conversion first
+        if constexpr (std::is_same_v<CharT, char>)
+        {
+            bool ascii = std::all_of(relativePath.begin(), relativePath.end(),
+                                     [](char c)
+                                     { return static_cast<unsigned char>(c) < 0x80; });
+            if (!ascii)
+            {
+                std::wstring wide = std::filesystem::path(std::string(relativePath)).wstring();
+                return FindWinner(std::wstring_view(wide));
+            }
+        }
+
+        uint64_t hash = 14695981039346656037ull;
+        size_t length = 0;
+        ForEachCanonicalChar(relativePath, [&hash, &length](wchar_t c)
+                             {
+                                 hash = HashStep(hash, c);
+                                 ++length;
+                                 return true;
+                             });
+
+        size_t mask = m_Slots.size() - 1;
+        for (size_t index = hash & mask; m_Slots[index].keyOffset != EmptySlot; index = (index + 1) & mask)
+        {
+            const Slot &slot = m_Slots[index];
+            if (slot.hash != hash || slot.keyLength != length)
+            {
+                continue;
+            }
+
+            const wchar_t *key = m_Keys.data() + slot.keyOffset;
+            size_t pos = 0;
+            bool equal = ForEachCanonicalChar(relativePath, [key, &pos](wchar_t c)
+                                              { return key[pos++] == c; });
+            if (equal)
+            {
+                return slot.layer;
+            }
+        }
+
+        return NoLayer;
+    }
+
+    template uint32_t OverlayIndex::FindWinner<char>(std::basic_string_view<char> relativePath) const;
+    template uint32_t OverlayIndex::FindWinner<wchar_t>(std::basic_string_view<wchar_t> relativePath) const;
+
+} // namespace ObseGPCompat
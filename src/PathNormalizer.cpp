@@ -0,0 +1,350 @@
+#include "PathNormalizer.h"
+#include "PathUtils.h"
+
+#include <cstdint>
+#include <string>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define OBSE64GP_NORMALIZER_SSE2 1
+#endif
+
+namespace ObseGPCompat
+{
+
+    namespace
+    {
+        template <typename CharT>
+        bool HasDevicePrefix(std::basic_string_view<CharT> path)
+        {
+            return path.size() >= 4 && IsPathSeparator(path[0]) && IsPathSeparator(path[1]) &&
+                   path[2] == CharT('.') && IsPathSeparator(path[3]);
+        }
+
+        template <typename CharT>
+        bool HasLongUncPrefix(std::basic_string_view<CharT> path)
+        {
+            return path.size() >= 8 && HasLongPathPrefix(path) &&
+                   FoldPathChar(path[4]) == CharT('u') && FoldPathChar(path[5]) == CharT('n') &&
+                   FoldPathChar(path[6]) == CharT('c') && IsPathSeparator(path[7]);
+        }
+
+#ifdef OBSE64GP_NORMALIZER_SSE2
+        // Bit i of separators/dots is set when character i of the 16-character block is one
+        inline void ClassifyBlock(const char *block, uint32_t &separators, uint32_t &dots)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block));
+            __m128i isSeparator = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\\')), _mm_cmpeq_epi8(v, _mm_set1_epi8('/')));
+            separators = static_cast<uint32_t>(_mm_movemask_epi8(isSeparator));
+            dots = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('.'))));
+        }
+
+        template <typename CharT>
+        inline void ClassifyWideBlock(const CharT *block, uint32_t &separators, uint32_t &dots)
+        {
+            __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block));
+            __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + 8));
+
+            __m128i backslash = _mm_set1_epi16('\\');
+            __m128i slash = _mm_set1_epi16('/');
+            __m128i dot = _mm_set1_epi16('.');
+
+            // Pack the 16-bit compare results down to bytes so movemask gives one bit per character
+            __m128i isSeparator = _mm_packs_epi16(
+                _mm_or_si128(_mm_cmpeq_epi16(low, backslash), _mm_cmpeq_epi16(low, slash)),
+                _mm_or_si128(_mm_cmpeq_epi16(high, backslash), _mm_cmpeq_epi16(high, slash)));
+            __m128i isDot = _mm_packs_epi16(_mm_cmpeq_epi16(low, dot), _mm_cmpeq_epi16(high, dot));
+
+            separators = static_cast<uint32_t>(_mm_movemask_epi8(isSeparator));
+            dots = static_cast<uint32_t>(_mm_movemask_epi8(isDot));
+        }
+#endif
+    }
+
+    template <typename CharT>
+    bool PathNeedsNormalization(std::basic_string_view<CharT> path)
+    {
+        if (HasDevicePrefix(path) || HasLongUncPrefix(path))
+        {
+            return true;
+        }
+
+        // A separator followed by another separator or a dot needs a closer look.
+        // Position 1 is exempt so UNC and \\?\ prefixes pass.
+        size_t i = 0;
+        uint32_t afterSeparator = 0;
+
+#ifdef OBSE64GP_NORMALIZER_SSE2
+        if constexpr (sizeof(CharT) == 1 || sizeof(CharT) == 2)
+        {
+            for (; i + 16 <= path.size(); i += 16)
+            {
+                uint32_t separators;
+                uint32_t dots;
+                if constexpr (sizeof(CharT) == 1)
+                {
+                    ClassifyBlock(reinterpret_cast<const char *>(path.data() + i), separators, dots);
+                }
+                else
+                {
+                    ClassifyWideBlock(path.data() + i, separators, dots);
+                }
+
+                uint32_t suspicious = ((separators << 1) | afterSeparator) & (separators | dots);
+                if (i == 0)
+                {
+                    suspicious &= ~2u;
+                }
+
+                if (suspicious & 0xFFFF)
+                {
+                    return true;
+                }
+
+                afterSeparator = (separators >> 15) & 1;
+            }
+        }
+#endif
+
+        for (; i < path.size(); ++i)
+        {
+            bool isSeparator = IsPathSeparator(path[i]);
+            if (afterSeparator && i != 1 && (isSeparator || path[i] == CharT('.')))
+            {
+                return true;
+            }
+            afterSeparator = isSeparator ? 1 : 0;
+        }
+
+        return false;
+    }
+
+    template <typename CharT>
+    size_t NormalizePath(std::basic_string_view<CharT> path, CharT *buffer, size_t capacity)
+    {
+        size_t out = 0;
+        auto put = [&](CharT c)
+        {
+            if (out + 1 >= capacity)
+            {
+                return false;
+            }
+            buffer[out++] = c;
+            return true;
+        };
+
+        // Root forms. rootLength covers what is emitted before the first component.
+        size_t pos = 0;
+        size_t protectedComponents = 0; // Components '..' may never remove (drive, or UNC server and share)
+        bool rooted = true;
+        if (HasLongUncPrefix(path))
+        {
+            pos = 8;
+            protectedComponents = 2;
+            if (!put(CharT('\\')) || !put(CharT('\\')))
+            {
+                return 0;
+            }
+        }
+        else if (HasLongPathPrefix(path))
+        {
+            pos = 4;
+            for (size_t i = 0; i < 4; ++i)
+            {
+                if (!put(i == 2 ? CharT('?') : CharT('\\')))
+                {
+                    return 0;
+                }
+            }
+        }
+        else if (HasDevicePrefix(path))
+        {
+            pos = 4;
+        }
+        else if (path.size() >= 2 && IsPathSeparator(path[0]) && IsPathSeparator(path[1]))
+        {
+            pos = 2;
+            protectedComponents = 2;
+            if (!put(CharT('\\')) || !put(CharT('\\')))
+            {
+                return 0;
+            }
+        }
+        else if (!path.empty() && IsPathSeparator(path[0]))
+        {
+            pos = 1;
+            if (!put(CharT('\\')))
+            {
+                return 0;
+            }
+        }
+        else
+        {
+            rooted = false;
+        }
+
+        size_t rootLength = out;
+        size_t floor = out;        // Output position '..' cannot cut below
+        size_t componentCount = 0; // Components emitted since the root
+        size_t driveEnd = 0;       // Input position just past a leading drive component
+
+        while (pos < path.size())
+        {
+            // Collapse runs of separators
+            while (pos < path.size() && IsPathSeparator(path[pos]))
+            {
+                ++pos;
+            }
+
+            if (pos >= path.size())
+            {
+                break;
+            }
+
+            size_t start = pos;
+            while (pos < path.size() && !IsPathSeparator(path[pos]))
+            {
+                ++pos;
+            }
+
+            std::basic_string_view<CharT> component = path.substr(start, pos - start);
+
+            if (component.size() == 1 && component[0] == CharT('.'))
+            {
+                continue;
+            }
+
+            bool isParent = component.size() == 2 && component[0] == CharT('.') && component[1] == CharT('.');
+            if (isParent)
+            {
+                if (out > floor)
+                {
+                    // Drop the last component and the separator in front of it
+                    size_t cut = out;
+                    while (cut > floor && buffer[cut - 1] != CharT('\\'))
+                    {
+                        --cut;
+                    }
+                    out = cut > floor ? cut - 1 : floor;
+                    --componentCount;
+                    continue;
+                }
+
+                if (rooted)
+                {
+                    // Already at the root: '..' goes nowhere
+                    continue;
+                }
+
+                // A relative path keeps leading '..' segments it cannot resolve
+            }
+
+            if (out > rootLength && !put(CharT('\\')))
+            {
+                return 0;
+            }
+
+            for (CharT c : component)
+            {
+                if (!put(c))
+                {
+                    return 0;
+                }
+            }
+            ++componentCount;
+
+            // Protect the drive ("C:") or the UNC server and share from '..'
+            if (componentCount == 1 && component.size() == 2 && component[1] == CharT(':'))
+            {
+                rooted = true;
+                protectedComponents = 1;
+                driveEnd = pos;
+            }
+
+            if (componentCount <= protectedComponents || (isParent && !rooted))
+            {
+                floor = out;
+            }
+        }
+
+        // Keep the separator of a bare drive root so "C:\" does not turn into "C:"
+        if (driveEnd != 0 && out == floor && path.size() > driveEnd)
+        {
+            if (!put(CharT('\\')))
+            {
+                return 0;
+            }
+        }
+
+        if (out >= capacity)
+        {
+            return 0;
+        }
+        buffer[out] = CharT(0);
+        return out;
+    }
+
+    template <typename CharT>
+    bool IsRelativePath(std::basic_string_view<CharT> path)
+    {
+        if (path.empty())
+        {
+            return false;
+        }
+
+        // UNC and device paths start with two separators
+        if (IsPathSeparator(path[0]))
+        {
+            return path.size() < 2 || !IsPathSeparator(path[1]);
+        }
+
+        // Anything with a drive ("C:\x", or drive-relative "C:x") is left alone
+        return path.size() < 2 || path[1] != CharT(':');
+    }
+
+    template <typename CharT>
+    size_t ResolveRelativePath(std::basic_string_view<CharT> path, std::basic_string_view<CharT> base,
+                               CharT *buffer, size_t capacity)
+    {
+        // "\foo" only takes the drive from the base directory; without one it is already rooted
+        if (!path.empty() && IsPathSeparator(path[0]))
+        {
+            if (base.size() < 2 || base[1] != CharT(':'))
+            {
+                return NormalizePath(path, buffer, capacity);
+            }
+            base = base.substr(0, 2);
+        }
+
+        if (base.empty())
+        {
+            return 0;
+        }
+
+        size_t joinedLength = base.size() + 1 + path.size();
+        if (joinedLength >= capacity)
+        {
+            return 0;
+        }
+
+        // Join into buffer, then canonicalize in place; extra separators collapse there
+        using Traits = std::char_traits<CharT>;
+        Traits::copy(buffer, base.data(), base.size());
+        buffer[base.size()] = CharT('\\');
+        Traits::copy(buffer + base.size() + 1, path.data(), path.size());
+
+        return NormalizePath(std::basic_string_view<CharT>(buffer, joinedLength), buffer, capacity);
+    }
+
+    template bool PathNeedsNormalization<char>(std::basic_string_view<char> path);
+    template bool PathNeedsNormalization<wchar_t>(std::basic_string_view<wchar_t> path);
+    template size_t NormalizePath<char>(std::basic_string_view<char> path, char *buffer, size_t capacity);
+    template size_t NormalizePath<wchar_t>(std::basic_string_view<wchar_t> path, wchar_t *buffer, size_t capacity);
+    template bool IsRelativePath<char>(std::basic_string_view<char> path);
+    template bool IsRelativePath<wchar_t>(std::basic_string_view<wchar_t> path);
+    template size_t ResolveRelativePath<char>(std::basic_string_view<char> path, std::basic_string_view<char> base,
+                                              char *buffer, size_t capacity);
+    template size_t ResolveRelativePath<wchar_t>(std::basic_string_view<wchar_t> path, std::basic_string_view<wchar_t> base,
+                                                 wchar_t *buffer, size_t capacity);
+
+} // namespace ObseGPCompat
@@ -0,0 +1,211 @@
+#include "PathPrefilter.h"
+#include "PathUtils.h"
+#include <algorithm>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define OBSE64GP_PREFILTER_SSE2 1
+#endif
+
+namespace ObseGPCompat
+{
+
+    namespace
+    {
+#ifdef OBSE64GP_PREFILTER_SSE2
+        inline __m128i FoldBytes(__m128i v)
+        {
+            __m128i isUpper = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('A' - 1)),
+                                            _mm_cmplt_epi8(v, _mm_set1_epi8('Z' + 1)));
+            v = _mm_or_si128(v, _mm_and_si128(isUpper, _mm_set1_epi8(0x20)));
+
+            __m128i isSlash = _mm_cmpeq_epi8(v, _mm_set1_epi8('/'));
+            return _mm_or_si128(_mm_andnot_si128(isSlash, v), _mm_and_si128(isSlash, _mm_set1_epi8('\\')));
+        }
+
+        inline __m128i FoldWords(__m128i v)
+        {
+            __m128i isUpper = _mm_and_si128(_mm_cmpgt_epi16(v, _mm_set1_epi16('A' - 1)),
+                                            _mm_cmplt_epi16(v, _mm_set1_epi16('Z' + 1)));
+            v = _mm_or_si128(v, _mm_and_si128(isUpper, _mm_set1_epi16(0x20)));
+
+            __m128i isSlash = _mm_cmpeq_epi16(v, _mm_set1_epi16('/'));
+            return _mm_or_si128(_mm_andnot_si128(isSlash, v), _mm_and_si128(isSlash, _mm_set1_epi16('\\')));
+        }
+#endif
+
+        // Folds case and turns '/' into '\\' across the whole head in place
+        template <typename CharT, size_t Length>
+        void FoldHead(CharT (&head)[Length])
+        {
+#ifdef OBSE64GP_PREFILTER_SSE2
+            if constexpr (sizeof(CharT) == 1 && Length == 16)
+            {
+                __m128i *lanes = reinterpret_cast<__m128i *>(head);
+                _mm_store_si128(lanes, FoldBytes(_mm_load_si128(lanes)));
+                return;
+            }
+            else if constexpr (sizeof(CharT) == 2 && Length == 16)
+            {
+                __m128i *lanes = reinterpret_cast<__m128i *>(head);
+                _mm_store_si128(lanes, FoldWords(_mm_load_si128(lanes)));
+                _mm_store_si128(lanes + 1, FoldWords(_mm_load_si128(lanes + 1)));
+                return;
+            }
+#endif
+            for (CharT &c : head)
+            {
+                c = FoldPathChar(c);
+                if (c == CharT('/'))
+                {
+                    c = CharT('\\');
+                }
+            }
+        }
+    }
+
+    template <typename CharT>
+    BasicPathPrefilter<CharT>::BasicPathPrefilter()
+    {
+        Clear();
+    }
+
+    template <typename CharT>
+    void BasicPathPrefilter<CharT>::Clear()
+    {
+        m_Anchors.clear();
+        m_MinLength = 0;
+    }
+
+    template <typename CharT>
+    void BasicPathPrefilter<CharT>::Build(const std::vector<StringView> &prefixes)
+    {
+        Clear();
+
+        std::vector<Anchor> anchors;
+        for (StringView prefix : prefixes)
+        {
+            Anchor anchor = {};
+            size_t length = 0;
+            bool lastWasSeparator = false;
+            for (CharT c : prefix)
+            {
+                if (length == AnchorLength)
+                {
+                    break;
+                }
+
+                // Anchors are stored in the same folded form MayMatch compares against
+                c = FoldPathChar(c);
+                if (IsPathSeparator(c))
+                {
+                    if (lastWasSeparator)
+                    {
+                        continue;
+                    }
+                    c = CharT('\\');
+                    lastWasSeparator = true;
+                }
+                else
+                {
+                    lastWasSeparator = false;
+                }
+
+                anchor.chars[length++] = c;
+            }
+
+            if (length == 0)
+            {
+                continue;
+            }
+
+            anchor.length = length;
+            anchor.mask = (1u << length) - 1;
+            anchors.push_back(anchor);
+        }
+
+        // Shorter anchors first, so any anchor already covered by a shorter one can be dropped
+        std::sort(anchors.begin(), anchors.end(),
+                  [](const Anchor &a, const Anchor &b)
+                  { return a.length < b.length; });
+
+        for (const Anchor &anchor : anchors)
+        {
+            bool covered = std::any_of(m_Anchors.begin(), m_Anchors.end(),
+                                       [&anchor](const Anchor &kept)
+                                       { return std::equal(kept.chars, kept.chars + kept.length, anchor.chars); });
+            if (!covered)
+            {
+                m_Anchors.push_back(anchor);
+            }
+        }
+
+        m_MinLength = m_Anchors.empty() ? 0 : m_Anchors.front().length;
+    }
+
+    template <typename CharT>
+    uint32_t BasicPathPrefilter<CharT>::CompareHead(const CharT *head, const Anchor &anchor) const
+    {
+#ifdef OBSE64GP_PREFILTER_SSE2
+        if constexpr (sizeof(CharT) == 1 && AnchorLength == 16)
+        {
+            __m128i equal = _mm_cmpeq_epi8(_mm_load_si128(reinterpret_cast<const __m128i *>(head)),
+                                           _mm_load_si128(reinterpret_cast<const __m128i *>(anchor.chars)));
+            return static_cast<uint32_t>(_mm_movemask_epi8(equal));
+        }
+        else if constexpr (sizeof(CharT) == 2 && AnchorLength == 16)
+        {
+            const __m128i *headLanes = reinterpret_cast<const __m128i *>(head);
+            const __m128i *anchorLanes = reinterpret_cast<const __m128i *>(anchor.chars);
+            __m128i low = _mm_cmpeq_epi16(_mm_load_si128(headLanes), _mm_load_si128(anchorLanes));
+            __m128i high = _mm_cmpeq_epi16(_mm_load_si128(headLanes + 1), _mm_load_si128(anchorLanes + 1));
+
+            // Narrow each 16-bit result to one byte so movemask yields one bit per character
+            return static_cast<uint32_t>(_mm_movemask_epi8(_mm_packs_epi16(low, high)));
+        }
+#endif
+        uint32_t equal = 0;
+        for (size_t i = 0; i < AnchorLength; ++i)
+        {
+            if (head[i] == anchor.chars[i])
+            {
+                equal |= 1u << i;
+            }
+        }
+        return equal;
+    }
+
+    template <typename CharT>
+    bool BasicPathPrefilter<CharT>::MayMatch(StringView path) const
+    {
+        // Lookups match past a \\?\ prefix, so the filter does too
+        if (HasLongPathPrefix(path))
+        {
+            path.remove_prefix(4);
+        }
+
+        if (m_Anchors.empty() || path.size() < m_MinLength)
+        {
+            return false;
+        }
+
+        // Lanes past the end of a short path stay zero and never equal an anchor character
+        alignas(16) CharT head[AnchorLength] = {};
+        std::copy_n(path.data(), std::min(path.size(), AnchorLength), head);
+        FoldHead(head);
+
+        for (const Anchor &anchor : m_Anchors)
+        {
+            if ((CompareHead(head, anchor) & anchor.mask) == anchor.mask)
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    template class BasicPathPrefilter<char>;
+    template class BasicPathPrefilter<wchar_t>;
+
+} // namespace ObseGPCompat
@@ -0,0 +1,281 @@
+#include "PathPrefixTable.h"
+#include <algorithm>
+
+namespace ObseGPCompat
+{
+
+    namespace
+    {
+        constexpr uint64_t HashSeed = 14695981039346656037ull;
+
+        template <typename CharT>
+        inline uint64_t HashStep(uint64_t hash, CharT c)
+        {
+            // FNV-1a, one code unit at a time so every prefix hash falls out of a single pass
+            hash ^= static_cast<uint64_t>(c);
+            return hash * 1099511628211ull;
+        }
+
+        // Calls onPrefix(hash, end) after each component of path, where hash covers the
+        // folded components so far joined by '\\' and end is the position just past the
+        // component. Stops early when onPrefix returns false.
+        template <typename CharT, typename PrefixFn>
+        void WalkPrefixes(std::basic_string_view<CharT> path, PrefixFn &&onPrefix)
+        {
+            uint64_t hash = HashSeed;
+            bool first = true;
+            size_t pos = 0;
+            while (true)
+            {
+                while (pos < path.size() && IsPathSeparator(path[pos]))
+                {
+                    ++pos;
+                }
+
+                if (pos >= path.size())
+                {
+                    return;
+                }
+
+                if (!first)
+                {
+                    hash = HashStep(hash, CharT('\\'));
+                }
+                first = false;
+
+                while (pos < path.size() && !IsPathSeparator(path[pos]))
+                {
+                    hash = HashStep(hash, FoldPathChar(path[pos]));
+                    ++pos;
+                }
+
+                if (!onPrefix(hash, pos))
+                {
+                    return;
+                }
+            }
+        }
+
+        // True when the components of path up to end spell out the folded key
+        template <typename CharT>
+        bool MatchesKey(std::basic_string_view<CharT> path, size_t end, std::basic_string_view<CharT> key)
+        {
+            size_t k = 0;
+            bool first = true;
+            size_t pos = 0;
+            while (pos < end)
+            {
+                while (pos < end && IsPathSeparator(path[pos]))
+                {
+                    ++pos;
+                }
+
+                if (pos >= end)
+                {
+                    break;
+                }
+
+                if (!first)
+                {
+                    if (k >= key.size() || key[k] != CharT('\\'))
+                    {
+                        return false;
+                    }
+                    ++k;
+                }
+                first = false;
+
+                while (pos < end && !IsPathSeparator(path[pos]))
+                {
+                    if (k >= key.size() || key[k] != FoldPathChar(path[pos]))
+                    {
+                        return false;
+                    }
+                    ++k;
+                    ++pos;
+                }
+            }
+
+            return k == key.size();
+        }
+    }
+
+    template <typename CharT>
+    BasicPathPrefixTable<CharT>::BasicPathPrefixTable()
+    {
+        Clear();
+    }
+
+    template <typename CharT>
+    void BasicPathPrefixTable<CharT>::Clear()
+    {
+        m_Slots.clear();
+        m_Keys.clear();
+        m_MaxKeyDepth = 0;
+    }
+
+    template <typename CharT>
+    uint32_t BasicPathPrefixTable<CharT>::FindSlot(uint64_t hash, StringView path, size_t end) const
+    {
+        if (m_Slots.empty())
+        {
+            return NoValue;
+        }
+
+        // Linear probing; the table is never more than half full, so runs stay short
+        size_t mask = m_Slots.size() - 1;
+        for (size_t index = hash & mask;; index = (index + 1) & mask)
+        {
+            const Slot &slot = m_Slots[index];
+            if (slot.key == NoValue)
+            {
+                return NoValue;
+            }
+
+            if (slot.hash == hash && MatchesKey(path, end, StringView(m_Keys[slot.key])))
+            {
+                return static_cast<uint32_t>(index);
+            }
+        }
+    }
+
+    template <typename CharT>
+    void BasicPathPrefixTable<CharT>::Grow()
+    {
+        std::vector<Slot> slots(std::max<size_t>(16, m_Slots.size() * 2), Slot{0, NoValue, 0});
+        size_t mask = slots.size() - 1;
+
+        for (const Slot &slot : m_Slots)
+        {
+            if (slot.key == NoValue)
+            {
+                continue;
+            }
+
+            size_t index = slot.hash & mask;
+            while (slots[index].key != NoValue)
+            {
+                index = (index + 1) & mask;
+            }
+            slots[index] = slot;
+        }
+
+        m_Slots.swap(slots);
+    }
+
+    template <typename CharT>
+    bool BasicPathPrefixTable<CharT>::Insert(StringView prefix, uint32_t value)
+    {
+        // Store the key in the same folded form lookups hash
+        String folded;
+        folded.reserve(prefix.size());
+        size_t depth = 0;
+        size_t pos = 0;
+        while (true)
+        {
+            while (pos < prefix.size() && IsPathSeparator(prefix[pos]))
+            {
+                ++pos;
+            }
+
+            if (pos >= prefix.size())
+            {
+                break;
+            }
+
+            if (depth > 0)
+            {
+                folded.push_back(CharT('\\'));
+            }
+
+            while (pos < prefix.size() && !IsPathSeparator(prefix[pos]))
+            {
+                folded.push_back(FoldPathChar(prefix[pos]));
+                ++pos;
+            }
+            ++depth;
+        }
+
+        if (depth == 0 || depth > MaxDepth)
+        {
+            return false;
+        }
+
+        uint64_t hash = HashSeed;
+        for (CharT c : folded)
+        {
+            hash = HashStep(hash, c);
+        }
+
+        // Re-inserting a prefix replaces its value
+        uint32_t existing = FindSlot(hash, StringView(folded), folded.size());
+        if (existing != NoValue)
+        {
+            m_Slots[existing].value = value;
+            return true;
+        }
+
+        if ((m_Keys.size() + 1) * 2 > m_Slots.size())
+        {
+            Grow();
+        }
+
+        size_t mask = m_Slots.size() - 1;
+        size_t index = hash & mask;
+        while (m_Slots[index].key != NoValue)
+        {
+            index = (index + 1) & mask;
+        }
+
+        m_Slots[index] = {hash, static_cast<uint32_t>(m_Keys.size()), value};
+        m_Keys.push_back(std::move(folded));
+        m_MaxKeyDepth = std::max(m_MaxKeyDepth, depth);
+        return true;
+    }
+
+    template <typename CharT>
+    uint32_t BasicPathPrefixTable<CharT>::FindLongest(StringView path, size_t *matchedLength) const
+    {
+        struct Prefix
+        {
+            uint64_t hash;
+            size_t end;
+        };
+
+        // Hash every ancestor no deeper than the deepest key in one pass
+        Prefix prefixes[MaxDepth];
+        size_t count = 0;
+        if (m_MaxKeyDepth > 0)
+        {
+            WalkPrefixes(path, [&](uint64_t hash, size_t end)
+                         {
+                             prefixes[count++] = {hash, end};
+                             return count < m_MaxKeyDepth;
+                         });
+        }
+
+        // Deepest ancestor first, so the first hit is the longest match
+        for (size_t i = count; i-- > 0;)
+        {
+            uint32_t slot = FindSlot(prefixes[i].hash, path, prefixes[i].end);
+            if (slot != NoValue)
+            {
+                if (matchedLength)
+                {
+                    *matchedLength = prefixes[i].end;
+                }
+                return m_Slots[slot].value;
+            }
+        }
+
+        if (matchedLength)
+        {
+            *matchedLength = 0;
+        }
+        return NoValue;
+    }
+
+    template class BasicPathPrefixTable<char>;
+    template class BasicPathPrefixTable<wchar_t>;
+
+} // namespace ObseGPCompat
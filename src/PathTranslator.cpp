@@ -1,162 +1,217 @@
 #include "PathTranslator.h"
 #include "ObseGPCompat.h"
-#include <shlobj.h>
-#include <Windows.h>
+#include "PathNormalizer.h"
+#include "TranslationCache.h"
+#include "WorkingDirectory.h"
 
 namespace ObseGPCompat
 {
 
+    namespace
+    {
+        // The form the lookups see: relative paths anchored at the cached working directory,
+        // anything else the normalizer would change normalized. Written into a buffer kept
+        // per thread, so nothing is allocated once it has grown; the view stays valid until
+        // the thread's next call. Empty when the path cannot be resolved.
+        template <typename CharT>
+        std::basic_string_view<CharT> Canonicalize(std::basic_string_view<CharT> path)
+        {
+            static thread_local std::basic_string<CharT> buffer;
+            size_t length;
+            if (IsRelativePath(path))
+            {
+                std::basic_string_view<CharT> workingDirectory = WorkingDirectory::Get<CharT>();
+                buffer.resize(workingDirectory.size() + path.size() + 2);
+                length = ResolveRelativePath(path, workingDirectory, buffer.data(), buffer.size());
+            }
+            else if (PathNeedsNormalization(path))
+            {
+                buffer.resize(path.size() + 1);
+                length = NormalizePath(path, buffer.data(), buffer.size());
+            }
+            else
+            {
+                return path;
+            }
+            return std::basic_string_view<CharT>(buffer.data(), length);
+        }
+    }
+
     PathTranslator::PathTranslator()
+        : m_Registry(nullptr)
     {
         // Constructor
     }
 
     PathTranslator::~PathTranslator()
     {
-        // Destructor
+        TranslationCacheStats stats = TranslationCache::GetStats();
+        Log(LogLevel::Info, "Translation cache: %llu hits, %llu misses",
+            static_cast<unsigned long long>(stats.hits), static_cast<unsigned long long>(stats.misses));
     }
 
     bool PathTranslator::Initialize()
     {
         Log(LogLevel::Info, "Initializing PathTranslator");
 
-        // Ensure paths are set
-        if (g_GamePassInstallPath.empty())
-        {
-            Log(LogLevel::Error, "Game Pass installation path is not set");
-            return false;
-        }
-
-        if (g_ObsePath.empty())
+        // The mappings themselves are compiled once by the shared registry
+        m_Registry = g_MappingRegistry.get();
+        if (!m_Registry)
         {
-            Log(LogLevel::Error, "OBSE installation path is not set");
+            Log(LogLevel::Error, "Mapping registry is not initialized");
             return false;
         }
 
-        // Build path mappings
-        BuildPathMappings();
-
         Log(LogLevel::Info, "PathTranslator initialized successfully");
         return true;
     }
 
-    void PathTranslator::BuildPathMappings()
+    std::filesystem::path PathTranslator::TranslateObsePath(const std::filesystem::path &path)
     {
-        Log(LogLevel::Info, "Building path mappings");
-
-        // Clear existing mappings
-        m_ObseToGamePaths.clear();
-        m_GameToObsePaths.clear();
-
-        // Game Pass path structure:
-        // C:\XboxGames\The Elder Scrolls IV- Oblivion Remastered\Content\OblivionRemastered\Binaries\WinGDK
-        // or
-        // C:\Program Files\ModifiableWindowsApps\The Elder Scrolls IV- Oblivion Remastered\Content\OblivionRemastered\Binaries\WinGDK
-        std::string gamePassBase = g_GamePassInstallPath.string();
-        std::string obsePathStr = g_ObsePath.string();
-        std::filesystem::path obsePath = g_ObsePath;
-
-        // Main executable directory
-        m_ObseToGamePaths[obsePathStr] =
-            gamePassBase + "\\Content\\OblivionRemastered\\Binaries\\WinGDK";
-        m_GameToObsePaths[gamePassBase + "\\Content\\OblivionRemastered\\Binaries\\WinGDK"] =
-            obsePathStr;
-
-        // Content directory
-        m_ObseToGamePaths[obsePathStr + "\\Content"] =
-            gamePassBase + "\\Content\\OblivionRemastered\\Content";
-        m_GameToObsePaths[gamePassBase + "\\Content\\OblivionRemastered\\Content"] =
-            obsePathStr + "\\Content";
-
-        // Data directory
-        m_ObseToGamePaths[obsePathStr + "\\Data"] =
-            gamePassBase + "\\Content\\OblivionRemastered\\Content\\Dev\\ObvData\\data";
-        m_GameToObsePaths[gamePassBase + "\\Content\\OblivionRemastered\\Content\\Dev\\ObvData\\data"] =
-            obsePathStr + "\\Data";
-
-        // OBSE64 directory for plugins
-        std::filesystem::path obsePluginsPath = obsePath / "OBSE" / "Plugins";
-        std::filesystem::path gamePluginsPath = g_GamePassInstallPath / "Content" / "OblivionRemastered" / "Binaries" / "Win64" / "OBSE" / "Plugins";
-
-        // Create the plugins directory if it doesn't exist
-        std::filesystem::create_directories(gamePluginsPath);
-
-        m_ObseToGamePaths[obsePluginsPath.string()] = gamePluginsPath.string();
-        m_GameToObsePaths[gamePluginsPath.string()] = obsePluginsPath.string();
-
-        // OBSE64 logs directory
-        char localAppData[MAX_PATH];
-        SHGetFolderPathA(NULL, CSIDL_LOCAL_APPDATA, NULL, 0, localAppData);
-
-        std::filesystem::path obseLogsPath = g_ObsePath / "OBSE" / "Logs";
-        std::filesystem::path gameLogsPath = std::filesystem::path(localAppData) / "My Games" / "Oblivion Remastered GP" / "OBSE" / "Logs";
-
-        // Create the logs directory
-        std::filesystem::create_directories(gameLogsPath);
-
-        m_ObseToGamePaths[obseLogsPath.string()] = gameLogsPath.string();
-        m_GameToObsePaths[gameLogsPath.string()] = obseLogsPath.string();
-
-        // Log the mappings
-        Log(LogLevel::Debug, "Path mappings created:");
-        for (const auto &mapping : m_ObseToGamePaths)
+        std::string pathStr = path.string();
+
+        std::string result;
+        if (!TryTranslate(pathStr, result))
         {
-            Log(LogLevel::Debug, "  OBSE -> Game Pass: '%s' -> '%s'",
-                mapping.first.c_str(), mapping.second.c_str());
+            // No mapping found, return original
+            return path;
         }
+
+        Log(LogLevel::Debug, "Translated OBSE path '%s' to Game Pass path '%s'",
+            pathStr.c_str(), result.c_str());
+        return std::filesystem::path(result);
     }
 
-    std::filesystem::path PathTranslator::TranslateObsePath(const std::filesystem::path &path)
+    bool PathTranslator::TryTranslate(std::string_view path, std::string &translatedPath) const
     {
-        std::string pathStr = path.string();
+        // Canonicalize variants the lookup cannot see through, anchoring relative paths at
+        // the working directory on the way; the per-thread buffer keeps misses off the heap
+        path = Canonicalize(path);
+        if (path.empty())
+        {
+            return false;
+        }
 
-        // Check each prefix mapping
-        for (const auto &mapping : m_ObseToGamePaths)
+        // Find the longest OBSE prefix covering this path; the reader keeps the
+        // snapshot (and the root copied below) alive until we are done
+        MappingRegistry::Reader mappings(*m_Registry);
+        size_t matchedLength = 0;
+        const std::string *gamePath = mappings->FindTarget(MappingDirection::ObseToGame, path, &matchedLength);
+        if (!gamePath)
         {
-            if (pathStr.find(mapping.first) == 0)
-            {
-                // Replace prefix
-                std::string result = mapping.second + pathStr.substr(mapping.first.length());
-                Log(LogLevel::Debug, "Translated OBSE path '%s' to Game Pass path '%s'",
-                    pathStr.c_str(), result.c_str());
-                return std::filesystem::path(result);
-            }
+            return false;
         }
 
-        // No mapping found, return original
-        return path;
+        // Replace prefix
+        std::string_view remainder = path.substr(matchedLength);
+        translatedPath.reserve(gamePath->size() + remainder.size());
+        translatedPath.assign(*gamePath);
+        translatedPath.append(remainder);
+        return true;
     }
 
-    bool PathTranslator::IsObsePath(const std::filesystem::path &path)
+    template <typename CharT>
+    bool PathTranslator::TranslateIntoBuffer(MappingDirection direction, std::basic_string_view<CharT> path,
+                                             CharT *buffer, size_t capacity, size_t *length) const
     {
-        std::string pathStr = path.string();
-
-        // Check if the path starts with any OBSE prefix
-        for (const auto &mapping : m_ObseToGamePaths)
+        // Canonicalize into the output buffer; the translation below then works in place.
+        // Relative paths are anchored at the cached working directory first.
+        if (IsRelativePath(path))
         {
-            if (pathStr.find(mapping.first) == 0)
+            size_t resolvedLength = ResolveRelativePath(path, WorkingDirectory::Get<CharT>(), buffer, capacity);
+            if (resolvedLength == 0)
             {
-                return true;
+                return false;
             }
+            path = std::basic_string_view<CharT>(buffer, resolvedLength);
+        }
+        else if (PathNeedsNormalization(path))
+        {
+            size_t normalizedLength = NormalizePath(path, buffer, capacity);
+            if (normalizedLength == 0)
+            {
+                return false;
+            }
+            path = std::basic_string_view<CharT>(buffer, normalizedLength);
         }
 
-        return false;
+        // Match past a \\?\ prefix and carry it over, so long paths stay long
+        std::basic_string_view<CharT> prefix;
+        if (HasLongPathPrefix(path))
+        {
+            prefix = path.substr(0, 4);
+            path.remove_prefix(4);
+        }
+
+        MappingRegistry::Reader mappings(*m_Registry);
+        size_t matchedLength = 0;
+        const std::basic_string<CharT> *target = mappings->FindTarget(direction, path, &matchedLength);
+        if (!target)
+        {
+            return false;
+        }
+
+        const std::basic_string<CharT> &root = *target;
+        std::basic_string_view<CharT> remainder = path.substr(matchedLength);
+
+        size_t total = prefix.size() + root.size() + remainder.size();
+        if (total >= capacity)
+        {
+            Log(LogLevel::Warning, "Translated path exceeds %zu characters, leaving it untranslated", capacity);
+            return false;
+        }
+
+        // The remainder (and prefix) may already sit in buffer, so move it into place first
+        using Traits = std::char_traits<CharT>;
+        Traits::move(buffer + prefix.size() + root.size(), remainder.data(), remainder.size());
+        Traits::move(buffer, prefix.data(), prefix.size());
+        Traits::copy(buffer + prefix.size(), root.data(), root.size());
+        buffer[total] = CharT(0);
+
+        if (length)
+        {
+            *length = total;
+        }
+        return true;
     }
 
-    bool PathTranslator::IsGamePath(const std::filesystem::path &path)
+    bool PathTranslator::TryTranslate(std::string_view path, char *buffer, size_t capacity, size_t *length) const
+    {
+        return TranslateIntoBuffer(MappingDirection::ObseToGame, path, buffer, capacity, length);
+    }
+
+    bool PathTranslator::TryTranslate(std::wstring_view path, wchar_t *buffer, size_t capacity, size_t *length) const
+    {
+        return TranslateIntoBuffer(MappingDirection::ObseToGame, path, buffer, capacity, length);
+    }
+
+    bool PathTranslator::MayTranslate(std::string_view path) const
+    {
+        // Judged by what TryTranslate will look up, not by the raw head of the path
+        path = Canonicalize(path);
+        return !path.empty() && MappingRegistry::Reader(*m_Registry)->MayMatchObsePath(path);
+    }
+
+    bool PathTranslator::MayTranslate(std::wstring_view path) const
     {
+        path = Canonicalize(path);
+        return !path.empty() && MappingRegistry::Reader(*m_Registry)->MayMatchObsePath(path);
+    }
+
+    bool PathTranslator::IsObsePath(const std::filesystem::path &path)
+    {
+        // Check if the path starts with any OBSE prefix
         std::string pathStr = path.string();
+        size_t matchedLength = 0;
+        return MappingRegistry::Reader(*m_Registry)->FindTarget(MappingDirection::ObseToGame, std::string_view(pathStr), &matchedLength) != nullptr;
+    }
 
+    bool PathTranslator::IsGamePath(const std::filesystem::path &path)
+    {
         // Check if the path starts with any Game Pass prefix
-        for (const auto &mapping : m_GameToObsePaths)
-        {
-            if (pathStr.find(mapping.first) == 0)
-            {
-                return true;
-            }
-        }
-
-        return false;
+        std::string pathStr = path.string();
+        size_t matchedLength = 0;
+        return MappingRegistry::Reader(*m_Registry)->FindTarget(MappingDirection::GameToObse, std::string_view(pathStr), &matchedLength) != nullptr;
     }
 
 } // namespace ObseGPCompat
\ No newline at end of file
@@ -0,0 +1,34 @@
+#include "Platform.h"
+
+namespace ObseGPCompat
+{
+
+    namespace Platform
+    {
+
+        const char *GetFileErrorName(FileError error)
+        {
+            switch (error)
+            {
+            case FileError::None:
+                return "no error";
+            case FileError::NotFound:
+                return "not found";
+            case FileError::PathNotFound:
+                return "path not found";
+            case FileError::AlreadyExists:
+                return "already exists";
+            case FileError::NotSameDevice:
+                return "not on the same device";
+            case FileError::TooManyLinks:
+                return "too many links";
+            case FileError::AccessDenied:
+                return "access denied";
+            default:
+                return "error";
+            }
+        }
+
+    }
+
+} // namespace ObseGPCompat
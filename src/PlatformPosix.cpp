@@ -0,0 +1,175 @@
+#include "Platform.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <fcntl.h>
+#include <pthread.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+namespace ObseGPCompat
+{
+
+    namespace Platform
+    {
+
+        std::filesystem::path GetKnownFolder(KnownFolder folder)
+        {
+            switch (folder)
+            {
+            case KnownFolder::LocalAppData:
+                if (const char *dataHome = std::getenv("XDG_DATA_HOME"); dataHome && *dataHome)
+                {
+                    return std::filesystem::path(dataHome);
+                }
+                if (const char *home = std::getenv("HOME"); home && *home)
+                {
+                    return std::filesystem::path(home) / ".local" / "share";
+                }
+                break;
+            }
+            return std::filesystem::path();
+        }
+
+        LocalTime GetLocalTime()
+        {
+            auto now = std::chrono::system_clock::now();
+            std::time_t seconds = std::chrono::system_clock::to_time_t(now);
+            std::tm local = {};
+            localtime_r(&seconds, &local);
+            auto milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count() % 1000;
+            return {local.tm_hour, local.tm_min, local.tm_sec, static_cast<int>(milliseconds)};
+        }
+
+        uint32_t GetCurrentThreadId()
+        {
+#ifdef __linux__
+            return static_cast<uint32_t>(syscall(SYS_gettid));
+#else
+            uint64_t id = 0;
+            pthread_threadid_np(nullptr, &id);
+            return static_cast<uint32_t>(id);
+#endif
+        }
+
+        FileError GetLastFileError()
+        {
+            switch (errno)
+            {
+            case 0:
+                return FileError::None;
+            case ENOENT:
+                return FileError::NotFound;
+            case ENOTDIR:
+                return FileError::PathNotFound;
+            case EEXIST:
+                return FileError::AlreadyExists;
+            case EXDEV:
+                return FileError::NotSameDevice;
+            case EMLINK:
+                return FileError::TooManyLinks;
+            case EACCES:
+            case EPERM:
+                return FileError::AccessDenied;
+            default:
+                return FileError::Other;
+            }
+        }
+
+        bool MakeDirectory(std::basic_string_view<char> path)
+        {
+            return mkdir(std::string(path).c_str(), 0777) == 0;
+        }
+
+        bool MakeDirectory(std::basic_string_view<wchar_t> path)
+        {
+            return mkdir(std::filesystem::path(std::wstring(path)).c_str(), 0777) == 0;
+        }
+
+        bool LinkFile(const std::filesystem::path &link, const std::filesystem::path &existing)
+        {
+            return ::link(existing.c_str(), link.c_str()) == 0;
+        }
+
+        bool SymlinkFile(const std::filesystem::path &link, const std::filesystem::path &target)
+        {
+            return ::symlink(target.c_str(), link.c_str()) == 0;
+        }
+
+        bool RenameFile(const std::filesystem::path &from, const std::filesystem::path &to, bool replaceExisting)
+        {
+            if (replaceExisting)
+            {
+                return ::rename(from.c_str(), to.c_str()) == 0;
+            }
+
+            // rename always replaces; linking fails on an existing name instead
+            if (::link(from.c_str(), to.c_str()) != 0)
+            {
+                return false;
+            }
+            ::unlink(from.c_str());
+            return true;
+        }
+
+        bool RemoveFile(const std::filesystem::path &path)
+        {
+            return ::unlink(path.c_str()) == 0;
+        }
+
+        bool SetReadOnly(const std::filesystem::path &path)
+        {
+            struct stat info = {};
+            return ::stat(path.c_str(), &info) == 0 && ::chmod(path.c_str(), info.st_mode & 07555) == 0;
+        }
+
+        bool MapFile(const std::filesystem::path &path, const void *&view, size_t &size)
+        {
+            int file = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (file < 0)
+            {
+                return false;
+            }
+
+            struct stat status = {};
+            if (fstat(file, &status) != 0 || !S_ISREG(status.st_mode) || status.st_size == 0)
+            {
+                ::close(file);
+                return false;
+            }
+
+            // The mapping keeps the file alive; the descriptor is not needed once it exists
+            void *mapped = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_SHARED, file, 0);
+            ::close(file);
+            if (mapped == MAP_FAILED)
+            {
+                return false;
+            }
+
+            view = mapped;
+            size = static_cast<size_t>(status.st_size);
+            return true;
+        }
+
+        void UnmapFile(const void *view, size_t size)
+        {
+            munmap(const_cast<void *>(view), size);
+        }
+
+        void PrefetchMemory(const void *address, size_t size)
+        {
+            // madvise wants a page-aligned start; mappings always are
+            madvise(const_cast<void *>(address), size, MADV_WILLNEED);
+        }
+
+    }
+
+} // namespace ObseGPCompat
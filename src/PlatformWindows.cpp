@@ -0,0 +1,236 @@
+#include "Platform.h"
+
+// Include our Windows wrapper first
+#include "WindowsWrapper.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace ObseGPCompat
+{
+
+    namespace Platform
+    {
+
+        namespace
+        {
+            // Windows 10 1809 can delete or replace a read-only name without clearing the
+            // attribute, which every hardlink to the file shares. The SDK only declares these
+            // for _WIN32_WINNT 0x0A00, above what this build targets.
+            constexpr FILE_INFO_BY_HANDLE_CLASS FileDispositionInfoExClass = static_cast<FILE_INFO_BY_HANDLE_CLASS>(21);
+            constexpr FILE_INFO_BY_HANDLE_CLASS FileRenameInfoExClass = static_cast<FILE_INFO_BY_HANDLE_CLASS>(22);
+            constexpr DWORD DispositionDelete = 0x1;
+            constexpr DWORD DispositionPosixSemantics = 0x2;
+            constexpr DWORD DispositionIgnoreReadOnly = 0x10;
+            constexpr DWORD RenameReplaceIfExists = 0x1;
+            constexpr DWORD RenamePosixSemantics = 0x2;
+            constexpr DWORD RenameIgnoreReadOnly = 0x40;
+
+            // FILE_RENAME_INFO with the flags that replace its ReplaceIfExists
+            struct RenameInfoEx
+            {
+                DWORD Flags;
+                HANDLE RootDirectory;
+                DWORD FileNameLength;
+                WCHAR FileName[1];
+            };
+
+            // Opened for DELETE only, sharing everything, so other readers are no obstacle
+            HANDLE OpenForDelete(const std::filesystem::path &path)
+            {
+                return CreateFileW(path.wstring().c_str(), DELETE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                   nullptr, OPEN_EXISTING, FILE_FLAG_OPEN_REPARSE_POINT, nullptr);
+            }
+
+            // Sets file information and closes the handle, keeping the call's error
+            bool SetInformationAndClose(HANDLE file, FILE_INFO_BY_HANDLE_CLASS type, void *information, DWORD size)
+            {
+                BOOL set = SetFileInformationByHandle(file, type, information, size);
+                DWORD error = GetLastError();
+                CloseHandle(file);
+                SetLastError(set ? ERROR_SUCCESS : error);
+                return set != FALSE;
+            }
+        }
+
+        std::filesystem::path GetKnownFolder(KnownFolder folder)
+        {
+            wchar_t path[MAX_PATH];
+            int csidl = CSIDL_LOCAL_APPDATA;
+            switch (folder)
+            {
+            case KnownFolder::LocalAppData:
+                csidl = CSIDL_LOCAL_APPDATA;
+                break;
+            }
+            if (SUCCEEDED(SHGetFolderPathW(NULL, csidl, NULL, 0, path)))
+            {
+                return std::filesystem::path(path);
+            }
+            return std::filesystem::path();
+        }
+
+        LocalTime GetLocalTime()
+        {
+            SYSTEMTIME st;
+            ::GetLocalTime(&st);
+            return {st.wHour, st.wMinute, st.wSecond, st.wMilliseconds};
+        }
+
+        uint32_t GetCurrentThreadId()
+        {
+            return ::GetCurrentThreadId();
+        }
+
+        FileError GetLastFileError()
+        {
+            switch (GetLastError())
+            {
+            case ERROR_SUCCESS:
+                return FileError::None;
+            case ERROR_FILE_NOT_FOUND:
+                return FileError::NotFound;
+            case ERROR_PATH_NOT_FOUND:
+                return FileError::PathNotFound;
+            case ERROR_ALREADY_EXISTS:
+            case ERROR_FILE_EXISTS:
+                return FileError::AlreadyExists;
+            case ERROR_NOT_SAME_DEVICE:
+                return FileError::NotSameDevice;
+            case ERROR_TOO_MANY_LINKS:
+                return FileError::TooManyLinks;
+            case ERROR_ACCESS_DENIED:
+                return FileError::AccessDenied;
+            default:
+                return FileError::Other;
+            }
+        }
+
+        bool MakeDirectory(std::basic_string_view<char> path)
+        {
+            return CreateDirectoryA(std::string(path).c_str(), nullptr) != FALSE;
+        }
+
+        bool MakeDirectory(std::basic_string_view<wchar_t> path)
+        {
+            return CreateDirectoryW(std::wstring(path).c_str(), nullptr) != FALSE;
+        }
+
+        bool LinkFile(const std::filesystem::path &link, const std::filesystem::path &existing)
+        {
+            return CreateHardLinkW(link.wstring().c_str(), existing.wstring().c_str(), nullptr) != FALSE;
+        }
+
+        bool SymlinkFile(const std::filesystem::path &link, const std::filesystem::path &target)
+        {
+            // Needs developer mode or the privilege
+            return CreateSymbolicLinkW(link.wstring().c_str(), target.wstring().c_str(), SYMBOLIC_LINK_FLAG_ALLOW_UNPRIVILEGED_CREATE) != FALSE;
+        }
+
+        bool RenameFile(const std::filesystem::path &from, const std::filesystem::path &to, bool replaceExisting)
+        {
+            if (MoveFileExW(from.wstring().c_str(), to.wstring().c_str(), replaceExisting ? MOVEFILE_REPLACE_EXISTING : 0))
+            {
+                return true;
+            }
+            if (!replaceExisting || GetLastError() != ERROR_ACCESS_DENIED)
+            {
+                return false;
+            }
+
+            // A read-only target, such as a link into the content store
+            HANDLE file = OpenForDelete(from);
+            if (file == INVALID_HANDLE_VALUE)
+            {
+                return false;
+            }
+            std::wstring name = to.wstring();
+            std::vector<uint8_t> buffer(sizeof(RenameInfoEx) + name.size() * sizeof(wchar_t));
+            RenameInfoEx *rename = reinterpret_cast<RenameInfoEx *>(buffer.data());
+            rename->Flags = RenameReplaceIfExists | RenamePosixSemantics | RenameIgnoreReadOnly;
+            rename->RootDirectory = nullptr;
+            rename->FileNameLength = static_cast<DWORD>(name.size() * sizeof(wchar_t));
+            std::copy(name.begin(), name.end(), rename->FileName);
+            return SetInformationAndClose(file, FileRenameInfoExClass, rename, static_cast<DWORD>(buffer.size()));
+        }
+
+        bool RemoveFile(const std::filesystem::path &path)
+        {
+            if (DeleteFileW(path.wstring().c_str()))
+            {
+                return true;
+            }
+            if (GetLastError() != ERROR_ACCESS_DENIED)
+            {
+                return false;
+            }
+
+            // A read-only file: remove this name and leave the attribute to the other links
+            HANDLE file = OpenForDelete(path);
+            if (file == INVALID_HANDLE_VALUE)
+            {
+                return false;
+            }
+            DWORD flags = DispositionDelete | DispositionPosixSemantics | DispositionIgnoreReadOnly;
+            return SetInformationAndClose(file, FileDispositionInfoExClass, &flags, sizeof(flags));
+        }
+
+        bool SetReadOnly(const std::filesystem::path &path)
+        {
+            DWORD attributes = GetFileAttributesW(path.wstring().c_str());
+            return attributes != INVALID_FILE_ATTRIBUTES &&
+                   SetFileAttributesW(path.wstring().c_str(), attributes | FILE_ATTRIBUTE_READONLY) != FALSE;
+        }
+
+        bool MapFile(const std::filesystem::path &path, const void *&view, size_t &size)
+        {
+            // Share everything, so a file another process is writing can still be mapped and
+            // this open never makes a writer fail; the view itself still blocks truncation
+            HANDLE file = CreateFileW(path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                      nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (file == INVALID_HANDLE_VALUE)
+            {
+                return false;
+            }
+
+            LARGE_INTEGER fileSize = {};
+            if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+            {
+                CloseHandle(file);
+                return false;
+            }
+
+            // The view keeps the mapping alive; neither handle is needed once it exists
+            HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            CloseHandle(file);
+            if (!mapping)
+            {
+                return false;
+            }
+
+            view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mapping);
+            if (!view)
+            {
+                return false;
+            }
+
+            size = static_cast<size_t>(fileSize.QuadPart);
+            return true;
+        }
+
+        void UnmapFile(const void *view, size_t size)
+        {
+            UnmapViewOfFile(view);
+        }
+
+        void PrefetchMemory(const void *address, size_t size)
+        {
+            WIN32_MEMORY_RANGE_ENTRY range = {const_cast<void *>(address), size};
+            PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+        }
+
+    }
+
+} // namespace ObseGPCompat
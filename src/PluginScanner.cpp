@@ -0,0 +1,415 @@
+#include "PluginScanner.h"
+#include "ObseGPCompat.h"
+#include "CacheFile.h"
+#include "MappedFile.h"
+#include "PathUtils.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <unordered_set>
+
+namespace ObseGPCompat
+{
+
+    namespace
+    {
+        constexpr uint16_t DosMagic = 0x5A4D;        // "MZ"
+        constexpr uint32_t PeSignature = 0x00004550; // "PE\0\0"
+        constexpr uint16_t OptionalMagicPe32 = 0x10B;
+        constexpr uint16_t OptionalMagicPe32Plus = 0x20B;
+        constexpr uint16_t CharacteristicDll = 0x2000;
+
+        constexpr uint32_t DirectoryExport = 0;
+        constexpr uint32_t DirectoryImport = 1;
+
+        // Corrupt counts must not turn into huge loops
+        constexpr uint32_t MaxNames = 65536;
+        constexpr size_t MaxNameLength = 1024;
+
+        constexpr uint32_t CacheMagic = 0x5350474F; // "OGPS"
+        constexpr uint32_t CacheVersion = 1;
+
+        struct Section
+        {
+            uint32_t virtualAddress;
+            uint32_t virtualSize;
+            uint32_t rawSize;
+            uint32_t rawOffset;
+        };
+
+        // Bounds-checked reads from a PE image laid out as on disk
+        class ImageReader
+        {
+        public:
+            ImageReader(const uint8_t *data, size_t size) : m_Data(data), m_Size(size) {}
+
+            template <typename T>
+            bool Read(size_t offset, T &value) const
+            {
+                if (offset > m_Size || m_Size - offset < sizeof(T))
+                {
+                    return false;
+                }
+                std::memcpy(&value, m_Data + offset, sizeof(T));
+                return true;
+            }
+
+            bool ReadString(size_t offset, std::string &value) const
+            {
+                if (offset >= m_Size)
+                {
+                    return false;
+                }
+                size_t available = std::min(m_Size - offset, MaxNameLength);
+                const void *end = std::memchr(m_Data + offset, 0, available);
+                if (!end)
+                {
+                    return false;
+                }
+                value.assign(reinterpret_cast<const char *>(m_Data + offset), static_cast<const uint8_t *>(end) - (m_Data + offset));
+                return true;
+            }
+
+            void AddSection(const Section &section) { m_Sections.push_back(section); }
+
+            // File offset of a relative virtual address
+            bool RvaToOffset(uint32_t rva, size_t &offset) const
+            {
+                for (const Section &section : m_Sections)
+                {
+                    uint32_t extent = std::max(section.virtualSize, section.rawSize);
+                    if (rva >= section.virtualAddress && rva - section.virtualAddress < extent)
+                    {
+                        uint32_t delta = rva - section.virtualAddress;
+                        if (delta >= section.rawSize)
+                        {
+                            return false; // Uninitialized data has no bytes on disk
+                        }
+                        offset = static_cast<size_t>(section.rawOffset) + delta;
+                        return offset < m_Size;
+                    }
+                }
+                return false;
+            }
+
+        private:
+            const uint8_t *m_Data;
+            size_t m_Size;
+            std::vector<Section> m_Sections;
+        };
+
+        bool IsDll(const std::filesystem::path &path)
+        {
+            std::string extension = path.extension().string();
+            std::transform(extension.begin(), extension.end(), extension.begin(), [](char c)
+                           { return FoldPathChar(c); });
+            return extension == ".dll";
+        }
+    }
+
+    bool PluginInfo::HasExport(std::string_view name) const
+    {
+        return std::find(exports.begin(), exports.end(), name) != exports.end();
+    }
+
+    PluginScanner::PluginScanner()
+        : m_CacheChanged(false),
+          m_Stats{}
+    {
+    }
+
+    bool PluginScanner::Parse(const uint8_t *data, size_t size, PluginInfo &info)
+    {
+        info.valid = false;
+        info.exports.clear();
+        info.imports.clear();
+
+        ImageReader reader(data, size);
+        uint16_t dosMagic = 0;
+        uint32_t peOffset = 0;
+        uint32_t signature = 0;
+        if (!reader.Read(0, dosMagic) || dosMagic != DosMagic || !reader.Read(0x3C, peOffset) ||
+            !reader.Read(peOffset, signature) || signature != PeSignature)
+        {
+            return false;
+        }
+
+        // COFF file header
+        size_t fileHeader = static_cast<size_t>(peOffset) + 4;
+        uint16_t sectionCount = 0;
+        uint16_t optionalHeaderSize = 0;
+        uint16_t characteristics = 0;
+        if (!reader.Read(fileHeader, info.machine) || !reader.Read(fileHeader + 2, sectionCount) ||
+            !reader.Read(fileHeader + 16, optionalHeaderSize) || !reader.Read(fileHeader + 18, characteristics))
+        {
+            return false;
+        }
+        info.isDll = (characteristics & CharacteristicDll) != 0;
+
+        // The data directories sit further into the 64-bit optional header
+        size_t optionalHeader = fileHeader + 20;
+        uint16_t optionalMagic = 0;
+        if (!reader.Read(optionalHeader, optionalMagic) ||
+            (optionalMagic != OptionalMagicPe32 && optionalMagic != OptionalMagicPe32Plus))
+        {
+            return false;
+        }
+        bool pe32Plus = optionalMagic == OptionalMagicPe32Plus;
+        size_t directoryCountOffset = optionalHeader + (pe32Plus ? 108 : 92);
+        size_t directories = optionalHeader + (pe32Plus ? 112 : 96);
+        uint32_t directoryCount = 0;
+        if (!reader.Read(directoryCountOffset, directoryCount))
+        {
+            return false;
+        }
+
+        size_t sectionTable = optionalHeader + optionalHeaderSize;
+        for (uint16_t i = 0; i < sectionCount; ++i)
+        {
+            size_t header = sectionTable + static_cast<size_t>(i) * 40;
+            Section section = {};
+            if (!reader.Read(header + 8, section.virtualSize) || !reader.Read(header + 12, section.virtualAddress) ||
+                !reader.Read(header + 16, section.rawSize) || !reader.Read(header + 20, section.rawOffset))
+            {
+                return false;
+            }
+            reader.AddSection(section);
+        }
+        info.valid = true;
+
+        // Exported names; damaged tables keep what was read before them
+        uint32_t exportRva = 0;
+        size_t exportDirectory = 0;
+        if (directoryCount > DirectoryExport && reader.Read(directories + DirectoryExport * 8, exportRva) && exportRva &&
+            reader.RvaToOffset(exportRva, exportDirectory))
+        {
+            uint32_t nameCount = 0;
+            uint32_t namesRva = 0;
+            size_t names = 0;
+            if (reader.Read(exportDirectory + 24, nameCount) && reader.Read(exportDirectory + 32, namesRva) &&
+                nameCount <= MaxNames && reader.RvaToOffset(namesRva, names))
+            {
+                for (uint32_t i = 0; i < nameCount; ++i)
+                {
+                    uint32_t nameRva = 0;
+                    size_t nameOffset = 0;
+                    std::string name;
+                    if (!reader.Read(names + static_cast<size_t>(i) * 4, nameRva) || !reader.RvaToOffset(nameRva, nameOffset) ||
+                        !reader.ReadString(nameOffset, name))
+                    {
+                        break;
+                    }
+                    info.exports.push_back(std::move(name));
+                }
+            }
+        }
+
+        // Imported modules; the descriptor table ends with an empty entry
+        uint32_t importRva = 0;
+        size_t importDirectory = 0;
+        if (directoryCount > DirectoryImport && reader.Read(directories + DirectoryImport * 8, importRva) && importRva &&
+            reader.RvaToOffset(importRva, importDirectory))
+        {
+            for (uint32_t i = 0; i < MaxNames; ++i)
+            {
+                size_t descriptor = importDirectory + static_cast<size_t>(i) * 20;
+                uint32_t nameRva = 0;
+                size_t nameOffset = 0;
+                std::string name;
+                if (!reader.Read(descriptor + 12, nameRva) || nameRva == 0 || !reader.RvaToOffset(nameRva, nameOffset) ||
+                    !reader.ReadString(nameOffset, name))
+                {
+                    break;
+                }
+                info.imports.push_back(std::move(name));
+            }
+        }
+
+        return true;
+    }
+
+    PluginInfo PluginScanner::ScanFile(const std::filesystem::path &file, uint64_t size, int64_t lastWriteTime)
+    {
+        // Read ahead even when the headers are cached: the loader is about to need the pages
+        MappedFile view;
+        bool mapped = view.Open(file);
+        if (mapped)
+        {
+            view.Prefetch();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            auto it = m_Cache.find(file.native());
+            if (it != m_Cache.end() && it->second.size == size && it->second.lastWriteTime == lastWriteTime)
+            {
+                ++m_Stats.cached;
+                return it->second;
+            }
+        }
+
+        PluginInfo info = {};
+        info.path = file;
+        info.size = size;
+        info.lastWriteTime = lastWriteTime;
+        if (mapped)
+        {
+            Parse(view.Data(), view.Size(), info);
+        }
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Cache[file.native()] = info;
+        m_CacheChanged = true;
+        ++m_Stats.parsed;
+        return info;
+    }
+
+    std::vector<PluginInfo> PluginScanner::Scan(const std::filesystem::path &directory, WorkerPool &pool)
+    {
+        struct Candidate
+        {
+            std::filesystem::path path;
+            uint64_t size;
+            int64_t lastWriteTime;
+        };
+
+        std::vector<Candidate> candidates;
+        std::error_code ec;
+        for (std::filesystem::directory_iterator it(directory, ec), end; !ec && it != end; it.increment(ec))
+        {
+            std::error_code entryError;
+            if (!IsDll(it->path()) || !it->is_regular_file(entryError))
+            {
+                continue;
+            }
+            uint64_t size = it->file_size(entryError);
+            int64_t lastWriteTime = it->last_write_time(entryError).time_since_epoch().count();
+            candidates.push_back({it->path(), entryError ? 0 : size, entryError ? 0 : lastWriteTime});
+        }
+        std::sort(candidates.begin(), candidates.end(), [](const Candidate &a, const Candidate &b)
+                  { return a.path < b.path; });
+
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Stats = {candidates.size(), 0, 0};
+        }
+
+        // One task per DLL; the caller waits for all of them
+        std::vector<PluginInfo> results(candidates.size());
+        std::mutex doneMutex;
+        std::condition_variable done;
+        size_t remaining = candidates.size();
+        for (size_t i = 0; i < candidates.size(); ++i)
+        {
+            pool.Submit([this, &candidates, &results, &doneMutex, &done, &remaining, i]()
+                        {
+                            results[i] = ScanFile(candidates[i].path, candidates[i].size, candidates[i].lastWriteTime);
+
+                            // Notify under the lock; the waiter's locals go away as soon as it wakes
+                            std::lock_guard<std::mutex> lock(doneMutex);
+                            --remaining;
+                            done.notify_one();
+                        });
+        }
+        {
+            std::unique_lock<std::mutex> lock(doneMutex);
+            done.wait(lock, [&remaining]()
+                      { return remaining == 0; });
+        }
+
+        // Forget plugins that have left the directory
+        std::unordered_set<std::filesystem::path::string_type> present;
+        for (const Candidate &candidate : candidates)
+        {
+            present.insert(candidate.path.native());
+        }
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        for (auto it = m_Cache.begin(); it != m_Cache.end();)
+        {
+            if (it->second.path.parent_path() == directory && !present.count(it->first))
+            {
+                it = m_Cache.erase(it);
+                m_CacheChanged = true;
+            }
+            else
+            {
+                ++it;
+            }
+        }
+
+        return results;
+    }
+
+    bool PluginScanner::LoadCache(const std::filesystem::path &cachePath)
+    {
+        CacheReader reader;
+        if (!reader.Open(cachePath))
+        {
+            return false;
+        }
+
+        uint32_t magic = 0;
+        uint32_t version = 0;
+        uint32_t count = 0;
+        if (!reader.Read(magic) || magic != CacheMagic || !reader.Read(version) || version != CacheVersion ||
+            !reader.Read(count))
+        {
+            Log(LogLevel::Warning, "Ignoring plugin cache in an unknown format: %s", cachePath.string().c_str());
+            return false;
+        }
+
+        std::unordered_map<std::filesystem::path::string_type, PluginInfo> cache;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            PluginInfo info = {};
+            std::string path;
+            uint8_t valid = 0;
+            uint8_t isDll = 0;
+            if (!reader.Read(path) || !reader.Read(info.size) || !reader.Read(info.lastWriteTime) ||
+                !reader.Read(valid) || !reader.Read(isDll) || !reader.Read(info.machine) ||
+                !reader.Read(info.exports) || !reader.Read(info.imports))
+            {
+                Log(LogLevel::Warning, "Ignoring truncated plugin cache: %s", cachePath.string().c_str());
+                return false;
+            }
+            info.path = std::filesystem::u8path(path);
+            info.valid = valid != 0;
+            info.isDll = isDll != 0;
+            cache[info.path.native()] = std::move(info);
+        }
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Cache = std::move(cache);
+        m_CacheChanged = false;
+        return true;
+    }
+
+    bool PluginScanner::SaveCache(const std::filesystem::path &cachePath) const
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (!m_CacheChanged)
+        {
+            return true;
+        }
+
+        CacheWriter writer(cachePath);
+        writer.Write(CacheMagic);
+        writer.Write(CacheVersion);
+        writer.Write(static_cast<uint32_t>(m_Cache.size()));
+        for (const auto &entry : m_Cache)
+        {
+            const PluginInfo &info = entry.second;
+            writer.Write(info.path.u8string());
+            writer.Write(info.size);
+            writer.Write(info.lastWriteTime);
+            writer.Write(static_cast<uint8_t>(info.valid));
+            writer.Write(static_cast<uint8_t>(info.isDll));
+            writer.Write(info.machine);
+            writer.Write(info.exports);
+            writer.Write(info.imports);
+        }
+        return writer.Commit();
+    }
+
+} // namespace ObseGPCompat
@@ -1,7 +1,11 @@
 #include "ProxyLauncher.h"
 #include "ObseGPCompat.h"
+#include "ConfigurationManager.h"
+#include "LinkDeployer.h"
+#include "MappingRegistry.h"
 #include <Windows.h>
 #include <shlobj.h>
+#include <chrono>
 #include <iostream>
 
 namespace ObseGPCompat
@@ -163,6 +167,15 @@ namespace ObseGPCompat
             return false;
         }
 
+        // In deploy mode the mappings are linked on disk before the game starts, and the
+        // layer inside the game leaves the file APIs unhooked
+        bool deployMode = g_ConfigurationManager && g_ConfigurationManager->GetBool("Settings", "DeployMode", false);
+        if (!DeployLinks(deployMode))
+        {
+            Log(LogLevel::Error, "Failed to deploy the path mappings");
+            return false;
+        }
+
         // Launch the process suspended
         if (!LaunchProcessSuspended(exePath, ""))
         {
@@ -190,6 +203,65 @@ namespace ObseGPCompat
         return true;
     }
 
+    bool ProxyLauncher::DeployLinks(bool deploy)
+    {
+        std::filesystem::path localAppData = GetLocalAppDataPath();
+        if (localAppData.empty())
+        {
+            // Without a manifest there is nothing to undo, and nothing to deploy incrementally
+            return !deploy;
+        }
+        std::filesystem::path manifestPath = localAppData / "OBSE64GP" / "DeployManifest.bin";
+
+        LinkDeployer deployer;
+        bool deployedBefore = deployer.LoadManifest(manifestPath);
+        if (!deploy && !deployedBefore)
+        {
+            return true;
+        }
+
+        // Hooked launches must not find the links of an earlier deployment
+        std::vector<DeployEntry> planned;
+        if (deploy)
+        {
+            MappingRegistry localRegistry;
+            const MappingRegistry *registry = g_MappingRegistry.get();
+            if (!registry)
+            {
+                if (!localRegistry.Initialize())
+                {
+                    return false;
+                }
+                registry = &localRegistry;
+            }
+            planned = deployer.Plan(*MappingRegistry::Reader(*registry));
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        DeployStats stats = deployer.Apply(std::move(planned));
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+        Log(LogLevel::Info, "%s %zu files in %lld ms: %zu added, %zu updated, %zu removed, %zu unchanged, %zu conflicts, %zu failed",
+            deploy ? "Deployed" : "Undeployed", deployer.GetDeployed().size(), static_cast<long long>(elapsed.count()),
+            stats.added, stats.updated, stats.removed, stats.unchanged, stats.conflicts, stats.failed);
+
+        std::error_code ec;
+        if (deployer.GetDeployed().empty())
+        {
+            std::filesystem::remove(manifestPath, ec);
+        }
+        else
+        {
+            std::filesystem::create_directories(manifestPath.parent_path(), ec);
+            if (!deployer.SaveManifest(manifestPath))
+            {
+                Log(LogLevel::Warning, "Failed to save deployment manifest: %s", manifestPath.string().c_str());
+            }
+        }
+
+        // Undeploy failures only leave stale links behind; missing links break the game
+        return !deploy || stats.failed == 0;
+    }
+
     bool ProxyLauncher::LaunchProcessSuspended(const std::filesystem::path &executablePath, const std::string &commandLine)
     {
         Log(LogLevel::Info, "Launching process suspended: %s", executablePath.string().c_str());
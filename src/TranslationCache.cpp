@@ -0,0 +1,26 @@
+#include "TranslationCache.h"
+
+namespace ObseGPCompat
+{
+
+    std::atomic<uint64_t> TranslationCache::s_Generation{1};
+    std::atomic<uint64_t> TranslationCache::s_Hits{0};
+    std::atomic<uint64_t> TranslationCache::s_Misses{0};
+
+    void TranslationCache::Invalidate()
+    {
+        s_Generation.fetch_add(1, std::memory_order_acq_rel);
+    }
+
+    TranslationCacheStats TranslationCache::GetStats()
+    {
+        return {s_Hits.load(std::memory_order_relaxed), s_Misses.load(std::memory_order_relaxed)};
+    }
+
+    void TranslationCache::ResetStats()
+    {
+        s_Hits.store(0, std::memory_order_relaxed);
+        s_Misses.store(0, std::memory_order_relaxed);
+    }
+
+} // namespace ObseGPCompat
@@ -1,125 +1,648 @@
 #include "VirtualFileSystem.h"
 #include "ObseGPCompat.h"
+#include "ConfigurationManager.h"
+#include "DirectoryMaterializer.h"
+#include "PathUtils.h"
+#include "Platform.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <numeric>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace ObseGPCompat
 {
 
+    namespace
+    {
+        // Archive mounts compare real paths folded, '\\'-separated, without trailing separators
+        std::string FoldArchivePath(const std::filesystem::path &path)
+        {
+            std::string folded = path.string();
+            while (!folded.empty() && IsPathSeparator(folded.back()))
+            {
+                folded.pop_back();
+            }
+            for (char &c : folded)
+            {
+                c = IsPathSeparator(c) ? '\\' : FoldPathChar(c);
+            }
+            return folded;
+        }
+
+        // Part of folded below root, if it is root or inside it
+        bool RelativeToRoot(const std::string &folded, const std::string &root, std::string_view &relative)
+        {
+            if (folded.compare(0, root.size(), root) != 0 ||
+                (folded.size() > root.size() && folded[root.size()] != '\\'))
+            {
+                return false;
+            }
+            relative = std::string_view(folded).substr(std::min(folded.size(), root.size() + 1));
+            return true;
+        }
+
+        using PathKey = std::filesystem::path::string_type;
+
+        // Change notifications and cache keys spell paths differently; both are compared folded
+        PathKey FoldKey(const std::filesystem::path &path)
+        {
+            return FoldPath(std::basic_string_view<PathKey::value_type>(path.native()));
+        }
+
+        // Whether key is root or below it, both folded
+        bool IsWithin(const PathKey &key, const PathKey &root)
+        {
+            return key.compare(0, root.size(), root) == 0 &&
+                   (key.size() == root.size() || key[root.size()] == PathKey::value_type('\\'));
+        }
+
+        bool HasExtension(const std::filesystem::path &path, const char *extension)
+        {
+            std::string folded = path.extension().string();
+            std::transform(folded.begin(), folded.end(), folded.begin(), [](char c)
+                           { return FoldPathChar(c); });
+            return folded == extension;
+        }
+    }
+
     VirtualFileSystem::VirtualFileSystem()
+        : m_Registry(nullptr)
     {
         // Constructor - no initialization needed here
     }
 
     VirtualFileSystem::~VirtualFileSystem()
     {
-        // Destructor - no cleanup needed
+        m_Watcher.Stop();
+        if (m_Watcher.RootCount() > 0)
+        {
+            DirectoryWatcherStats watched = m_Watcher.GetStats();
+            Log(LogLevel::Info, "Directory watcher: %llu notifications, %llu changes applied in %llu batches, %llu overflows",
+                static_cast<unsigned long long>(watched.notifications), static_cast<unsigned long long>(watched.dispatched),
+                static_cast<unsigned long long>(watched.batches), static_cast<unsigned long long>(watched.overflows));
+        }
+
+        MetadataCacheStats stats = m_MetadataCache.GetStats();
+        uint64_t lookups = stats.hits + stats.misses;
+        Log(LogLevel::Info, "Metadata cache: %llu hits (%llu negative), %llu misses, %llu expired, %llu invalidated, %llu evicted; %.1f%% of filesystem queries saved",
+            static_cast<unsigned long long>(stats.hits), static_cast<unsigned long long>(stats.negativeHits),
+            static_cast<unsigned long long>(stats.misses), static_cast<unsigned long long>(stats.expirations),
+            static_cast<unsigned long long>(stats.invalidations), static_cast<unsigned long long>(stats.evictions),
+            lookups ? 100.0 * static_cast<double>(stats.hits) / static_cast<double>(lookups) : 0.0);
+
+        FileViewCacheStats views = m_ViewCache.GetStats();
+        Log(LogLevel::Info, "File views: %llu hits, %llu misses, %llu evictions",
+            static_cast<unsigned long long>(views.hits), static_cast<unsigned long long>(views.misses),
+            static_cast<unsigned long long>(views.evictions));
+
+        if (m_ContentStore.IsInitialized())
+        {
+            ContentStoreStats store = m_ContentStore.GetStats();
+            Log(LogLevel::Info, "Content store: %llu stored, %llu deduplicated (%.1f MB saved), %llu links",
+                static_cast<unsigned long long>(store.stored), static_cast<unsigned long long>(store.deduplicated),
+                static_cast<double>(store.bytesSaved) / (1024.0 * 1024.0), static_cast<unsigned long long>(store.links));
+        }
     }
 
     bool VirtualFileSystem::Initialize()
     {
         Log(LogLevel::Info, "Initializing VirtualFileSystem");
 
-        // Clear existing mappings
-        m_VirtualToRealPaths.clear();
-        m_RealToVirtualPaths.clear();
+        // Virtual paths are the OBSE side of the shared mappings, real paths the Game Pass side
+        m_Registry = g_MappingRegistry.get();
+        if (!m_Registry)
+        {
+            Log(LogLevel::Error, "Mapping registry is not initialized");
+            return false;
+        }
 
-        // Add mappings based on OBSE and Game Pass paths
+        // Metadata is cached until the VFS changes it; an optional TTL also covers outside changes
+        if (g_ConfigurationManager)
+        {
+            int ttl = g_ConfigurationManager->GetInt("Settings", "MetadataCacheTTLMs", 0);
+            m_MetadataCache.SetTimeToLive(std::chrono::milliseconds(ttl > 0 ? ttl : 0));
+        }
 
-        // Map plugins directory
-        std::filesystem::path obsePluginsPath = g_ObsePath / "OBSE" / "Plugins";
-        std::filesystem::path gamePluginsPath = g_GamePassInstallPath / "Content" / "OblivionRemastered" / "Binaries" / "WinGDK" / "OBSE" / "Plugins";
+        if (!g_ConfigurationManager || g_ConfigurationManager->GetBool("Settings", "MountArchives", true))
+        {
+            MountDataArchives();
+        }
 
-        MapPath(obsePluginsPath, gamePluginsPath);
+        if (!g_ConfigurationManager || g_ConfigurationManager->GetBool("Settings", "EnableDirectoryIndex", true))
+        {
+            BuildDirectoryIndex();
+        }
 
-        // Also map directly to OBSE directory for loader to find plugins
-        std::filesystem::path obseDirPath = g_ObsePath / "OBSE";
-        std::filesystem::path gameDirPath = g_GamePassInstallPath / "Content" / "OblivionRemastered" / "Binaries" / "WinGDK" / "OBSE";
+        // Hardlinks only work within a volume, so the store defaults to the game's
+        std::filesystem::path storeRoot;
+        if (g_ConfigurationManager)
+        {
+            storeRoot = g_ConfigurationManager->GetString("Paths", "ContentStore", "");
+        }
+        if (storeRoot.empty() && !g_GamePassInstallPath.empty())
+        {
+            storeRoot = g_GamePassInstallPath / "OBSE64GP" / "Store";
+        }
+        if (!storeRoot.empty())
+        {
+            m_ContentStore.Initialize(storeRoot);
+        }
 
-        MapPath(obseDirPath, gameDirPath);
+        // Batches run on a bounded pool; 0 picks one thread per core, up to 8
+        int workerThreads = g_ConfigurationManager ? g_ConfigurationManager->GetInt("Settings", "BatchWorkerThreads", 0) : 0;
+        if (workerThreads <= 0)
+        {
+            workerThreads = static_cast<int>(std::min(std::max(std::thread::hardware_concurrency(), 1u), 8u));
+        }
+        m_WorkerPool = std::make_unique<WorkerPool>(static_cast<size_t>(workerThreads));
 
-        // Map data directory
-        std::filesystem::path obseDataPath = g_ObsePath / "Data";
-        std::filesystem::path gameDataPath = g_GamePassInstallPath / "Content" / "OblivionRemastered" / "Content" / "Dev" / "ObvData" / "data";
+        // Before OBSE gets to the plugins, so their pages are already in memory
+        if (!g_ConfigurationManager || g_ConfigurationManager->GetBool("Settings", "ScanPlugins", true))
+        {
+            ScanPlugins();
+        }
 
-        MapPath(obseDataPath, gameDataPath);
+        if (!g_ConfigurationManager || g_ConfigurationManager->GetBool("Settings", "CheckLoadOrder", true))
+        {
+            ScanModFiles();
+        }
 
-        // Map logs directory
-        char localAppData[MAX_PATH];
-        if (SUCCEEDED(SHGetFolderPathA(NULL, CSIDL_LOCAL_APPDATA, NULL, 0, localAppData)))
+        // Last, so the handler never sees the structures above half-built
+        if (!g_ConfigurationManager || g_ConfigurationManager->GetBool("Settings", "WatchDirectories", true))
         {
-            std::filesystem::path obseLogsPath = g_ObsePath / "OBSE" / "Logs";
-            std::filesystem::path gameLogsPath = std::filesystem::path(localAppData) / "My Games" / "Oblivion Remastered GP" / "OBSE" / "Logs";
+            StartWatching();
+        }
+
+        Log(LogLevel::Info, "VirtualFileSystem initialized successfully");
+        Log(LogLevel::Info, "Using %zu virtual path mappings", MappingRegistry::Reader(*m_Registry)->GetMappings().size());
+        return true;
+    }
 
-            MapPath(obseLogsPath, gameLogsPath);
+    std::vector<std::filesystem::path> VirtualFileSystem::GetRealRoots() const
+    {
+        // Every real root the mappings and overlays point into
+        std::vector<std::filesystem::path> roots;
+        MappingRegistry::Reader mappings(*m_Registry);
+        for (const PathMapping &mapping : mappings->GetMappings())
+        {
+            roots.emplace_back(mapping.gamePathW);
+        }
+        for (const OverlayMount &overlay : mappings->GetOverlays())
+        {
+            for (size_t i = 0; i < overlay.index->LayerCount(); ++i)
+            {
+                roots.push_back(overlay.index->GetLayer(i).root);
+            }
         }
+        return roots;
+    }
 
-        // Ensure all mapped directories exist
-        for (const auto &mapping : m_VirtualToRealPaths)
+    void VirtualFileSystem::BuildDirectoryIndex()
+    {
+        // Nested roots are folded in by the index
+        std::vector<std::filesystem::path> roots = GetRealRoots();
+
+        // Kept next to the logs; without a place to keep it the index is rebuilt every start
+        std::filesystem::path snapshotPath;
+        std::filesystem::path localAppData = GetLocalAppDataPath();
+        if (!localAppData.empty())
         {
-            std::filesystem::path realPath(mapping.second);
-            if (!std::filesystem::exists(realPath))
+            std::error_code ec;
+            std::filesystem::create_directories(localAppData / "OBSE64GP", ec);
+            snapshotPath = localAppData / "OBSE64GP" / "DirectoryIndex.bin";
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        m_DirectoryIndex.Build(roots, snapshotPath);
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+
+        const DirectoryIndexStats &stats = m_DirectoryIndex.GetStats();
+        Log(LogLevel::Info, "Directory index: %zu directories, %zu files, %zu directories rescanned, snapshot %s, built in %lld ms",
+            stats.directories, stats.files, stats.rescannedDirectories,
+            stats.snapshotReused ? "reused" : "rewritten", static_cast<long long>(elapsed.count()));
+    }
+
+    void VirtualFileSystem::MountDataArchives()
+    {
+        // Every archive in Data; the game decides which ones it loads, existence is all we answer
+        std::filesystem::path dataPath = g_ObsePath / "Data";
+        std::filesystem::path realDataPath = TranslateToReal(dataPath);
+
+        auto start = std::chrono::steady_clock::now();
+        size_t mounted = 0;
+        std::error_code ec;
+        for (std::filesystem::directory_iterator it(realDataPath, ec), end; !ec && it != end; it.increment(ec))
+        {
+            if (HasExtension(it->path(), ".bsa") && MountArchive(dataPath, it->path()))
             {
-                std::filesystem::create_directories(realPath);
-                Log(LogLevel::Info, "Created directory: %s", realPath.string().c_str());
+                ++mounted;
             }
         }
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
 
-        Log(LogLevel::Info, "VirtualFileSystem initialized successfully");
-        Log(LogLevel::Info, "Created %d virtual path mappings", m_VirtualToRealPaths.size());
-        return true;
+        Log(LogLevel::Info, "Mounted %zu archives from %s in %lld ms", mounted, realDataPath.string().c_str(),
+            static_cast<long long>(elapsed.count()));
     }
 
-    bool VirtualFileSystem::MapPath(const std::filesystem::path &virtualPath, const std::filesystem::path &realPath)
+    bool VirtualFileSystem::MountArchive(const std::filesystem::path &virtualDirectory, const std::filesystem::path &archivePath)
     {
-        Log(LogLevel::Info, "Mapping path: %s -> %s",
-            virtualPath.string().c_str(), realPath.string().c_str());
+        auto archive = std::make_shared<BsaArchive>();
+        if (!archive->Open(archivePath))
+        {
+            return false;
+        }
 
-        // Add mappings in both directions
-        m_VirtualToRealPaths[virtualPath.string()] = realPath.string();
-        m_RealToVirtualPaths[realPath.string()] = virtualPath.string();
+        Log(LogLevel::Info, "Mounted archive %s at %s (%zu files, %zu folders)", archivePath.string().c_str(),
+            virtualDirectory.string().c_str(), archive->FileCount(), archive->FolderCount());
 
+        std::unique_lock<std::shared_mutex> lock(m_ArchiveMutex);
+        m_Archives.push_back({FoldArchivePath(TranslateToReal(virtualDirectory)), FoldArchivePath(archivePath), std::move(archive)});
         return true;
     }
 
-    std::filesystem::path VirtualFileSystem::TranslateToReal(const std::filesystem::path &virtualPath)
+    void VirtualFileSystem::RemountArchive(const std::filesystem::path &virtualDirectory, const std::filesystem::path &archivePath)
     {
-        std::string pathStr = virtualPath.string();
+        std::string folded = FoldArchivePath(archivePath);
+        {
+            std::unique_lock<std::shared_mutex> lock(m_ArchiveMutex);
+            m_Archives.erase(std::remove_if(m_Archives.begin(), m_Archives.end(), [&folded](const ArchiveMount &mount)
+                                            { return mount.path == folded; }),
+                             m_Archives.end());
+        }
 
-        // Check each prefix mapping
-        for (const auto &mapping : m_VirtualToRealPaths)
+        std::error_code ec;
+        if (std::filesystem::is_regular_file(archivePath, ec))
+        {
+            MountArchive(virtualDirectory, archivePath);
+        }
+        else
+        {
+            Log(LogLevel::Info, "Unmounted archive %s", archivePath.string().c_str());
+        }
+    }
+
+    bool VirtualFileSystem::IsInArchive(const std::filesystem::path &realPath)
+    {
+        std::shared_lock<std::shared_mutex> lock(m_ArchiveMutex);
+        if (m_Archives.empty())
         {
-            if (pathStr.find(mapping.first) == 0)
+            return false;
+        }
+
+        std::string folded = FoldArchivePath(realPath);
+        for (const ArchiveMount &mount : m_Archives)
+        {
+            std::string_view relative;
+            if (RelativeToRoot(folded, mount.root, relative) &&
+                (mount.archive->FindFile(relative) || mount.archive->FindFolder(relative)))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void VirtualFileSystem::ScanPlugins()
+    {
+        std::filesystem::path pluginsPath = TranslateToReal(g_ObsePath / "OBSE" / "Plugins");
+
+        std::filesystem::path cachePath;
+        std::filesystem::path localAppData = GetLocalAppDataPath();
+        if (!localAppData.empty())
+        {
+            cachePath = localAppData / "OBSE64GP" / "PluginCache.bin";
+            m_PluginScanner.LoadCache(cachePath);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<PluginInfo> plugins = m_PluginScanner.Scan(pluginsPath, *m_WorkerPool);
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+
+        // Report what would make OBSE skip a plugin, before it tries
+        for (const PluginInfo &plugin : plugins)
+        {
+            std::string name = plugin.path.filename().string();
+            if (!plugin.valid)
+            {
+                Log(LogLevel::Warning, "Plugin %s is not a valid DLL", name.c_str());
+            }
+            else if (plugin.machine != PluginInfo::MachineAmd64)
+            {
+                Log(LogLevel::Warning, "Plugin %s is not a 64-bit DLL (machine 0x%04X) and cannot be loaded", name.c_str(), plugin.machine);
+            }
+            else if (!plugin.IsObsePlugin())
+            {
+                Log(LogLevel::Warning, "Plugin %s does not export OBSEPlugin_Load", name.c_str());
+            }
+            else
             {
-                // Replace prefix
-                std::string result = mapping.second + pathStr.substr(mapping.first.length());
-                Log(LogLevel::Debug, "Translated virtual path '%s' to real path '%s'",
-                    pathStr.c_str(), result.c_str());
-                return std::filesystem::path(result);
+                Log(LogLevel::Debug, "Plugin %s: %zu exports, %zu imported modules", name.c_str(), plugin.exports.size(), plugin.imports.size());
             }
         }
 
-        // No mapping found, return original
-        return virtualPath;
+        const PluginScanStats &stats = m_PluginScanner.GetStats();
+        Log(LogLevel::Info, "Scanned %zu plugins in %s (%zu parsed, %zu cached) in %lld ms", stats.plugins,
+            pluginsPath.string().c_str(), stats.parsed, stats.cached, static_cast<long long>(elapsed.count()));
+
+        if (!cachePath.empty() && !m_PluginScanner.SaveCache(cachePath))
+        {
+            Log(LogLevel::Warning, "Failed to save plugin cache: %s", cachePath.string().c_str());
+        }
+
+        std::lock_guard<std::mutex> lock(m_ScanMutex);
+        m_Plugins = std::move(plugins);
     }
 
-    std::filesystem::path VirtualFileSystem::TranslateToVirtual(const std::filesystem::path &realPath)
+    void VirtualFileSystem::ScanModFiles()
+    {
+        std::filesystem::path dataPath = g_ObsePath / "Data";
+        std::filesystem::path realDataPath = TranslateToReal(dataPath);
+
+        std::filesystem::path cachePath;
+        std::filesystem::path localAppData = GetLocalAppDataPath();
+        if (!localAppData.empty())
+        {
+            cachePath = localAppData / "OBSE64GP" / "ModFileCache.bin";
+            m_ModFileScanner.LoadCache(cachePath);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<ModFileInfo> modFiles = m_ModFileScanner.Scan(realDataPath, *m_WorkerPool);
+
+        // Plugins.txt lists the active plugins in load order, one file name per line. The
+        // game rewrites it, so the view is closed as soon as it has been read.
+        std::vector<std::string> loadOrder;
+        std::filesystem::path pluginsListPath = dataPath / "Plugins.txt";
+        {
+            FileView pluginsList = MapView(pluginsListPath);
+            std::string_view text = pluginsList.AsText();
+            while (!text.empty())
+            {
+                size_t lineEnd = std::min(text.find('\n'), text.size());
+                std::string_view line = text.substr(0, lineEnd);
+                text.remove_prefix(std::min(lineEnd + 1, text.size()));
+
+                while (!line.empty() && (line.back() == '\r' || line.back() == ' ' || line.back() == '\t'))
+                {
+                    line.remove_suffix(1);
+                }
+                while (!line.empty() && (line.front() == ' ' || line.front() == '\t'))
+                {
+                    line.remove_prefix(1);
+                }
+                if (!line.empty() && line.front() != '#')
+                {
+                    loadOrder.emplace_back(line);
+                }
+            }
+        }
+
+        std::vector<LoadOrderProblem> problems = ModFileScanner::CheckLoadOrder(modFiles, loadOrder);
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+
+        for (const ModFileInfo &file : modFiles)
+        {
+            if (!file.valid)
+            {
+                Log(LogLevel::Warning, "Plugin %s has no readable TES4 header", file.path.filename().string().c_str());
+            }
+        }
+        for (const LoadOrderProblem &problem : problems)
+        {
+            Log(LogLevel::Warning, "Load order: %s needs %s (%s)", problem.plugin.c_str(), problem.master.c_str(),
+                GetLoadOrderIssueName(problem.issue));
+        }
+
+        Log(LogLevel::Info, "Checked %zu plugins in %s (%zu parsed, %zu active, %zu problems) in %lld ms", modFiles.size(),
+            realDataPath.string().c_str(), m_ModFileScanner.GetParsedCount(), loadOrder.empty() ? modFiles.size() : loadOrder.size(),
+            problems.size(), static_cast<long long>(elapsed.count()));
+
+        if (!cachePath.empty() && !m_ModFileScanner.SaveCache(cachePath))
+        {
+            Log(LogLevel::Warning, "Failed to save plugin header cache: %s", cachePath.string().c_str());
+        }
+
+        std::lock_guard<std::mutex> lock(m_ScanMutex);
+        m_ModFiles = std::move(modFiles);
+    }
+
+    std::vector<PluginInfo> VirtualFileSystem::GetPlugins() const
+    {
+        std::lock_guard<std::mutex> lock(m_ScanMutex);
+        return m_Plugins;
+    }
+
+    std::vector<ModFileInfo> VirtualFileSystem::GetModFiles() const
+    {
+        std::lock_guard<std::mutex> lock(m_ScanMutex);
+        return m_ModFiles;
+    }
+
+    void VirtualFileSystem::StartWatching()
     {
-        std::string pathStr = realPath.string();
+        // One watch per tree; roots inside another root are already covered by it
+        std::vector<std::filesystem::path> roots = GetRealRoots();
+        std::vector<PathKey> keys;
+        for (const std::filesystem::path &root : roots)
+        {
+            keys.push_back(FoldKey(root));
+        }
+        std::unordered_set<PathKey> watched;
+        for (size_t i = 0; i < roots.size(); ++i)
+        {
+            bool covered = std::any_of(keys.begin(), keys.end(), [&keys, i](const PathKey &other)
+                                       { return other != keys[i] && IsWithin(keys[i], other); });
+            std::error_code ec;
+            if (!covered && watched.insert(keys[i]).second && std::filesystem::is_directory(roots[i], ec))
+            {
+                m_Watcher.Watch(roots[i]);
+            }
+        }
+
+        if (m_Watcher.Start([this](const std::vector<FileChange> &changes, const std::vector<std::filesystem::path> &overflowedRoots)
+                            { ApplyChanges(changes, overflowedRoots); }))
+        {
+            Log(LogLevel::Info, "Watching %zu directories for changes", m_Watcher.RootCount());
+        }
+    }
+
+    void VirtualFileSystem::ApplyChanges(const std::vector<FileChange> &changes, const std::vector<std::filesystem::path> &overflowedRoots)
+    {
+        auto start = std::chrono::steady_clock::now();
+
+        // What the caches may hold under another spelling: each changed path and its directory,
+        // whose write time moved, and everything below removed paths, new directories and
+        // roots that lost notifications
+        std::unordered_set<PathKey> changed;
+        std::unordered_set<PathKey> subtrees;
+        for (const FileChange &change : changes)
+        {
+            PathKey key = FoldKey(change.path);
+            changed.insert(FoldKey(change.path.parent_path()));
+            std::error_code ec;
+            if (change.kind == FileChangeKind::Removed || std::filesystem::is_directory(change.path, ec))
+            {
+                subtrees.insert(key);
+            }
+            changed.insert(std::move(key));
+
+            // Lookups in the directory holding it go to the disk until it is listed again
+            m_DirectoryIndex.MarkStale(change.path);
+            if (change.kind == FileChangeKind::Removed)
+            {
+                DirectoryMaterializer::Forget(std::wstring_view(change.path.wstring()));
+            }
+        }
+        for (const std::filesystem::path &root : overflowedRoots)
+        {
+            Log(LogLevel::Warning, "Lost change notifications for %s; forgetting everything cached below it", root.string().c_str());
+            PathKey key = FoldKey(root);
+            changed.insert(key);
+            subtrees.insert(std::move(key));
+            m_DirectoryIndex.MarkStale(root, true);
+        }
+
+        // The index lists only the directories the changes touched and answers for them again
+        size_t relisted = m_DirectoryIndex.Refresh();
+
+        auto affected = [&changed, &subtrees](const PathKey &cached)
+        {
+            PathKey key = FoldPath(std::basic_string_view<PathKey::value_type>(cached));
+            if (changed.count(key))
+            {
+                return true;
+            }
+            for (size_t pos = key.find(PathKey::value_type('\\')); pos != PathKey::npos; pos = key.find(PathKey::value_type('\\'), pos + 1))
+            {
+                if (subtrees.count(key.substr(0, pos)))
+                {
+                    return true;
+                }
+            }
+            return false;
+        };
+        m_MetadataCache.InvalidateWhere(affected);
+        m_ViewCache.InvalidateWhere(affected);
+
+        // Rescan what the changes touched; the scanners' caches keep this to the changed files
+        std::filesystem::path dataPath = g_ObsePath / "Data";
+        PathKey pluginsKey = FoldKey(TranslateToReal(g_ObsePath / "OBSE" / "Plugins"));
+        PathKey dataKey = FoldKey(TranslateToReal(dataPath));
+        auto below = [&overflowedRoots](const PathKey &key)
+        {
+            return std::any_of(overflowedRoots.begin(), overflowedRoots.end(), [&key](const std::filesystem::path &root)
+                               { return IsWithin(key, FoldKey(root)); });
+        };
 
-        // Check each prefix mapping
-        for (const auto &mapping : m_RealToVirtualPaths)
+        bool rescanPlugins = below(pluginsKey) || changed.count(pluginsKey) > 0;
+        bool rescanModFiles = below(dataKey) || changed.count(dataKey) > 0;
+        bool remountArchives = below(dataKey);
+        std::vector<std::filesystem::path> changedArchives;
+        for (const FileChange &change : changes)
         {
-            if (pathStr.find(mapping.first) == 0)
+            PathKey parent = FoldKey(change.path.parent_path());
+            if (parent == pluginsKey && HasExtension(change.path, ".dll"))
             {
-                // Replace prefix
-                std::string result = mapping.second + pathStr.substr(mapping.first.length());
-                Log(LogLevel::Debug, "Translated real path '%s' to virtual path '%s'",
-                    pathStr.c_str(), result.c_str());
-                return std::filesystem::path(result);
+                rescanPlugins = true;
             }
+            else if (parent == dataKey)
+            {
+                if (HasExtension(change.path, ".esp") || HasExtension(change.path, ".esm") ||
+                    FoldKey(change.path.filename()) == FoldKey("plugins.txt"))
+                {
+                    rescanModFiles = true;
+                }
+                else if (HasExtension(change.path, ".bsa"))
+                {
+                    changedArchives.push_back(change.path);
+                }
+            }
+        }
+
+        if (!g_ConfigurationManager || g_ConfigurationManager->GetBool("Settings", "MountArchives", true))
+        {
+            if (remountArchives)
+            {
+                std::string root = FoldArchivePath(TranslateToReal(dataPath));
+                {
+                    std::unique_lock<std::shared_mutex> lock(m_ArchiveMutex);
+                    m_Archives.erase(std::remove_if(m_Archives.begin(), m_Archives.end(), [&root](const ArchiveMount &mount)
+                                                    { return mount.root == root; }),
+                                     m_Archives.end());
+                }
+                MountDataArchives();
+            }
+            else
+            {
+                for (const std::filesystem::path &archive : changedArchives)
+                {
+                    RemountArchive(dataPath, archive);
+                }
+            }
+        }
+        if (rescanPlugins && (!g_ConfigurationManager || g_ConfigurationManager->GetBool("Settings", "ScanPlugins", true)))
+        {
+            ScanPlugins();
+        }
+        if (rescanModFiles && (!g_ConfigurationManager || g_ConfigurationManager->GetBool("Settings", "CheckLoadOrder", true)))
+        {
+            ScanModFiles();
+        }
+
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+        Log(LogLevel::Debug, "Applied %zu changed paths (%zu roots overflowed, %zu directories listed) in %lld ms", changes.size(),
+            overflowedRoots.size(), relisted, static_cast<long long>(elapsed.count()));
+    }
+
+    bool VirtualFileSystem::MapPath(const std::filesystem::path &virtualPath, const std::filesystem::path &realPath)
+    {
+        Log(LogLevel::Info, "Mapping path: %s -> %s",
+            virtualPath.string().c_str(), realPath.string().c_str());
+
+        // Add mappings in both directions; safe while the hooks are translating
+        m_Registry->AddMapping(virtualPath, realPath);
+
+        return true;
+    }
+
+    std::filesystem::path VirtualFileSystem::Translate(MappingDirection direction, const std::filesystem::path &path, const char *description)
+    {
+        MappingRegistry::Reader mappings(*m_Registry);
+        return Translate(*mappings, direction, path, description);
+    }
+
+    std::filesystem::path VirtualFileSystem::Translate(const MappingSnapshot &mappings, MappingDirection direction,
+                                                       const std::filesystem::path &path, const char *description)
+    {
+        std::string pathStr = path.string();
+
+        // Longest mapped prefix wins, so nested roots are not shadowed by their parents
+        size_t matchedLength = 0;
+        const std::string *target = mappings.FindTarget(direction, std::string_view(pathStr), &matchedLength);
+        if (!target)
+        {
+            // No mapping found, return original
+            return path;
         }
 
-        // No mapping found, return original
-        return realPath;
+        // Replace prefix
+        std::string result = *target + pathStr.substr(matchedLength);
+        Log(LogLevel::Debug, "Translated %s '%s' to '%s'", description, pathStr.c_str(), result.c_str());
+        return std::filesystem::path(result);
+    }
+
+    std::filesystem::path VirtualFileSystem::TranslateToReal(const std::filesystem::path &virtualPath)
+    {
+        return Translate(MappingDirection::ObseToGame, virtualPath, "virtual path");
+    }
+
+    std::filesystem::path VirtualFileSystem::TranslateToVirtual(const std::filesystem::path &realPath)
+    {
+        return Translate(MappingDirection::GameToObse, realPath, "real path");
     }
 
     bool VirtualFileSystem::IsVirtualPath(const std::filesystem::path &path)
@@ -127,35 +650,124 @@ namespace ObseGPCompat
         std::string pathStr = path.string();
 
         // Check if the path starts with any virtual prefix
-        for (const auto &mapping : m_VirtualToRealPaths)
+        size_t matchedLength = 0;
+        return MappingRegistry::Reader(*m_Registry)->FindTarget(MappingDirection::ObseToGame, std::string_view(pathStr), &matchedLength) != nullptr;
+    }
+
+    bool VirtualFileSystem::MountOverlay(const std::filesystem::path &virtualPath, const std::vector<OverlayLayer> &layers)
+    {
+        // Files any layer provides resolve to the highest-priority one; the rest fall
+        // through to the regular mappings
+        return m_Registry->MountOverlay(virtualPath, layers);
+    }
+
+    bool VirtualFileSystem::FileExists(const std::filesystem::path &virtualPath)
+    {
+        // Translate to real path
+        return FileExistsAt(this->TranslateToReal(virtualPath));
+    }
+
+    bool VirtualFileSystem::FileExistsAt(const std::filesystem::path &realPath)
+    {
+        // The index answers for anything under the real roots it has not been told changed
+        DirectoryIndex::Presence presence = m_DirectoryIndex.Find(realPath);
+        bool exists;
+        if (presence != DirectoryIndex::Presence::NotIndexed)
+        {
+            exists = presence != DirectoryIndex::Presence::Missing;
+        }
+        else
+        {
+            // Check if file exists; repeated probes are answered from the metadata cache
+            exists = m_MetadataCache.Get(realPath).exists;
+        }
+
+        // Loose files come first, as in the game; archives only fill the gaps
+        return exists || IsInArchive(realPath);
+    }
+
+    bool VirtualFileSystem::GetFileMetadata(const std::filesystem::path &virtualPath, FileMetadata &metadata)
+    {
+        // Translate to real path
+        std::filesystem::path realPath = this->TranslateToReal(virtualPath);
+
+        metadata = m_MetadataCache.Get(realPath);
+        return metadata.exists;
+    }
+
+    std::vector<std::string> VirtualFileSystem::ListDirectory(const std::filesystem::path &virtualPath)
+    {
+        // Translate to real path
+        std::filesystem::path realPath = this->TranslateToReal(virtualPath);
+
+        std::vector<std::string> names;
+        std::unordered_set<std::string> seen;
+        auto add = [&names, &seen](const std::string &name)
         {
-            if (pathStr.find(mapping.first) == 0)
+            std::string folded = name;
+            std::transform(folded.begin(), folded.end(), folded.begin(), [](char c)
+                           { return FoldPathChar(c); });
+            if (seen.insert(std::move(folded)).second)
             {
-                return true;
+                names.push_back(name);
             }
+        };
+
+        std::error_code ec;
+        for (std::filesystem::directory_iterator it(realPath, ec), end; !ec && it != end; it.increment(ec))
+        {
+            add(it->path().filename().string());
         }
 
-        return false;
+        std::shared_lock<std::shared_mutex> lock(m_ArchiveMutex);
+        std::string folded = FoldArchivePath(realPath);
+        for (const ArchiveMount &mount : m_Archives)
+        {
+            std::string_view relative;
+            const ArchiveFolder *folder = RelativeToRoot(folded, mount.root, relative) ? mount.archive->FindFolder(relative) : nullptr;
+            if (folder)
+            {
+                std::for_each(folder->folders.begin(), folder->folders.end(), add);
+                std::for_each(folder->files.begin(), folder->files.end(), add);
+            }
+        }
+        return names;
     }
 
-    bool VirtualFileSystem::FileExists(const std::filesystem::path &virtualPath)
+    FileView VirtualFileSystem::MapView(const std::filesystem::path &virtualPath)
     {
         // Translate to real path
         std::filesystem::path realPath = this->TranslateToReal(virtualPath);
 
-        // Check if file exists
-        return std::filesystem::exists(realPath);
+        // The cached size and write time tell whether an open mapping is still current
+        FileMetadata metadata = m_MetadataCache.Get(realPath);
+        if (!metadata.exists || metadata.type != std::filesystem::file_type::regular)
+        {
+            return FileView();
+        }
+
+        FileView view = m_ViewCache.Get(realPath, metadata.size, metadata.lastWriteTime);
+        if (!view)
+        {
+            Log(LogLevel::Warning, "Failed to map '%s'", realPath.string().c_str());
+        }
+        return view;
     }
 
     bool VirtualFileSystem::CreateDirectory(const std::filesystem::path &virtualPath)
     {
         // Translate to real path
-        std::filesystem::path realPath = this->TranslateToReal(virtualPath);
+        return CreateDirectoryAt(this->TranslateToReal(virtualPath));
+    }
 
+    bool VirtualFileSystem::CreateDirectoryAt(const std::filesystem::path &realPath)
+    {
         // Create directory
         try
         {
             bool result = std::filesystem::create_directories(realPath);
+            m_MetadataCache.InvalidateWithAncestors(realPath);
+            m_DirectoryIndex.MarkStale(realPath);
             if (result)
             {
                 Log(LogLevel::Info, "Created directory: %s", realPath.string().c_str());
@@ -173,12 +785,19 @@ namespace ObseGPCompat
     bool VirtualFileSystem::DeleteFile(const std::filesystem::path &virtualPath)
     {
         // Translate to real path
-        std::filesystem::path realPath = this->TranslateToReal(virtualPath);
+        return DeleteFileAt(this->TranslateToReal(virtualPath));
+    }
 
-        // Delete file
+    bool VirtualFileSystem::DeleteFileAt(const std::filesystem::path &realPath)
+    {
+        // Delete file; RemoveFile takes a read-only store link by name alone, leaving the object
         try
         {
-            bool result = std::filesystem::remove(realPath);
+            bool result = Platform::RemoveFile(realPath) || std::filesystem::remove(realPath);
+            DirectoryMaterializer::Forget(std::wstring_view(realPath.wstring()));
+            m_MetadataCache.Invalidate(realPath);
+            m_ViewCache.Invalidate(realPath);
+            m_DirectoryIndex.MarkStale(realPath);
             if (result)
             {
                 Log(LogLevel::Info, "Deleted file: %s", realPath.string().c_str());
@@ -193,44 +812,289 @@ namespace ObseGPCompat
         }
     }
 
-    bool VirtualFileSystem::CopyFile(const std::filesystem::path &srcVirtualPath, const std::filesystem::path &destVirtualPath, bool overwrite)
+    bool VirtualFileSystem::CopyFile(const std::filesystem::path &srcVirtualPath, const std::filesystem::path &destVirtualPath, bool overwrite,
+                                     const CopyProgressCallback &progress)
     {
         // Translate to real paths
-        std::filesystem::path srcRealPath = this->TranslateToReal(srcVirtualPath);
-        std::filesystem::path destRealPath = this->TranslateToReal(destVirtualPath);
+        return CopyFileAt(this->TranslateToReal(srcVirtualPath), this->TranslateToReal(destVirtualPath), overwrite, progress);
+    }
+
+    bool VirtualFileSystem::CopyFileAt(const std::filesystem::path &srcRealPath, const std::filesystem::path &destRealPath, bool overwrite,
+                                       const CopyProgressCallback &progress)
+    {
+        // Create destination directory if it doesn't exist
+        DirectoryMaterializer::EnsureParentDirectory(std::wstring_view(destRealPath.wstring()));
+
+        // A copy keeps the source's write time, so the size and time need not change
+        m_ViewCache.Invalidate(destRealPath);
+
+        // Copy file; the engine refuses an existing destination itself unless overwriting
+        CopyResult result = m_CopyEngine.Copy(srcRealPath, destRealPath, overwrite, progress);
+        m_MetadataCache.InvalidateWithAncestors(destRealPath);
+        m_DirectoryIndex.MarkStale(destRealPath);
 
-        // Check if destination file exists and we're not allowed to overwrite
-        if (!overwrite && std::filesystem::exists(destRealPath))
+        if (!result.success)
         {
-            Log(LogLevel::Error, "Destination file '%s' already exists and overwrite is not allowed",
-                destRealPath.string().c_str());
+            if (result.error == Platform::FileError::AlreadyExists && overwrite)
+            {
+                Log(LogLevel::Error, "Cannot copy '%s' onto '%s': they are the same file",
+                    srcRealPath.string().c_str(), destRealPath.string().c_str());
+            }
+            else if (result.error == Platform::FileError::AlreadyExists)
+            {
+                Log(LogLevel::Error, "Destination file '%s' already exists and overwrite is not allowed",
+                    destRealPath.string().c_str());
+            }
+            else
+            {
+                Log(LogLevel::Error, "Failed to copy file from '%s' to '%s': %s",
+                    srcRealPath.string().c_str(), destRealPath.string().c_str(), Platform::GetFileErrorName(result.error));
+            }
             return false;
         }
 
-        // Create destination directory if it doesn't exist
-        std::filesystem::path destDir = destRealPath.parent_path();
-        if (!std::filesystem::exists(destDir))
+        Log(LogLevel::Info, "Copied file from '%s' to '%s' (%llu bytes, %s, %.1f MB/s)",
+            srcRealPath.string().c_str(), destRealPath.string().c_str(),
+            static_cast<unsigned long long>(result.bytes), GetCopyMethodName(result.method),
+            result.BytesPerSecond() / (1024.0 * 1024.0));
+        return true;
+    }
+
+    bool VirtualFileSystem::ImportFile(const std::filesystem::path &sourcePath, const std::filesystem::path &virtualPath, ContentId *id)
+    {
+        if (!m_ContentStore.IsInitialized())
+        {
+            Log(LogLevel::Error, "Cannot import '%s': the content store is not available", sourcePath.string().c_str());
+            return false;
+        }
+
+        ContentId stored = {};
+        if (!m_ContentStore.Add(sourcePath, stored))
+        {
+            return false;
+        }
+        if (id)
         {
-            std::filesystem::create_directories(destDir);
+            *id = stored;
         }
+        return ExposeContent(stored, virtualPath);
+    }
 
-        // Copy file
-        try
+    bool VirtualFileSystem::ExposeContent(const ContentId &id, const std::filesystem::path &virtualPath)
+    {
+        if (!m_ContentStore.Contains(id))
         {
-            std::filesystem::copy_file(
-                srcRealPath,
-                destRealPath,
-                overwrite ? std::filesystem::copy_options::overwrite_existing : std::filesystem::copy_options::none);
-            Log(LogLevel::Info, "Copied file from '%s' to '%s'",
-                srcRealPath.string().c_str(), destRealPath.string().c_str());
+            Log(LogLevel::Error, "Content %ls is not in the content store", id.ToString().c_str());
+            return false;
+        }
+
+        std::filesystem::path realPath = this->TranslateToReal(virtualPath);
+        DirectoryMaterializer::EnsureParentDirectory(std::wstring_view(realPath.wstring()));
+
+        m_ViewCache.Invalidate(realPath);
+        bool linked = m_ContentStore.Link(id, realPath);
+        Platform::FileError linkError = linked ? Platform::FileError::None : Platform::GetLastFileError();
+        m_MetadataCache.InvalidateWithAncestors(realPath);
+        m_DirectoryIndex.MarkStale(realPath);
+        if (linked)
+        {
+            Log(LogLevel::Info, "Linked %ls at '%s'", id.ToString().c_str(), realPath.string().c_str());
             return true;
         }
-        catch (const std::exception &e)
+
+        // Another volume, or the object ran out of links: the path gets its own copy, which
+        // is not shared and so need not stay read-only like the object
+        std::filesystem::path objectPath = m_ContentStore.GetObjectPath(id);
+        Log(LogLevel::Info, "Copying stored content '%s' to '%s' (linking failed: %s)",
+            objectPath.string().c_str(), realPath.string().c_str(), Platform::GetFileErrorName(linkError));
+        if (!CopyFileAt(objectPath, realPath, true, nullptr))
         {
-            Log(LogLevel::Error, "Failed to copy file from '%s' to '%s': %s",
-                srcRealPath.string().c_str(), destRealPath.string().c_str(), e.what());
             return false;
         }
+        std::error_code ec;
+        std::filesystem::permissions(realPath, std::filesystem::perms::owner_write, std::filesystem::perm_options::add, ec);
+        return true;
+    }
+
+    bool VirtualFileSystem::RunOperation(const FileOperation &operation)
+    {
+        try
+        {
+            switch (operation.type)
+            {
+            case FileOperationType::Exists:
+                return FileExistsAt(operation.path);
+            case FileOperationType::MakeDirectory:
+                return CreateDirectoryAt(operation.path);
+            case FileOperationType::Remove:
+                return DeleteFileAt(operation.path);
+            case FileOperationType::Copy:
+                return CopyFileAt(operation.path, operation.destination, operation.overwrite, nullptr);
+            }
+        }
+        catch (const std::exception &e)
+        {
+            Log(LogLevel::Error, "Batched operation on '%s' failed: %s", operation.path.string().c_str(), e.what());
+        }
+        return false;
+    }
+
+    std::future<std::vector<FileOperationResult>> VirtualFileSystem::SubmitBatch(std::vector<FileOperation> operations,
+                                                                                 FileBatchCallback onComplete)
+    {
+        struct Batch
+        {
+            std::vector<FileOperation> operations; // On real paths
+            std::vector<FileOperationResult> results;
+            std::atomic<size_t> remaining;
+            std::promise<std::vector<FileOperationResult>> promise;
+            FileBatchCallback onComplete;
+            std::chrono::steady_clock::time_point start;
+        };
+
+        auto batch = std::make_shared<Batch>();
+        std::future<std::vector<FileOperationResult>> future = batch->promise.get_future();
+        batch->start = std::chrono::steady_clock::now();
+        batch->onComplete = std::move(onComplete);
+
+        // Translate everything against one snapshot, so a concurrent remap cannot split the batch
+        {
+            MappingRegistry::Reader mappings(*m_Registry);
+            for (FileOperation &operation : operations)
+            {
+                operation.path = Translate(*mappings, MappingDirection::ObseToGame, operation.path, "virtual path");
+                if (operation.type == FileOperationType::Copy)
+                {
+                    operation.destination = Translate(*mappings, MappingDirection::ObseToGame, operation.destination, "virtual path");
+                }
+            }
+        }
+
+        // Operations conflict when they name the same path, or when one lies below a directory
+        // another creates or removes. Conflicting operations are joined into one group, which
+        // runs in submission order; everything else is independent and spreads across the pool.
+        std::vector<size_t> leaders(operations.size());
+        std::iota(leaders.begin(), leaders.end(), 0);
+        auto leaderOf = [&leaders](size_t index)
+        {
+            while (leaders[index] != index)
+            {
+                leaders[index] = leaders[leaders[index]];
+                index = leaders[index];
+            }
+            return index;
+        };
+        auto join = [&leaders, &leaderOf](size_t a, size_t b)
+        {
+            a = leaderOf(a);
+            b = leaderOf(b);
+            leaders[std::max(a, b)] = std::min(a, b);
+        };
+
+        // Folded, so every spelling of a path is one key
+        std::vector<std::vector<std::wstring>> keys(operations.size());
+        std::unordered_map<std::wstring, size_t> owners; // Key -> first operation naming it
+        std::unordered_set<std::wstring> directories;    // Created or removed by the batch
+        for (size_t i = 0; i < operations.size(); ++i)
+        {
+            const FileOperation &operation = operations[i];
+            keys[i].push_back(FoldPath(std::wstring_view(operation.path.wstring())));
+            if (operation.type == FileOperationType::Copy)
+            {
+                keys[i].push_back(FoldPath(std::wstring_view(operation.destination.wstring())));
+            }
+            for (const std::wstring &key : keys[i])
+            {
+                auto owner = owners.emplace(key, i);
+                if (!owner.second)
+                {
+                    join(i, owner.first->second);
+                }
+            }
+            if (operation.type == FileOperationType::MakeDirectory || operation.type == FileOperationType::Remove)
+            {
+                directories.insert(keys[i].front());
+            }
+        }
+        if (!directories.empty())
+        {
+            for (size_t i = 0; i < operations.size(); ++i)
+            {
+                for (const std::wstring &key : keys[i])
+                {
+                    for (size_t pos = key.find(L'\\'); pos != std::wstring::npos; pos = key.find(L'\\', pos + 1))
+                    {
+                        auto directory = directories.find(key.substr(0, pos));
+                        if (directory != directories.end())
+                        {
+                            join(i, owners[*directory]);
+                        }
+                    }
+                }
+            }
+        }
+
+        std::vector<std::vector<size_t>> groups;
+        std::unordered_map<size_t, size_t> groupOf; // Leader -> index into groups
+        for (size_t i = 0; i < operations.size(); ++i)
+        {
+            auto group = groupOf.emplace(leaderOf(i), groups.size());
+            if (group.second)
+            {
+                groups.emplace_back();
+            }
+            groups[group.first->second].push_back(i);
+        }
+
+        size_t count = operations.size();
+        batch->operations = std::move(operations);
+        batch->results.resize(count, FileOperationResult{false});
+        batch->remaining.store(count);
+
+        auto finish = [](Batch &finished)
+        {
+            Log(LogLevel::Debug, "Batch of %zu operations finished in %lld ms", finished.results.size(),
+                static_cast<long long>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - finished.start).count()));
+            if (finished.onComplete)
+            {
+                finished.onComplete(finished.results);
+            }
+            finished.promise.set_value(std::move(finished.results));
+        };
+
+        if (count == 0)
+        {
+            finish(*batch);
+            return future;
+        }
+
+        for (std::vector<size_t> &group : groups)
+        {
+            auto task = [this, batch, finish, group = std::move(group)]()
+            {
+                for (size_t index : group)
+                {
+                    batch->results[index].success = RunOperation(batch->operations[index]);
+                }
+
+                // The last group to finish completes the batch
+                if (batch->remaining.fetch_sub(group.size()) == group.size())
+                {
+                    finish(*batch);
+                }
+            };
+
+            if (m_WorkerPool)
+            {
+                m_WorkerPool->Submit(std::move(task));
+            }
+            else
+            {
+                task();
+            }
+        }
+
+        return future;
     }
 
 } // namespace ObseGPCompat
\ No newline at end of file
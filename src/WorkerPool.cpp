@@ -0,0 +1,58 @@
+#include "WorkerPool.h"
+
+namespace ObseGPCompat
+{
+
+    WorkerPool::WorkerPool(size_t threadCount)
+        : m_Stopping(false)
+    {
+        for (size_t i = 0; i < (threadCount ? threadCount : 1); ++i)
+        {
+            m_Threads.emplace_back(&WorkerPool::Run, this);
+        }
+    }
+
+    WorkerPool::~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Stopping = true;
+        }
+        m_Wake.notify_all();
+
+        for (std::thread &thread : m_Threads)
+        {
+            thread.join();
+        }
+    }
+
+    void WorkerPool::Submit(std::function<void()> task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Tasks.push_back(std::move(task));
+        }
+        m_Wake.notify_one();
+    }
+
+    void WorkerPool::Run()
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        for (;;)
+        {
+            m_Wake.wait(lock, [this]()
+                        { return m_Stopping || !m_Tasks.empty(); });
+            if (m_Tasks.empty())
+            {
+                return;
+            }
+
+            std::function<void()> task = std::move(m_Tasks.front());
+            m_Tasks.pop_front();
+            lock.unlock();
+            task();
+            lock.lock();
+        }
+    }
+
+} // namespace ObseGPCompat
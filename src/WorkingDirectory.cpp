@@ -0,0 +1,53 @@
+#include "WorkingDirectory.h"
+
+#include <filesystem>
+
+namespace ObseGPCompat
+{
+
+    std::atomic<uint64_t> WorkingDirectory::s_Version{1};
+
+    void WorkingDirectory::Invalidate()
+    {
+        s_Version.fetch_add(1, std::memory_order_acq_rel);
+    }
+
+    template <>
+    std::basic_string<char> WorkingDirectory::Query<char>()
+    {
+        std::error_code ec;
+        return std::filesystem::current_path(ec).string();
+    }
+
+    template <>
+    std::basic_string<wchar_t> WorkingDirectory::Query<wchar_t>()
+    {
+        std::error_code ec;
+        return std::filesystem::current_path(ec).wstring();
+    }
+
+    template <typename CharT>
+    std::basic_string_view<CharT> WorkingDirectory::Get()
+    {
+        struct Snapshot
+        {
+            uint64_t version = 0; // Zero never matches a live version
+            std::basic_string<CharT> path;
+        };
+        static thread_local Snapshot snapshot;
+
+        // Read the version before querying: a change racing with the query leaves the
+        // snapshot tagged with the older version, so the next call queries again
+        uint64_t version = Version();
+        if (snapshot.version != version)
+        {
+            snapshot.path = Query<CharT>();
+            snapshot.version = version;
+        }
+        return snapshot.path;
+    }
+
+    template std::basic_string_view<char> WorkingDirectory::Get<char>();
+    template std::basic_string_view<wchar_t> WorkingDirectory::Get<wchar_t>();
+
+} // namespace ObseGPCompat
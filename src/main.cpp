@@ -1,4 +1,5 @@
 #include "ObseGPCompat.h"
+#include "MappingRegistry.h"
 #include "PathTranslator.h"
 #include "APIHookManager.h"
 #include "VirtualFileSystem.h"
@@ -7,37 +8,12 @@
 
 #include <Windows.h>
 #include <iostream>
-#include <fstream>
-#include <shlobj.h>
 #include <filesystem>
-#include <stdarg.h>
 
 namespace ObseGPCompat
 {
-    // Global variables
-    std::filesystem::path g_GamePassInstallPath;
-    std::filesystem::path g_ObsePath;
-    std::filesystem::path g_CompatLayerPath;
-
-    // Global components
-    std::unique_ptr<PathTranslator> g_PathTranslator;
+    // The hooks only exist on Windows; the other globals live with the core
     std::unique_ptr<APIHookManager> g_APIHookManager;
-    std::unique_ptr<VirtualFileSystem> g_VirtualFileSystem;
-    std::unique_ptr<ConfigurationManager> g_ConfigurationManager;
-
-    // Log file handle
-    static std::ofstream g_LogFile;
-
-    // Helper function to get Local AppData path
-    std::filesystem::path GetLocalAppDataPath()
-    {
-        char path[MAX_PATH];
-        if (SUCCEEDED(SHGetFolderPathA(NULL, CSIDL_LOCAL_APPDATA, NULL, 0, path)))
-        {
-            return std::filesystem::path(path);
-        }
-        return std::filesystem::path();
-    }
 
     // Initialize the compatibility layer
     bool Initialize()
@@ -47,8 +23,7 @@ namespace ObseGPCompat
         std::filesystem::create_directories(logPath);
 
         // Open log file
-        g_LogFile.open((logPath / "compat_layer.log").string());
-        if (!g_LogFile.is_open())
+        if (!OpenLogFile(logPath / "compat_layer.log"))
         {
             std::cerr << "Failed to open log file" << std::endl;
             return false;
@@ -71,6 +46,13 @@ namespace ObseGPCompat
         g_CompatLayerPath = std::filesystem::current_path();
 
         // Initialize other components
+        g_MappingRegistry = std::make_unique<MappingRegistry>();
+        if (!g_MappingRegistry->Initialize())
+        {
+            Log(LogLevel::Error, "Failed to initialize MappingRegistry");
+            return false;
+        }
+
         g_PathTranslator = std::make_unique<PathTranslator>();
         if (!g_PathTranslator->Initialize())
         {
@@ -85,11 +67,19 @@ namespace ObseGPCompat
             return false;
         }
 
-        g_APIHookManager = std::make_unique<APIHookManager>();
-        if (!g_APIHookManager->Initialize())
+        // In deploy mode the launcher has linked the mappings on disk, so nothing needs redirecting
+        if (g_ConfigurationManager->GetBool("Settings", "DeployMode", false))
         {
-            Log(LogLevel::Error, "Failed to initialize APIHookManager");
-            return false;
+            Log(LogLevel::Info, "Deploy mode: file API hooks are not installed");
+        }
+        else
+        {
+            g_APIHookManager = std::make_unique<APIHookManager>();
+            if (!g_APIHookManager->Initialize())
+            {
+                Log(LogLevel::Error, "Failed to initialize APIHookManager");
+                return false;
+            }
         }
 
         Log(LogLevel::Info, "Compatibility layer initialized successfully");
@@ -105,44 +95,11 @@ namespace ObseGPCompat
         g_APIHookManager.reset();
         g_VirtualFileSystem.reset();
         g_PathTranslator.reset();
+        g_MappingRegistry.reset();
         g_ConfigurationManager.reset();
 
         // Close log file
-        g_LogFile.close();
-    }
-
-    // Log a message
-    void Log(LogLevel level, const char *format, ...)
-    {
-        static const char *levelStrings[] = {
-            "DEBUG",
-            "INFO",
-            "WARNING",
-            "ERROR"};
-
-        // Format time
-        SYSTEMTIME st;
-        GetLocalTime(&st);
-        char timeStr[20];
-        sprintf_s(timeStr, sizeof(timeStr), "%02d:%02d:%02d.%03d",
-                  st.wHour, st.wMinute, st.wSecond, st.wMilliseconds);
-
-        // Format message
-        char buffer[4096];
-        va_list args;
-        va_start(args, format);
-        vsprintf_s(buffer, sizeof(buffer), format, args);
-        va_end(args);
-
-        // Write to log file
-        if (g_LogFile.is_open())
-        {
-            g_LogFile << timeStr << " [" << levelStrings[static_cast<int>(level)] << "] " << buffer << std::endl;
-            g_LogFile.flush();
-        }
-
-        // Also write to console if available
-        printf("%s [%s] %s\n", timeStr, levelStrings[static_cast<int>(level)], buffer);
+        CloseLogFile();
     }
 
 } // namespace ObseGPCompat
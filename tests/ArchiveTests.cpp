@@ -0,0 +1,252 @@
+#include "Tests.h"
+#include "BsaArchive.h"
+
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace ObseGPCompat
+{
+
+    namespace Test
+    {
+
+        namespace
+        {
+            struct SyntheticFile
+            {
+                std::string name;
+                uint32_t size; // May carry the compression toggle bit
+            };
+
+            struct SyntheticFolder
+            {
+                std::string name;
+                std::vector<SyntheticFile> files;
+            };
+
+            template <typename T>
+            void Append(std::vector<uint8_t> &bytes, T value)
+            {
+                size_t offset = bytes.size();
+                bytes.resize(offset + sizeof(T));
+                std::memcpy(bytes.data() + offset, &value, sizeof(T));
+            }
+
+            void Patch(std::vector<uint8_t> &bytes, size_t offset, uint32_t value)
+            {
+                std::memcpy(bytes.data() + offset, &value, sizeof(value));
+            }
+
+            // A version 103 archive with the name tables Load reads; the hashes are not
+            // checked and the file data is left out
+            std::vector<uint8_t> BuildArchive(const std::vector<SyntheticFolder> &folders, uint32_t archiveFlags = 0x3)
+            {
+                uint32_t fileCount = 0;
+                uint32_t folderNameLength = 0;
+                uint32_t fileNameLength = 0;
+                for (const SyntheticFolder &folder : folders)
+                {
+                    fileCount += static_cast<uint32_t>(folder.files.size());
+                    folderNameLength += static_cast<uint32_t>(folder.name.size() + 1);
+                    for (const SyntheticFile &file : folder.files)
+                    {
+                        fileNameLength += static_cast<uint32_t>(file.name.size() + 1);
+                    }
+                }
+
+                std::vector<uint8_t> bytes;
+                Append<uint32_t>(bytes, 0x00415342);
+                Append<uint32_t>(bytes, BsaArchive::Version);
+                Append<uint32_t>(bytes, 36);
+                Append<uint32_t>(bytes, archiveFlags);
+                Append<uint32_t>(bytes, static_cast<uint32_t>(folders.size()));
+                Append<uint32_t>(bytes, fileCount);
+                Append<uint32_t>(bytes, folderNameLength);
+                Append<uint32_t>(bytes, fileNameLength);
+                Append<uint32_t>(bytes, 0);
+
+                for (const SyntheticFolder &folder : folders)
+                {
+                    Append<uint64_t>(bytes, 0);
+                    Append<uint32_t>(bytes, static_cast<uint32_t>(folder.files.size()));
+                    Append<uint32_t>(bytes, 0);
+                }
+
+                uint32_t dataOffset = 0x1000;
+                for (const SyntheticFolder &folder : folders)
+                {
+                    Append<uint8_t>(bytes, static_cast<uint8_t>(folder.name.size() + 1));
+                    bytes.insert(bytes.end(), folder.name.begin(), folder.name.end());
+                    Append<uint8_t>(bytes, 0);
+                    for (const SyntheticFile &file : folder.files)
+                    {
+                        Append<uint64_t>(bytes, 0);
+                        Append<uint32_t>(bytes, file.size);
+                        Append<uint32_t>(bytes, dataOffset);
+                        dataOffset += file.size & 0x3FFFFFFF;
+                    }
+                }
+
+                for (const SyntheticFolder &folder : folders)
+                {
+                    for (const SyntheticFile &file : folder.files)
+                    {
+                        bytes.insert(bytes.end(), file.name.begin(), file.name.end());
+                        Append<uint8_t>(bytes, 0);
+                    }
+                }
+                return bytes;
+            }
+
+            std::vector<SyntheticFolder> GetSampleFolders()
+            {
+                return {{"meshes\\clutter", {{"bucket01.nif", 1200}, {"Bowl.NIF", 800 | 0x40000000}}},
+                        {"meshes\\architecture\\anvil", {{"house.nif", 5000}}},
+                        {"textures", {{"sky.dds", 40000}}},
+                        {".", {{"readme.txt", 10}}}};
+            }
+
+            void IndexesFilesAndFolders(TestContext &context)
+            {
+                std::vector<uint8_t> bytes = BuildArchive(GetSampleFolders());
+                BsaArchive archive;
+                REQUIRE(archive.Load(bytes.data(), bytes.size()));
+                CHECK_EQUAL(archive.FileCount(), 5u);
+
+                // Any case, either separator
+                const ArchiveFile *file = archive.FindFile("Meshes/Clutter/Bucket01.nif");
+                REQUIRE(file != nullptr);
+                CHECK_EQUAL(file->size, 1200u);
+                CHECK_EQUAL(file->offset, 0x1000u);
+                CHECK(!file->compressed);
+                CHECK(archive.FindFile("meshes\\clutter\\bowl.nif") != nullptr);
+                CHECK(archive.FindFile("readme.txt") != nullptr);
+                CHECK(archive.FindFile("meshes\\clutter") == nullptr);
+                CHECK(archive.FindFile("meshes\\clutter\\cup.nif") == nullptr);
+
+                // Intermediate folders exist even without a record of their own
+                const ArchiveFolder *root = archive.FindFolder("");
+                REQUIRE(root != nullptr);
+                CHECK_EQUAL(root->folders.size(), 2u);
+                CHECK_EQUAL(root->files.size(), 1u);
+                const ArchiveFolder *meshes = archive.FindFolder("MESHES\\");
+                REQUIRE(meshes != nullptr);
+                CHECK_EQUAL(meshes->folders.size(), 2u);
+                CHECK(meshes->files.empty());
+                const ArchiveFolder *anvil = archive.FindFolder("meshes/architecture/anvil");
+                REQUIRE(anvil != nullptr);
+                CHECK_EQUAL(anvil->files.size(), 1u);
+                CHECK_EQUAL(anvil->files[0], "house.nif");
+            }
+
+            // The per-file bit inverts the archive default
+            void TogglesCompression(TestContext &context)
+            {
+                std::vector<uint8_t> bytes = BuildArchive(GetSampleFolders());
+                BsaArchive archive;
+                REQUIRE(archive.Load(bytes.data(), bytes.size()));
+                REQUIRE(archive.FindFile("meshes\\clutter\\bowl.nif") != nullptr);
+                CHECK(archive.FindFile("meshes\\clutter\\bowl.nif")->compressed);
+                CHECK_EQUAL(archive.FindFile("meshes\\clutter\\bowl.nif")->size, 800u);
+
+                bytes = BuildArchive(GetSampleFolders(), 0x3 | 0x4);
+                REQUIRE(archive.Load(bytes.data(), bytes.size()));
+                CHECK(!archive.FindFile("meshes\\clutter\\bowl.nif")->compressed);
+                CHECK(archive.FindFile("textures\\sky.dds")->compressed);
+            }
+
+            void RejectsUnsupportedArchives(TestContext &context)
+            {
+                BsaArchive archive;
+                std::vector<uint8_t> bytes = BuildArchive(GetSampleFolders());
+                std::vector<uint8_t> other = bytes;
+                Patch(other, 4, 104);
+                CHECK(!archive.Load(other.data(), other.size()));
+                other = bytes;
+                other[0] = 'X';
+                CHECK(!archive.Load(other.data(), other.size()));
+
+                // Hash-only archives cannot be matched by name
+                other = BuildArchive(GetSampleFolders(), 0x1);
+                CHECK(!archive.Load(other.data(), other.size()));
+
+                // A count that disagrees with the folder records
+                other = bytes;
+                Patch(other, 20, 6);
+                CHECK(!archive.Load(other.data(), other.size()));
+            }
+
+            void RejectsTruncatedArchives(TestContext &context)
+            {
+                std::vector<uint8_t> bytes = BuildArchive(GetSampleFolders());
+                BsaArchive archive;
+                for (size_t size = 0; size < bytes.size(); ++size)
+                {
+                    if (archive.Load(bytes.data(), size))
+                    {
+                        context.Fail("Loaded an archive cut to " + std::to_string(size) + " bytes", __FILE__, __LINE__);
+                        return;
+                    }
+                    CHECK_EQUAL(archive.FileCount(), 0u);
+                }
+            }
+
+            // Counts far beyond the file are refused before anything is allocated for them
+            void RejectsImpossibleCounts(TestContext &context)
+            {
+                std::vector<uint8_t> bytes = BuildArchive(GetSampleFolders());
+                BsaArchive archive;
+                for (size_t offset : {size_t(16), size_t(20)})
+                {
+                    for (uint32_t count : {0xFFFFFFFFu, 0x10000000u, static_cast<uint32_t>(bytes.size())})
+                    {
+                        std::vector<uint8_t> other = bytes;
+                        Patch(other, offset, count);
+                        bool loaded = true;
+                        try
+                        {
+                            loaded = archive.Load(other.data(), other.size());
+                        }
+                        catch (const std::exception &)
+                        {
+                            context.Fail("Load threw on a count of " + std::to_string(count), __FILE__, __LINE__);
+                        }
+                        CHECK(!loaded);
+                    }
+                }
+
+                // A folder table that starts past the end
+                std::vector<uint8_t> other = bytes;
+                Patch(other, 8, 0xFFFFFFF0u);
+                CHECK(!archive.Load(other.data(), other.size()));
+            }
+
+            void OpensFromDisk(TestContext &context)
+            {
+                std::vector<uint8_t> bytes = BuildArchive(GetSampleFolders());
+                std::filesystem::path path = context.WorkDirectory() / "Sample.bsa";
+                std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char *>(bytes.data()), bytes.size());
+
+                BsaArchive archive;
+                REQUIRE(archive.Open(path));
+                CHECK_EQUAL(archive.GetPath(), path);
+                CHECK(archive.FindFile("textures\\sky.dds") != nullptr);
+                CHECK(!archive.Open(context.WorkDirectory() / "Missing.bsa"));
+            }
+        }
+
+        void RegisterArchiveTests(TestRegistry &registry)
+        {
+            registry.Add("archive/indexes_files_and_folders", IndexesFilesAndFolders);
+            registry.Add("archive/toggles_compression", TogglesCompression);
+            registry.Add("archive/rejects_unsupported_archives", RejectsUnsupportedArchives);
+            registry.Add("archive/rejects_truncated_archives", RejectsTruncatedArchives);
+            registry.Add("archive/rejects_impossible_counts", RejectsImpossibleCounts);
+            registry.Add("archive/opens_from_disk", OpensFromDisk);
+        }
+    }
+
+} // namespace ObseGPCompat
@@ -0,0 +1,105 @@
+#include "Tests.h"
+#include "CoreFixture.h"
+#include "ObseGPCompat.h"
+#include "VirtualFileSystem.h"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace ObseGPCompat
+{
+
+    namespace Test
+    {
+
+        namespace
+        {
+            constexpr int StagedFiles = 200;
+
+            FileOperation MakeOperation(FileOperationType type, const std::filesystem::path &path,
+                                        const std::filesystem::path &destination = {})
+            {
+                return {type, path, destination, false};
+            }
+
+            std::vector<bool> Run(std::vector<FileOperation> operations)
+            {
+                std::vector<bool> successes;
+                for (const FileOperationResult &result : g_VirtualFileSystem->SubmitBatch(std::move(operations)).get())
+                {
+                    successes.push_back(result.success);
+                }
+                return successes;
+            }
+
+            // The mod manager's pattern: many files staged into one directory at once
+            void StagesIntoOneDirectory(TestContext &context)
+            {
+                CoreFixture core(context.WorkDirectory());
+                REQUIRE(core.Start());
+
+                std::filesystem::path data = core.GetObsePath() / "Data";
+                std::vector<FileOperation> operations;
+                for (int i = 0; i < StagedFiles; ++i)
+                {
+                    std::string name = "source" + std::to_string(i) + ".dds";
+                    std::ofstream(core.GetDataPath() / name, std::ios::binary) << name;
+                    operations.push_back(MakeOperation(FileOperationType::Copy, data / name, data / "Staged" / ("asset" + std::to_string(i) + ".dds")));
+                }
+
+                size_t completed = 0;
+                std::vector<FileOperationResult> results =
+                    g_VirtualFileSystem->SubmitBatch(operations, [&completed](const std::vector<FileOperationResult> &all)
+                                                     { completed = all.size(); })
+                        .get();
+                CHECK_EQUAL(completed, static_cast<size_t>(StagedFiles));
+                REQUIRE(results.size() == static_cast<size_t>(StagedFiles));
+                for (int i = 0; i < StagedFiles; ++i)
+                {
+                    CHECK(results[i].success);
+                }
+                CHECK(std::filesystem::exists(core.GetDataPath() / "Staged" / "asset199.dds"));
+            }
+
+            // Operations on one path, and below a directory the batch creates, keep their order
+            // however the rest of the batch is spread
+            void OrdersConflictingOperations(TestContext &context)
+            {
+                CoreFixture core(context.WorkDirectory());
+                REQUIRE(core.Start());
+
+                std::filesystem::path data = core.GetObsePath() / "Data";
+                std::ofstream(core.GetDataPath() / "Example.esp", std::ios::binary) << "TES4";
+                for (int round = 0; round < 20; ++round)
+                {
+                    std::filesystem::path directory = data / ("Round" + std::to_string(round)) / "Sub";
+                    std::filesystem::path copy = directory / "Example.esp";
+                    std::vector<FileOperation> operations;
+                    for (int i = 0; i < 8; ++i)
+                    {
+                        operations.push_back(MakeOperation(FileOperationType::Exists, data / ("missing" + std::to_string(i) + ".esp")));
+                    }
+                    operations.push_back(MakeOperation(FileOperationType::MakeDirectory, directory));
+                    operations.push_back(MakeOperation(FileOperationType::Exists, directory));
+                    operations.push_back(MakeOperation(FileOperationType::Copy, data / "Example.esp", copy));
+                    operations.push_back(MakeOperation(FileOperationType::Exists, copy));
+                    operations.push_back(MakeOperation(FileOperationType::Remove, copy));
+                    operations.push_back(MakeOperation(FileOperationType::Exists, copy));
+
+                    std::vector<bool> successes = Run(std::move(operations));
+                    std::vector<bool> expected(8, false);
+                    expected.insert(expected.end(), {true, true, true, true, true, false});
+                    CHECK(successes == expected);
+                }
+            }
+        }
+
+        void RegisterBatchTests(TestRegistry &registry)
+        {
+            registry.Add("batch/stages_into_one_directory", StagesIntoOneDirectory);
+            registry.Add("batch/orders_conflicting_operations", OrdersConflictingOperations);
+        }
+    }
+
+} // namespace ObseGPCompat
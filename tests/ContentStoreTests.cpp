@@ -0,0 +1,129 @@
+#include "Tests.h"
+#include "ContentStore.h"
+#include "CoreFixture.h"
+#include "ObseGPCompat.h"
+#include "Platform.h"
+#include "VirtualFileSystem.h"
+
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <sys/stat.h>
+#include <system_error>
+
+namespace ObseGPCompat
+{
+
+    namespace Test
+    {
+
+        namespace
+        {
+            void WriteFile(const std::filesystem::path &path, const std::string &content)
+            {
+                std::ofstream(path, std::ios::binary) << content;
+            }
+
+            std::string ReadFile(const std::filesystem::path &path)
+            {
+                std::ifstream in(path, std::ios::binary);
+                return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            }
+
+            bool IsWritable(const std::filesystem::path &path)
+            {
+                using std::filesystem::perms;
+                std::error_code ec;
+                perms write = perms::owner_write | perms::group_write | perms::others_write;
+                return (std::filesystem::status(path, ec).permissions() & write) != perms::none;
+            }
+
+            // Runs as root on CI, where permissions do not stop writes, so the layer itself
+            // must never write through a link
+            void KeepsObjectsWhenLinksChange(TestContext &context)
+            {
+                CoreFixture core(context.WorkDirectory());
+                REQUIRE(core.Start());
+
+                std::filesystem::path source = context.WorkDirectory() / "Import.esp";
+                std::filesystem::path replacement = context.WorkDirectory() / "Replacement.esp";
+                WriteFile(source, "TES4 stored");
+                WriteFile(replacement, "TES4 replacement");
+
+                std::filesystem::path linked = core.GetObsePath() / "Data" / "Linked.esp";
+                std::filesystem::path deleted = core.GetObsePath() / "Data" / "Deleted.esp";
+                ContentId id = {};
+                REQUIRE(g_VirtualFileSystem->ImportFile(source, linked, &id));
+                REQUIRE(g_VirtualFileSystem->ImportFile(source, deleted));
+
+                ContentStore store;
+                REQUIRE(store.Initialize(core.GetInstallPath() / "OBSE64GP" / "Store"));
+                std::filesystem::path object = store.GetObjectPath(id);
+                std::error_code ec;
+                CHECK_EQUAL(std::filesystem::hard_link_count(object, ec), 3u);
+                CHECK(!IsWritable(object));
+
+                CHECK(g_VirtualFileSystem->CopyFile(replacement, linked, true));
+                CHECK_EQUAL(ReadFile(g_VirtualFileSystem->TranslateToReal(linked)), "TES4 replacement");
+                CHECK(g_VirtualFileSystem->DeleteFile(deleted));
+                CHECK(!std::filesystem::exists(g_VirtualFileSystem->TranslateToReal(deleted), ec));
+
+                // The object is untouched, so adding the original again finds no collision
+                CHECK_EQUAL(ReadFile(object), "TES4 stored");
+                CHECK_EQUAL(std::filesystem::hard_link_count(object, ec), 1u);
+                CHECK(!IsWritable(object));
+                ContentId again = {};
+                CHECK(store.Add(source, again));
+                CHECK_EQUAL(store.GetStats().deduplicated, 1u);
+            }
+
+            // /dev/shm is usually another volume, where no link can reach; the test still
+            // holds where it is not, since a link exposes the same content
+            void CopiesAcrossVolumes(TestContext &context)
+            {
+                std::error_code ec;
+                std::filesystem::path shared = "/dev/shm";
+                REQUIRE(std::filesystem::is_directory(shared, ec));
+                CoreOptions options;
+                options.contentStore = shared / ("obse64gp-store-" + std::to_string(Platform::GetCurrentThreadId()));
+                std::filesystem::remove_all(options.contentStore, ec);
+
+                {
+                    CoreFixture core(context.WorkDirectory());
+                    REQUIRE(core.Start(options));
+
+                    std::filesystem::path source = context.WorkDirectory() / "Import.esp";
+                    WriteFile(source, "TES4 stored");
+                    std::filesystem::path path = core.GetObsePath() / "Data" / "Imported.esp";
+                    std::filesystem::path real = core.GetDataPath() / "Imported.esp";
+                    ContentId id = {};
+                    REQUIRE(g_VirtualFileSystem->ImportFile(source, path, &id));
+
+                    // The path resolves as before, with no mapping of its own
+                    CHECK_EQUAL(g_VirtualFileSystem->TranslateToReal(path).lexically_normal(), real.lexically_normal());
+                    CHECK_EQUAL(ReadFile(real), "TES4 stored");
+
+                    ContentStore store;
+                    REQUIRE(store.Initialize(options.contentStore));
+                    std::filesystem::path object = store.GetObjectPath(id);
+                    struct stat objectInfo = {}, realInfo = {};
+                    REQUIRE(stat(object.c_str(), &objectInfo) == 0 && stat(real.c_str(), &realInfo) == 0);
+                    if (objectInfo.st_dev != realInfo.st_dev)
+                    {
+                        CHECK_EQUAL(std::filesystem::hard_link_count(object, ec), 1u);
+                        CHECK(IsWritable(real));
+                    }
+                }
+
+                std::filesystem::remove_all(options.contentStore, ec);
+            }
+        }
+
+        void RegisterContentStoreTests(TestRegistry &registry)
+        {
+            registry.Add("store/keeps_objects_when_links_change", KeepsObjectsWhenLinksChange);
+            registry.Add("store/copies_across_volumes", CopiesAcrossVolumes);
+        }
+    }
+
+} // namespace ObseGPCompat
@@ -0,0 +1,129 @@
+#include "Tests.h"
+#include "CopyEngine.h"
+
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <sys/stat.h>
+#include <system_error>
+
+namespace ObseGPCompat
+{
+
+    namespace Test
+    {
+
+        namespace
+        {
+            void WriteFile(const std::filesystem::path &path, const std::string &content)
+            {
+                std::ofstream(path, std::ios::binary) << content;
+            }
+
+            std::string ReadFile(const std::filesystem::path &path)
+            {
+                std::ifstream in(path, std::ios::binary);
+                return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            }
+
+            size_t CountEntries(const std::filesystem::path &directory)
+            {
+                std::error_code ec;
+                size_t count = 0;
+                for (std::filesystem::directory_iterator it(directory, ec), end; !ec && it != end; it.increment(ec))
+                {
+                    ++count;
+                }
+                return count;
+            }
+
+            void CopiesContents(TestContext &context)
+            {
+                std::filesystem::path source = context.WorkDirectory() / "source.esp";
+                std::filesystem::path destination = context.WorkDirectory() / "destination.esp";
+                WriteFile(source, "TES4 source");
+
+                CopyEngine engine;
+                CopyResult result = engine.Copy(source, destination, false);
+                CHECK(result.success);
+                CHECK_EQUAL(result.bytes, 11u);
+                CHECK_EQUAL(ReadFile(destination), "TES4 source");
+
+                WriteFile(source, "TES4 changed");
+                result = engine.Copy(source, destination, false);
+                CHECK(!result.success);
+                CHECK(result.error == Platform::FileError::AlreadyExists);
+                CHECK_EQUAL(ReadFile(destination), "TES4 source");
+
+                CHECK(engine.Copy(source, destination, true).success);
+                CHECK_EQUAL(ReadFile(destination), "TES4 changed");
+                CHECK_EQUAL(CountEntries(context.WorkDirectory()), 2u);
+            }
+
+            // Truncating the destination would empty the source too, under either name
+            void RefusesCopyOntoItself(TestContext &context)
+            {
+                std::filesystem::path path = context.WorkDirectory() / "self.txt";
+                std::filesystem::path link = context.WorkDirectory() / "link.txt";
+                WriteFile(path, "keep me");
+                std::error_code ec;
+                std::filesystem::create_hard_link(path, link, ec);
+                REQUIRE(!ec);
+
+                CopyEngine engine;
+                for (const std::filesystem::path &destination : {path, link})
+                {
+                    CopyResult result = engine.Copy(path, destination, true);
+                    CHECK(!result.success);
+                    CHECK(result.error == Platform::FileError::AlreadyExists);
+                    CHECK_EQUAL(ReadFile(path), "keep me");
+                }
+            }
+
+            // A directory opens but cannot be read, so the copy fails after it started
+            void KeepsDestinationWhenCopyFails(TestContext &context)
+            {
+                std::filesystem::path source = context.WorkDirectory() / "Unreadable";
+                std::filesystem::path destination = context.WorkDirectory() / "destination.esp";
+                std::error_code ec;
+                std::filesystem::create_directories(source, ec);
+                struct stat info = {};
+                REQUIRE(stat(source.c_str(), &info) == 0 && info.st_size > 0);
+                WriteFile(destination, "original");
+
+                CopyEngine engine;
+                CHECK(!engine.Copy(source, destination, true).success);
+                CHECK_EQUAL(ReadFile(destination), "original");
+                CHECK_EQUAL(CountEntries(context.WorkDirectory()), 2u);
+            }
+
+            // The new file takes the name; other links to the old one keep their content
+            void ReplacesLinksInsteadOfWritingThrough(TestContext &context)
+            {
+                std::filesystem::path shared = context.WorkDirectory() / "shared.dll";
+                std::filesystem::path link = context.WorkDirectory() / "link.dll";
+                std::filesystem::path source = context.WorkDirectory() / "source.dll";
+                WriteFile(shared, "shared");
+                WriteFile(source, "replacement");
+                std::error_code ec;
+                std::filesystem::create_hard_link(shared, link, ec);
+                REQUIRE(!ec);
+
+                CopyEngine engine;
+                CHECK(engine.Copy(source, link, true).success);
+                CHECK_EQUAL(ReadFile(link), "replacement");
+                CHECK_EQUAL(ReadFile(shared), "shared");
+                CHECK_EQUAL(std::filesystem::hard_link_count(shared, ec), 1u);
+            }
+        }
+
+        void RegisterCopyEngineTests(TestRegistry &registry)
+        {
+            registry.Add("copy/copies_contents", CopiesContents);
+            registry.Add("copy/refuses_copy_onto_itself", RefusesCopyOntoItself);
+            registry.Add("copy/keeps_destination_when_copy_fails", KeepsDestinationWhenCopyFails);
+            registry.Add("copy/replaces_links_instead_of_writing_through", ReplacesLinksInsteadOfWritingThrough);
+        }
+    }
+
+} // namespace ObseGPCompat
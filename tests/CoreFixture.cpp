@@ -0,0 +1,92 @@
+#include "CoreFixture.h"
+#include "ObseGPCompat.h"
+#include "ConfigurationManager.h"
+#include "MappingRegistry.h"
+#include "PathTranslator.h"
+#include "VirtualFileSystem.h"
+
+#include <system_error>
+
+namespace ObseGPCompat
+{
+
+    namespace Test
+    {
+
+        CoreFixture::CoreFixture(const std::filesystem::path &root)
+            : m_InstallPath(root / "XboxGames" / "The Elder Scrolls IV- Oblivion Remastered"),
+              m_ObsePath(root / "Steam" / "Oblivion Remastered" / "OblivionRemastered" / "Binaries" / "Win64")
+        {
+        }
+
+        CoreFixture::~CoreFixture()
+        {
+            // Same order as Shutdown
+            g_VirtualFileSystem.reset();
+            g_PathTranslator.reset();
+            g_MappingRegistry.reset();
+            g_ConfigurationManager.reset();
+
+            g_GamePassInstallPath.clear();
+            g_ObsePath.clear();
+
+            // Later tests start from the defaults, without this one's caches
+            std::error_code ec;
+            std::filesystem::remove_all(GetLocalAppDataPath() / "OBSE64GP", ec);
+        }
+
+        std::filesystem::path CoreFixture::GetDataPath() const
+        {
+            return m_InstallPath / "Content" / "OblivionRemastered" / "Content" / "Dev" / "ObvData" / "data";
+        }
+
+        bool CoreFixture::Start(const CoreOptions &options)
+        {
+            std::error_code ec;
+            std::filesystem::create_directories(GetDataPath(), ec);
+            if (ec)
+            {
+                return false;
+            }
+
+            g_GamePassInstallPath = m_InstallPath;
+            g_ObsePath = m_ObsePath;
+
+            g_ConfigurationManager = std::make_unique<ConfigurationManager>();
+            if (!g_ConfigurationManager->Initialize())
+            {
+                return false;
+            }
+            g_ConfigurationManager->SetBool("Settings", "EnableDirectoryIndex", options.directoryIndex);
+            g_ConfigurationManager->SetBool("Settings", "MountArchives", options.mountArchives);
+            g_ConfigurationManager->SetBool("Settings", "ScanPlugins", options.scanPlugins);
+            g_ConfigurationManager->SetBool("Settings", "CheckLoadOrder", options.checkLoadOrder);
+            g_ConfigurationManager->SetBool("Settings", "WatchDirectories", options.watchDirectories);
+            g_ConfigurationManager->SetInt("Settings", "BatchWorkerThreads", options.batchWorkerThreads);
+            g_ConfigurationManager->SetString("Paths", "ContentStore", options.contentStore.string());
+
+            g_MappingRegistry = std::make_unique<MappingRegistry>();
+            if (!g_MappingRegistry->Initialize())
+            {
+                return false;
+            }
+
+            g_PathTranslator = std::make_unique<PathTranslator>();
+            if (!g_PathTranslator->Initialize())
+            {
+                return false;
+            }
+
+            if (options.virtualFileSystem)
+            {
+                g_VirtualFileSystem = std::make_unique<VirtualFileSystem>();
+                if (!g_VirtualFileSystem->Initialize())
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+    }
+
+} // namespace ObseGPCompat
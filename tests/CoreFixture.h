@@ -0,0 +1,49 @@
+#pragma once
+
+#include <filesystem>
+
+namespace ObseGPCompat
+{
+
+    namespace Test
+    {
+        // Settings the tests change; everything that scans or watches is off unless asked for
+        struct CoreOptions
+        {
+            bool virtualFileSystem = true; // Otherwise only configuration, mappings and translator
+            bool directoryIndex = false;
+            bool mountArchives = false;
+            bool scanPlugins = false;
+            bool checkLoadOrder = false;
+            bool watchDirectories = false;
+            int batchWorkerThreads = 4; // Several even on one core, so batches really overlap
+            std::filesystem::path contentStore; // Empty for the default inside the install
+        };
+
+        // The globals Initialize in main.cpp creates, over an empty Game Pass install and
+        // OBSE directory below root. Only one may exist at a time; the destructor resets
+        // the globals.
+        class CoreFixture
+        {
+        public:
+            explicit CoreFixture(const std::filesystem::path &root);
+            ~CoreFixture();
+
+            CoreFixture(const CoreFixture &) = delete;
+            CoreFixture &operator=(const CoreFixture &) = delete;
+
+            bool Start(const CoreOptions &options = CoreOptions());
+
+            const std::filesystem::path &GetInstallPath() const { return m_InstallPath; }
+            const std::filesystem::path &GetObsePath() const { return m_ObsePath; }
+
+            // Where OBSE's Data resolves to inside the install; created by Start
+            std::filesystem::path GetDataPath() const;
+
+        private:
+            std::filesystem::path m_InstallPath;
+            std::filesystem::path m_ObsePath;
+        };
+    }
+
+} // namespace ObseGPCompat
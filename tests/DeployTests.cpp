@@ -0,0 +1,192 @@
+#include "Tests.h"
+#include "CoreFixture.h"
+#include "LinkDeployer.h"
+#include "MappingRegistry.h"
+#include "ObseGPCompat.h"
+
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace ObseGPCompat
+{
+
+    namespace Test
+    {
+
+        namespace
+        {
+            void WriteFile(const std::filesystem::path &path, const std::string &content)
+            {
+                std::error_code ec;
+                std::filesystem::create_directories(path.parent_path(), ec);
+                std::ofstream(path, std::ios::binary) << content;
+            }
+
+            // Written beside and renamed over, the way mod managers install files
+            void ReplaceFile(const std::filesystem::path &path, const std::string &content)
+            {
+                std::filesystem::path temporary = path;
+                temporary += ".new";
+                WriteFile(temporary, content);
+                std::error_code ec;
+                std::filesystem::rename(temporary, path, ec);
+            }
+
+            DeployStats Deploy(LinkDeployer &deployer)
+            {
+                MappingRegistry::Reader mappings(*g_MappingRegistry);
+                return deployer.Apply(deployer.Plan(*mappings));
+            }
+
+            struct DeployFixture
+            {
+                CoreFixture core;
+                std::vector<std::string> files = {"Example.esp", "Meshes/Clutter/Bucket.nif", "Meshes/Clutter/Bowl.nif",
+                                                  "Textures/Sky.dds"};
+
+                // Data lies inside Content, and both are mapped, so each file is linked twice
+                static constexpr size_t LinksPerFile = 2;
+
+                explicit DeployFixture(const std::filesystem::path &root)
+                    : core(root)
+                {
+                }
+
+                bool Start()
+                {
+                    CoreOptions options;
+                    options.virtualFileSystem = false;
+                    if (!core.Start(options))
+                    {
+                        return false;
+                    }
+                    for (const std::string &file : files)
+                    {
+                        WriteFile(core.GetDataPath() / file, file);
+                    }
+                    return true;
+                }
+
+                std::filesystem::path Deployed(const std::string &file) const
+                {
+                    return core.GetObsePath() / "Data" / file;
+                }
+            };
+
+            void LinksEveryFile(TestContext &context)
+            {
+                DeployFixture fixture(context.WorkDirectory());
+                REQUIRE(fixture.Start());
+
+                LinkDeployer deployer;
+                DeployStats stats = Deploy(deployer);
+                CHECK_EQUAL(stats.added, fixture.files.size() * DeployFixture::LinksPerFile);
+                CHECK_EQUAL(stats.failed, 0u);
+                for (const std::string &file : fixture.files)
+                {
+                    std::error_code ec;
+                    CHECK(std::filesystem::equivalent(fixture.Deployed(file), fixture.core.GetDataPath() / file, ec));
+                }
+            }
+
+            // The directories a process created are remembered; deleting them behind its back
+            // must not make every later link fail
+            void RecreatesRemovedDirectories(TestContext &context)
+            {
+                DeployFixture fixture(context.WorkDirectory());
+                REQUIRE(fixture.Start());
+
+                LinkDeployer first;
+                CHECK_EQUAL(Deploy(first).added, fixture.files.size() * DeployFixture::LinksPerFile);
+
+                std::error_code ec;
+                std::filesystem::remove_all(fixture.core.GetObsePath(), ec);
+                LinkDeployer second;
+                DeployStats stats = Deploy(second);
+                CHECK_EQUAL(stats.added, fixture.files.size() * DeployFixture::LinksPerFile);
+                CHECK_EQUAL(stats.failed, 0u);
+                CHECK(std::filesystem::exists(fixture.Deployed("Meshes/Clutter/Bowl.nif")));
+            }
+
+            void AppliesOnlyChanges(TestContext &context)
+            {
+                DeployFixture fixture(context.WorkDirectory());
+                REQUIRE(fixture.Start());
+
+                std::filesystem::path manifestPath = context.WorkDirectory() / "DeployManifest.bin";
+                {
+                    LinkDeployer deployer;
+                    Deploy(deployer);
+                    REQUIRE(deployer.SaveManifest(manifestPath));
+                }
+
+                // Nothing changed: every listing comes from the manifest
+                LinkDeployer deployer;
+                REQUIRE(deployer.LoadManifest(manifestPath));
+                DeployStats stats = Deploy(deployer);
+                CHECK_EQUAL(stats.unchanged, fixture.files.size() * DeployFixture::LinksPerFile);
+                CHECK_EQUAL(stats.added + stats.updated + stats.removed + stats.failed, 0u);
+
+                // One file replaced, one added, one removed, each in a different directory
+                ReplaceFile(fixture.core.GetDataPath() / "Textures" / "Sky.dds", "new sky");
+                WriteFile(fixture.core.GetDataPath() / "Meshes" / "Clutter" / "Cup.nif", "cup");
+                std::error_code ec;
+                std::filesystem::remove(fixture.core.GetDataPath() / "Example.esp", ec);
+
+                stats = Deploy(deployer);
+                CHECK_EQUAL(stats.updated, DeployFixture::LinksPerFile);
+                CHECK_EQUAL(stats.added, DeployFixture::LinksPerFile);
+                CHECK_EQUAL(stats.removed, DeployFixture::LinksPerFile);
+                CHECK_EQUAL(stats.unchanged, 2 * DeployFixture::LinksPerFile);
+                CHECK_EQUAL(stats.failed, 0u);
+                CHECK(!std::filesystem::exists(fixture.Deployed("Example.esp")));
+                CHECK(std::filesystem::equivalent(fixture.Deployed("Textures/Sky.dds"), fixture.core.GetDataPath() / "Textures" / "Sky.dds", ec));
+                CHECK(std::filesystem::exists(fixture.Deployed("Meshes/Clutter/Cup.nif")));
+            }
+
+            // Rewritten in place, the file keeps its link, which shows the new content
+            void FollowsFilesRewrittenInPlace(TestContext &context)
+            {
+                DeployFixture fixture(context.WorkDirectory());
+                REQUIRE(fixture.Start());
+
+                LinkDeployer deployer;
+                Deploy(deployer);
+                WriteFile(fixture.core.GetDataPath() / "Example.esp", "rewritten");
+                DeployStats stats = Deploy(deployer);
+                CHECK_EQUAL(stats.failed, 0u);
+
+                std::ifstream in(fixture.Deployed("Example.esp"), std::ios::binary);
+                std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+                CHECK_EQUAL(content, "rewritten");
+            }
+
+            void UndeploysEverything(TestContext &context)
+            {
+                DeployFixture fixture(context.WorkDirectory());
+                REQUIRE(fixture.Start());
+
+                LinkDeployer deployer;
+                Deploy(deployer);
+                DeployStats stats = deployer.Apply({});
+                CHECK_EQUAL(stats.removed, fixture.files.size() * DeployFixture::LinksPerFile);
+                CHECK(deployer.GetDeployed().empty());
+                CHECK(!std::filesystem::exists(fixture.Deployed("Textures/Sky.dds")));
+                CHECK(std::filesystem::exists(fixture.core.GetDataPath() / "Textures" / "Sky.dds"));
+            }
+        }
+
+        void RegisterDeployTests(TestRegistry &registry)
+        {
+            registry.Add("deploy/links_every_file", LinksEveryFile);
+            registry.Add("deploy/recreates_removed_directories", RecreatesRemovedDirectories);
+            registry.Add("deploy/applies_only_changes", AppliesOnlyChanges);
+            registry.Add("deploy/follows_files_rewritten_in_place", FollowsFilesRewrittenInPlace);
+            registry.Add("deploy/undeploys_everything", UndeploysEverything);
+        }
+    }
+
+} // namespace ObseGPCompat
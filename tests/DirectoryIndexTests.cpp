@@ -0,0 +1,121 @@
+#include "Tests.h"
+#include "DirectoryIndex.h"
+
+#include <fstream>
+#include <system_error>
+
+namespace ObseGPCompat
+{
+
+    namespace Test
+    {
+
+        namespace
+        {
+            using Presence = DirectoryIndex::Presence;
+
+            void WriteFile(const std::filesystem::path &path)
+            {
+                std::error_code ec;
+                std::filesystem::create_directories(path.parent_path(), ec);
+                std::ofstream(path, std::ios::binary) << "x";
+            }
+
+            struct IndexFixture
+            {
+                std::filesystem::path root;
+                DirectoryIndex index;
+
+                explicit IndexFixture(const std::filesystem::path &workDirectory)
+                    : root(workDirectory / "Data")
+                {
+                    WriteFile(root / "Example.esp");
+                    WriteFile(root / "Meshes" / "Clutter" / "Bucket.nif");
+                    WriteFile(root / "Textures" / "Sky.dds");
+                    index.Build({root}, {});
+                }
+            };
+
+            void AnswersFromListing(TestContext &context)
+            {
+                IndexFixture fixture(context.WorkDirectory());
+                CHECK(fixture.index.Find(fixture.root / "example.ESP") == Presence::File);
+                CHECK(fixture.index.Find(fixture.root / "Meshes" / "Clutter") == Presence::Directory);
+                CHECK(fixture.index.Find(fixture.root / "Meshes" / "Bowl.nif") == Presence::Missing);
+                CHECK(fixture.index.Find(fixture.root / "Example.esp" / "x") == Presence::Missing);
+                CHECK(fixture.index.Find(context.WorkDirectory() / "Other") == Presence::NotIndexed);
+                CHECK_EQUAL(fixture.index.GetStats().files, 3u);
+            }
+
+            // A change sends lookups in its directory to the disk only until Refresh lists
+            // that one directory again
+            void RelistsChangedDirectory(TestContext &context)
+            {
+                IndexFixture fixture(context.WorkDirectory());
+                std::filesystem::path added = fixture.root / "Meshes" / "Clutter" / "Bowl.nif";
+                WriteFile(added);
+                fixture.index.MarkStale(added);
+                CHECK(fixture.index.Find(added) == Presence::NotIndexed);
+                CHECK(fixture.index.Find(fixture.root / "Textures" / "Sky.dds") == Presence::File);
+
+                CHECK_EQUAL(fixture.index.Refresh(), 1u);
+                CHECK(fixture.index.Find(added) == Presence::File);
+                CHECK(fixture.index.Find(fixture.root / "Meshes" / "Clutter" / "Bucket.nif") == Presence::File);
+                CHECK(fixture.index.Find(fixture.root / "Meshes" / "Clutter" / "Cup.nif") == Presence::Missing);
+                CHECK_EQUAL(fixture.index.Refresh(), 0u);
+
+                // A new directory is known by name; what is inside it is not
+                std::filesystem::path created = fixture.root / "Sound" / "Voice.wav";
+                WriteFile(created);
+                fixture.index.MarkStale(created.parent_path());
+                fixture.index.Refresh();
+                CHECK(fixture.index.Find(created.parent_path()) == Presence::Directory);
+                CHECK(fixture.index.Find(created) == Presence::NotIndexed);
+                CHECK(fixture.index.Find(fixture.root / "Meshes" / "Clutter" / "Bowl.nif") == Presence::File);
+            }
+
+            // Removed and made again: the directory's own listing is stale too, and its time shows it
+            void RelistsReplacedDirectories(TestContext &context)
+            {
+                IndexFixture fixture(context.WorkDirectory());
+                std::error_code ec;
+                std::filesystem::remove_all(fixture.root / "Meshes", ec);
+                WriteFile(fixture.root / "Meshes" / "Bowl.nif");
+                fixture.index.MarkStale(fixture.root / "Meshes");
+
+                CHECK_EQUAL(fixture.index.Refresh(), 2u);
+                CHECK(fixture.index.Find(fixture.root / "Meshes" / "Bowl.nif") == Presence::File);
+                CHECK(fixture.index.Find(fixture.root / "Meshes" / "Clutter") == Presence::Missing);
+                CHECK(fixture.index.Find(fixture.root / "Textures" / "Sky.dds") == Presence::File);
+
+                std::filesystem::remove_all(fixture.root / "Textures", ec);
+                fixture.index.MarkStale(fixture.root / "Textures" / "Sky.dds");
+                fixture.index.MarkStale(fixture.root / "Textures");
+                fixture.index.Refresh();
+                CHECK(fixture.index.Find(fixture.root / "Textures" / "Sky.dds") == Presence::Missing);
+            }
+
+            // Lost notifications: the whole tree below is listed again
+            void RelistsSubtree(TestContext &context)
+            {
+                IndexFixture fixture(context.WorkDirectory());
+                std::filesystem::path added = fixture.root / "Meshes" / "Clutter" / "Bowl.nif";
+                WriteFile(added);
+                fixture.index.MarkStale(fixture.root, true);
+
+                CHECK_EQUAL(fixture.index.Refresh(), 4u);
+                CHECK(fixture.index.Find(added) == Presence::File);
+                CHECK(fixture.index.Find(fixture.root / "Textures" / "Sky.dds") == Presence::File);
+            }
+        }
+
+        void RegisterDirectoryIndexTests(TestRegistry &registry)
+        {
+            registry.Add("index/answers_from_listing", AnswersFromListing);
+            registry.Add("index/relists_changed_directory", RelistsChangedDirectory);
+            registry.Add("index/relists_replaced_directories", RelistsReplacedDirectories);
+            registry.Add("index/relists_subtree", RelistsSubtree);
+        }
+    }
+
+} // namespace ObseGPCompat
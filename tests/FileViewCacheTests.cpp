@@ -0,0 +1,80 @@
+#include "Tests.h"
+#include "FileViewCache.h"
+
+#include <fstream>
+#include <string>
+#include <system_error>
+
+namespace ObseGPCompat
+{
+
+    namespace Test
+    {
+
+        namespace
+        {
+            void WriteFile(const std::filesystem::path &path, const char *content)
+            {
+                std::ofstream(path, std::ios::binary) << content;
+            }
+
+            FileView Get(FileViewCache &cache, const std::filesystem::path &path)
+            {
+                std::error_code ec;
+                return cache.Get(path, std::filesystem::file_size(path, ec), std::filesystem::last_write_time(path, ec));
+            }
+
+            void SharesMappingBetweenViews(TestContext &context)
+            {
+                std::filesystem::path path = context.WorkDirectory() / "Plugins.txt";
+                WriteFile(path, "Oblivion.esm\n");
+
+                FileViewCache cache;
+                FileView first = Get(cache, path);
+                FileView second = Get(cache, path);
+                REQUIRE(first && second);
+                CHECK(first.Data() == second.Data());
+                CHECK_EQUAL(std::string(second.AsText()), "Oblivion.esm\n");
+
+                FileViewCacheStats stats = cache.GetStats();
+                CHECK_EQUAL(stats.misses, 1u);
+                CHECK_EQUAL(stats.hits, 1u);
+            }
+
+            // Nothing stays mapped once the views are gone, so a rewrite that keeps the size
+            // and write time is still read afresh
+            void ClosesMappingWithLastView(TestContext &context)
+            {
+                std::filesystem::path path = context.WorkDirectory() / "Plugins.txt";
+                WriteFile(path, "Oblivion.esm\n");
+                std::error_code ec;
+                std::filesystem::file_time_type written = std::filesystem::last_write_time(path, ec);
+
+                FileViewCache cache;
+                {
+                    FileView view = Get(cache, path);
+                    REQUIRE(view);
+                    CHECK_EQUAL(std::string(view.AsText()), "Oblivion.esm\n");
+                }
+
+                WriteFile(path, "Knights.esp\n\n");
+                std::filesystem::last_write_time(path, written, ec);
+                FileView view = Get(cache, path);
+                REQUIRE(view);
+                CHECK_EQUAL(std::string(view.AsText()), "Knights.esp\n\n");
+
+                FileViewCacheStats stats = cache.GetStats();
+                CHECK_EQUAL(stats.misses, 2u);
+                CHECK_EQUAL(stats.hits, 0u);
+                CHECK_EQUAL(stats.evictions, 0u);
+            }
+        }
+
+        void RegisterFileViewCacheTests(TestRegistry &registry)
+        {
+            registry.Add("views/shares_mapping_between_views", SharesMappingBetweenViews);
+            registry.Add("views/closes_mapping_with_last_view", ClosesMappingWithLastView);
+        }
+    }
+
+} // namespace ObseGPCompat
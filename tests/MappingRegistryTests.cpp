@@ -0,0 +1,143 @@
+#include "Tests.h"
+#include "CoreFixture.h"
+#include "MappingRegistry.h"
+#include "ObseGPCompat.h"
+#include "PathTranslator.h"
+#include "PathUtils.h"
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ObseGPCompat
+{
+
+    namespace Test
+    {
+
+        namespace
+        {
+            constexpr int PublishCount = 200;
+            constexpr int ReaderCount = 4;
+
+            // Every snapshot is a fresh allocation of the same size, so freed ones are soon
+            // reused at the same address
+            void IdsAreUnique(TestContext &context)
+            {
+                CoreFixture core(context.WorkDirectory());
+                CoreOptions options;
+                options.virtualFileSystem = false;
+                REQUIRE(core.Start(options));
+
+                uint64_t previous = 0;
+                for (int i = 0; i < 16; ++i)
+                {
+                    g_MappingRegistry->AddMapping(core.GetObsePath() / "Data" / std::to_string(i), context.WorkDirectory() / "Target");
+                    MappingRegistry::Reader reader(*g_MappingRegistry);
+                    CHECK(reader->GetId() > previous);
+                    previous = reader->GetId();
+                }
+            }
+
+            // A writer keeps adding more specific roots while readers translate paths below
+            // them. Once a root has been published, every later translation of a path below
+            // it must use it; a result cached against an earlier snapshot would not.
+            void PublishesWhileTranslating(TestContext &context)
+            {
+                CoreFixture core(context.WorkDirectory());
+                CoreOptions options;
+                options.virtualFileSystem = false;
+                REQUIRE(core.Start(options));
+
+                std::filesystem::path source = core.GetObsePath() / "Data" / "Stress";
+                std::filesystem::path target = context.WorkDirectory() / "Stress";
+                std::atomic<int> published{0};
+                std::atomic<bool> finished{false};
+                std::atomic<int> failures{0};
+                std::atomic<long> translations{0};
+
+                std::vector<std::thread> readers;
+                for (int r = 0; r < ReaderCount; ++r)
+                {
+                    readers.emplace_back([&, r]()
+                                         {
+                                             std::vector<char> buffer(PathTranslator::MaxPathLength);
+                                             for (int i = r; !finished.load(std::memory_order_acquire); ++i)
+                                             {
+                                                 // The latest few roots, so lookups repeat and hit the cache
+                                                 int latest = published.load(std::memory_order_acquire);
+                                                 if (latest == 0)
+                                                 {
+                                                     continue;
+                                                 }
+                                                 int k = latest - i % std::min(latest, 4);
+                                                 std::string path = (source / std::to_string(k) / "x.nif").string();
+                                                 std::string expected = FoldPath(std::string_view((target / std::to_string(k) / "x.nif").string()));
+                                                 if (!g_PathTranslator->TryTranslate(std::string_view(path), buffer.data(), buffer.size()) ||
+                                                     FoldPath(std::string_view(buffer.data())) != expected)
+                                                 {
+                                                     failures.fetch_add(1, std::memory_order_relaxed);
+                                                 }
+                                                 translations.fetch_add(1, std::memory_order_relaxed);
+                                             }
+                                         });
+                }
+
+                for (int k = 1; k <= PublishCount; ++k)
+                {
+                    g_MappingRegistry->AddMapping(source / std::to_string(k), target / std::to_string(k));
+                    published.store(k, std::memory_order_release);
+                    std::this_thread::yield();
+                }
+                finished.store(true, std::memory_order_release);
+                for (std::thread &reader : readers)
+                {
+                    reader.join();
+                }
+
+                CHECK_EQUAL(failures.load(), 0);
+                CHECK(translations.load() > 0);
+            }
+
+            // The prefix table folds roots, so another spelling is the same root and must
+            // replace it rather than sit beside it
+            void ReplacesRootsUnderAnySpelling(TestContext &context)
+            {
+                CoreFixture core(context.WorkDirectory());
+                CoreOptions options;
+                options.virtualFileSystem = false;
+                REQUIRE(core.Start(options));
+
+                size_t mappingCount = MappingRegistry::Reader(*g_MappingRegistry)->GetMappings().size();
+                std::filesystem::path root = core.GetObsePath() / "Data" / "Mods" / "Example";
+                std::string respelled = (core.GetObsePath() / "DATA" / "mods" / "EXAMPLE").string() + "//";
+                respelled.insert(core.GetObsePath().string().size(), "/");
+                std::filesystem::path first = context.WorkDirectory() / "First";
+                std::filesystem::path second = context.WorkDirectory() / "Second";
+
+                g_MappingRegistry->AddMapping(root, first);
+                g_MappingRegistry->AddMappings({{respelled, second}});
+                CHECK_EQUAL(MappingRegistry::Reader(*g_MappingRegistry)->GetMappings().size(), mappingCount + 1);
+                std::string translated;
+                CHECK(g_PathTranslator->TryTranslate(std::string_view((root / "x.nif").string()), translated));
+                CHECK_EQUAL(FoldPath(std::string_view(translated)), FoldPath(std::string_view((second / "x.nif").string())));
+
+                REQUIRE(g_MappingRegistry->MountOverlay(root, {{first, 0}}));
+                REQUIRE(g_MappingRegistry->MountOverlay(respelled, {{second, 0}}));
+                MappingRegistry::Reader reader(*g_MappingRegistry);
+                REQUIRE(reader->GetOverlays().size() == 1u);
+                CHECK_EQUAL(reader->GetOverlays().front().virtualPath, respelled);
+            }
+        }
+
+        void RegisterMappingRegistryTests(TestRegistry &registry)
+        {
+            registry.Add("mapping/ids_are_unique", IdsAreUnique);
+            registry.Add("mapping/publishes_while_translating", PublishesWhileTranslating);
+            registry.Add("mapping/replaces_roots_under_any_spelling", ReplacesRootsUnderAnySpelling);
+        }
+    }
+
+} // namespace ObseGPCompat
@@ -0,0 +1,198 @@
+#include "Tests.h"
+#include "CoreFixture.h"
+#include "MetadataCache.h"
+#include "ObseGPCompat.h"
+#include "VirtualFileSystem.h"
+
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <system_error>
+#include <thread>
+
+namespace ObseGPCompat
+{
+
+    namespace Test
+    {
+
+        namespace
+        {
+            void WriteFile(const std::filesystem::path &path, const char *content)
+            {
+                std::ofstream(path, std::ios::binary) << content;
+            }
+
+            // The loader's pattern: probe optional files that are mostly absent, again and
+            // again, then create one and see it
+            void AnswersRepeatedProbes(TestContext &context)
+            {
+                MetadataCache cache;
+                std::filesystem::path path = context.WorkDirectory() / "optional.ini";
+
+                for (int i = 0; i < 5; ++i)
+                {
+                    CHECK(!cache.Get(path).exists);
+                }
+                MetadataCacheStats stats = cache.GetStats();
+                CHECK_EQUAL(stats.misses, 1u);
+                CHECK_EQUAL(stats.hits, 4u);
+                CHECK_EQUAL(stats.negativeHits, 4u);
+
+                // Still cached as missing until someone says otherwise
+                WriteFile(path, "[General]\n");
+                CHECK(!cache.Get(path).exists);
+                cache.Invalidate(path);
+
+                FileMetadata metadata = cache.Get(path);
+                CHECK(metadata.exists);
+                CHECK_EQUAL(metadata.size, 10u);
+                CHECK(metadata.type == std::filesystem::file_type::regular);
+                stats = cache.GetStats();
+                CHECK_EQUAL(stats.misses, 2u);
+                CHECK_EQUAL(stats.invalidations, 1u);
+            }
+
+            void InvalidatesAncestors(TestContext &context)
+            {
+                MetadataCache cache;
+                std::filesystem::path directory = context.WorkDirectory() / "a" / "b";
+                std::filesystem::path file = directory / "x.esp";
+                CHECK(!cache.Get(context.WorkDirectory() / "a").exists);
+                CHECK(!cache.Get(directory).exists);
+                CHECK(!cache.Get(file).exists);
+
+                std::error_code ec;
+                std::filesystem::create_directories(directory, ec);
+                WriteFile(file, "x");
+                cache.InvalidateWithAncestors(file);
+                CHECK(cache.Get(context.WorkDirectory() / "a").exists);
+                CHECK(cache.Get(directory).type == std::filesystem::file_type::directory);
+                CHECK(cache.Get(file).exists);
+            }
+
+            // Callers spell one path differently; every spelling reaches the same entry
+            void InvalidatesAnySpelling(TestContext &context)
+            {
+                MetadataCache cache;
+                std::filesystem::path directory = context.WorkDirectory() / "Meshes";
+                std::filesystem::path file = directory / "Bucket.nif";
+                CHECK(!cache.Get(directory).exists);
+                CHECK(!cache.Get(file).exists);
+                CHECK(!cache.Get(context.WorkDirectory() / "MESHES" / "bucket.NIF").exists);
+                CHECK_EQUAL(cache.GetStats().hits, 1u);
+
+                std::error_code ec;
+                std::filesystem::create_directories(directory, ec);
+                WriteFile(file, "x");
+                cache.InvalidateWithAncestors(context.WorkDirectory() / "meshes" / "BUCKET.nif");
+                CHECK(cache.Get(directory).exists);
+                CHECK(cache.Get(file).exists);
+
+                std::filesystem::remove(file, ec);
+                std::filesystem::path::string_type trailing = file.native();
+                trailing += std::filesystem::path::preferred_separator;
+                cache.Invalidate(std::filesystem::path(trailing));
+                CHECK(!cache.Get(file).exists);
+                CHECK_EQUAL(cache.GetStats().invalidations, 3u);
+            }
+
+            // Probes for ever new paths must not grow the cache without bound
+            void StaysWithinCapacity(TestContext &context)
+            {
+                constexpr size_t Capacity = MetadataCache::ShardCount * 4;
+                MetadataCache cache(Capacity);
+                std::filesystem::path last;
+                for (int i = 0; i < 1000; ++i)
+                {
+                    last = context.WorkDirectory() / ("probe" + std::to_string(i) + ".ini");
+                    cache.Get(last);
+                }
+
+                // Nothing was invalidated, so whatever missed and was not evicted is still held
+                MetadataCacheStats stats = cache.GetStats();
+                CHECK(stats.evictions > 0u);
+                CHECK(stats.misses - stats.evictions <= Capacity);
+                cache.Get(last);
+                CHECK_EQUAL(cache.GetStats().hits, 1u);
+            }
+
+            void ExpiresAfterTimeToLive(TestContext &context)
+            {
+                MetadataCache cache;
+                cache.SetTimeToLive(std::chrono::milliseconds(20));
+                std::filesystem::path path = context.WorkDirectory() / "x.esp";
+
+                CHECK(!cache.Get(path).exists);
+                WriteFile(path, "x");
+                std::this_thread::sleep_for(std::chrono::milliseconds(40));
+                CHECK(cache.Get(path).exists);
+                CHECK_EQUAL(cache.GetStats().expirations, 1u);
+            }
+
+            void InvalidatesWhere(TestContext &context)
+            {
+                MetadataCache cache;
+                std::filesystem::path keep = context.WorkDirectory() / "keep.esp";
+                std::filesystem::path drop = context.WorkDirectory() / "drop.esp";
+                cache.Get(keep);
+                cache.Get(drop);
+
+                cache.InvalidateWhere([&](const std::filesystem::path::string_type &key)
+                                      { return key.find(drop.filename().native()) != std::filesystem::path::string_type::npos; });
+                CHECK_EQUAL(cache.GetStats().invalidations, 1u);
+                cache.Get(keep);
+                cache.Get(drop);
+                CHECK_EQUAL(cache.GetStats().hits, 1u);
+
+                cache.Clear();
+                CHECK_EQUAL(cache.GetStats().invalidations, 3u);
+            }
+
+            // The same script through the file system, whose own operations keep the cache
+            // current without the caller invalidating anything
+            void StaysCurrentThroughFileSystem(TestContext &context)
+            {
+                CoreFixture core(context.WorkDirectory());
+                REQUIRE(core.Start());
+
+                std::filesystem::path data = core.GetObsePath() / "Data";
+                std::filesystem::path directory = data / "Meshes" / "Clutter";
+                std::filesystem::path file = data / "Example.esp";
+                std::filesystem::path copy = directory / "Example.esp";
+
+                CHECK(!g_VirtualFileSystem->FileExists(directory));
+                CHECK(!g_VirtualFileSystem->FileExists(file));
+                CHECK(g_VirtualFileSystem->CreateDirectory(directory));
+                CHECK(g_VirtualFileSystem->FileExists(directory));
+                CHECK(g_VirtualFileSystem->FileExists(data / "Meshes"));
+
+                // Written behind the layer's back, then copied through it
+                WriteFile(core.GetDataPath() / "Example.esp", "TES4");
+                CHECK(!g_VirtualFileSystem->FileExists(copy));
+                CHECK(g_VirtualFileSystem->CopyFile(file, copy));
+                CHECK(g_VirtualFileSystem->FileExists(copy));
+
+                FileMetadata metadata = {};
+                CHECK(g_VirtualFileSystem->GetFileMetadata(copy, metadata));
+                CHECK_EQUAL(metadata.size, 4u);
+
+                CHECK(g_VirtualFileSystem->DeleteFile(copy));
+                CHECK(!g_VirtualFileSystem->FileExists(copy));
+                CHECK(!std::filesystem::exists(core.GetDataPath() / "Meshes" / "Clutter" / "Example.esp"));
+            }
+        }
+
+        void RegisterMetadataCacheTests(TestRegistry &registry)
+        {
+            registry.Add("metadata/answers_repeated_probes", AnswersRepeatedProbes);
+            registry.Add("metadata/invalidates_ancestors", InvalidatesAncestors);
+            registry.Add("metadata/invalidates_any_spelling", InvalidatesAnySpelling);
+            registry.Add("metadata/stays_within_capacity", StaysWithinCapacity);
+            registry.Add("metadata/expires_after_time_to_live", ExpiresAfterTimeToLive);
+            registry.Add("metadata/invalidates_where", InvalidatesWhere);
+            registry.Add("metadata/stays_current_through_file_system", StaysCurrentThroughFileSystem);
+        }
+    }
+
+} // namespace ObseGPCompat
@@ -0,0 +1,264 @@
+#include "Tests.h"
+#include "ModFileScanner.h"
+#include "WorkerPool.h"
+
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace ObseGPCompat
+{
+
+    namespace Test
+    {
+
+        namespace
+        {
+            struct SyntheticHeader
+            {
+                bool master = false;
+                float version = 1.0f;
+                int32_t recordCount = 0;
+                std::string author;
+                std::vector<std::string> masters;
+                size_t descriptionLength = 0; // Above 0xFFFF it needs an XXXX subrecord
+            };
+
+            template <typename T>
+            void Append(std::vector<uint8_t> &bytes, T value)
+            {
+                size_t offset = bytes.size();
+                bytes.resize(offset + sizeof(T));
+                std::memcpy(bytes.data() + offset, &value, sizeof(T));
+            }
+
+            // Record and subrecord types are four characters without a terminator
+            void AppendType(std::vector<uint8_t> &bytes, const char *type)
+            {
+                size_t offset = bytes.size();
+                bytes.resize(offset + 4);
+                std::memcpy(bytes.data() + offset, type, 4);
+            }
+
+            void AppendSubrecord(std::vector<uint8_t> &bytes, const char *type, const std::vector<uint8_t> &data)
+            {
+                if (data.size() > 0xFFFF)
+                {
+                    AppendType(bytes, "XXXX");
+                    Append<uint16_t>(bytes, 4);
+                    Append<uint32_t>(bytes, static_cast<uint32_t>(data.size()));
+                }
+                AppendType(bytes, type);
+                Append<uint16_t>(bytes, data.size() > 0xFFFF ? 0 : static_cast<uint16_t>(data.size()));
+                bytes.insert(bytes.end(), data.begin(), data.end());
+            }
+
+            std::vector<uint8_t> ZeroTerminated(const std::string &value)
+            {
+                std::vector<uint8_t> data(value.begin(), value.end());
+                data.push_back(0);
+                return data;
+            }
+
+            // The TES4 record that opens every .esp/.esm, followed by one unrelated record
+            std::vector<uint8_t> BuildModFile(const SyntheticHeader &header)
+            {
+                std::vector<uint8_t> subrecords;
+                std::vector<uint8_t> hedr;
+                Append<float>(hedr, header.version);
+                Append<int32_t>(hedr, header.recordCount);
+                Append<uint32_t>(hedr, 0x800);
+                AppendSubrecord(subrecords, "HEDR", hedr);
+                if (!header.author.empty())
+                {
+                    AppendSubrecord(subrecords, "CNAM", ZeroTerminated(header.author));
+                }
+                if (header.descriptionLength)
+                {
+                    AppendSubrecord(subrecords, "SNAM", ZeroTerminated(std::string(header.descriptionLength, 'x')));
+                }
+                for (const std::string &master : header.masters)
+                {
+                    AppendSubrecord(subrecords, "MAST", ZeroTerminated(master));
+                    AppendSubrecord(subrecords, "DATA", std::vector<uint8_t>(8, 0));
+                }
+
+                std::vector<uint8_t> bytes;
+                AppendType(bytes, "TES4");
+                Append<uint32_t>(bytes, static_cast<uint32_t>(subrecords.size()));
+                Append<uint32_t>(bytes, header.master ? 0x1 : 0x0);
+                Append<uint32_t>(bytes, 0);
+                Append<uint32_t>(bytes, 0);
+                bytes.insert(bytes.end(), subrecords.begin(), subrecords.end());
+                AppendType(bytes, "GRUP");
+                bytes.resize(bytes.size() + 16, 0);
+                return bytes;
+            }
+
+            void WriteModFile(const std::filesystem::path &path, const SyntheticHeader &header)
+            {
+                std::vector<uint8_t> bytes = BuildModFile(header);
+                std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char *>(bytes.data()), bytes.size());
+            }
+
+            ModFileInfo MakeInfo(const std::string &name, bool master, std::vector<std::string> masters, int64_t lastWriteTime)
+            {
+                ModFileInfo info = {};
+                info.path = name;
+                info.valid = true;
+                info.isMaster = master;
+                info.masters = std::move(masters);
+                info.lastWriteTime = lastWriteTime;
+                return info;
+            }
+
+            bool HasProblem(const std::vector<LoadOrderProblem> &problems, LoadOrderIssue issue, const std::string &plugin,
+                            const std::string &master)
+            {
+                for (const LoadOrderProblem &problem : problems)
+                {
+                    if (problem.issue == issue && problem.plugin == plugin && problem.master == master)
+                    {
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            void ReadsHeader(TestContext &context)
+            {
+                SyntheticHeader header;
+                header.version = 0.8f;
+                header.recordCount = 1234;
+                header.author = "Bethesda";
+                header.masters = {"Oblivion.esm", "Knights.esp"};
+                std::vector<uint8_t> bytes = BuildModFile(header);
+
+                ModFileInfo info = {};
+                REQUIRE(ModFileScanner::Parse(bytes.data(), bytes.size(), info));
+                CHECK(info.valid);
+                CHECK(!info.isMaster);
+                CHECK_EQUAL(info.version, 0.8f);
+                CHECK_EQUAL(info.recordCount, 1234u);
+                CHECK_EQUAL(info.author, "Bethesda");
+                REQUIRE(info.masters.size() == 2u);
+                CHECK_EQUAL(info.masters[1], "Knights.esp");
+
+                header.master = true;
+                header.masters.clear();
+                bytes = BuildModFile(header);
+                REQUIRE(ModFileScanner::Parse(bytes.data(), bytes.size(), info));
+                CHECK(info.isMaster);
+                CHECK(info.masters.empty());
+            }
+
+            // A description longer than 16 bits can say needs XXXX; the masters after it still count
+            void FollowsLargeSubrecords(TestContext &context)
+            {
+                SyntheticHeader header;
+                header.descriptionLength = 70000;
+                header.masters = {"Oblivion.esm"};
+                std::vector<uint8_t> bytes = BuildModFile(header);
+
+                ModFileInfo info = {};
+                REQUIRE(ModFileScanner::Parse(bytes.data(), bytes.size(), info));
+                REQUIRE(info.masters.size() == 1u);
+                CHECK_EQUAL(info.masters[0], "Oblivion.esm");
+            }
+
+            void RejectsDamagedHeaders(TestContext &context)
+            {
+                SyntheticHeader header;
+                header.masters = {"Oblivion.esm"};
+                std::vector<uint8_t> bytes = BuildModFile(header);
+                ModFileInfo info = {};
+
+                std::vector<uint8_t> other = bytes;
+                other[0] = 'T';
+                other[3] = '3';
+                CHECK(!ModFileScanner::Parse(other.data(), other.size(), info));
+                CHECK(!info.valid);
+
+                // Record size past the end of the file, or a subrecord past the end of the record
+                other = bytes;
+                uint32_t dataSize = static_cast<uint32_t>(bytes.size());
+                std::memcpy(other.data() + 4, &dataSize, sizeof(dataSize));
+                CHECK(!ModFileScanner::Parse(other.data(), other.size(), info));
+                other = bytes;
+                other[24] = 0xFF;
+                CHECK(!ModFileScanner::Parse(other.data(), other.size(), info));
+
+                for (size_t size : {size_t(0), size_t(4), size_t(19), size_t(40)})
+                {
+                    CHECK(!ModFileScanner::Parse(bytes.data(), size, info));
+                }
+            }
+
+            void FindsLoadOrderProblems(TestContext &context)
+            {
+                std::vector<ModFileInfo> files = {MakeInfo("Oblivion.esm", true, {}, 1),
+                                                  MakeInfo("Knights.esp", false, {"Oblivion.esm"}, 2),
+                                                  MakeInfo("Patch.esp", false, {"oblivion.esm", "Knights.esp", "Missing.esm"}, 3),
+                                                  MakeInfo("Unused.esp", false, {"Oblivion.esm"}, 4),
+                                                  MakeInfo("Needs.esp", false, {"Unused.esp"}, 5)};
+
+                std::vector<LoadOrderProblem> problems =
+                    ModFileScanner::CheckLoadOrder(files, {"Oblivion.esm", "Patch.esp", "Knights.esp", "Needs.esp"});
+                CHECK_EQUAL(problems.size(), 3u);
+                CHECK(HasProblem(problems, LoadOrderIssue::MasterLoadsLater, "Patch.esp", "Knights.esp"));
+                CHECK(HasProblem(problems, LoadOrderIssue::MissingMaster, "Patch.esp", "Missing.esm"));
+                CHECK(HasProblem(problems, LoadOrderIssue::InactiveMaster, "Needs.esp", "Unused.esp"));
+
+                // Without a list: masters first, then by write time, which suits these files
+                problems = ModFileScanner::CheckLoadOrder(files, {});
+                CHECK_EQUAL(problems.size(), 1u);
+                CHECK(HasProblem(problems, LoadOrderIssue::MissingMaster, "Patch.esp", "Missing.esm"));
+                CHECK_EQUAL(std::string(GetLoadOrderIssueName(LoadOrderIssue::MissingMaster)).empty(), false);
+            }
+
+            void ScansDirectory(TestContext &context)
+            {
+                std::filesystem::path directory = context.WorkDirectory() / "Data";
+                std::filesystem::create_directories(directory);
+                SyntheticHeader master;
+                master.master = true;
+                master.recordCount = 100;
+                WriteModFile(directory / "Oblivion.esm", master);
+                SyntheticHeader plugin;
+                plugin.masters = {"Oblivion.esm"};
+                WriteModFile(directory / "Example.ESP", plugin);
+                std::ofstream(directory / "Example.ini") << "[General]\n";
+                std::ofstream(directory / "Empty.esp");
+
+                WorkerPool pool(2);
+                ModFileScanner scanner;
+                std::vector<ModFileInfo> files = scanner.Scan(directory, pool);
+                REQUIRE(files.size() == 3u);
+                CHECK(!files[0].valid);
+                CHECK_EQUAL(files[1].masters.size(), 1u);
+                CHECK(files[2].isMaster);
+                CHECK_EQUAL(scanner.GetParsedCount(), 3u);
+
+                std::filesystem::path cachePath = context.WorkDirectory() / "modfiles.cache";
+                REQUIRE(scanner.SaveCache(cachePath));
+                ModFileScanner reloaded;
+                REQUIRE(reloaded.LoadCache(cachePath));
+                files = reloaded.Scan(directory, pool);
+                CHECK_EQUAL(reloaded.GetParsedCount(), 0u);
+                REQUIRE(files.size() == 3u);
+                CHECK_EQUAL(files[2].recordCount, 100u);
+            }
+        }
+
+        void RegisterModFileScannerTests(TestRegistry &registry)
+        {
+            registry.Add("modfile/reads_header", ReadsHeader);
+            registry.Add("modfile/follows_large_subrecords", FollowsLargeSubrecords);
+            registry.Add("modfile/rejects_damaged_headers", RejectsDamagedHeaders);
+            registry.Add("modfile/finds_load_order_problems", FindsLoadOrderProblems);
+            registry.Add("modfile/scans_directory", ScansDirectory);
+        }
+    }
+
+} // namespace ObseGPCompat
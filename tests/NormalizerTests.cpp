@@ -0,0 +1,182 @@
+#include "Tests.h"
+#include "PathNormalizer.h"
+#include "WorkingDirectory.h"
+
+#include <string>
+#include <system_error>
+
+namespace ObseGPCompat
+{
+
+    namespace Test
+    {
+
+        namespace
+        {
+            template <typename CharT>
+            std::basic_string<CharT> Normalize(const std::basic_string<CharT> &path, size_t capacity = 512)
+            {
+                std::basic_string<CharT> buffer(capacity, CharT(0));
+                buffer.resize(NormalizePath(std::basic_string_view<CharT>(path), buffer.data(), buffer.size()));
+                return buffer;
+            }
+
+            std::string Resolve(const std::string &path, const std::string &base)
+            {
+                std::string buffer(512, '\0');
+                buffer.resize(ResolveRelativePath(std::string_view(path), std::string_view(base), buffer.data(), buffer.size()));
+                return buffer;
+            }
+
+            bool NeedsNormalization(const std::string &path)
+            {
+                return PathNeedsNormalization(std::string_view(path));
+            }
+
+            bool IsRelative(const std::string &path)
+            {
+                return IsRelativePath(std::string_view(path));
+            }
+
+            void CollapsesSeparatorsAndDots(TestContext &context)
+            {
+                CHECK_EQUAL(Normalize<char>("C:\\Games\\\\Data\\.\\Meshes\\x.nif"), "C:\\Games\\Data\\Meshes\\x.nif");
+                CHECK_EQUAL(Normalize<char>("C:/Games//Data/./Meshes/x.nif"), "C:\\Games\\Data\\Meshes\\x.nif");
+                CHECK_EQUAL(Normalize<char>("C:\\Games\\Data\\Meshes\\"), "C:\\Games\\Data\\Meshes");
+                CHECK_EQUAL(Normalize<char>("C:\\Games\\Data\\\\\\"), "C:\\Games\\Data");
+            }
+
+            void ResolvesParentSegments(TestContext &context)
+            {
+                CHECK_EQUAL(Normalize<char>("C:\\Games\\Data\\..\\Data\\x.esp"), "C:\\Games\\Data\\x.esp");
+                CHECK_EQUAL(Normalize<char>("C:\\Games\\a\\b\\..\\..\\x.esp"), "C:\\Games\\x.esp");
+
+                // Never above the drive or the UNC share
+                CHECK_EQUAL(Normalize<char>("C:\\..\\..\\x.esp"), "C:\\x.esp");
+                CHECK_EQUAL(Normalize<char>("\\\\server\\share\\..\\x.esp"), "\\\\server\\share\\x.esp");
+                CHECK_EQUAL(Normalize<char>("C:\\"), "C:\\");
+                CHECK_EQUAL(Normalize<char>("C:\\Games\\.."), "C:\\");
+
+                // Relative paths keep what they cannot resolve
+                CHECK_EQUAL(Normalize<char>("..\\..\\Data\\x.esp"), "..\\..\\Data\\x.esp");
+                CHECK_EQUAL(Normalize<char>("a\\..\\..\\x.esp"), "..\\x.esp");
+            }
+
+            void HandlesDevicePrefixes(TestContext &context)
+            {
+                CHECK_EQUAL(Normalize<char>("\\\\.\\C:\\Games\\x.esp"), "C:\\Games\\x.esp");
+                CHECK_EQUAL(Normalize<char>("\\\\?\\C:\\Games\\.\\x.esp"), "\\\\?\\C:\\Games\\x.esp");
+                CHECK_EQUAL(Normalize<char>("//?/C:/Games/x.esp"), "\\\\?\\C:\\Games\\x.esp");
+                CHECK_EQUAL(Normalize<char>("\\\\?\\UNC\\server\\share\\..\\x.esp"), "\\\\server\\share\\x.esp");
+            }
+
+            void WideMatchesNarrow(TestContext &context)
+            {
+                const char *paths[] = {"C:\\Games\\\\Data\\.\\x.nif", "\\\\?\\UNC\\server\\share\\a\\..\\b",
+                                       "C:/a/b/../../../c/", "\\\\.\\C:\\x", "..\\x\\..\\y"};
+                for (const char *path : paths)
+                {
+                    std::string narrow = Normalize<char>(path);
+                    std::wstring wide = Normalize<wchar_t>(std::filesystem::path(path).wstring());
+                    CHECK_EQUAL(std::filesystem::path(wide).string(), narrow);
+                }
+            }
+
+            void RefusesSmallBuffers(TestContext &context)
+            {
+                std::string path = "C:\\Games\\Data\\x.esp";
+                CHECK_EQUAL(Normalize<char>(path, path.size()), "");
+                CHECK_EQUAL(Normalize<char>(path, path.size() + 1), path);
+            }
+
+            void DetectsVariants(TestContext &context)
+            {
+                CHECK(!NeedsNormalization("C:\\Games\\Data\\x.esp"));
+                CHECK(!NeedsNormalization("C:/Games/Data/x.esp"));
+                CHECK(!NeedsNormalization("C:\\Games\\Data\\Meshes\\Architecture\\Anvil\\x.nif"));
+                CHECK(NeedsNormalization("C:\\Games\\\\Data\\x.esp"));
+                CHECK(NeedsNormalization("C:\\Games\\.\\Data\\x.esp"));
+                CHECK(NeedsNormalization("C:\\Games\\..\\Data\\x.esp"));
+                CHECK(NeedsNormalization("\\\\.\\C:\\Games\\x.esp"));
+                CHECK(NeedsNormalization("\\\\?\\UNC\\server\\share\\x.esp"));
+
+                // Past the first 16-character block, where the vector scan hands over
+                CHECK(NeedsNormalization("C:\\Games\\Data\\Meshes\\Architecture\\\\x.nif"));
+                CHECK(NeedsNormalization("C:\\Games\\Data\\Meshes\\Architecture\\Anvil\\..\\x.nif"));
+                CHECK(NeedsNormalization("C:\\Games\\Data\\Meshes\\Architecture\\Anvil\\x\\\\"));
+            }
+
+            void ClassifiesRelativePaths(TestContext &context)
+            {
+                CHECK(IsRelative("Data\\x.esp"));
+                CHECK(IsRelative("..\\x.esp"));
+                CHECK(IsRelative("\\Games\\x.esp"));
+                CHECK(IsRelative("/home/player/x.esp"));
+                CHECK(!IsRelative("C:\\Games\\x.esp"));
+                CHECK(!IsRelative("C:x.esp"));
+                CHECK(!IsRelative("\\\\server\\share\\x.esp"));
+                CHECK(!IsRelative("\\\\?\\C:\\x.esp"));
+                CHECK(!IsRelative(""));
+            }
+
+            void ResolvesAgainstBase(TestContext &context)
+            {
+                CHECK_EQUAL(Resolve("Data\\x.esp", "C:\\Games\\Oblivion"), "C:\\Games\\Oblivion\\Data\\x.esp");
+                CHECK_EQUAL(Resolve("..\\x.esp", "C:\\Games\\Oblivion"), "C:\\Games\\x.esp");
+                CHECK_EQUAL(Resolve(".\\Data\\\\x.esp", "C:\\Games\\Oblivion\\"), "C:\\Games\\Oblivion\\Data\\x.esp");
+
+                // Rooted on the current drive
+                CHECK_EQUAL(Resolve("\\Other\\x.esp", "C:\\Games\\Oblivion"), "C:\\Other\\x.esp");
+                CHECK_EQUAL(Resolve("x.esp", ""), "");
+            }
+
+            // POSIX working directories have no drive; the result keeps their root
+            void ResolvesAgainstPosixBase(TestContext &context)
+            {
+                CHECK_EQUAL(Resolve("Data/x.esp", "/home/player/game"), "\\home\\player\\game\\Data\\x.esp");
+                CHECK_EQUAL(Resolve("../x.esp", "/home/player/game"), "\\home\\player\\x.esp");
+                CHECK_EQUAL(Resolve("/tmp/./x.esp", "/home/player/game"), "\\tmp\\x.esp");
+            }
+
+            void FollowsWorkingDirectory(TestContext &context)
+            {
+                std::error_code ec;
+                std::filesystem::path previous = std::filesystem::current_path(ec);
+                std::filesystem::path first = context.WorkDirectory() / "first";
+                std::filesystem::path second = context.WorkDirectory() / "second";
+                std::filesystem::create_directories(first, ec);
+                std::filesystem::create_directories(second, ec);
+
+                std::filesystem::current_path(first, ec);
+                WorkingDirectory::Invalidate();
+                std::string firstPath = std::filesystem::current_path(ec).string();
+                CHECK_EQUAL(std::string(WorkingDirectory::Get<char>()), firstPath);
+
+                // Cached until the hooks report a change
+                std::filesystem::current_path(second, ec);
+                CHECK_EQUAL(std::string(WorkingDirectory::Get<char>()), firstPath);
+                WorkingDirectory::Invalidate();
+                CHECK_EQUAL(std::string(WorkingDirectory::Get<char>()), std::filesystem::current_path().string());
+                CHECK_EQUAL(std::wstring(WorkingDirectory::Get<wchar_t>()), std::filesystem::current_path().wstring());
+
+                std::filesystem::current_path(previous, ec);
+                WorkingDirectory::Invalidate();
+            }
+        }
+
+        void RegisterNormalizerTests(TestRegistry &registry)
+        {
+            registry.Add("normalizer/collapses_separators_and_dots", CollapsesSeparatorsAndDots);
+            registry.Add("normalizer/resolves_parent_segments", ResolvesParentSegments);
+            registry.Add("normalizer/handles_device_prefixes", HandlesDevicePrefixes);
+            registry.Add("normalizer/wide_matches_narrow", WideMatchesNarrow);
+            registry.Add("normalizer/refuses_small_buffers", RefusesSmallBuffers);
+            registry.Add("normalizer/detects_variants", DetectsVariants);
+            registry.Add("relative/classifies_relative_paths", ClassifiesRelativePaths);
+            registry.Add("relative/resolves_against_base", ResolvesAgainstBase);
+            registry.Add("relative/resolves_against_posix_base", ResolvesAgainstPosixBase);
+            registry.Add("relative/follows_working_directory", FollowsWorkingDirectory);
+        }
+    }
+
+} // namespace ObseGPCompat
@@ -0,0 +1,231 @@
+#include "Tests.h"
+#include "PluginScanner.h"
+#include "WorkerPool.h"
+
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace ObseGPCompat
+{
+
+    namespace Test
+    {
+
+        namespace
+        {
+            // Layout of the sample image: headers, then one section holding the export
+            // directory, the import descriptors and every name
+            constexpr uint32_t PeOffset = 0x80;
+            constexpr uint32_t OptionalHeaderSize = 0xF0;
+            constexpr uint32_t SectionRva = 0x1000;
+            constexpr uint32_t SectionOffset = 0x200;
+            constexpr uint32_t SectionSize = 0x400;
+            constexpr uint32_t ExportRva = SectionRva;
+            constexpr uint32_t ImportRva = SectionRva + 0x100;
+            constexpr uint32_t NamesRva = SectionRva + 0x200;
+
+            struct SyntheticImage
+            {
+                uint16_t machine = PluginInfo::MachineAmd64;
+                bool dll = true;
+                std::vector<std::string> exports;
+                std::vector<std::string> imports;
+            };
+
+            template <typename T>
+            void Put(std::vector<uint8_t> &bytes, size_t offset, T value)
+            {
+                std::memcpy(bytes.data() + offset, &value, sizeof(T));
+            }
+
+            size_t RvaToOffset(uint32_t rva)
+            {
+                return rva - SectionRva + SectionOffset;
+            }
+
+            // A PE32+ image as the linker lays it out on disk, reduced to what Parse reads
+            std::vector<uint8_t> BuildImage(const SyntheticImage &image)
+            {
+                std::vector<uint8_t> bytes(SectionOffset + SectionSize, 0);
+                bytes[0] = 'M';
+                bytes[1] = 'Z';
+                Put<uint32_t>(bytes, 0x3C, PeOffset);
+                std::memcpy(bytes.data() + PeOffset, "PE\0\0", 4);
+
+                size_t fileHeader = PeOffset + 4;
+                Put<uint16_t>(bytes, fileHeader, image.machine);
+                Put<uint16_t>(bytes, fileHeader + 2, 1);
+                Put<uint16_t>(bytes, fileHeader + 16, OptionalHeaderSize);
+                Put<uint16_t>(bytes, fileHeader + 18, image.dll ? 0x2022 : 0x0022);
+
+                size_t optionalHeader = fileHeader + 20;
+                Put<uint16_t>(bytes, optionalHeader, 0x20B);
+                Put<uint32_t>(bytes, optionalHeader + 108, 16);
+                if (!image.exports.empty())
+                {
+                    Put<uint32_t>(bytes, optionalHeader + 112, ExportRva);
+                    Put<uint32_t>(bytes, optionalHeader + 116, 40);
+                }
+                if (!image.imports.empty())
+                {
+                    Put<uint32_t>(bytes, optionalHeader + 120, ImportRva);
+                    Put<uint32_t>(bytes, optionalHeader + 124, static_cast<uint32_t>(image.imports.size() + 1) * 20);
+                }
+
+                size_t section = optionalHeader + OptionalHeaderSize;
+                std::memcpy(bytes.data() + section, ".rdata", 6);
+                Put<uint32_t>(bytes, section + 8, SectionSize);
+                Put<uint32_t>(bytes, section + 12, SectionRva);
+                Put<uint32_t>(bytes, section + 16, SectionSize);
+                Put<uint32_t>(bytes, section + 20, SectionOffset);
+
+                // Names are packed from NamesRva on; the name pointer table sits before them
+                uint32_t nameRva = NamesRva;
+                auto addName = [&](const std::string &name)
+                {
+                    std::memcpy(bytes.data() + RvaToOffset(nameRva), name.c_str(), name.size() + 1);
+                    uint32_t rva = nameRva;
+                    nameRva += static_cast<uint32_t>(name.size() + 1);
+                    return rva;
+                };
+
+                uint32_t pointersRva = ExportRva + 40;
+                Put<uint32_t>(bytes, RvaToOffset(ExportRva) + 24, static_cast<uint32_t>(image.exports.size()));
+                Put<uint32_t>(bytes, RvaToOffset(ExportRva) + 32, pointersRva);
+                for (size_t i = 0; i < image.exports.size(); ++i)
+                {
+                    Put<uint32_t>(bytes, RvaToOffset(pointersRva) + i * 4, addName(image.exports[i]));
+                }
+                for (size_t i = 0; i < image.imports.size(); ++i)
+                {
+                    Put<uint32_t>(bytes, RvaToOffset(ImportRva) + i * 20 + 12, addName(image.imports[i]));
+                }
+                return bytes;
+            }
+
+            SyntheticImage GetSamplePlugin()
+            {
+                SyntheticImage image;
+                image.exports = {"OBSEPlugin_Load", "OBSEPlugin_Version"};
+                image.imports = {"KERNEL32.dll", "VCRUNTIME140.dll", "api-ms-win-crt-runtime-l1-1-0.dll"};
+                return image;
+            }
+
+            void ReadsExportsAndImports(TestContext &context)
+            {
+                std::vector<uint8_t> bytes = BuildImage(GetSamplePlugin());
+                PluginInfo info = {};
+                REQUIRE(PluginScanner::Parse(bytes.data(), bytes.size(), info));
+                CHECK(info.valid);
+                CHECK(info.isDll);
+                CHECK_EQUAL(info.machine, PluginInfo::MachineAmd64);
+                CHECK(info.IsObsePlugin());
+                CHECK(info.HasExport("OBSEPlugin_Version"));
+                CHECK(!info.HasExport("obseplugin_load"));
+                REQUIRE(info.exports.size() == 2u);
+                REQUIRE(info.imports.size() == 3u);
+                CHECK_EQUAL(info.imports[1], "VCRUNTIME140.dll");
+            }
+
+            // An ordinary DLL, or a 32-bit build of a plugin, is valid but not loadable
+            void TellsPluginsApart(TestContext &context)
+            {
+                SyntheticImage image;
+                image.imports = {"KERNEL32.dll"};
+                std::vector<uint8_t> bytes = BuildImage(image);
+                PluginInfo info = {};
+                REQUIRE(PluginScanner::Parse(bytes.data(), bytes.size(), info));
+                CHECK(!info.IsObsePlugin());
+                CHECK(info.exports.empty());
+                CHECK_EQUAL(info.imports.size(), 1u);
+
+                image = GetSamplePlugin();
+                image.machine = 0x14C;
+                image.dll = false;
+                bytes = BuildImage(image);
+                REQUIRE(PluginScanner::Parse(bytes.data(), bytes.size(), info));
+                CHECK_EQUAL(info.machine, 0x14Cu);
+                CHECK(!info.isDll);
+                CHECK(info.IsObsePlugin());
+            }
+
+            void RejectsOtherFiles(TestContext &context)
+            {
+                PluginInfo info = {};
+                std::string text = "This program cannot be run in DOS mode.";
+                CHECK(!PluginScanner::Parse(reinterpret_cast<const uint8_t *>(text.data()), text.size(), info));
+                CHECK(!info.valid);
+
+                std::vector<uint8_t> bytes = BuildImage(GetSamplePlugin());
+                std::vector<uint8_t> other = bytes;
+                other[PeOffset + 1] = 'X';
+                CHECK(!PluginScanner::Parse(other.data(), other.size(), info));
+                other = bytes;
+                Put<uint32_t>(other, 0x3C, 0xFFFFFFF0);
+                CHECK(!PluginScanner::Parse(other.data(), other.size(), info));
+                for (size_t size : {size_t(0), size_t(2), size_t(0x40), size_t(PeOffset + 8), size_t(PeOffset + 24 + OptionalHeaderSize)})
+                {
+                    CHECK(!PluginScanner::Parse(bytes.data(), size, info));
+                }
+            }
+
+            // Tables that run off the image keep whatever was read before them
+            void KeepsNamesBeforeDamage(TestContext &context)
+            {
+                std::vector<uint8_t> bytes = BuildImage(GetSamplePlugin());
+                Put<uint32_t>(bytes, RvaToOffset(ExportRva + 40) + 4, 0x7FFFFFFF);
+                Put<uint32_t>(bytes, RvaToOffset(ImportRva) + 20 + 12, 0x7FFFFFFF);
+
+                PluginInfo info = {};
+                REQUIRE(PluginScanner::Parse(bytes.data(), bytes.size(), info));
+                CHECK_EQUAL(info.exports.size(), 1u);
+                CHECK_EQUAL(info.imports.size(), 1u);
+            }
+
+            void ScansDirectory(TestContext &context)
+            {
+                std::filesystem::path directory = context.WorkDirectory() / "Plugins";
+                std::filesystem::create_directories(directory);
+                std::vector<uint8_t> bytes = BuildImage(GetSamplePlugin());
+                for (const char *name : {"b_plugin.dll", "A_Plugin.DLL"})
+                {
+                    std::ofstream(directory / name, std::ios::binary).write(reinterpret_cast<const char *>(bytes.data()), bytes.size());
+                }
+                std::ofstream(directory / "b_plugin.ini") << "[Settings]\n";
+                std::ofstream(directory / "broken.dll") << "MZ";
+
+                WorkerPool pool(2);
+                PluginScanner scanner;
+                std::vector<PluginInfo> plugins = scanner.Scan(directory, pool);
+                REQUIRE(plugins.size() == 3u);
+                CHECK_EQUAL(plugins[0].path.filename(), std::filesystem::path("A_Plugin.DLL"));
+                CHECK(plugins[0].IsObsePlugin());
+                CHECK(!plugins[2].valid);
+                CHECK_EQUAL(scanner.GetStats().parsed, 3u);
+
+                // Unchanged files come from the cache, also after a round trip through disk
+                std::filesystem::path cachePath = context.WorkDirectory() / "plugins.cache";
+                REQUIRE(scanner.SaveCache(cachePath));
+                PluginScanner reloaded;
+                REQUIRE(reloaded.LoadCache(cachePath));
+                plugins = reloaded.Scan(directory, pool);
+                CHECK_EQUAL(reloaded.GetStats().cached, 3u);
+                CHECK_EQUAL(reloaded.GetStats().parsed, 0u);
+                REQUIRE(plugins.size() == 3u);
+                CHECK_EQUAL(plugins[1].imports.size(), 3u);
+            }
+        }
+
+        void RegisterPluginScannerTests(TestRegistry &registry)
+        {
+            registry.Add("plugin/reads_exports_and_imports", ReadsExportsAndImports);
+            registry.Add("plugin/tells_plugins_apart", TellsPluginsApart);
+            registry.Add("plugin/rejects_other_files", RejectsOtherFiles);
+            registry.Add("plugin/keeps_names_before_damage", KeepsNamesBeforeDamage);
+            registry.Add("plugin/scans_directory", ScansDirectory);
+        }
+    }
+
+} // namespace ObseGPCompat
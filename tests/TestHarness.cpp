@@ -0,0 +1,69 @@
+#include "TestHarness.h"
+
+#include <cstdio>
+#include <exception>
+#include <system_error>
+#include <utility>
+
+namespace ObseGPCompat
+{
+
+    namespace Test
+    {
+
+        TestContext::TestContext(std::filesystem::path workDirectory)
+            : m_WorkDirectory(std::move(workDirectory)),
+              m_Failures(0)
+        {
+        }
+
+        bool TestContext::Check(bool condition, const char *expression, const char *file, int line)
+        {
+            if (!condition)
+            {
+                Fail(expression, file, line);
+            }
+            return condition;
+        }
+
+        void TestContext::Fail(const std::string &message, const char *file, int line)
+        {
+            ++m_Failures;
+            fprintf(stderr, "    %s:%d: %s\n", std::filesystem::path(file).filename().string().c_str(), line, message.c_str());
+        }
+
+        void TestRegistry::Add(const std::string &name, TestFunction function)
+        {
+            m_Cases.push_back({name, std::move(function)});
+        }
+
+        bool RunCase(const TestCase &testCase, const std::filesystem::path &workDirectory)
+        {
+            std::filesystem::path caseDirectory = workDirectory / "case";
+            std::error_code ec;
+            std::filesystem::remove_all(caseDirectory, ec);
+            std::filesystem::create_directories(caseDirectory, ec);
+
+            TestContext context(caseDirectory);
+            if (ec)
+            {
+                context.Fail("cannot create " + caseDirectory.string() + ": " + ec.message(), __FILE__, __LINE__);
+            }
+            else
+            {
+                try
+                {
+                    testCase.function(context);
+                }
+                catch (const std::exception &e)
+                {
+                    context.Fail(std::string("unexpected exception: ") + e.what(), __FILE__, __LINE__);
+                }
+            }
+
+            std::filesystem::remove_all(caseDirectory, ec);
+            return context.FailureCount() == 0;
+        }
+    }
+
+} // namespace ObseGPCompat
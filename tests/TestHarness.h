@@ -0,0 +1,116 @@
+#pragma once
+
+#include <filesystem>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace ObseGPCompat
+{
+
+    namespace Test
+    {
+        // Handed to each test: a scratch directory and the checks. A failed check is
+        // recorded and the test goes on, unless it used REQUIRE.
+        class TestContext
+        {
+        public:
+            explicit TestContext(std::filesystem::path workDirectory);
+
+            // Empty and private to this test; removed once it finishes
+            const std::filesystem::path &WorkDirectory() const { return m_WorkDirectory; }
+
+            bool Check(bool condition, const char *expression, const char *file, int line);
+
+            template <typename Actual, typename Expected>
+            bool CheckEqual(const Actual &actual, const Expected &expected, const char *expression, const char *file, int line);
+
+            void Fail(const std::string &message, const char *file, int line);
+
+            size_t FailureCount() const { return m_Failures; }
+
+        private:
+            template <typename T>
+            static std::string Describe(const T &value);
+
+            std::filesystem::path m_WorkDirectory;
+            size_t m_Failures;
+        };
+
+        using TestFunction = std::function<void(TestContext &context)>;
+
+        struct TestCase
+        {
+            std::string name; // "<area>/<behaviour>"; ctest runs one area per entry
+            TestFunction function;
+        };
+
+        class TestRegistry
+        {
+        public:
+            void Add(const std::string &name, TestFunction function);
+
+            const std::vector<TestCase> &GetCases() const { return m_Cases; }
+
+        private:
+            std::vector<TestCase> m_Cases;
+        };
+
+        // Runs one test in a fresh workDirectory / "case"; true when every check passed
+        bool RunCase(const TestCase &testCase, const std::filesystem::path &workDirectory);
+
+        template <typename T>
+        std::string TestContext::Describe(const T &value)
+        {
+            if constexpr (std::is_same_v<T, std::wstring>)
+            {
+                return '"' + std::filesystem::path(value).string() + '"';
+            }
+            else if constexpr (std::is_same_v<T, std::filesystem::path>)
+            {
+                return '"' + value.string() + '"';
+            }
+            else if constexpr (std::is_convertible_v<T, std::string_view>)
+            {
+                return '"' + std::string(std::string_view(value)) + '"';
+            }
+            else if constexpr (std::is_enum_v<T>)
+            {
+                return std::to_string(static_cast<long long>(value));
+            }
+            else
+            {
+                std::ostringstream text;
+                text << value;
+                return text.str();
+            }
+        }
+
+        template <typename Actual, typename Expected>
+        bool TestContext::CheckEqual(const Actual &actual, const Expected &expected, const char *expression, const char *file, int line)
+        {
+            if (actual == expected)
+            {
+                return true;
+            }
+            Fail(std::string(expression) + ": got " + Describe(actual) + ", expected " + Describe(expected), file, line);
+            return false;
+        }
+    }
+
+} // namespace ObseGPCompat
+
+// The test functions name their parameter context
+#define CHECK(expression) context.Check(static_cast<bool>(expression), #expression, __FILE__, __LINE__)
+#define CHECK_EQUAL(actual, expected) context.CheckEqual((actual), (expected), #actual " == " #expected, __FILE__, __LINE__)
+#define REQUIRE(expression)                                                               \
+    do                                                                                    \
+    {                                                                                     \
+        if (!context.Check(static_cast<bool>(expression), #expression, __FILE__, __LINE__)) \
+        {                                                                                 \
+            return;                                                                       \
+        }                                                                                 \
+    } while (false)
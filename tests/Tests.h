@@ -0,0 +1,26 @@
+#pragma once
+
+#include "TestHarness.h"
+
+namespace ObseGPCompat
+{
+
+    namespace Test
+    {
+        // One per area, each in its own file
+        void RegisterNormalizerTests(TestRegistry &registry);
+        void RegisterTranslatorTests(TestRegistry &registry);
+        void RegisterMappingRegistryTests(TestRegistry &registry);
+        void RegisterMetadataCacheTests(TestRegistry &registry);
+        void RegisterFileViewCacheTests(TestRegistry &registry);
+        void RegisterDirectoryIndexTests(TestRegistry &registry);
+        void RegisterCopyEngineTests(TestRegistry &registry);
+        void RegisterContentStoreTests(TestRegistry &registry);
+        void RegisterArchiveTests(TestRegistry &registry);
+        void RegisterPluginScannerTests(TestRegistry &registry);
+        void RegisterModFileScannerTests(TestRegistry &registry);
+        void RegisterDeployTests(TestRegistry &registry);
+        void RegisterBatchTests(TestRegistry &registry);
+    }
+
+} // namespace ObseGPCompat
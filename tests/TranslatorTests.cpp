@@ -0,0 +1,222 @@
+#include "Tests.h"
+#include "CoreFixture.h"
+#include "ObseGPCompat.h"
+#include "PathTranslator.h"
+#include "PathUtils.h"
+#include "VirtualFileSystem.h"
+#include "WorkingDirectory.h"
+
+#include <string>
+#include <fstream>
+#include <system_error>
+#include <vector>
+
+namespace ObseGPCompat
+{
+
+    namespace Test
+    {
+
+        namespace
+        {
+            // The translator joins the remainder with '\\' while the file system appends path
+            // components, which only differs in the separator on Linux, so results are compared folded
+            std::string Folded(const std::filesystem::path &path)
+            {
+                return FoldPath(std::string_view(path.string()));
+            }
+
+            std::vector<std::filesystem::path> GetProbePaths(const CoreFixture &core)
+            {
+                const std::filesystem::path &obse = core.GetObsePath();
+                return {obse,
+                        obse / "obse64_loader.exe",
+                        obse / "Data" / "Oblivion.esm",
+                        obse / "Data" / "Meshes" / "Clutter" / "Bucket.nif",
+                        obse / "Content" / "Paks" / "OblivionRemastered-Windows.pak",
+                        obse / "OBSE" / "Plugins" / "Example.dll",
+                        obse / "OBSE" / "Logs" / "obse64.log",
+                        obse.parent_path() / "Win32" / "unmapped.dll",
+                        core.GetInstallPath() / "Content" / "unmapped.txt"};
+            }
+
+            // Both components read the one registry, so every path must come out the same
+            void TranslatorAndFileSystemAgree(TestContext &context)
+            {
+                CoreFixture core(context.WorkDirectory());
+                REQUIRE(core.Start());
+
+                for (const std::filesystem::path &path : GetProbePaths(core))
+                {
+                    std::filesystem::path translated = g_PathTranslator->TranslateObsePath(path);
+                    CHECK_EQUAL(Folded(translated), Folded(g_VirtualFileSystem->TranslateToReal(path)));
+                    CHECK_EQUAL(g_PathTranslator->IsObsePath(path), g_VirtualFileSystem->IsVirtualPath(path));
+
+                    // The buffer form the hooks use gives the same result
+                    std::vector<char> buffer(PathTranslator::MaxPathLength);
+                    bool hit = g_PathTranslator->TryTranslate(std::string_view(path.string()), buffer.data(), buffer.size());
+                    CHECK_EQUAL(hit, translated != path);
+                    if (hit)
+                    {
+                        CHECK_EQUAL(Folded(buffer.data()), Folded(translated));
+                    }
+                }
+            }
+
+            void NestedRootsWin(TestContext &context)
+            {
+                CoreFixture core(context.WorkDirectory());
+                REQUIRE(core.Start());
+
+                std::filesystem::path content = core.GetInstallPath() / "Content" / "OblivionRemastered";
+                std::filesystem::path plugin = core.GetObsePath() / "OBSE" / "Plugins" / "Example.dll";
+                CHECK_EQUAL(Folded(g_PathTranslator->TranslateObsePath(plugin)), Folded(content / "Binaries" / "Win64" / "OBSE" / "Plugins" / "Example.dll"));
+                CHECK_EQUAL(Folded(g_VirtualFileSystem->TranslateToReal(core.GetObsePath() / "Data" / "x.esp")), Folded(core.GetDataPath() / "x.esp"));
+                CHECK_EQUAL(Folded(g_PathTranslator->TranslateObsePath(core.GetObsePath() / "x.exe")), Folded(content / "Binaries" / "WinGDK" / "x.exe"));
+            }
+
+            void RoundTripsThroughFileSystem(TestContext &context)
+            {
+                CoreFixture core(context.WorkDirectory());
+                REQUIRE(core.Start());
+
+                std::filesystem::path path = core.GetObsePath() / "Data" / "Textures" / "x.dds";
+                std::filesystem::path real = g_VirtualFileSystem->TranslateToReal(path);
+                CHECK(g_PathTranslator->IsGamePath(real));
+                CHECK_EQUAL(g_VirtualFileSystem->TranslateToVirtual(real), path);
+            }
+
+            // Mappings added through either one are seen by the other at once
+            void SeesMappingsAddedLater(TestContext &context)
+            {
+                CoreFixture core(context.WorkDirectory());
+                REQUIRE(core.Start());
+
+                std::filesystem::path mod = core.GetObsePath() / "Data" / "Mods" / "Example";
+                std::filesystem::path target = context.WorkDirectory() / "Profiles" / "Example";
+                g_VirtualFileSystem->MapPath(mod, target);
+
+                std::filesystem::path file = mod / "Meshes" / "x.nif";
+                CHECK_EQUAL(Folded(g_PathTranslator->TranslateObsePath(file)), Folded(target / "Meshes" / "x.nif"));
+                CHECK_EQUAL(Folded(g_VirtualFileSystem->TranslateToReal(file)), Folded(target / "Meshes" / "x.nif"));
+                CHECK_EQUAL(Folded(g_PathTranslator->TranslateObsePath(mod.parent_path() / "Other" / "x.nif")),
+                            Folded(core.GetDataPath() / "Mods" / "Other" / "x.nif"));
+            }
+
+            void SeesOverlays(TestContext &context)
+            {
+                CoreFixture core(context.WorkDirectory());
+                REQUIRE(core.Start());
+
+                std::filesystem::path low = context.WorkDirectory() / "Layers" / "Low";
+                std::filesystem::path high = context.WorkDirectory() / "Layers" / "High";
+                std::error_code ec;
+                std::filesystem::create_directories(low, ec);
+                std::filesystem::create_directories(high, ec);
+                for (const std::filesystem::path &file : {low / "shared.esp", low / "low.esp", high / "shared.esp"})
+                {
+                    std::ofstream(file) << "x";
+                }
+
+                std::filesystem::path mount = core.GetObsePath() / "Data";
+                REQUIRE(g_VirtualFileSystem->MountOverlay(mount, {{low, 0}, {high, 1}}));
+                for (const char *name : {"shared.esp", "low.esp", "absent.esp"})
+                {
+                    std::filesystem::path path = mount / name;
+                    CHECK_EQUAL(Folded(g_PathTranslator->TranslateObsePath(path)), Folded(g_VirtualFileSystem->TranslateToReal(path)));
+                }
+                CHECK_EQUAL(Folded(g_PathTranslator->TranslateObsePath(mount / "shared.esp")), Folded(high / "shared.esp"));
+                CHECK_EQUAL(Folded(g_PathTranslator->TranslateObsePath(mount / "low.esp")), Folded(low / "low.esp"));
+                CHECK_EQUAL(Folded(g_PathTranslator->TranslateObsePath(mount / "absent.esp")), Folded(core.GetDataPath() / "absent.esp"));
+            }
+
+            // On Linux the working directory has no drive, but resolution still anchors there
+            void TranslatesRelativePaths(TestContext &context)
+            {
+                CoreFixture core(context.WorkDirectory());
+                REQUIRE(core.Start());
+
+                std::error_code ec;
+                std::filesystem::path previous = std::filesystem::current_path(ec);
+                std::filesystem::create_directories(core.GetObsePath(), ec);
+                std::filesystem::current_path(core.GetObsePath(), ec);
+                REQUIRE(!ec);
+                WorkingDirectory::Invalidate();
+
+                std::string translated;
+                CHECK(g_PathTranslator->TryTranslate(std::string_view("Data/Meshes/x.nif"), translated));
+                CHECK_EQUAL(Folded(translated), Folded(core.GetDataPath() / "Meshes" / "x.nif"));
+                CHECK(g_PathTranslator->TryTranslate(std::string_view("./OBSE/../Data/x.esp"), translated));
+                CHECK_EQUAL(Folded(translated), Folded(core.GetDataPath() / "x.esp"));
+
+                std::wstring wide(PathTranslator::MaxPathLength, L'\0');
+                CHECK(g_PathTranslator->TryTranslate(std::wstring_view(L"Data\\x.esp"), wide.data(), wide.size()));
+                CHECK_EQUAL(Folded(std::filesystem::path(wide.c_str())), Folded(core.GetDataPath() / "x.esp"));
+
+                // Climbing out of the mapped tree leaves the path alone
+                CHECK(!g_PathTranslator->TryTranslate(std::string_view("../../../../../unmapped.txt"), translated));
+
+                std::filesystem::current_path(previous, ec);
+                WorkingDirectory::Invalidate();
+            }
+
+            // The hooks' first check must pass whatever TryTranslate maps, and reject relative
+            // or unnormalized paths that resolve elsewhere instead of passing them all. The
+            // check compares heads, so "elsewhere" is the root, far from the temporary tree.
+            void PrefiltersResolvedPaths(TestContext &context)
+            {
+                CoreFixture core(context.WorkDirectory());
+                REQUIRE(core.Start());
+
+                std::error_code ec;
+                std::filesystem::path previous = std::filesystem::current_path(ec);
+                std::filesystem::create_directories(core.GetObsePath(), ec);
+                std::filesystem::current_path(context.WorkDirectory().root_path(), ec);
+                REQUIRE(!ec);
+                WorkingDirectory::Invalidate();
+
+                std::string obse = core.GetObsePath().string();
+                std::string separator(1, static_cast<char>(std::filesystem::path::preferred_separator));
+                std::string climb;
+                for (int i = 0; i < 32; ++i)
+                {
+                    climb += separator + "..";
+                }
+                CHECK(g_PathTranslator->MayTranslate(std::string_view(obse + separator + "Data" + separator + "x.esp")));
+                CHECK(g_PathTranslator->MayTranslate(std::string_view(obse + separator + separator + "Data" + separator + "x.esp")));
+                CHECK(!g_PathTranslator->MayTranslate(std::string_view("Data/x.esp")));
+                CHECK(!g_PathTranslator->MayTranslate(std::wstring_view(L"Data\\x.esp")));
+                CHECK(!g_PathTranslator->MayTranslate(std::string_view(obse + climb + separator + "x.esp")));
+
+                std::filesystem::current_path(core.GetObsePath(), ec);
+                REQUIRE(!ec);
+                WorkingDirectory::Invalidate();
+                CHECK(g_PathTranslator->MayTranslate(std::string_view("Data/x.esp")));
+                CHECK(g_PathTranslator->MayTranslate(std::wstring_view(L"Data\\x.esp")));
+                CHECK(g_PathTranslator->MayTranslate(std::string_view("./OBSE/../Data/x.esp")));
+
+                // Every path MayTranslate turns away is one TryTranslate would not have mapped
+                std::string translated;
+                for (std::string path : {std::string("Data/x.esp"), std::string("./Data//x.esp"), climb.substr(1) + "/x.esp"})
+                {
+                    CHECK(g_PathTranslator->MayTranslate(std::string_view(path)) || !g_PathTranslator->TryTranslate(std::string_view(path), translated));
+                }
+
+                std::filesystem::current_path(previous, ec);
+                WorkingDirectory::Invalidate();
+            }
+        }
+
+        void RegisterTranslatorTests(TestRegistry &registry)
+        {
+            registry.Add("translator/agrees_with_file_system", TranslatorAndFileSystemAgree);
+            registry.Add("translator/nested_roots_win", NestedRootsWin);
+            registry.Add("translator/round_trips_through_file_system", RoundTripsThroughFileSystem);
+            registry.Add("translator/sees_mappings_added_later", SeesMappingsAddedLater);
+            registry.Add("translator/sees_overlays", SeesOverlays);
+            registry.Add("translator/translates_relative_paths", TranslatesRelativePaths);
+            registry.Add("translator/prefilters_resolved_paths", PrefiltersResolvedPaths);
+        }
+    }
+
+} // namespace ObseGPCompat
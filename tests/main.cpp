@@ -0,0 +1,112 @@
+#include "Tests.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <system_error>
+#include <unistd.h>
+#include <vector>
+
+int main(int argc, char *argv[])
+{
+    using namespace ObseGPCompat::Test;
+
+    // Any other arguments are name prefixes; a test runs if it starts with one of them
+    std::vector<std::string> prefixes;
+    bool list = false;
+    bool verbose = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+        if (argument == "--list")
+        {
+            list = true;
+        }
+        else if (argument == "--verbose")
+        {
+            verbose = true;
+        }
+        else if (argument.rfind("--", 0) == 0)
+        {
+            fprintf(stderr, "Usage: obse64gp_tests [--list] [--verbose] [name prefix...]\n");
+            return argument == "--help" ? 0 : 1;
+        }
+        else
+        {
+            prefixes.push_back(argument);
+        }
+    }
+
+    TestRegistry registry;
+    RegisterNormalizerTests(registry);
+    RegisterTranslatorTests(registry);
+    RegisterMappingRegistryTests(registry);
+    RegisterMetadataCacheTests(registry);
+    RegisterFileViewCacheTests(registry);
+    RegisterDirectoryIndexTests(registry);
+    RegisterCopyEngineTests(registry);
+    RegisterContentStoreTests(registry);
+    RegisterArchiveTests(registry);
+    RegisterPluginScannerTests(registry);
+    RegisterModFileScannerTests(registry);
+    RegisterDeployTests(registry);
+    RegisterBatchTests(registry);
+
+    std::vector<const TestCase *> selected;
+    for (const TestCase &testCase : registry.GetCases())
+    {
+        bool matches = prefixes.empty();
+        for (const std::string &prefix : prefixes)
+        {
+            matches = matches || testCase.name.rfind(prefix, 0) == 0;
+        }
+        if (matches)
+        {
+            selected.push_back(&testCase);
+        }
+    }
+    if (list)
+    {
+        for (const TestCase *testCase : selected)
+        {
+            printf("%s\n", testCase->name.c_str());
+        }
+        return 0;
+    }
+    if (selected.empty())
+    {
+        fprintf(stderr, "No tests match\n");
+        return 1;
+    }
+
+    // As in the bench, everything the layer writes stays in the work directory
+    std::filesystem::path workDirectory = std::filesystem::temp_directory_path() / ("obse64gp_tests_" + std::to_string(getpid()));
+    std::error_code ec;
+    std::filesystem::create_directories(workDirectory / "appdata", ec);
+    if (ec)
+    {
+        fprintf(stderr, "Cannot create %s: %s\n", workDirectory.string().c_str(), ec.message().c_str());
+        return 1;
+    }
+    setenv("XDG_DATA_HOME", (workDirectory / "appdata").c_str(), 1);
+
+    // Log also prints every line; the results go to stderr
+    if (!verbose && !freopen("/dev/null", "w", stdout))
+    {
+        fprintf(stderr, "Cannot silence stdout; the layer's log output will be mixed in\n");
+    }
+
+    size_t failed = 0;
+    for (const TestCase *testCase : selected)
+    {
+        // Failed checks are printed below the name as they happen
+        fprintf(stderr, "[ RUN  ] %s\n", testCase->name.c_str());
+        bool passed = RunCase(*testCase, workDirectory);
+        fprintf(stderr, "%s %s\n", passed ? "[ PASS ]" : "[ FAIL ]", testCase->name.c_str());
+        failed += passed ? 0 : 1;
+    }
+    std::filesystem::remove_all(workDirectory, ec);
+
+    fprintf(stderr, "%zu of %zu tests passed\n", selected.size() - failed, selected.size());
+    return failed == 0 ? 0 : 1;
+}